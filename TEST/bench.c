@@ -0,0 +1,135 @@
+/*
+ * bench.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Helpers shared by the benchmark programs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "bench.h"
+
+double benchNow()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+char *benchReadFile(const char *name)
+{
+   FILE *f = fopen(name, "r");
+   char *buf;
+   long  size;
+
+   if (f == NULL)
+      return NULL;
+   fseek(f, 0, SEEK_END);
+   size = ftell(f);
+   fseek(f, 0, SEEK_SET);
+   buf = malloc(size + 1);
+   if (fread(buf, 1, size, f) != (size_t) size) {
+      free(buf);
+      buf = NULL;
+   } else {
+      buf[size] = 0;
+   }
+   fclose(f);
+   return buf;
+}
+
+static void append(char **buf, size_t *len, size_t *max, const char *s)
+{
+   size_t l = strlen(s);
+   if (*len + l + 1 > *max) {
+      while (*len + l + 1 > *max)
+         *max *= 2;
+      *buf = realloc(*buf, *max);
+   }
+   memcpy(*buf + *len, s, l + 1);
+   *len += l;
+}
+
+char *benchEnumInstancesResponse(int instances, int properties)
+{
+   size_t len = 0, max = 65536;
+   char  *buf = malloc(max);
+   char   tmp[512];
+   int    i, p;
+
+   buf[0] = 0;
+   append(&buf, &len, &max,
+          "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+          "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+          "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+          "<SIMPLERSP>\n"
+          "<IMETHODRESPONSE NAME=\"EnumerateInstances\">\n"
+          "<IRETURNVALUE>\n");
+   for (i = 0; i < instances; i++) {
+      sprintf(tmp,
+              "<VALUE.NAMEDINSTANCE>\n"
+              "<INSTANCENAME CLASSNAME=\"Bench_Element\">\n"
+              "<KEYBINDING NAME=\"CreationClassName\">"
+              "<KEYVALUE VALUETYPE=\"string\">Bench_Element</KEYVALUE>"
+              "</KEYBINDING>\n"
+              "<KEYBINDING NAME=\"Id\">"
+              "<KEYVALUE VALUETYPE=\"numeric\">%d</KEYVALUE>"
+              "</KEYBINDING>\n"
+              "</INSTANCENAME>\n"
+              "<INSTANCE CLASSNAME=\"Bench_Element\">\n"
+              "<PROPERTY NAME=\"CreationClassName\" TYPE=\"string\">"
+              "<VALUE>Bench_Element</VALUE></PROPERTY>\n"
+              "<PROPERTY NAME=\"Id\" TYPE=\"uint32\">"
+              "<VALUE>%d</VALUE></PROPERTY>\n", i, i);
+      append(&buf, &len, &max, tmp);
+      for (p = 0; p < properties; p++) {
+         switch (p % 5) {
+         case 0:
+            sprintf(tmp, "<PROPERTY NAME=\"Counter%d\" TYPE=\"uint64\">"
+                    "<VALUE>%llu</VALUE></PROPERTY>\n",
+                    p, 1000000007ULL * (i + 1) + p);
+            break;
+         case 1:
+            sprintf(tmp, "<PROPERTY NAME=\"Caption%d\" TYPE=\"string\">"
+                    "<VALUE>Element %d &amp; property %d</VALUE></PROPERTY>\n",
+                    p, i, p);
+            break;
+         case 2:
+            sprintf(tmp, "<PROPERTY NAME=\"Enabled%d\" TYPE=\"boolean\">"
+                    "<VALUE>%s</VALUE></PROPERTY>\n",
+                    p, (i + p) % 2 ? "TRUE" : "FALSE");
+            break;
+         case 3:
+            sprintf(tmp, "<PROPERTY NAME=\"Changed%d\" TYPE=\"datetime\">"
+                    "<VALUE>20070315%02d%02d%02d.%06d+060</VALUE></PROPERTY>\n",
+                    p, i % 24, p % 60, i % 60, i % 1000000);
+            break;
+         default:
+            sprintf(tmp, "<PROPERTY.ARRAY NAME=\"Ratios%d\" TYPE=\"real64\">"
+                    "<VALUE.ARRAY><VALUE>%d.25</VALUE><VALUE>-%d.5E3</VALUE>"
+                    "</VALUE.ARRAY></PROPERTY.ARRAY>\n", p, i, p);
+            break;
+         }
+         append(&buf, &len, &max, tmp);
+      }
+      append(&buf, &len, &max, "</INSTANCE>\n</VALUE.NAMEDINSTANCE>\n");
+   }
+   append(&buf, &len, &max,
+          "</IRETURNVALUE>\n"
+          "</IMETHODRESPONSE>\n"
+          "</SIMPLERSP>\n"
+          "</MESSAGE>\n"
+          "</CIM>\n");
+   return buf;
+}
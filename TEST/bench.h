@@ -0,0 +1,28 @@
+/*
+ * bench.h
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Helpers shared by the benchmark programs
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/* wall clock in seconds */
+double benchNow();
+
+/* contents of a recorded response, NULL if it can't be read */
+char *benchReadFile(const char *name);
+
+/* a synthetic EnumerateInstances response */
+char *benchEnumInstancesResponse(int instances, int properties);
+
+#endif
@@ -0,0 +1,139 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "cmcimacs.h"
+
+/*
+ * getInstance of N instances, one request after the other and batched in
+ * one multiple operation request: round trips are counted as connection
+ * leases, i.e. requests posted
+ * usage: bench_batch [number of instances] [repetitions]
+ */
+
+static long msecs(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) * 1000 + (end.tv_usec - start->tv_usec) / 1000;
+}
+
+static CIMCUint64 roundTrips(CIMCEnv *ce)
+{
+    return ce->ft->getCounter(ce, CIMC_CNT_POOL_HITS, NULL) +
+           ce->ft->getCounter(ce, CIMC_CNT_POOL_MISSES, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+CIMCEnv *ce;
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CIMCObjectPath **cop;
+CIMCClient *client = NULL;
+CIMCBatch *bt;
+CIMCInstance *inst;
+CIMCValue key;
+CIMCData data;
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+int i, r, n = argc > 1 ? atoi(argv[1]) : 20, reps = argc > 2 ? atoi(argv[2]) : 10;
+int failed = 0;
+CIMCUint64 trips;
+struct timeval start;
+long seqTime, batchTime;
+
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+
+    printf(" Benchmarking batched getInstance \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",0,&rc,&msg);
+    if(ce == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+
+    client = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    if (client == NULL) {
+	printf("Coudn't connect to the server. Check if sfcb is running.\n");
+	return 1;
+    }
+
+    cop = (CIMCObjectPath**)malloc(n * sizeof(CIMCObjectPath*));
+    for (i = 0; i < n; i++) {
+       cop[i] = ce->ft->newObjectPath(ce, "root/cimv2", "Test_Class" , &status);
+       key.uint32 = i;
+       cop[i]->ft->addKey(cop[i], "Id", &key, CIMC_uint32);
+    }
+
+    /* one request per instance */
+    trips = roundTrips(ce);
+    gettimeofday(&start, NULL);
+    for (r = 0; r < reps; r++) {
+       for (i = 0; i < n; i++) {
+          inst = client->ft->getInstance(client, cop[i], 0, NULL, &status);
+          if (status.rc) {
+             if (status.msg) CMRelease(status.msg);
+             failed++;
+          }
+          if (inst) inst->ft->release(inst);
+       }
+    }
+    seqTime = msecs(&start);
+    printf(" sequential: %d x %d getInstance, %llu round trips, %ld ms\n",
+           reps, n, roundTrips(ce) - trips, seqTime);
+
+    /* all instances in one request */
+    trips = roundTrips(ce);
+    gettimeofday(&start, NULL);
+    for (r = 0; r < reps; r++) {
+       bt = ce->ft->newBatch(ce, client, &status);
+       for (i = 0; i < n; i++)
+          bt->ft->getInstance(bt, cop[i], 0, NULL, &status);
+       status = bt->ft->execute(bt);
+       if (status.rc) {
+          printf("  ERROR received from execute status.rc = %d\n",status.rc) ;
+          if (status.msg) {
+             printf("  ERROR msg = %s\n",CMGetCharPtr(status.msg)) ;
+             CMRelease(status.msg);
+          }
+       }
+       for (i = 0; i < n; i++) {
+          data = bt->ft->getResult(bt, i, &status);
+          if (status.rc || data.type != CIMC_instance) {
+             if (status.msg) CMRelease(status.msg);
+             failed++;
+          }
+       }
+       bt->ft->release(bt);
+    }
+    batchTime = msecs(&start);
+    printf(" batched:    %d x %d getInstance, %llu round trips, %ld ms\n",
+           reps, n, roundTrips(ce) - trips, batchTime);
+    printf(" %d failed\n", failed);
+
+    for (i = 0; i < n; i++)
+       cop[i]->ft->release(cop[i]);
+    free(cop);
+    if(client) client->ft->release(client);
+    if(ce) ReleaseCIMCEnv(ce);
+
+    return failed != 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * bench_convert.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Collects the numeric property and key values of an EnumerateInstances
+ *    response, plus a set of edge cases, converts them with str2CMPIValue
+ *    and getKeyValueTypePtr and checks the results against strtoull(),
+ *    strtoll(), strtod() and strtof(). Reports the time per value of the
+ *    conversion and of the sscanf() it replaces. The checks are repeated
+ *    with a locale using a decimal comma if one is installed.
+ *
+ *    usage: bench_convert [-f recorded-response] [-n instances]
+ *                         [-i iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <locale.h>
+#include <limits.h>
+
+#include "cmcidt.h"
+#include "cmcift.h"
+#include "cmcimacs.h"
+#include "native.h"
+#include "bench.h"
+
+typedef struct {
+   CMPIType type;          /* 0 for a numeric key */
+   char    *text;
+   double   real64;        /* strtod() and strtof() in the C locale */
+   float    real32;
+} Sample;
+
+static Sample *corpus;
+static int     count, size;
+
+static const struct {
+   const char *name;
+   CMPIType    type;
+} types[] = {
+   { "uint8", CMPI_uint8 },   { "sint8", CMPI_sint8 },
+   { "uint16", CMPI_uint16 }, { "sint16", CMPI_sint16 },
+   { "uint32", CMPI_uint32 }, { "sint32", CMPI_sint32 },
+   { "uint64", CMPI_uint64 }, { "sint64", CMPI_sint64 },
+   { "real32", CMPI_real32 }, { "real64", CMPI_real64 }
+};
+
+static const char *edgeCases[] = {
+   "uint8", "255", "uint8", "256", "uint8", "0", "sint8", "-128",
+   "sint8", "127", "sint8", "-129", "uint16", "65535", "sint16", "-32768",
+   "uint32", "4294967295", "uint32", "4294967296", "sint32", "-2147483648",
+   "sint32", "2147483648", "uint64", "18446744073709551615",
+   "uint64", "18446744073709551616", "uint64", "99999999999999999999",
+   "uint64", "000000000000000000000000042", "uint64", "-1",
+   "sint64", "-9223372036854775808", "sint64", "9223372036854775807",
+   "sint64", "-9223372036854775809", "sint64", "+17", "uint32", " 42 ",
+   "real64", "3.175e+00", "real64", "0.1", "real64", "-0", "real64", "1e23",
+   "real64", "9007199254740993", "real64", "2.2250738585072014e-308",
+   "real64", "4.9e-324", "real64", "1.7976931348623157e308",
+   "real64", "123456789012345678901234567890", "real64", ".5",
+   "real64", "5.", "real64", "1E-5", "real64", "0.30000000000000004",
+   "real64", "1e400", "real64", "INF", "real32", "3.4028235e38",
+   "real32", "1.17549435e-38", "real32", "0.1", "real32", "16777217",
+   "real32", "3.14159265358979", "real32", "-7.5e-3", NULL
+};
+
+static void add(CMPIType type, const char *text, size_t len)
+{
+   if (count == size) {
+      size = size ? size * 2 : 1024;
+      corpus = realloc(corpus, size * sizeof(Sample));
+   }
+   corpus[count].type = type;
+   corpus[count].text = malloc(len + 1);
+   memcpy(corpus[count].text, text, len);
+   corpus[count].text[len] = 0;
+   corpus[count].real64 = strtod(corpus[count].text, NULL);
+   corpus[count].real32 = strtof(corpus[count].text, NULL);
+   count++;
+}
+
+static CMPIType typeOf(const char *name, size_t len)
+{
+   unsigned int i;
+
+   for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+      if (strlen(types[i].name) == len && strncmp(types[i].name, name, len) == 0)
+         return types[i].type;
+   return CMPI_null;
+}
+
+/* the VALUEs of numeric PROPERTY and PROPERTY.ARRAY elements and numeric
+   KEYVALUEs, which don't need unescaping */
+static void collect(const char *response)
+{
+   const char *p = response, *t, *end, *v, *e;
+   CMPIType type;
+
+   while ((p = strstr(p, "<PROPERTY")) != NULL) {
+      end = strstr(p, "</PROPERTY");
+      t = strstr(p, "TYPE=\"");
+      if (end == NULL)
+         break;
+      if (t && t < end && (type = typeOf(t + 6, strcspn(t + 6, "\""))) != CMPI_null) {
+         for (v = strstr(p, "<VALUE>"); v && v < end; v = strstr(e, "<VALUE>")) {
+            e = strstr(v, "</VALUE>");
+            add(type, v + 7, e - v - 7);
+         }
+      }
+      p = end + 1;
+   }
+   for (p = response; (p = strstr(p, "VALUETYPE=\"numeric\">")) != NULL; p = e) {
+      p += 20;
+      e = strchr(p, '<');
+      add(0, p, e - p);
+   }
+}
+
+static CMPIValue convert(Sample *s, CMPIType *type)
+{
+   CMPIValue v;
+
+   if (s->type == 0) {
+      getKeyValueTypePtr("numeric", s->text, NULL, &v, type);
+      return v;
+   }
+   *type = s->type;
+   return str2CMPIValue(s->type, s->text, NULL);
+}
+
+/* the previous conversion, for the timing */
+static void convertSscanf(Sample *s, CMPIValue *v)
+{
+   switch (s->type) {
+   case 0:
+      if (s->text[0] == '-' || s->text[0] == '+')
+         sscanf(s->text, "%lld", &v->sint64);
+      else
+         sscanf(s->text, "%llu", &v->uint64);
+      break;
+   case CMPI_real32: sscanf(s->text, "%f", &v->real32); break;
+   case CMPI_real64: sscanf(s->text, "%lf", &v->real64); break;
+   case CMPI_sint64: sscanf(s->text, "%lld", &v->sint64); break;
+   case CMPI_uint64: sscanf(s->text, "%llu", &v->uint64); break;
+   case CMPI_sint32: sscanf(s->text, "%ld", &v->sint32); break;
+   case CMPI_uint32: sscanf(s->text, "%lu", &v->uint32); break;
+   case CMPI_sint16: sscanf(s->text, "%hd", &v->sint16); break;
+   case CMPI_uint16: sscanf(s->text, "%hu", &v->uint16); break;
+   default:          sscanf(s->text, "%lu", &v->uint32); break;
+   }
+}
+
+static unsigned long long umax(CMPIType type)
+{
+   switch (type) {
+   case CMPI_uint8:  return 0xff;
+   case CMPI_uint16: return 0xffff;
+   case CMPI_uint32: return 0xffffffff;
+   case CMPI_sint8:  return 0x7f;
+   case CMPI_sint16: return 0x7fff;
+   case CMPI_sint32: return 0x7fffffff;
+   case CMPI_sint64: return LLONG_MAX;
+   }
+   return ULLONG_MAX;
+}
+
+/* out of range integers saturate at the bounds of their type */
+static int check(Sample *s)
+{
+   CMPIType type;
+   CMPIValue v = convert(s, &type);
+   unsigned long long u, max;
+   long long l;
+
+   if (s->type == 0 && type != ((s->text[0] == '-' || s->text[0] == '+') ?
+                                CMPI_sint64 : CMPI_uint64))
+      return 1;
+
+   switch (type) {
+   case CMPI_real32:
+      return memcmp(&s->real32, &v.real32, sizeof(float)) != 0;
+   case CMPI_real64:
+      return memcmp(&s->real64, &v.real64, sizeof(double)) != 0;
+   case CMPI_uint8:
+   case CMPI_uint16:
+   case CMPI_uint32:
+   case CMPI_uint64:
+      max = umax(type);
+      u = strchr(s->text, '-') ? 0 : strtoull(s->text, NULL, 10);
+      if (u > max)
+         u = max;
+      return u != (type == CMPI_uint8 ? v.uint8 : type == CMPI_uint16 ? v.uint16 :
+                   type == CMPI_uint32 ? v.uint32 : v.uint64);
+   default:
+      max = umax(type);
+      l = strtoll(s->text, NULL, 10);
+      if (l > (long long) max)
+         l = max;
+      if (l < -(long long) max - 1)
+         l = -(long long) max - 1;
+      return l != (type == CMPI_sint8 ? v.sint8 : type == CMPI_sint16 ? v.sint16 :
+                   type == CMPI_sint32 ? v.sint32 : v.sint64);
+   }
+}
+
+static int checkAll(const char *label)
+{
+   int i, failed = 0;
+
+   for (i = 0; i < count; i++) {
+      if (check(corpus + i)) {
+         printf("%s: %s not converted correctly\n", label, corpus[i].text);
+         failed++;
+      }
+   }
+   return failed;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *file = NULL, *comma[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", NULL };
+   char       *response;
+   CMPIValue   v;
+   CMPIType    type;
+   double      start, t1, t2;
+   int         instances = 2000, iterations = 20, i, n, c, failed = 0;
+
+   while ((c = getopt(argc, argv, "f:n:i:")) != -1) {
+      switch (c) {
+      case 'f': file = optarg; break;
+      case 'n': instances = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-f recorded-response] [-n instances] "
+                 "[-i iterations]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   response = file ? benchReadFile(file) :
+                     benchEnumInstancesResponse(instances, 20);
+   if (response == NULL) {
+      fprintf(stderr, "can't read %s\n", file);
+      return 1;
+   }
+   collect(response);
+   for (i = 0; edgeCases[i]; i += 2)
+      add(typeOf(edgeCases[i], strlen(edgeCases[i])), edgeCases[i + 1],
+          strlen(edgeCases[i + 1]));
+
+   failed += checkAll("C locale");
+   for (i = 0; comma[i]; i++) {
+      if (setlocale(LC_NUMERIC, comma[i])) {
+         failed += checkAll(comma[i]);
+         setlocale(LC_NUMERIC, "C");
+         break;
+      }
+   }
+   if (comma[i] == NULL)
+      printf("no locale with a decimal comma, skipped\n");
+
+   start = benchNow();
+   for (n = 0; n < iterations; n++)
+      for (i = 0; i < count; i++)
+         v = convert(corpus + i, &type);
+   t1 = benchNow() - start;
+
+   start = benchNow();
+   for (n = 0; n < iterations; n++)
+      for (i = 0; i < count; i++)
+         convertSscanf(corpus + i, &v);
+   t2 = benchNow() - start;
+
+   printf("%d values, %d iterations\n", count, iterations);
+   printf("str2CMPIValue: %7.1f ns per value\n", t1 / iterations / count * 1e9);
+   printf("sscanf:        %7.1f ns per value\n", t2 / iterations / count * 1e9);
+   printf("%d failed\n", failed);
+
+   for (i = 0; i < count; i++)
+      free(corpus[i].text);
+   free(corpus);
+   free(response);
+   return failed != 0;
+}
@@ -0,0 +1,349 @@
+/*
+ * bench_datetime.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Checks the datetime conversions in several timezones against
+ *    localtime_r() and timegm(), and in UTC, where it was right, against
+ *    the previous mktime() based conversion. Then reports the time per
+ *    conversion of both, in 1 and in several threads.
+ *
+ *    usage: bench_datetime [-n values] [-t threads]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cmcidt.h"
+#include "cmcift.h"
+#include "cmcimacs.h"
+#include "native.h"
+#include "bench.h"
+
+static const char *zones[] = {
+   "UTC", "America/New_York", "Europe/Berlin", "Asia/Kolkata",
+   "America/St_Johns", "Australia/Lord_Howe", "Pacific/Chatham", NULL
+};
+
+static int values = 100000;
+static CMPIUint64 *times;
+static char (*strings)[26];
+
+/* the previous conversions, for the comparison in UTC and the timing */
+static CMPIUint64 oldChars2bin(const char *string)
+{
+   CMPIUint64 msecs, secs;
+   CMPIBoolean interval;
+   char *str;
+
+   str = strdup(string);
+   interval = (str[21] == ':');
+   str[21] = 0;
+   msecs = strtoull(str + 15, NULL, 10);
+   str[14] = 0;
+   secs = strtoull(str + 12, NULL, 10);
+   str[12] = 0;
+   secs += strtoull(str + 10, NULL, 10) * 60ULL;
+   str[10] = 0;
+   secs += strtoull(str + 8, NULL, 10) * 60ULL * 60ULL;
+   str[8] = 0;
+   if (interval) {
+      secs += strtoull(str, NULL, 10) * 60ULL * 60ULL * 24ULL;
+      msecs = msecs + (secs * 1000000ULL);
+   }
+   else {
+      struct tm tmp;
+      memset(&tmp, 0, sizeof(struct tm));
+      tzset();
+      tmp.tm_gmtoff = timezone;
+      tmp.tm_isdst = daylight;
+      tmp.tm_mday = atoi(str + 6);
+      str[6] = 0;
+      tmp.tm_mon = atoi(str + 4) - 1;
+      str[4] = 0;
+      tmp.tm_year = atoi(str) - 1900;
+      msecs = msecs + (secs * 1000000ULL);
+      msecs += (CMPIUint64) mktime(&tmp) * 1000000ULL;
+   }
+   free(str);
+   return msecs;
+}
+
+static void oldBin2chars(CMPIUint64 msecs, CMPIBoolean interval, char *str_time)
+{
+   time_t secs = msecs / 1000000ULL;
+   unsigned long usecs = msecs % 1000000ULL;
+
+   if (interval) {
+      unsigned long long useconds, seconds, mins, hrs, days;
+      seconds = msecs / 1000000ULL;
+      useconds = msecs % 1000000ULL;
+      mins = seconds / 60ULL;
+      seconds %= 60ULL;
+      hrs = mins / 60ULL;
+      mins %= 60ULL;
+      days = hrs / 24ULL;
+      hrs %= 24ULL;
+      sprintf(str_time, "%8.8llu%2.2llu%2.2llu%2.2llu.%6.6llu:000",
+              days, hrs, mins, seconds, useconds);
+   }
+   else {
+      struct tm tm_time;
+      char us_utc_time[11];
+      localtime_r(&secs, &tm_time);
+      tzset();
+      snprintf(us_utc_time, 11, "%6.6ld%+4.3ld",
+               usecs, (daylight != 0) * 60 - timezone / 60);
+      strftime(str_time, 26, "%Y%m%d%H%M%S.", &tm_time);
+      strcat(str_time, us_utc_time);
+   }
+}
+
+/* what the conversions have to give */
+static void refBin2chars(CMPIUint64 usecs, char *str)
+{
+   time_t secs = usecs / 1000000;
+   struct tm tm;
+   long offset;
+
+   localtime_r(&secs, &tm);
+   offset = tm.tm_gmtoff / 60;
+   strftime(str, 26, "%Y%m%d%H%M%S.", &tm);
+   sprintf(str + 15, "%06lu%c%03ld", (unsigned long) (usecs % 1000000),
+           offset < 0 ? '-' : '+', offset < 0 ? -offset : offset);
+}
+
+static CMPIUint64 refChars2bin(const char *str)
+{
+   struct tm tm;
+   long offset;
+
+   memset(&tm, 0, sizeof(tm));
+   sscanf(str, "%4d%2d%2d%2d%2d%2d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+          &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+   tm.tm_year -= 1900;
+   tm.tm_mon--;
+   offset = atol(str + 22) * 60;
+   if (str[21] == '-')
+      offset = -offset;
+   return (CMPIUint64) (timegm(&tm) - offset) * 1000000 + atol(str + 15);
+}
+
+static CMPIUint64 newChars2bin(const char *str)
+{
+   CMPIDateTime *dt = native_new_CMPIDateTime_fromChars(str, NULL);
+   CMPIUint64 t = CMGetBinaryFormat(dt, NULL);
+
+   CMRelease(dt);
+   return t;
+}
+
+static void newBin2chars(CMPIUint64 t, CMPIBoolean interval, char *str)
+{
+   CMPIDateTime *dt = native_new_CMPIDateTime_fromBinary(t, interval, NULL);
+   CMPIString *s = CMGetStringFormat(dt, NULL);
+
+   strcpy(str, CMGetCharPtr(s));
+   CMRelease(s);
+   CMRelease(dt);
+}
+
+static unsigned long long rnd(unsigned long long *seed)
+{
+   *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+   return *seed >> 17;
+}
+
+static int checkZone(const char *zone)
+{
+   unsigned long long seed = 4711;
+   CMPIUint64 t, now = (CMPIUint64) time(NULL) * 1000000;
+   char s1[26], s2[26];
+   int i, failed = 0;
+
+   setenv("TZ", zone, 1);
+   native_datetime_refresh_timezone();
+
+   for (i = 0; i < 20000; i++) {
+      /* around now, where the cached offset is used, and 1970 to 2100 */
+      if (i % 2)
+         t = now - 400 * 86400000000ULL + rnd(&seed) % (800 * 86400000000ULL);
+      else
+         t = rnd(&seed) % 4102444800000000ULL;
+      newBin2chars(t, 0, s1);
+      refBin2chars(t, s2);
+      if (strcmp(s1, s2)) {
+         printf("%s: %llu gives %s, not %s\n", zone, t, s1, s2);
+         failed++;
+      }
+      if (newChars2bin(s2) != t || refChars2bin(s2) != t) {
+         printf("%s: %s gives %llu, not %llu\n", zone, s2, newChars2bin(s2), t);
+         failed++;
+      }
+
+      /* intervals don't depend on the timezone */
+      t = rnd(&seed) % 8640000000000000000ULL;
+      newBin2chars(t, 1, s1);
+      oldBin2chars(t, 1, s2);
+      if (strcmp(s1, s2) || newChars2bin(s1) != t) {
+         printf("%s: interval %llu gives %s, not %s\n", zone, t, s1, s2);
+         failed++;
+      }
+   }
+
+   /* a time with an offset other than the local one */
+   if (newChars2bin("20070315120000.000001-300") != 1173978000000001ULL ||
+       newChars2bin("19991231233000.500000+330") != 946663200500000ULL) {
+      printf("%s: foreign offsets not converted correctly\n", zone);
+      failed++;
+   }
+   return failed;
+}
+
+/* the only zone the previous conversion got right */
+static int checkOld()
+{
+   unsigned long long seed = 42;
+   CMPIUint64 t;
+   char s1[26], s2[26];
+   int i, failed = 0;
+
+   setenv("TZ", "UTC", 1);
+   native_datetime_refresh_timezone();
+   for (i = 0; i < 20000; i++) {
+      t = rnd(&seed) % 4102444800000000ULL;
+      newBin2chars(t, 0, s1);
+      oldBin2chars(t, 0, s2);
+      if (strcmp(s1, s2) || newChars2bin(s1) != oldChars2bin(s2)) {
+         printf("UTC: %llu gives %s, previously %s\n", t, s1, s2);
+         failed++;
+      }
+   }
+   return failed;
+}
+
+static void *convertNew(void *arg)
+{
+   CMPIUint64 t, sum = 0;
+   char str[26];
+   int i;
+
+   for (i = 0; i < values; i++) {
+      t = times[i];
+      newBin2chars(t, 0, str);
+      sum += newChars2bin(str);
+   }
+   return (void *) (long) sum;
+}
+
+static void *convertOld(void *arg)
+{
+   CMPIUint64 t, sum = 0;
+   char str[26];
+   int i;
+
+   for (i = 0; i < values; i++) {
+      t = times[i];
+      oldBin2chars(t, 0, str);
+      sum += oldChars2bin(str);
+   }
+   return (void *) (long) sum;
+}
+
+static double run(void *(*fn)(void *), int threads)
+{
+   pthread_t tid[64];
+   double start = benchNow();
+   int i;
+
+   for (i = 0; i < threads; i++)
+      pthread_create(tid + i, NULL, fn, NULL);
+   for (i = 0; i < threads; i++)
+      pthread_join(tid[i], NULL);
+   return (benchNow() - start) / threads / values * 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+   CMPIDateTime **dts, *dt;
+   unsigned long long seed = 1;
+   volatile CMPIUint64 sum = 0;
+   double start, tNew, tOld;
+   int threads = 4, i, c, failed = 0;
+
+   while ((c = getopt(argc, argv, "n:t:")) != -1) {
+      switch (c) {
+      case 'n': values = atoi(optarg); break;
+      case 't': threads = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-n values] [-t threads]\n", argv[0]);
+         return 1;
+      }
+   }
+   if (threads < 1 || threads > 64)
+      threads = 4;
+
+   for (i = 0; zones[i]; i++)
+      failed += checkZone(zones[i]);
+   failed += checkOld();
+
+   setenv("TZ", "Europe/Berlin", 1);
+   native_datetime_refresh_timezone();
+   times = malloc(values * sizeof(CMPIUint64));
+   strings = malloc(values * sizeof(*strings));
+   dts = malloc(values * sizeof(CMPIDateTime *));
+   for (i = 0; i < values; i++) {
+      times[i] = (CMPIUint64) time(NULL) * 1000000 - rnd(&seed) % 86400000000ULL;
+      refBin2chars(times[i], strings[i]);
+      dts[i] = native_new_CMPIDateTime_fromChars(strings[i], NULL);
+   }
+
+   printf("%d values in %s\n", values, getenv("TZ"));
+   start = benchNow();
+   for (i = 0; i < values; i++)
+      sum += CMGetBinaryFormat(dts[i], NULL);
+   tNew = (benchNow() - start) / values * 1e9;
+   start = benchNow();
+   for (i = 0; i < values; i++)
+      sum += oldChars2bin(strings[i]);
+   tOld = (benchNow() - start) / values * 1e9;
+   printf("string to binary:  %7.1f ns, previously %7.1f ns\n", tNew, tOld);
+
+   start = benchNow();
+   for (i = 0; i < values; i++) {
+      dt = native_new_CMPIDateTime_fromBinary(times[i], 0, NULL);
+      CMRelease(dt);
+   }
+   tNew = (benchNow() - start) / values * 1e9;
+   start = benchNow();
+   for (i = 0; i < values; i++)
+      oldBin2chars(times[i], 0, strings[i]);
+   tOld = (benchNow() - start) / values * 1e9;
+   printf("binary to string:  %7.1f ns, previously %7.1f ns "
+          "(with allocating the datetime)\n", tNew, tOld);
+
+   tNew = run(convertNew, threads);
+   tOld = run(convertOld, threads);
+   printf("both, %d threads:  %7.1f ns, previously %7.1f ns\n",
+          threads, tNew, tOld);
+   printf("%d failed\n", failed);
+
+   for (i = 0; i < values; i++)
+      CMRelease(dts[i]);
+   free(dts);
+   free(strings);
+   free(times);
+   return failed != 0;
+}
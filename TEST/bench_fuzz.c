@@ -0,0 +1,418 @@
+/*
+ * bench_fuzz.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Feeds mutants of an EnumerateInstances response, an
+ *    EnumerateInstanceNames response with reference keys, an error
+ *    response and an ExportIndication request - truncated, with bytes
+ *    changed, ranges cut out or repeated, markup spliced in from
+ *    elsewhere - to scanCimXmlResponse, to the incremental stream parser and to a
+ *    running indication listener. Every mutant has to come back as a
+ *    result or as an error without taking down the process, and the
+ *    listener has to account for every request as delivered or malformed
+ *    and still deliver a valid indication at the end. The responses
+ *    themselves have to stream into the same objects in chunks of any
+ *    size. Reports the time per mutant.
+ *
+ *    usage: bench_fuzz [-n mutants] [-r seed] [-f recorded-response]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "cimc.h"
+#include "nativeCimXml.h"
+#include "cimXmlParser.h"
+#include "bench.h"
+
+extern CIMCEnv *_Create_XML_Env(const char *id, unsigned int options,
+                                int *rc, char **msg);
+
+static const char errorResponse[] =
+   "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+   "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+   "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+   "<SIMPLERSP>\n"
+   "<IMETHODRESPONSE NAME=\"GetInstance\">\n"
+   "<ERROR CODE=\"6\" DESCRIPTION=\"Instance not found &amp; gone\"/>\n"
+   "</IMETHODRESPONSE>\n"
+   "</SIMPLERSP>\n"
+   "</MESSAGE>\n"
+   "</CIM>\n";
+
+/* association instance names, whose keys are references to INSTANCENAMEs */
+static const char namesResponse[] =
+   "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+   "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+   "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+   "<SIMPLERSP>\n"
+   "<IMETHODRESPONSE NAME=\"EnumerateInstanceNames\">\n"
+   "<IRETURNVALUE>\n"
+   "<INSTANCENAME CLASSNAME=\"CIM_SystemDevice\">\n"
+   "<KEYBINDING NAME=\"GroupComponent\"><VALUE.REFERENCE><INSTANCEPATH>"
+   "<NAMESPACEPATH><HOST>localhost</HOST><LOCALNAMESPACEPATH>"
+   "<NAMESPACE NAME=\"root\"/><NAMESPACE NAME=\"cimv2\"/>"
+   "</LOCALNAMESPACEPATH></NAMESPACEPATH>"
+   "<INSTANCENAME CLASSNAME=\"CIM_ComputerSystem\">"
+   "<KEYBINDING NAME=\"Name\"><KEYVALUE VALUETYPE=\"string\">fuzz</KEYVALUE>"
+   "</KEYBINDING></INSTANCENAME></INSTANCEPATH></VALUE.REFERENCE></KEYBINDING>\n"
+   "<KEYBINDING NAME=\"PartComponent\"><VALUE.REFERENCE>"
+   "<INSTANCENAME CLASSNAME=\"CIM_LogicalDisk\">"
+   "<KEYBINDING NAME=\"DeviceID\"><KEYVALUE VALUETYPE=\"string\">sda</KEYVALUE>"
+   "</KEYBINDING></INSTANCENAME></VALUE.REFERENCE></KEYBINDING>\n"
+   "</INSTANCENAME>\n"
+   "<INSTANCENAME CLASSNAME=\"CIM_SystemDevice\">\n"
+   "<KEYBINDING NAME=\"GroupComponent\"><VALUE.REFERENCE>"
+   "<INSTANCENAME CLASSNAME=\"CIM_ComputerSystem\">"
+   "<KEYBINDING NAME=\"Name\"><KEYVALUE VALUETYPE=\"string\">fuzz</KEYVALUE>"
+   "</KEYBINDING></INSTANCENAME></VALUE.REFERENCE></KEYBINDING>\n"
+   "<KEYBINDING NAME=\"PartComponent\"><VALUE.REFERENCE>"
+   "<INSTANCENAME CLASSNAME=\"CIM_LogicalDisk\">"
+   "<KEYBINDING NAME=\"DeviceID\"><KEYVALUE VALUETYPE=\"string\">sdb</KEYVALUE>"
+   "</KEYBINDING></INSTANCENAME></VALUE.REFERENCE></KEYBINDING>\n"
+   "</INSTANCENAME>\n"
+   "</IRETURNVALUE>\n"
+   "</IMETHODRESPONSE>\n"
+   "</SIMPLERSP>\n"
+   "</MESSAGE>\n"
+   "</CIM>\n";
+
+static const char indication[] =
+   "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+   "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+   "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+   "<SIMPLEEXPREQ>\n"
+   "<EXPMETHODCALL NAME=\"ExportIndication\">\n"
+   "<EXPPARAMVALUE NAME=\"NewIndication\">\n"
+   "<INSTANCE CLASSNAME=\"CIM_AlertIndication\">\n"
+   "<PROPERTY NAME=\"IndicationIdentifier\" TYPE=\"string\">"
+   "<VALUE>fuzz-4711</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"AlertType\" TYPE=\"uint16\"><VALUE>2</VALUE></PROPERTY>\n"
+   "<PROPERTY.ARRAY NAME=\"Severities\" TYPE=\"uint16\"><VALUE.ARRAY>"
+   "<VALUE>3</VALUE><VALUE>5</VALUE></VALUE.ARRAY></PROPERTY.ARRAY>\n"
+   "<!-- a comment -->\n"
+   "<PROPERTY.REFERENCE NAME=\"Source\" REFERENCECLASS=\"CIM_System\">"
+   "<VALUE.REFERENCE><INSTANCENAME CLASSNAME=\"CIM_System\">"
+   "<KEYBINDING NAME=\"Name\"><KEYVALUE VALUETYPE=\"string\">fuzz</KEYVALUE>"
+   "</KEYBINDING></INSTANCENAME></VALUE.REFERENCE></PROPERTY.REFERENCE>\n"
+   "<PROPERTY NAME=\"IndicationTime\" TYPE=\"datetime\">"
+   "<VALUE>20070315120000.000000+060</VALUE></PROPERTY>\n"
+   "</INSTANCE>\n"
+   "</EXPPARAMVALUE>\n"
+   "</EXPMETHODCALL>\n"
+   "</SIMPLEEXPREQ>\n"
+   "</MESSAGE>\n"
+   "</CIM>\n";
+
+static const char *markup[] = {
+   "<", ">", "/>", "</", "\"", "=", "&amp;", "&#", "<VALUE>", "</VALUE>",
+   "<INSTANCE>", "<PROPERTY NAME=\"x\">", "<VALUE.ARRAY>", "<KEYBINDING",
+   "<!--", "<IRETURNVALUE>", "</CIM>", "<ERROR CODE=\"1\"", "TYPE=\"uint8\"",
+   "\xff\xfe", NULL
+};
+
+static unsigned long long seed = 4711;
+static long mutants, rejected, parsed, failed;
+
+static unsigned int rnd(unsigned int n)
+{
+   seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+   return (unsigned int) (seed >> 33) % n;
+}
+
+/* a mutant of len bytes of src in dst, which has room for 2 * len + 256 */
+static size_t mutate(const char *src, size_t len, char *dst)
+{
+   size_t at = rnd(len), n = 1 + rnd(len - at < 64 ? len - at : 64), l, i;
+   const char *m;
+
+   memcpy(dst, src, len + 1);
+   switch (rnd(6)) {
+   case 0:                      /* truncated */
+      len = at;
+      break;
+   case 1:                      /* bytes changed */
+      for (i = rnd(4); i < 4; i++)
+         dst[rnd(len)] = "<>/\"=&; \x80\x01"[rnd(10)];
+      break;
+   case 2:                      /* a range cut out */
+      memmove(dst + at, dst + at + n, len - at - n);
+      len -= n;
+      break;
+   case 3:                      /* a range repeated */
+      memmove(dst + at + n, dst + at, len - at);
+      len += n;
+      break;
+   case 4:                      /* markup inserted */
+      for (i = 0; markup[i]; i++);
+      m = markup[rnd(i)];
+      l = strlen(m);
+      memmove(dst + at + l, dst + at, len - at);
+      memcpy(dst + at, m, l);
+      len += l;
+      break;
+   default:                     /* a tag replaced by another one */
+      if ((m = strchr(src + at, '<')) != NULL) {
+         at = m - src;
+         m = strchr(src + rnd(len), '<');
+         if (m && (l = strcspn(m + 1, "<")) < 200) {
+            n = strcspn(dst + at + 1, "<") + 1;
+            memmove(dst + at + l + 1, dst + at + n, len - at - n);
+            memcpy(dst + at, m, l + 1);
+            len = len - n + l + 1;
+         }
+      }
+   }
+   dst[len] = 0;
+   return len;
+}
+
+/* returns the number of objects, -1 if the response is rejected */
+static int parse(char *xml, ParserHeap *heap)
+{
+   ResponseHdr rh = scanCimXmlResponse(xml, NULL, heap);
+   int objects = rh.errCode ? -1 : (int) CMGetArrayCount(rh.rvArray, NULL);
+
+   if (rh.errCode)
+      rejected++;
+   else
+      parsed++;
+   free(rh.description);
+   free(rh.enumerationContext);
+   if (rh.outArgs)
+      CMRelease(rh.outArgs);
+   CMRelease(rh.rvArray);
+   return objects;
+}
+
+/* feeds xml in chunks of a size, or of random sizes given 0, returns the
+   number of objects as parse() does */
+static int parseStream(const char *xml, size_t len, size_t chunk)
+{
+   XmlStream *xs = newXmlStream(NULL);
+   size_t at, n;
+   int objects;
+
+   for (at = 0; at < len; at += n) {
+      n = chunk ? chunk : 1 + rnd(512);
+      if (n > len - at)
+         n = len - at;
+      xmlStreamFeed(xs, xml + at, n);
+   }
+   xmlStreamEnd(xs);
+   objects = xs->errCode ? -1 : (int) CMGetArrayCount(xs->rvArray, NULL);
+   releaseXmlStream(xs);
+   return objects;
+}
+
+/* the listener */
+
+static int port;
+static long delivered;
+
+static void deliver(CIMCInstance *inst)
+{
+   __sync_fetch_and_add(&delivered, 1);
+   inst->ft->release(inst);
+}
+
+static int connectListener()
+{
+   struct sockaddr_in sin;
+   int fd = socket(PF_INET, SOCK_STREAM, 0);
+
+   memset(&sin, 0, sizeof(sin));
+   sin.sin_family = AF_INET;
+   sin.sin_port = htons(port);
+   sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   if (connect(fd, (struct sockaddr *) &sin, sizeof(sin))) {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/* sends an ExportIndication request with body, 0 if it was acknowledged */
+static int sendIndication(int fd, const char *body, size_t len)
+{
+   char buf[4096];
+   int n, r;
+
+   n = sprintf(buf, "POST /cimom HTTP/1.1\r\n"
+               "Host: localhost\r\n"
+               "Content-Type: application/xml; charset=\"utf-8\"\r\n"
+               "Content-Length: %d\r\n"
+               "CIMExport: MethodRequest\r\n"
+               "CIMExportMethod: ExportIndication\r\n\r\n", (int) len);
+   if (send(fd, buf, n, MSG_NOSIGNAL) != n ||
+       send(fd, body, len, MSG_NOSIGNAL) != (ssize_t) len)
+      return -1;
+   buf[0] = 0;
+   for (n = 0; strstr(buf, "\r\n\r\n") == NULL; n += r) {
+      r = read(fd, buf + n, sizeof(buf) - 1 - n);
+      if (r < 0 && errno == EINTR)
+         r = 0;
+      else if (r <= 0)
+         return -1;
+      buf[n + r] = 0;
+   }
+   return strncmp(buf, "HTTP/1.1 200", 12) != 0;
+}
+
+static long fuzzListener(CIMCEnv *ce, int count, char *mutant)
+{
+   CIMCIndicationListener *il;
+   CIMCStatus st;
+   CIMCUint64 malformed;
+   long sent = 0;
+   size_t len;
+   int fd = -1, i;
+
+   il = ce->ft->newIndicationListener(ce, 0, &port, NULL, deliver, &st);
+   st = il->ft->start(il);
+   if (st.rc) {
+      printf("can't start the listener\n");
+      return 1;
+   }
+   if (port == 0)
+      port = ((struct native_indicationlistener *) il)->port;
+
+   for (i = 0; i <= count; i++) {
+      if (i < count)
+         len = mutate(indication, sizeof(indication) - 1, mutant);
+      else
+         len = strlen(strcpy(mutant, indication));
+      if ((fd < 0 && (fd = connectListener()) < 0) ||
+          sendIndication(fd, mutant, len)) {
+         printf("request %d not acknowledged\n", i);
+         failed++;
+         close(fd);
+         fd = -1;
+         continue;
+      }
+      sent++;
+   }
+   close(fd);
+
+   /* the valid one at the end has to come through */
+   for (i = 0; i < 500; i++) {
+      malformed = il->ft->getCounter(il, CIMC_CNT_LISTENER_MALFORMED, NULL);
+      if (delivered + malformed >= sent)
+         break;
+      usleep(10000);
+   }
+   malformed = il->ft->getCounter(il, CIMC_CNT_LISTENER_MALFORMED, NULL);
+   printf("listener: %ld requests, %ld delivered, %ld malformed\n", sent,
+          delivered, (long) malformed);
+   if (delivered + malformed != sent || delivered == 0 || malformed == 0)
+      failed++;
+
+   il->ft->stop(il);
+   il->ft->release(il);
+   return 0;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *file = NULL, *corpus[4];
+   size_t      lengths[4], len, max = 0, chunks[] = { 16, 64, 200, 4096 };
+   ParserHeap *heap = parser_heap_init();
+   CIMCEnv    *ce;
+   char       *response, *mutant, *msg = NULL;
+   double      start, elapsed;
+   int         count = 20000, n = 0, rc, i, c, objects, k;
+   long        before;
+
+   while ((c = getopt(argc, argv, "n:r:f:")) != -1) {
+      switch (c) {
+      case 'n': count = atoi(optarg); break;
+      case 'r': seed = strtoull(optarg, NULL, 10); break;
+      case 'f': file = optarg; break;
+      default:
+         fprintf(stderr, "usage: %s [-n mutants] [-r seed] "
+                 "[-f recorded-response]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   response = file ? benchReadFile(file) : benchEnumInstancesResponse(20, 12);
+   if (response == NULL) {
+      fprintf(stderr, "can't read %s\n", file);
+      return 1;
+   }
+   corpus[n++] = response;
+   corpus[n++] = namesResponse;
+   corpus[n++] = errorResponse;
+   corpus[n++] = indication;
+   for (i = 0; i < n; i++) {
+      lengths[i] = strlen(corpus[i]);
+      if (lengths[i] > max)
+         max = lengths[i];
+   }
+   mutant = malloc(2 * max + 256);
+
+   /* the originals are fine, and the responses stream into as many
+      objects whichever way they are cut */
+   for (i = 0; i < n; i++) {
+      before = rejected;
+      objects = parse(strcpy(mutant, corpus[i]), heap);
+      if (rejected != before && corpus[i] != errorResponse) {
+         printf("corpus entry %d not parsed\n", i);
+         failed++;
+      }
+      if (corpus[i] != response && corpus[i] != namesResponse)
+         continue;
+      for (k = 0; k < (int) (sizeof(chunks) / sizeof(chunks[0])); k++) {
+         rc = parseStream(corpus[i], lengths[i], chunks[k]);
+         if (rc != objects) {
+            printf("corpus entry %d streamed in %d byte chunks: %d objects, "
+                   "%d expected\n", i, (int) chunks[k], rc, objects);
+            failed++;
+         }
+      }
+   }
+   parsed = rejected = 0;
+
+   start = benchNow();
+   for (mutants = 0; mutants < count; mutants++) {
+      i = rnd(n);
+      len = mutate(corpus[i], lengths[i], mutant);
+      parse(mutant, heap);
+   }
+   elapsed = benchNow() - start;
+   printf("%ld mutants, %ld rejected, %ld parsed, %.1f us per mutant\n",
+          mutants, rejected, parsed, elapsed / mutants * 1e6);
+   if (rejected == 0)
+      failed++;
+
+   for (c = 0; c < count / 10; c++) {
+      i = rnd(n);
+      len = mutate(corpus[i], lengths[i], mutant);
+      parseStream(mutant, len, 0);
+   }
+   printf("%d mutants streamed\n", count / 10);
+
+   ce = _Create_XML_Env("fuzz", 0, &rc, &msg);
+   fuzzListener(ce, count / 20, mutant);
+   ce->ft->release(ce);
+
+   printf("%ld failed\n", failed);
+   free(mutant);
+   free(response);
+   parser_heap_term(heap);
+   return failed != 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * bench_lazy.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Parses an EnumerateInstances response of instances with many
+ *    properties and reads either 3 of them by name or all of them by
+ *    position, checking the values read. Reports the time to parse and
+ *    to read per instance, which shows what the sparse access pattern
+ *    saves by converting property values only when they are read.
+ *
+ *    usage: bench_lazy [-n instances] [-p properties] [-i iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cimXmlParser.h"
+#include "bench.h"
+
+static CMPIArray *parse(const char *response, char *received, size_t len,
+                        CMPIObjectPath *cop, ParserHeap *heap, double *t)
+{
+   double start = benchNow();
+   ResponseHdr rh;
+
+   memcpy(received, response, len);
+   rh = scanCimXmlResponse(received, cop, heap);
+   *t += benchNow() - start;
+   return rh.rvArray;
+}
+
+int main(int argc, char *argv[])
+{
+   CMPIObjectPath *cop = newCMPIObjectPath("root/cimv2", "Bench_Element", NULL);
+   ParserHeap     *heap = parser_heap_init();
+   CMPIArray      *insts;
+   CMPIInstance   *inst;
+   CMPIData        d;
+   char           *response, *received, caption[64];
+   double          start, parseTime = 0, sparse = 0, full = 0;
+   size_t          len;
+   int             instances = 2000, properties = 200, iterations = 10,
+                   i, n, p, c, count, failed = 0;
+
+   while ((c = getopt(argc, argv, "n:p:i:")) != -1) {
+      switch (c) {
+      case 'n': instances = atoi(optarg); break;
+      case 'p': properties = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-n instances] [-p properties] "
+                 "[-i iterations]\n", argv[0]);
+         return 1;
+      }
+   }
+   if (properties < 6) {
+      fprintf(stderr, "at least 6 properties\n");
+      return 1;
+   }
+
+   response = benchEnumInstancesResponse(instances, properties);
+   len = strlen(response) + 1;
+   received = malloc(len);
+
+   for (i = 0; i < iterations; i++) {
+      /* 3 properties of each instance */
+      insts = parse(response, received, len, cop, heap, &parseTime);
+      start = benchNow();
+      for (n = 0; n < instances; n++) {
+         inst = CMGetArrayElementAt(insts, n, NULL).value.inst;
+         d = CMGetProperty(inst, "Id", NULL);
+         if (d.type != CMPI_uint32 || d.value.uint32 != n)
+            failed++;
+         d = CMGetProperty(inst, "Caption1", NULL);
+         sprintf(caption, "Element %d & property 1", n);
+         if (d.type != CMPI_string || strcmp(CMGetCharPtr(d.value.string), caption))
+            failed++;
+         d = CMGetProperty(inst, "Counter5", NULL);
+         if (d.type != CMPI_uint64 || d.value.uint64 != 1000000007ULL * (n + 1) + 5)
+            failed++;
+      }
+      sparse += benchNow() - start;
+      CMRelease(insts);
+
+      /* all of them */
+      insts = parse(response, received, len, cop, heap, &parseTime);
+      start = benchNow();
+      for (n = 0; n < instances; n++) {
+         inst = CMGetArrayElementAt(insts, n, NULL).value.inst;
+         count = CMGetPropertyCount(inst, NULL);
+         for (p = 0; p < count; p++) {
+            d = CMGetPropertyAt(inst, p, NULL, NULL);
+            if (d.state & CMPI_nullValue)
+               failed++;
+         }
+         if (count != properties + 2)
+            failed++;
+      }
+      full += benchNow() - start;
+      CMRelease(insts);
+   }
+
+   printf("%d instances of %d properties, %d iterations\n",
+          instances, properties + 2, iterations);
+   printf("parse:          %7.2f us per instance\n",
+          parseTime / iterations / 2 / instances * 1e6);
+   printf("read 3:         %7.2f us per instance\n",
+          sparse / iterations / instances * 1e6);
+   printf("read all:       %7.2f us per instance\n",
+          full / iterations / instances * 1e6);
+   printf("parse + read 3: %7.2f us per instance\n",
+          (parseTime / 2 + sparse) / iterations / instances * 1e6);
+   printf("%d failed\n", failed);
+
+   parser_heap_term(heap);
+   CMRelease(cop);
+   free(received);
+   free(response);
+   return failed != 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * bench_lex.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Runs sfccLex alone over an EnumerateInstances response, without the
+ *    grammar, and reports tokens per second.
+ *
+ *    usage: bench_lex [-f recorded-response] [-n instances] [-i iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cimXmlParser.h"
+#include "bench.h"
+
+static long lex(char *xml)
+{
+   ParserControl control;
+   XmlBuffer     xmb;
+   parseUnion    lval;
+   long          tokens = 0;
+
+   memset(&control, 0, sizeof(control));
+   memset(&xmb, 0, sizeof(xmb));
+   xmb.base = xmb.cur = xml;
+   xmb.last = xml + strlen(xml);
+   control.xmb = &xmb;
+   control.heap = parser_heap_init();
+
+   while (sfccLex(&lval, &control))
+      tokens++;
+
+   parser_heap_term(control.heap);
+   return tokens;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *response;
+   char       *received;
+   double      start, elapsed = 0;
+   long        tokens = 0;
+   size_t      len;
+   int         instances = 2000, iterations = 20, i, c;
+   char       *file = NULL;
+
+   while ((c = getopt(argc, argv, "f:n:i:")) != -1) {
+      switch (c) {
+      case 'f': file = optarg; break;
+      case 'n': instances = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-f file] [-n instances] [-i iterations]\n",
+                 argv[0]);
+         return 1;
+      }
+   }
+
+   response = file ? benchReadFile(file) :
+                     benchEnumInstancesResponse(instances, 20);
+   if (response == NULL) {
+      fprintf(stderr, "can't read %s\n", file);
+      return 1;
+   }
+   len = strlen(response) + 1;
+   received = malloc(len);
+
+   for (i = 0; i < iterations; i++) {
+      /* lexed in place, restore the response each time */
+      memcpy(received, response, len);
+      start = benchNow();
+      tokens += lex(received);
+      elapsed += benchNow() - start;
+   }
+
+   printf("response: %lu bytes, %ld tokens per pass\n",
+          (unsigned long) len - 1, tokens / iterations);
+   printf("%.0f tokens/s, %.1f MB/s\n", tokens / elapsed,
+          (double) (len - 1) * iterations / elapsed / 1e6);
+
+   free(received);
+   return 0;
+}
@@ -0,0 +1,366 @@
+/*
+ * bench_listener.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Load generator for the indication listener: starts a listener and
+ *    sends it ExportIndication requests from several connections as fast
+ *    as they are acknowledged, first keeping the connections open, then
+ *    with a connection per indication. Reports the indications per second
+ *    acknowledged and delivered to the callback, and the listener's
+ *    counters. A callback taking time per call (-d) shows how the queue,
+ *    its overflow policy (-o) and batches (-b, -l) deal with a slow
+ *    consumer. Kept connections can send several requests before
+ *    reading the responses (-P), and indications can be padded to a
+ *    size (-z). Stalled clients (-S) send a request's header and hold
+ *    the body back while the others run, which mustn't slow them down.
+ *
+ *    usage: bench_listener [-c connections] [-s seconds] [-w workers]
+ *                          [-p port] [-d callback-microseconds]
+ *                          [-b batch-size] [-l linger-ms]
+ *                          [-o block|drop-oldest|drop-newest]
+ *                          [-q queue-size] [-P pipelined-requests]
+ *                          [-z indication-bytes] [-S stalled-clients]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "cimc.h"
+#include "nativeCimXml.h"
+#include "bench.h"
+
+extern CIMCEnv *_Create_XML_Env(const char *id, unsigned int options,
+                                int *rc, char **msg);
+
+static const char indicationHead[] =
+   "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+   "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+   "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+   "<SIMPLEEXPREQ>\n"
+   "<EXPMETHODCALL NAME=\"ExportIndication\">\n"
+   "<EXPPARAMVALUE NAME=\"NewIndication\">\n"
+   "<INSTANCE CLASSNAME=\"CIM_AlertIndication\">\n"
+   "<PROPERTY NAME=\"IndicationIdentifier\" TYPE=\"string\">"
+   "<VALUE>bench-4711</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"AlertType\" TYPE=\"uint16\"><VALUE>2</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"PerceivedSeverity\" TYPE=\"uint16\">"
+   "<VALUE>3</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"Description\" TYPE=\"string\">"
+   "<VALUE>Disk &amp; filesystem usage above threshold</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"AlertingManagedElement\" TYPE=\"string\">"
+   "<VALUE>root/cimv2:Linux_FileSystem.Name=&quot;/var&quot;</VALUE>"
+   "</PROPERTY>\n"
+   "<PROPERTY NAME=\"IndicationTime\" TYPE=\"datetime\">"
+   "<VALUE>20070315120000.000000+060</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"ProbableCause\" TYPE=\"uint16\"><VALUE>50</VALUE></PROPERTY>\n"
+   "<PROPERTY NAME=\"SystemName\" TYPE=\"string\">"
+   "<VALUE>bench.example.com</VALUE></PROPERTY>\n";
+
+static const char indicationTail[] =
+   "</INSTANCE>\n"
+   "</EXPPARAMVALUE>\n"
+   "</EXPMETHODCALL>\n"
+   "</SIMPLEEXPREQ>\n"
+   "</MESSAGE>\n"
+   "</CIM>\n";
+
+static char *request;
+static int  requestLength, port, seconds = 3, delay, pipelined = 1, size;
+static int  keepAlive, stalled;
+static volatile int running;
+static long sent, delivered, failed, calls;
+static CIMCIndicationListener *il;
+
+static void check(CIMCInstance *inst)
+{
+   CIMCData d = inst->ft->getProperty(inst, "AlertType", NULL);
+
+   if (d.type != CIMC_uint16 || d.value.uint16 != 2)
+      __sync_fetch_and_add(&failed, 1);
+   __sync_fetch_and_add(&delivered, 1);
+   inst->ft->release(inst);
+}
+
+static void deliver(CIMCInstance *inst)
+{
+   check(inst);
+   calls++;
+   if (delay)
+      usleep(delay);
+}
+
+static void deliverBatch(CIMCInstance **insts, CIMCCount count)
+{
+   CIMCCount i;
+
+   for (i = 0; i < count; i++)
+      check(insts[i]);
+   calls++;
+   if (delay)
+      usleep(delay);
+}
+
+static CIMCUint64 counter(int c)
+{
+   return il->ft->getCounter(il, c, NULL);
+}
+
+static int connectListener()
+{
+   struct sockaddr_in sin;
+   int fd = socket(PF_INET, SOCK_STREAM, 0);
+
+   memset(&sin, 0, sizeof(sin));
+   sin.sin_family = AF_INET;
+   sin.sin_port = htons(port);
+   sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   if (connect(fd, (struct sockaddr *) &sin, sizeof(sin))) {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/* reads n responses without a body, returns 1 if the connection can be
+   kept */
+static int readResponses(int fd, int n)
+{
+   char buf[4096], *p, *end;
+   int len = 0, r, keep = 1;
+
+   while (n) {
+      r = read(fd, buf + len, sizeof(buf) - 1 - len);
+      if (r < 0 && errno == EINTR)
+         continue;
+      if (r <= 0 || (len += r) == sizeof(buf) - 1)
+         return -1;
+      buf[len] = 0;
+      for (p = buf; n && (end = strstr(p, "\r\n\r\n")) != NULL; p = end + 4) {
+         *end = 0;
+         if (strncmp(p, "HTTP/1.1 200", 12))
+            return -1;
+         if (strstr(p, "Connection: close"))
+            keep = 0;
+         n--;
+      }
+      len -= p - buf;
+      memmove(buf, p, len);
+   }
+   return keep;
+}
+
+static void *client(void *arg)
+{
+   long count = 0;
+   int fd = -1, rc, n = keepAlive ? pipelined : 1;
+
+   while (running) {
+      if (fd < 0 && (fd = connectListener()) < 0) {
+         __sync_fetch_and_add(&failed, 1);
+         break;
+      }
+      if (send(fd, request, requestLength * n, MSG_NOSIGNAL) != requestLength * n ||
+          (rc = readResponses(fd, n)) < 0) {
+         __sync_fetch_and_add(&failed, 1);
+         break;
+      }
+      count += n;
+      if (!rc || !keepAlive) {
+         close(fd);
+         fd = -1;
+      }
+   }
+   if (fd >= 0)
+      close(fd);
+   __sync_fetch_and_add(&sent, count);
+   return NULL;
+}
+
+/* connects and sends a header promising a body that never comes */
+static int stall()
+{
+   static const char header[] =
+      "POST /cimom HTTP/1.1\r\n"
+      "Host: localhost\r\n"
+      "Content-Type: application/xml; charset=\"utf-8\"\r\n"
+      "Content-Length: 1000\r\n"
+      "CIMExport: MethodRequest\r\n"
+      "CIMExportMethod: ExportIndication\r\n\r\n";
+   int fd = connectListener();
+
+   if (fd >= 0)
+      send(fd, header, sizeof(header) - 1, MSG_NOSIGNAL);
+   return fd;
+}
+
+static void run(int connections)
+{
+   pthread_t tid[256];
+   int stalledFds[256];
+   double start, elapsed;
+   long dropped = counter(CIMC_CNT_LISTENER_DROPPED);
+   long blocked = counter(CIMC_CNT_LISTENER_BLOCKED);
+   char *indication;
+   int i, len, pad;
+
+   /* padded with a string property to size */
+   pad = size - (int) (sizeof(indicationHead) + sizeof(indicationTail)) - 70;
+   indication = malloc(sizeof(indicationHead) + sizeof(indicationTail) + 100 +
+                       (pad > 0 ? pad : 0));
+   len = sprintf(indication, "%s", indicationHead);
+   if (pad > 0) {
+      len += sprintf(indication + len,
+                     "<PROPERTY NAME=\"Padding\" TYPE=\"string\"><VALUE>");
+      memset(indication + len, 'x', pad);
+      len += pad;
+      len += sprintf(indication + len, "</VALUE></PROPERTY>\n");
+   }
+   len += sprintf(indication + len, "%s", indicationTail);
+
+   free(request);
+   request = malloc((len + 300) * pipelined);
+   requestLength = sprintf(request,
+                           "POST /cimom HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "Content-Type: application/xml; charset=\"utf-8\"\r\n"
+                           "Content-Length: %d\r\n"
+                           "CIMExport: MethodRequest\r\n"
+                           "CIMExportMethod: ExportIndication\r\n"
+                           "%s\r\n%s",
+                           len, keepAlive ? "" : "Connection: close\r\n",
+                           indication);
+   for (i = 1; i < pipelined; i++)
+      memcpy(request + i * requestLength, request, requestLength);
+   free(indication);
+   sent = delivered = calls = 0;
+   for (i = 0; i < stalled; i++)
+      stalledFds[i] = stall();
+   running = 1;
+   start = benchNow();
+   for (i = 0; i < connections; i++)
+      pthread_create(tid + i, NULL, client, NULL);
+   sleep(seconds);
+   running = 0;
+   for (i = 0; i < connections; i++)
+      pthread_join(tid[i], NULL);
+   elapsed = benchNow() - start;
+   for (i = 0; i < stalled; i++)
+      if (stalledFds[i] >= 0)
+         close(stalledFds[i]);
+
+   /* the last ones may still be queued */
+   for (i = 0; i < 3000; i++) {
+      if (delivered + counter(CIMC_CNT_LISTENER_DROPPED) - dropped >= sent)
+         break;
+      usleep(10000);
+   }
+   dropped = counter(CIMC_CNT_LISTENER_DROPPED) - dropped;
+   blocked = counter(CIMC_CNT_LISTENER_BLOCKED) - blocked;
+   if (delivered + dropped != sent) {
+      printf("%ld indications sent, %ld delivered, %ld dropped\n",
+             sent, delivered, dropped);
+      failed++;
+   }
+   printf("%-22s %8.0f acknowledged/s %8.0f delivered/s\n",
+          keepAlive ? "kept connections:" : "connection per request:",
+          sent / elapsed, delivered / elapsed);
+   printf("%22s %8ld dropped %8ld blocked %8.1f per call\n", "",
+          dropped, blocked, calls ? (double) delivered / calls : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+   CIMCEnv *ce;
+   CIMCStatus st;
+   char *msg = NULL;
+   int rc, c, connections = 8, workers = 0, batch = 0, linger = 0,
+       overflow = CIMC_OVERFLOW_BLOCK, queue = 0;
+
+   while ((c = getopt(argc, argv, "c:s:w:p:d:b:l:o:q:P:z:S:")) != -1) {
+      switch (c) {
+      case 'c': connections = atoi(optarg); break;
+      case 's': seconds = atoi(optarg); break;
+      case 'w': workers = atoi(optarg); break;
+      case 'p': port = atoi(optarg); break;
+      case 'd': delay = atoi(optarg); break;
+      case 'b': batch = atoi(optarg); break;
+      case 'l': linger = atoi(optarg); break;
+      case 'q': queue = atoi(optarg); break;
+      case 'P': pipelined = atoi(optarg); break;
+      case 'z': size = atoi(optarg); break;
+      case 'S': stalled = atoi(optarg); break;
+      case 'o':
+         overflow = strcmp(optarg, "drop-oldest") == 0 ? CIMC_OVERFLOW_DROP_OLDEST :
+                    strcmp(optarg, "drop-newest") == 0 ? CIMC_OVERFLOW_DROP_NEWEST :
+                    CIMC_OVERFLOW_BLOCK;
+         break;
+      default:
+         fprintf(stderr, "usage: %s [-c connections] [-s seconds] [-w workers] "
+                 "[-p port] [-d callback-microseconds] [-b batch-size] "
+                 "[-l linger-ms] [-o block|drop-oldest|drop-newest] "
+                 "[-q queue-size] [-P pipelined-requests] "
+                 "[-z indication-bytes] [-S stalled-clients]\n", argv[0]);
+         return 1;
+      }
+   }
+   if (connections < 1 || connections > 256)
+      connections = 8;
+   if (pipelined < 1)
+      pipelined = 1;
+   if (stalled < 0 || stalled > 256)
+      stalled = 0;
+
+   ce = _Create_XML_Env("bench", 0, &rc, &msg);
+   if (workers)
+      ce->ft->setOption(ce, CIMC_OPT_LISTENER_WORKERS, workers);
+   ce->ft->setOption(ce, CIMC_OPT_LISTENER_QUEUE_SIZE, queue);
+   ce->ft->setOption(ce, CIMC_OPT_LISTENER_OVERFLOW, overflow);
+   ce->ft->setOption(ce, CIMC_OPT_LISTENER_BATCH_SIZE, batch);
+   ce->ft->setOption(ce, CIMC_OPT_LISTENER_LINGER, linger);
+   if (batch)
+      il = ce->ft->newBatchIndicationListener(ce, 0, &port, NULL, deliverBatch,
+                                              &st);
+   else
+      il = ce->ft->newIndicationListener(ce, 0, &port, NULL, deliver, &st);
+   st = il->ft->start(il);
+   if (st.rc) {
+      fprintf(stderr, "can't start the listener\n");
+      return 1;
+   }
+   if (port == 0)
+      port = ((struct native_indicationlistener *) il)->port;
+
+   printf("%d connections, %d seconds, %d us per callback, batches of %d\n",
+          connections, seconds, delay, batch ? batch : 1);
+   if (pipelined > 1 || size)
+      printf("%d requests pipelined, indications of %d bytes\n", pipelined,
+             size);
+   if (stalled)
+      printf("%d clients stalled sending a request\n", stalled);
+   keepAlive = 1;
+   run(connections);
+   keepAlive = 0;
+   run(connections);
+   printf("%ld failed\n", failed);
+
+   il->ft->release(il);
+   free(request);
+   ce->ft->release(ce);
+   free(ce);           /* as ReleaseCIMCEnv() does */
+   return failed != 0;
+}
@@ -0,0 +1,364 @@
+/*
+ * bench_metrics.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Sends EnumerateInstances requests to a canned CIMOM on the loopback
+ *    interface, in rounds with CIMC_OPT_METRICS off and on, and reports
+ *    the time per request of both. Checks the counters getMetrics()
+ *    returns for the requests made while metrics were on, failed
+ *    GetInstance requests included, that nothing is counted while they
+ *    are off, and that dumpMetrics() returns well-formed JSON.
+ *
+ *    usage: bench_metrics [-n requests-per-round] [-i instances]
+ *                         [-p properties] [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "cimc.h"
+#include "bench.h"
+
+extern CIMCEnv *_Create_XML_Env(const char *id, unsigned int options,
+                                int *rc, char **msg);
+
+#define ROUNDS 4
+
+static const char errorResponse[] =
+   "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+   "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+   "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+   "<SIMPLERSP>\n"
+   "<IMETHODRESPONSE NAME=\"GetInstance\">\n"
+   "<ERROR CODE=\"6\" DESCRIPTION=\"Instance not found\"/>\n"
+   "</IMETHODRESPONSE>\n"
+   "</SIMPLERSP>\n"
+   "</MESSAGE>\n"
+   "</CIM>\n";
+
+static char *enumResponse;
+static int   listenFd;
+static long  failed;
+
+static int sendAll(int fd, const char *buf, size_t len)
+{
+   ssize_t n;
+
+   while (len) {
+      n = send(fd, buf, len, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0)
+         return -1;
+      buf += n;
+      len -= n;
+   }
+   return 0;
+}
+
+/* reads a request into buf, returns its CIMMethod in method or -1 once
+   the client closed the connection */
+static int readRequest(int fd, char *buf, int max, char *method)
+{
+   char *end = NULL, *h;
+   int   len = 0, r, length = 0;
+
+   method[0] = 0;
+
+   for (;;) {
+      if (end && len >= end + 4 - buf + length)
+         break;
+      r = read(fd, buf + len, max - 1 - len);
+      if (r < 0 && errno == EINTR)
+         continue;
+      if (r <= 0)
+         return -1;
+      buf[len += r] = 0;
+      if (end == NULL && (end = strstr(buf, "\r\n\r\n")) != NULL) {
+         for (h = buf; h < end; h = strstr(h, "\r\n") + 2) {
+            if (strncasecmp(h, "Content-Length:", 15) == 0)
+               length = atoi(h + 15);
+            else if (strncasecmp(h, "CIMMethod:", 10) == 0)
+               sscanf(h + 10, " %63s", method);
+         }
+      }
+   }
+   return 0;
+}
+
+static void *serve(void *arg)
+{
+   char buf[65536], method[64], *response = malloc(strlen(enumResponse) + 256);
+   const char *body;
+   int fd = (long) arg, n;
+
+   while (readRequest(fd, buf, sizeof(buf), method) == 0) {
+      body = strcmp(method, "GetInstance") ? enumResponse : errorResponse;
+      /* in one piece, or the client waits for a delayed ACK */
+      n = sprintf(response,
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/xml; charset=\"utf-8\"\r\n"
+                  "Content-Length: %d\r\n"
+                  "CIMOperation: MethodResponse\r\n\r\n%s",
+                  (int) strlen(body), body);
+      if (sendAll(fd, response, n))
+         break;
+   }
+   close(fd);
+   free(response);
+   return NULL;
+}
+
+static void *server(void *arg)
+{
+   pthread_t tid;
+   long fd;
+
+   while ((fd = accept(listenFd, NULL, NULL)) >= 0) {
+      pthread_create(&tid, NULL, serve, (void *) fd);
+      pthread_detach(tid);
+   }
+   return NULL;
+}
+
+static int startServer()
+{
+   struct sockaddr_in sin;
+   socklen_t len = sizeof(sin);
+   pthread_t tid;
+   int on = 1;
+
+   listenFd = socket(PF_INET, SOCK_STREAM, 0);
+   setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+   memset(&sin, 0, sizeof(sin));
+   sin.sin_family = AF_INET;
+   sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   if (bind(listenFd, (struct sockaddr *) &sin, sizeof(sin)) ||
+       listen(listenFd, 16) ||
+       getsockname(listenFd, (struct sockaddr *) &sin, &len))
+      return -1;
+   pthread_create(&tid, NULL, server, NULL);
+   pthread_detach(tid);
+   return ntohs(sin.sin_port);
+}
+
+/* n requests, returns the seconds they took */
+static double enumerate(CIMCClient *cl, CIMCObjectPath *cop, int n, int instances)
+{
+   CIMCEnumeration *enm;
+   CIMCArray *arr = NULL;
+   CIMCStatus st;
+   double start = benchNow();
+   int i;
+
+   for (i = 0; i < n; i++) {
+      enm = cl->ft->enumInstances(cl, cop, 0, NULL, &st);
+      if (enm)
+         arr = enm->ft->toArray(enm, NULL);
+      if (enm == NULL || arr->ft->getSize(arr, NULL) != (CIMCCount) instances) {
+         printf("EnumerateInstances failed: %d %s\n", st.rc,
+                st.msg ? st.msg->ft->getCharPtr(st.msg, NULL) : "");
+         failed++;
+      }
+      if (st.msg)
+         st.msg->ft->release(st.msg);
+      if (enm)
+         enm->ft->release(enm);
+   }
+   return benchNow() - start;
+}
+
+static CIMCUint64 count(CIMCMetrics *m, int phase)
+{
+   CIMCUint64 n = 0;
+   int b;
+
+   for (b = 0; b < CIMC_METRICS_BUCKETS; b++)
+      n += m->histogram[phase][b];
+   return n;
+}
+
+static void expect(const char *what, CIMCUint64 value, CIMCUint64 expected)
+{
+   if (value != expected) {
+      printf("%s is %llu instead of %llu\n", what,
+             (unsigned long long) value, (unsigned long long) expected);
+      failed++;
+   }
+}
+
+/* skips the JSON value at p, NULL if it isn't one; dumpMetrics() only
+   has objects, arrays and numbers */
+static const char *skipValue(const char *p)
+{
+   char close;
+
+   if (*p >= '0' && *p <= '9') {
+      while (*p >= '0' && *p <= '9')
+         p++;
+      return p;
+   }
+   if (*p != '{' && *p != '[')
+      return NULL;
+   close = *p++ == '{' ? '}' : ']';
+   if (*p == close)
+      return p + 1;
+   for (;;) {
+      if (close == '}') {
+         if (*p != '"' || (p = strchr(p + 1, '"')) == NULL || *++p != ':')
+            return NULL;
+         p++;
+      }
+      if ((p = skipValue(p)) == NULL)
+         return NULL;
+      if (*p == close)
+         return p + 1;
+      if (*p++ != ',')
+         return NULL;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   CIMCEnv        *ce;
+   CIMCClient     *cl;
+   CIMCObjectPath *cop;
+   CIMCInstance   *inst;
+   CIMCStatus      st;
+   CIMCMetrics     m, all;
+   const char     *end;
+   char            port[16], expected[128], *json, *msg = NULL;
+   double          off = 0, on = 0;
+   int             requests = 2000, instances = 20, properties = 12;
+   int             verbose = 0, rc, i, c;
+
+   while ((c = getopt(argc, argv, "n:i:p:v")) != -1) {
+      switch (c) {
+      case 'n': requests = atoi(optarg); break;
+      case 'i': instances = atoi(optarg); break;
+      case 'p': properties = atoi(optarg); break;
+      case 'v': verbose = 1; break;
+      default:
+         fprintf(stderr, "usage: %s [-n requests-per-round] [-i instances] "
+                 "[-p properties] [-v]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   enumResponse = benchEnumInstancesResponse(instances, properties);
+   if ((c = startServer()) < 0) {
+      perror("can't listen");
+      return 1;
+   }
+   sprintf(port, "%d", c);
+
+   ce = _Create_XML_Env("bench", 0, &rc, &msg);
+   cl = ce->ft->connect(ce, "127.0.0.1", "http", port, NULL, NULL, &st);
+   cop = ce->ft->newObjectPath(ce, "root/cimv2", "Bench_Element", &st);
+
+   /* the connection is opened while metrics are off */
+   enumerate(cl, cop, requests / 10 + 1, instances);
+
+   for (i = 0; i < ROUNDS; i++) {
+      ce->ft->setOption(ce, CIMC_OPT_METRICS, 0);
+      off += enumerate(cl, cop, requests, instances);
+      ce->ft->setOption(ce, CIMC_OPT_METRICS, 1);
+      on += enumerate(cl, cop, requests, instances);
+   }
+   printf("%d requests of %d instances: %.1f us per request without metrics, "
+          "%.1f us with (%+.1f%%)\n", ROUNDS * requests, instances,
+          off / (ROUNDS * requests) * 1e6, on / (ROUNDS * requests) * 1e6,
+          (on - off) / off * 100);
+
+   /* the server answers these with a CIM error */
+   for (i = 0; i < 10; i++) {
+      inst = cl->ft->getInstance(cl, cop, 0, NULL, &st);
+      expect("GetInstance status", st.rc, CIMC_RC_ERR_NOT_FOUND);
+      if (st.msg)
+         st.msg->ft->release(st.msg);
+      if (inst)
+         inst->ft->release(inst);
+   }
+
+   /* not counted */
+   ce->ft->setOption(ce, CIMC_OPT_METRICS, 0);
+   enumerate(cl, cop, 10, instances);
+
+   ce->ft->getMetrics(ce, "EnumerateInstances", &m);
+   expect("operations", m.operations, ROUNDS * requests);
+   expect("failures", m.failures, 0);
+   expect("objects", m.objects, m.operations * instances);
+   expect("responseBytes", m.responseBytes, m.operations * strlen(enumResponse));
+   expect("decodedBytes", m.decodedBytes, m.responseBytes);
+   if (m.requestBytes < m.operations * 100)
+      expect("requestBytes", m.requestBytes, m.operations * 100);
+   expect("total count", count(&m, CIMC_PHASE_TOTAL), m.operations);
+   expect("request count", count(&m, CIMC_PHASE_REQUEST), m.operations);
+   expect("server count", count(&m, CIMC_PHASE_SERVER), m.operations);
+   expect("transfer count", count(&m, CIMC_PHASE_TRANSFER), m.operations);
+   expect("parse count", count(&m, CIMC_PHASE_PARSE), m.operations);
+   expect("connect count", count(&m, CIMC_PHASE_CONNECT), 0);
+   if (m.time[CIMC_PHASE_TOTAL] < m.time[CIMC_PHASE_PARSE] ||
+       m.time[CIMC_PHASE_TOTAL] < m.time[CIMC_PHASE_SERVER]) {
+      printf("total time shorter than a phase\n");
+      failed++;
+   }
+   printf("%-10s %10s %10s %10s %10s %10s\n", "us per op", "total",
+          "request", "server", "transfer", "parse");
+   printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f\n", "",
+          (double) m.time[CIMC_PHASE_TOTAL] / m.operations,
+          (double) m.time[CIMC_PHASE_REQUEST] / m.operations,
+          (double) m.time[CIMC_PHASE_SERVER] / m.operations,
+          (double) m.time[CIMC_PHASE_TRANSFER] / m.operations,
+          (double) m.time[CIMC_PHASE_PARSE] / m.operations);
+
+   ce->ft->getMetrics(ce, "GetInstance", &m);
+   expect("GetInstance operations", m.operations, 10);
+   expect("GetInstance failures", m.failures, 10);
+   expect("GetInstance objects", m.objects, 0);
+
+   ce->ft->getMetrics(ce, NULL, &all);
+   expect("all operations", all.operations, ROUNDS * requests + 10);
+   expect("all failures", all.failures, 10);
+
+   json = ce->ft->dumpMetrics(ce, &st);
+   end = skipValue(json);
+   if (end == NULL || *end) {
+      printf("malformed JSON at %ld: %s\n",
+             end ? (long) (end - json) : -1L, json);
+      failed++;
+   }
+   sprintf(expected, "\"EnumerateInstances\":{\"operations\":%d,",
+           ROUNDS * requests);
+   if (strstr(json, expected) == NULL) {
+      printf("%s missing in %s\n", expected, json);
+      failed++;
+   }
+   if (verbose)
+      printf("%s\n", json);
+   printf("%d bytes of JSON\n", (int) strlen(json));
+   free(json);
+
+   printf("%ld failed\n", failed);
+   cop->ft->release(cop);
+   cl->ft->release(cl);
+   ce->ft->release(ce);
+   free(enumResponse);
+   return failed != 0;
+}
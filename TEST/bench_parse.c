@@ -0,0 +1,109 @@
+/*
+ * bench_parse.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Parses the same EnumerateInstances response with scanCimXmlResponse
+ *    in 1, 2, 4, ... threads and reports the aggregate throughput.
+ *
+ *    usage: bench_parse [-f recorded-response] [-n instances]
+ *                       [-i iterations] [-t max-threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "cimXmlParser.h"
+#include "bench.h"
+
+static const char *response;
+static int iterations = 20;
+
+static void *parser(void *arg)
+{
+   CMPIObjectPath *cop = newCMPIObjectPath("root/cimv2", "Bench_Element", NULL);
+   size_t len = strlen(response) + 1;
+   char *received = malloc(len);
+   ParserHeap *heap = parser_heap_init();   /* kept like a connection's */
+   long objects = 0;
+   int i;
+
+   for (i = 0; i < iterations; i++) {
+      /* parsed in place, as received into the connection's buffer */
+      memcpy(received, response, len);
+      ResponseHdr rh = scanCimXmlResponse(received, cop, heap);
+      objects += CMGetArrayCount(rh.rvArray, NULL);
+      CMRelease(rh.rvArray);
+   }
+   parser_heap_term(heap);
+   free(received);
+   CMRelease(cop);
+   return (void *) objects;
+}
+
+int main(int argc, char *argv[])
+{
+   pthread_t *tid;
+   double     start, elapsed, base = 0;
+   long       objects, maxThreads = sysconf(_SC_NPROCESSORS_ONLN);
+   int        instances = 2000, threads, t, c;
+   char      *file = NULL;
+   void      *rv;
+
+   while ((c = getopt(argc, argv, "f:n:i:t:")) != -1) {
+      switch (c) {
+      case 'f': file = optarg; break;
+      case 'n': instances = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      case 't': maxThreads = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-f file] [-n instances] [-i iterations] "
+                 "[-t threads]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   response = file ? benchReadFile(file) :
+                     benchEnumInstancesResponse(instances, 20);
+   if (response == NULL) {
+      fprintf(stderr, "can't read %s\n", file);
+      return 1;
+   }
+   tid = calloc(maxThreads, sizeof(pthread_t));
+
+   printf("response: %lu bytes, %d iterations per thread\n",
+          (unsigned long) strlen(response), iterations);
+   printf("threads   objects/s        MB/s  speedup\n");
+
+   for (threads = 1; threads <= maxThreads; threads *= 2) {
+      objects = 0;
+      start = benchNow();
+      for (t = 0; t < threads; t++)
+         pthread_create(&tid[t], NULL, parser, NULL);
+      for (t = 0; t < threads; t++) {
+         pthread_join(tid[t], &rv);
+         objects += (long) rv;
+      }
+      elapsed = benchNow() - start;
+      if (threads == 1)
+         base = objects / elapsed;
+      printf("%7d %11.0f %11.1f %8.2f\n", threads, objects / elapsed,
+             (double) strlen(response) * iterations * threads / elapsed / 1e6,
+             objects / elapsed / base);
+      if (threads < maxThreads && threads * 2 > maxThreads)
+         threads = maxThreads / 2;
+   }
+
+   free(tid);
+   return 0;
+}
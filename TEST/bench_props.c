@@ -0,0 +1,152 @@
+/*
+ * bench_props.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Builds instances with many properties, looks every property up by
+ *    name in a different case and walks them by position, checking that
+ *    the insertion order is kept. Reports the time of each step. With
+ *    -t the same is done in that many threads at once, which all intern
+ *    the same property names; the time per property is their average and
+ *    the throughput is over all threads.
+ *
+ *    usage: bench_props [-n properties] [-i iterations] [-t threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "cmcidt.h"
+#include "cmcift.h"
+#include "cmcimacs.h"
+#include "native.h"
+#include "bench.h"
+
+typedef struct {
+   double add, get, at;
+   int    failed;
+} Times;
+
+static CMPIObjectPath *cop;
+static char          **names;
+static int             properties = 300, iterations = 20;
+
+static void *run(void *arg)
+{
+   Times          *t = (Times *) arg;
+   CMPIInstance   *inst, *clone;
+   CMPIString     *name;
+   CMPIData        d;
+   CMPIValue       v;
+   CMPIStatus      rc;
+   char            upper[32], *s;
+   double          start;
+   int             i, n;
+
+   for (i = 0; i < iterations; i++) {
+      inst = newCMPIInstance(cop, NULL);
+
+      start = benchNow();
+      for (n = 0; n < properties; n++) {
+         v.uint32 = n;
+         CMSetProperty(inst, names[n], &v, CMPI_uint32);
+      }
+      t->add += benchNow() - start;
+
+      start = benchNow();
+      for (n = 0; n < properties; n++) {
+         for (s = upper; (*s = toupper(names[n][s - upper])); s++)
+            ;
+         d = CMGetProperty(inst, upper, &rc);
+         if (rc.rc || d.value.uint32 != n)
+            t->failed++;
+      }
+      t->get += benchNow() - start;
+
+      clone = CMClone(inst, NULL);
+      start = benchNow();
+      for (n = 0; n < properties; n++) {
+         d = CMGetPropertyAt(clone, n, &name, &rc);
+         if (rc.rc || d.value.uint32 != n ||
+             strcmp(CMGetCharPtr(name), names[n]))
+            t->failed++;
+         CMRelease(name);
+      }
+      t->at += benchNow() - start;
+      if (CMGetPropertyCount(clone, NULL) != properties)
+         t->failed++;
+
+      CMRelease(clone);
+      CMRelease(inst);
+   }
+   return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+   pthread_t      *tid;
+   Times          *times, sum = { 0, 0, 0, 0 };
+   double          start, elapsed;
+   int             threads = 1, n, c;
+
+   while ((c = getopt(argc, argv, "n:i:t:")) != -1) {
+      switch (c) {
+      case 'n': properties = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      case 't': threads = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-n properties] [-i iterations] "
+                 "[-t threads]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   names = malloc(properties * sizeof(char *));
+   for (n = 0; n < properties; n++) {
+      names[n] = malloc(32);
+      sprintf(names[n], "Property%d", (n * 7919) % properties);
+   }
+   cop = newCMPIObjectPath("root/cimv2", "Bench_Element", NULL);
+
+   tid = calloc(threads, sizeof(pthread_t));
+   times = calloc(threads, sizeof(Times));
+   start = benchNow();
+   for (n = 0; n < threads; n++)
+      pthread_create(&tid[n], NULL, run, times + n);
+   for (n = 0; n < threads; n++) {
+      pthread_join(tid[n], NULL);
+      sum.add += times[n].add;
+      sum.get += times[n].get;
+      sum.at += times[n].at;
+      sum.failed += times[n].failed;
+   }
+   elapsed = benchNow() - start;
+
+   printf("%d properties, %d iterations, %d threads\n", properties,
+          iterations, threads);
+   printf("setProperty:   %.0f ns per property\n", sum.add / threads / iterations / properties * 1e9);
+   printf("getProperty:   %.0f ns per property\n", sum.get / threads / iterations / properties * 1e9);
+   printf("getPropertyAt: %.0f ns per property\n", sum.at / threads / iterations / properties * 1e9);
+   printf("throughput:    %.0f properties per second\n",
+          (double) properties * iterations * threads / elapsed);
+   printf("%d failed\n", sum.failed);
+
+   for (n = 0; n < properties; n++)
+      free(names[n]);
+   free(names);
+   free(tid);
+   free(times);
+   CMRelease(cop);
+   return sum.failed != 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * bench_request.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Serializes uint64, sint32, real64 and string arrays into request
+ *    VALUE.ARRAY elements, once through value2Chars and AsciiToXmlStr as
+ *    the request builders used to and once straight into the buffer with
+ *    value2Xml, checks that both produce the same XML and reports the
+ *    time per value.
+ *
+ *    usage: bench_request [-n elements] [-i iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cmcidt.h"
+#include "cmcift.h"
+#include "cmcimacs.h"
+#include "native.h"
+#include "utilft.h"
+#include "bench.h"
+
+extern char *value2Chars(CMPIType type, CMPIValue * value);
+extern void value2Xml(CMPIType type, CMPIValue * value, UtilStringBuffer *sb);
+extern char *AsciiToXmlStr(char *AsciiStr);
+
+static void strdupXml(UtilStringBuffer *sb, CMPIType type, CMPIValue *value)
+{
+   char *cv = value2Chars(type, value), *xv;
+
+   if (type == CMPI_string || type == CMPI_chars) {
+      xv = AsciiToXmlStr(cv);
+      free(cv);
+      cv = xv;
+   }
+   sb->ft->append3Chars(sb, "<VALUE>", cv, "</VALUE>\n");
+   free(cv);
+}
+
+static void directXml(UtilStringBuffer *sb, CMPIType type, CMPIValue *value)
+{
+   sb->ft->appendBlock(sb, "<VALUE>", 7);
+   value2Xml(type, value, sb);
+   sb->ft->appendBlock(sb, "</VALUE>\n", 9);
+}
+
+static double serialize(UtilStringBuffer *sb, CMPIArray *arr, int n,
+                        void (*fn) (UtilStringBuffer *, CMPIType, CMPIValue *))
+{
+   CMPIType type = CMGetArrayType(arr, NULL);
+   CMPIData d;
+   double   start;
+   int      i;
+
+   sb->ft->reset(sb);
+   start = benchNow();
+   sb->ft->appendChars(sb, "<VALUE.ARRAY>\n");
+   for (i = 0; i < n; i++) {
+      d = CMGetArrayElementAt(arr, i, NULL);
+      fn(sb, type, &d.value);
+   }
+   sb->ft->appendChars(sb, "</VALUE.ARRAY>\n");
+   return benchNow() - start;
+}
+
+int main(int argc, char *argv[])
+{
+   static const char *names[] = { "uint64", "sint32", "real64", "string" };
+   static const CMPIType types[] = {
+      CMPI_uint64, CMPI_sint32, CMPI_real64, CMPI_string
+   };
+   UtilStringBuffer *sb1, *sb2;
+   CMPIArray  *arr[4];
+   CMPIValue   v;
+   char        str[64];
+   double      before[4] = { 0 }, after[4] = { 0 };
+   int         elements = 10000, iterations = 20, i, t, n, c, failed = 0;
+
+   while ((c = getopt(argc, argv, "n:i:")) != -1) {
+      switch (c) {
+      case 'n': elements = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-n elements] [-i iterations]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   for (t = 0; t < 4; t++)
+      arr[t] = newCMPIArray(elements, types[t], NULL);
+   for (n = 0; n < elements; n++) {
+      v.uint64 = 18446744073709551557ULL - n * 7919ULL;
+      CMSetArrayElementAt(arr[0], n, &v, CMPI_uint64);
+      v.sint32 = (n * 104729) * (n & 1 ? -1 : 1);
+      CMSetArrayElementAt(arr[1], n, &v, CMPI_sint32);
+      v.real64 = n * 3.14159265;
+      CMSetArrayElementAt(arr[2], n, &v, CMPI_real64);
+      sprintf(str, n % 10 ? "Element %d of the array" : "<a & \"b\" %d>", n);
+      v.string = newCMPIString(str, NULL);
+      CMSetArrayElementAt(arr[3], n, &v, CMPI_string);
+      CMRelease(v.string);
+   }
+
+   sb1 = UtilFactory->newStringBuffer(1024);
+   sb2 = UtilFactory->newStringBuffer(1024);
+   for (i = 0; i < iterations; i++) {
+      for (t = 0; t < 4; t++) {
+         before[t] += serialize(sb1, arr[t], elements, strdupXml);
+         after[t] += serialize(sb2, arr[t], elements, directXml);
+         if (sb1->len != sb2->len ||
+             strcmp(sb1->ft->getCharPtr(sb1), sb2->ft->getCharPtr(sb2)))
+            failed++;
+      }
+   }
+
+   printf("%d elements, %d iterations\n", elements, iterations);
+   for (t = 0; t < 4; t++)
+      printf("%-7s value2Chars: %4.0f ns  value2Xml: %4.0f ns per value\n",
+             names[t], before[t] / iterations / elements * 1e9,
+             after[t] / iterations / elements * 1e9);
+   printf("%d failed\n", failed);
+
+   sb1->ft->release(sb1);
+   sb2->ft->release(sb2);
+   for (t = 0; t < 4; t++)
+      CMRelease(arr[t]);
+   return failed != 0;
+}
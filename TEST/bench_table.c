@@ -0,0 +1,215 @@
+/*
+ * bench_table.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ *    Parses the same EnumerateInstances response into instances with
+ *    scanCimXmlResponse and into a CIMCResultTable, checks that every row
+ *    has the values of its instance, in several threads reading the same
+ *    rows at once, and reports the parse time and the time to sum up a
+ *    uint64 property, through CMGetProperty on the instances and through
+ *    the column.
+ *
+ *    usage: bench_table [-n instances] [-i iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "cimXmlParser.h"
+#include "nativeCimXml.h"
+#include "bench.h"
+
+static int sameData(CMPIData a, CMPIData b)
+{
+   CMPIString *sa, *sb;
+   CMPICount i, n;
+   int same;
+
+   if (a.type != b.type || (a.state & CMPI_nullValue) != (b.state & CMPI_nullValue))
+      return 0;
+   if (a.state & CMPI_nullValue)
+      return 1;
+   if (a.type & CMPI_ARRAY) {
+      n = CMGetArrayCount(a.value.array, NULL);
+      if (n != CMGetArrayCount(b.value.array, NULL))
+         return 0;
+      for (i = 0; i < n; i++)
+         if (!sameData(CMGetArrayElementAt(a.value.array, i, NULL),
+                       CMGetArrayElementAt(b.value.array, i, NULL)))
+            return 0;
+      return 1;
+   }
+   switch (a.type) {
+   case CMPI_string:
+      return strcmp(CMGetCharPtr(a.value.string), CMGetCharPtr(b.value.string)) == 0;
+   case CMPI_dateTime:
+      sa = CMGetStringFormat(a.value.dateTime, NULL);
+      sb = CMGetStringFormat(b.value.dateTime, NULL);
+      same = strcmp(CMGetCharPtr(sa), CMGetCharPtr(sb)) == 0;
+      CMRelease(sa);
+      CMRelease(sb);
+      return same;
+   case CMPI_real64:
+      return a.value.real64 == b.value.real64;
+   case CMPI_boolean:
+      return !a.value.boolean == !b.value.boolean;
+   }
+   return a.value.uint64 == b.value.uint64;
+}
+
+/* rows against instances, including the keys of the object paths */
+static int compare(CMPIArray *insts, CIMCResultTable *rt)
+{
+   CMPIInstance   *inst, *row;
+   CMPIObjectPath *op1, *op2;
+   CMPIString     *name;
+   CMPIData        d;
+   CMPICount       n = CMGetArrayCount(insts, NULL), i, p, props;
+   int             failed = 0;
+
+   if (n != rt->ft->getRowCount(rt, NULL))
+      return 1;
+   for (i = 0; i < n; i++) {
+      inst = CMGetArrayElementAt(insts, i, NULL).value.inst;
+      row = (CMPIInstance *) rt->ft->getRow(rt, i, NULL);
+      props = CMGetPropertyCount(inst, NULL);
+      if (props != CMGetPropertyCount(row, NULL))
+         failed++;
+      for (p = 0; p < props; p++) {
+         d = CMGetPropertyAt(inst, p, &name, NULL);
+         if (!sameData(d, CMGetProperty(row, CMGetCharPtr(name), NULL)))
+            failed++;
+         CMRelease(name);
+      }
+      op1 = CMGetObjectPath(inst, NULL);
+      op2 = CMGetObjectPath(row, NULL);
+      if (CMGetKeyCount(op1, NULL) != CMGetKeyCount(op2, NULL) ||
+          !sameData(CMGetKey(op1, "Id", NULL), CMGetKey(op2, "Id", NULL)))
+         failed++;
+      CMRelease(op1);
+      CMRelease(op2);
+      CMRelease(row);
+   }
+   return failed;
+}
+
+#define COMPARE_THREADS 4
+
+static CMPIArray       *compareInsts;
+static CIMCResultTable *compareTable;
+
+static void *comparer(void *arg)
+{
+   return (void *) (long) compare(compareInsts, compareTable);
+}
+
+int main(int argc, char *argv[])
+{
+   CMPIObjectPath  *cop = newCMPIObjectPath("root/cimv2", "Bench_Element", NULL);
+   ParserHeap      *heap = parser_heap_init();
+   CIMCResultTable *rt = NULL;
+   CMPIArray       *insts = NULL;
+   ResponseHdr      rh;
+   const CMPIUint64 *column;
+   const unsigned char *nulls;
+   char            *response, *received;
+   double           start, parseInst = 0, parseTable = 0, sumInst = 0, sumTable = 0;
+   unsigned long long s1 = 0, s2 = 0;
+   size_t           len;
+   int              instances = 20000, iterations = 10, i, c, col, format,
+                    failed = 0;
+   CMPICount        n, r;
+   pthread_t        tid[COMPARE_THREADS];
+   void            *rv;
+
+   while ((c = getopt(argc, argv, "n:i:")) != -1) {
+      switch (c) {
+      case 'n': instances = atoi(optarg); break;
+      case 'i': iterations = atoi(optarg); break;
+      default:
+         fprintf(stderr, "usage: %s [-n instances] [-i iterations]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   response = benchEnumInstancesResponse(instances, 20);
+   len = strlen(response) + 1;
+   received = malloc(len);
+
+   for (i = 0; i < iterations; i++) {
+      if (insts)
+         CMRelease(insts);
+      if (rt)
+         rt->ft->release(rt);
+
+      memcpy(received, response, len);
+      start = benchNow();
+      rh = scanCimXmlResponse(received, cop, heap);
+      parseInst += benchNow() - start;
+      insts = rh.rvArray;
+
+      memcpy(received, response, len);
+      start = benchNow();
+      rt = newCIMCResultTable("root/cimv2");
+      rh = scanCimXmlTableResponse(received, cop, heap, rt);
+      parseTable += benchNow() - start;
+      CMRelease(rh.rvArray);
+
+      n = CMGetArrayCount(insts, NULL);
+      s1 = 0;
+      start = benchNow();
+      for (r = 0; r < n; r++)
+         s1 += CMGetProperty(CMGetArrayElementAt(insts, r, NULL).value.inst,
+                             "Counter0", NULL).value.uint64;
+      sumInst += benchNow() - start;
+
+      s2 = 0;
+      start = benchNow();
+      col = rt->ft->findColumn(rt, "Counter0", NULL);
+      column = rt->ft->getColumn(rt, col, &format, NULL);
+      nulls = rt->ft->getNulls(rt, col, NULL);
+      n = rt->ft->getRowCount(rt, NULL);
+      for (r = 0; r < n; r++)
+         if (!(nulls[r >> 3] & (1 << (r & 7))))
+            s2 += column[r];
+      sumTable += benchNow() - start;
+
+      if (s1 != s2 || format != CIMC_COLUMN_VALUES)
+         failed++;
+   }
+   /* the rows' strings are made on first read, by whichever thread */
+   compareInsts = insts;
+   compareTable = rt;
+   for (i = 0; i < COMPARE_THREADS; i++)
+      pthread_create(tid + i, NULL, comparer, NULL);
+   for (i = 0; i < COMPARE_THREADS; i++) {
+      pthread_join(tid[i], &rv);
+      failed += (int) (long) rv;
+   }
+
+   printf("%d instances of 22 properties, %d iterations\n", instances, iterations);
+   printf("parse   instances: %7.1f ms  table: %7.1f ms\n",
+          parseInst / iterations * 1e3, parseTable / iterations * 1e3);
+   printf("sum     instances: %7.3f ms  table: %7.3f ms\n",
+          sumInst / iterations * 1e3, sumTable / iterations * 1e3);
+   printf("%d failed\n", failed);
+
+   CMRelease(insts);
+   rt->ft->release(rt);
+   parser_heap_term(heap);
+   CMRelease(cop);
+   free(received);
+   free(response);
+   return failed != 0;
+}
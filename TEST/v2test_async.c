@@ -0,0 +1,114 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "cmcimacs.h"
+
+/*
+ * asynchronous enumerateInstanceNames: all requests are in flight at
+ * the same time, driven by wait() from this single thread
+ * usage: v2test_async [number of requests]
+ */
+
+static int completed = 0, failed = 0, names = 0;
+
+static void done(CIMCAsyncOp *op, void *data, CIMCStatus *rc, CIMCData *result)
+{
+    CIMCEnumeration *enm;
+
+    if (rc->rc) {
+       printf("  ERROR received for request %ld status.rc = %d\n",
+              (long)data, rc->rc);
+       if (rc->msg)
+          printf("  ERROR msg = %s\n", CMGetCharPtr(rc->msg));
+       failed++;
+       return;
+    }
+    enm = result->value.Enum;
+    while (enm->ft->hasNext(enm, NULL)) {
+       enm->ft->getNext(enm, NULL);
+       names++;
+    }
+    enm->ft->release(enm);
+    completed++;
+}
+
+int main(int argc, char *argv[])
+{
+CIMCEnv *ce;
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CIMCObjectPath *op = NULL;
+CIMCClient *client = NULL;
+CIMCAsync *as = NULL;
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+long i, requests = argc > 1 ? atol(argv[1]) : 100;
+struct timeval start, end;
+
+    /*
+     * Setup a connection to the CIMOM by checking environment
+     * if not found we default those values
+     */
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+
+    printf(" Testing asynchronous enumerateInstanceNames \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",0,&rc,&msg);
+    if(ce == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+
+    client = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    if (client == NULL) {
+	printf("Coudn't connect to the server. Check if sfcb is running.\n");
+	return 1;
+    }
+
+    as = ce->ft->newAsync(ce, &status);
+    if (as == NULL) {
+       printf(" failed the call to newAsync \n") ;
+       return 1;
+    }
+
+    op = ce->ft->newObjectPath(ce, "root/cimv2", "CIM_ManagedElement" , &status);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < requests; i++) {
+       if (as->ft->enumInstanceNames(as, client, op, done, (void*)i, &status) == NULL) {
+          printf("  ERROR submitting request %ld status.rc = %d\n", i, status.rc);
+          failed++;
+       }
+    }
+    while (as->ft->wait(as, 1000, NULL) > 0)
+       ;
+    gettimeofday(&end, NULL);
+
+    printf(" %d requests completed, %d failed, %d instance names, %ld ms\n",
+           completed, failed, names,
+           (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000);
+
+    as->ft->release(as);
+    if(op) op->ft->release(op);
+    if(client) client->ft->release(client);
+    if(ce) ReleaseCIMCEnv(ce);
+
+    return failed != 0;
+}
@@ -0,0 +1,153 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "cmcimacs.h"
+
+/*
+ * getClass and enumClasses with CIMC_OPT_CLASS_CACHE_SIZE set: repeated
+ * getClass calls are answered from the cache until the class is flushed,
+ * evicted or expired
+ * usage: v2test_classcache [number of getClass calls]
+ */
+
+static CIMCEnv *ce;
+static int failed = 0;
+
+static long usecs(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) * 1000000 + (end.tv_usec - start->tv_usec);
+}
+
+static CIMCUint64 roundTrips()
+{
+    return ce->ft->getCounter(ce, CIMC_CNT_POOL_HITS, NULL) +
+           ce->ft->getCounter(ce, CIMC_CNT_POOL_MISSES, NULL);
+}
+
+static void getClasses(CIMCClient *client, CIMCObjectPath *op, CIMCFlags flags,
+                       int n, const char *what)
+{
+    CIMCStatus status;
+    CIMCClass *cls;
+    CIMCUint64 trips;
+    struct timeval start;
+    long elapsed;
+    int i;
+
+    trips = roundTrips();
+    gettimeofday(&start, NULL);
+    for (i = 0; i < n; i++) {
+       cls = client->ft->getClass(client, op, flags, NULL, &status);
+       if (cls == NULL || cls->ft->getPropertyCount(cls, NULL) == 0) {
+          printf("  ERROR received from getClass status.rc = %d\n", status.rc);
+          failed++;
+       }
+       if (cls) cls->ft->release(cls);
+    }
+    elapsed = usecs(&start);
+    printf(" %s: %d getClass, %llu from the server, %.1f us each\n", what, n,
+           roundTrips() - trips,
+           (double) elapsed / n);
+}
+
+static void expect(int counter, CIMCUint64 value, const char *what)
+{
+    CIMCUint64 v = ce->ft->getCounter(ce, counter, NULL);
+
+    if (v != value) {
+       printf("  ERROR %s is %llu, expected %llu\n", what, v, value);
+       failed++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CIMCObjectPath *op = NULL, *op3 = NULL;
+CIMCEnumeration *enm;
+CIMCClient *client = NULL;
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+int n = argc > 1 ? atoi(argv[1]) : 1000;
+
+    /*
+     * Setup a connection to the CIMOM by checking environment
+     * if not found we default those values
+     */
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+
+    printf(" Testing the class cache \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",0,&rc,&msg);
+    if(ce == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+
+    client = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    if (client == NULL) {
+	printf("Coudn't connect to the server. Check if sfcb is running.\n");
+	return 1;
+    }
+
+    op = ce->ft->newObjectPath(ce, "root/cimv2", "CIM_ManagedElement" , &status);
+
+    getClasses(client, op, CIMC_FLAG_IncludeQualifiers, n / 10 + 1, "no cache");
+
+    ce->ft->setOption(ce, CIMC_OPT_CLASS_CACHE_SIZE, 100);
+    getClasses(client, op, CIMC_FLAG_IncludeQualifiers, n, "cached");
+    expect(CIMC_CNT_CLASS_CACHE_HITS, n - 1, "hits");
+    getClasses(client, op, CIMC_FLAG_LocalOnly, 1, "other flags");
+    expect(CIMC_CNT_CLASS_CACHE_ENTRIES, 2, "entries");
+
+    /* enumClasses fills the cache */
+    enm = client->ft->enumClasses(client, op, 0, &status);
+    if (enm) enm->ft->release(enm);
+    op3 = ce->ft->newObjectPath(ce, "root/cimv2", "c_3" , &status);
+    getClasses(client, op3, 0, 1, "enumerated");
+    expect(CIMC_CNT_CLASS_CACHE_MISSES, 2, "misses");
+
+    ce->ft->flushClassCache(ce, op);
+    getClasses(client, op, CIMC_FLAG_IncludeQualifiers, 1, "flushed");
+    expect(CIMC_CNT_CLASS_CACHE_MISSES, 3, "misses");
+
+    ce->ft->setOption(ce, CIMC_OPT_CLASS_CACHE_SIZE, 10);
+    expect(CIMC_CNT_CLASS_CACHE_ENTRIES, 10, "entries");
+
+    ce->ft->setOption(ce, CIMC_OPT_CLASS_CACHE_TTL, 1);
+    ce->ft->flushClassCache(ce, NULL);
+    getClasses(client, op, CIMC_FLAG_IncludeQualifiers, 1, "ttl");
+    sleep(2);
+    getClasses(client, op, CIMC_FLAG_IncludeQualifiers, 1, "expired");
+    expect(CIMC_CNT_CLASS_CACHE_MISSES, 5, "misses");
+
+    printf(" %d failed\n", failed);
+
+    if(op) op->ft->release(op);
+    if(op3) op3->ft->release(op3);
+    if(client) client->ft->release(client);
+    if(ce) ReleaseCIMCEnv(ce);
+
+    return failed != 0;
+}
@@ -0,0 +1,103 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "cmcimacs.h"
+
+/*
+ * enumerateInstances with CIMC_COMPRESS_RESPONSES, once read at a time
+ * and once streamed: reports the bytes received and decoded
+ */
+
+static int enumerate(CIMCEnv *ce, CIMCClient *client, CIMCObjectPath *op,
+                     const char *what)
+{
+   CIMCStatus status;
+   CIMCEnumeration *enm;
+   CIMCUint64 received, decoded;
+   int count = 0;
+
+   received = ce->ft->getCounter(ce, CIMC_CNT_BYTES_RECEIVED, NULL);
+   decoded = ce->ft->getCounter(ce, CIMC_CNT_BYTES_DECODED, NULL);
+
+   enm = client->ft->enumInstances(client, op, 0, NULL, &status);
+   if (enm == NULL) {
+      printf("  ERROR received from enumInstances status.rc = %d\n", status.rc);
+      if (status.msg)
+         printf("  ERROR msg = %s\n", CMGetCharPtr(status.msg));
+      return -1;
+   }
+   while (enm->ft->hasNext(enm, NULL)) {
+      enm->ft->getNext(enm, NULL);
+      count++;
+   }
+   enm->ft->release(enm);
+
+   received = ce->ft->getCounter(ce, CIMC_CNT_BYTES_RECEIVED, NULL) - received;
+   decoded = ce->ft->getCounter(ce, CIMC_CNT_BYTES_DECODED, NULL) - decoded;
+   printf(" %s: %d instances, %llu bytes received, %llu bytes decoded\n",
+          what, count, received, decoded);
+   return count;
+}
+
+int main()
+{
+CIMCEnv *ce, *ces;
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CIMCObjectPath *op = NULL;
+CIMCClient *client = NULL, *sclient = NULL;
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+int failed = 0;
+
+    /*
+     * Setup a connection to the CIMOM by checking environment
+     * if not found we default those values
+     */
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+
+    printf(" Testing compressed enumerateInstances \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",CIMC_COMPRESS_RESPONSES,&rc,&msg);
+    ces = NewCIMCEnv("XML",CIMC_COMPRESS_RESPONSES|CIMC_STREAM_ENUMERATIONS,&rc,&msg);
+    if(ce == NULL || ces == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+
+    client = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    sclient = ces->ft->connect(ces, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    if (client == NULL || sclient == NULL) {
+	printf("Coudn't connect to the server. Check if sfcb is running.\n");
+	return 1;
+    }
+
+    op = ce->ft->newObjectPath(ce, "root/cimv2", "CIM_ManagedElement" , &status);
+
+    failed += enumerate(ce, client, op, "read at once") < 0;
+    failed += enumerate(ces, sclient, op, "streamed") < 0;
+
+    if(op) op->ft->release(op);
+    client->ft->release(client);
+    sclient->ft->release(sclient);
+    ReleaseCIMCEnv(ce);
+    ReleaseCIMCEnv(ces);
+
+    return failed != 0;
+}
@@ -0,0 +1,100 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "cmcimacs.h"
+
+void showInstance( CMPIInstance * );
+
+/*
+ * enumerateInstances with CIMC_STREAM_ENUMERATIONS: instances are
+ * handed out while the response is still being received
+ */
+
+int main()
+{
+CIMCEnv *ce;
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CMPIObjectPath *op = NULL ;
+CIMCEnumeration *enm = NULL;
+CIMCClient *client = NULL;
+CIMCData data;
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+int count = 0;
+
+    /*
+     * Setup a connection to the CIMOM by checking environment 
+     * if not found we default those values
+     */
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+	     
+    printf(" Testing streamed enumerateInstances \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",CIMC_STREAM_ENUMERATIONS,&rc,&msg);
+    if(ce == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+    
+    client = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    if (client == NULL) {
+	printf("Coudn't connect to the server. Check if sfcb is running.\n");
+	return 1;
+    }
+    
+    op = (CMPIObjectPath *) ce->ft->newObjectPath(ce, "root/cimv2", "CIM_ManagedElement" , &status);     
+    if(op == NULL) 
+    {
+       printf(" failed the call to newObjectPath \n") ;	
+    }
+     
+    enm = client->ft->enumInstances(client,(CIMCObjectPath *) op, 0 , NULL, &status);
+
+    if(enm == NULL) 
+    {
+       printf(" failed the call to client->ft->enumInstances \n") ;	
+    }
+    
+    /* Print the results, each instance is only valid until the next call */
+   
+    if (!status.rc) {
+       printf("results:\n");
+       while (enm->ft->hasNext(enm, &status)) {
+          data = enm->ft->getNext(enm, NULL);
+          showInstance((CMPIInstance *)data.value.inst);
+          count++;
+       }
+       if (status.rc)
+          printf("  ERROR received while streaming status.rc = %d\n",status.rc) ;
+       printf("%d instances\n", count);
+    } else {
+       printf("  ERROR received from enumInstances status.rc = %d\n",status.rc) ;
+       if(status.msg)
+       	 printf("  ERROR msg = %s\n",CMGetCharPtr(status.msg)) ;
+    }
+    
+    if(enm) enm->ft->release(enm);
+    if(op) op->ft->release(op);
+    if(client) client->ft->release(client);
+    if(ce) ReleaseCIMCEnv(ce);
+    if(status.msg) CMRelease(status.msg);		       
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "cmcimacs.h"
+
+/*
+ * several clients of one environment issuing requests in turn: after the
+ * first request all of them should be served by the same pooled connection
+ */
+
+#define CLIENTS  4
+#define REQUESTS 5
+
+int main()
+{
+CIMCEnv *ce;
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CIMCObjectPath *cop = NULL;
+CIMCEnumeration *enm;
+CIMCClient *client[CLIENTS];
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+int i, c, failed = 0;
+
+    /*
+     * Setup a connection to the CIMOM by checking environment
+     * if not found we default those values
+     */
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+
+    printf(" Testing the connection pool \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",0,&rc,&msg);
+    if(ce == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+    ce->ft->setOption(ce, CIMC_OPT_POOL_SIZE, 2);
+    ce->ft->setOption(ce, CIMC_OPT_POOL_IDLE_TIMEOUT, 30);
+
+    for (c = 0; c < CLIENTS; c++) {
+       client[c] = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+       if (client[c] == NULL) {
+          printf("Coudn't connect to the server. Check if sfcb is running.\n");
+          return 1;
+       }
+    }
+
+    cop = ce->ft->newObjectPath(ce, "root/cimv2", NULL , &status);
+
+    for (i = 0; i < REQUESTS; i++) {
+       for (c = 0; c < CLIENTS; c++) {
+          enm = client[c]->ft->enumClassNames(client[c], cop, 0 , &status);
+          if (status.rc) {
+             printf("  ERROR received from enumClassNames status.rc = %d\n",status.rc) ;
+             if(status.msg)
+                printf("  ERROR msg = %s\n",CMGetCharPtr(status.msg)) ;
+             failed++;
+          }
+          if(enm) enm->ft->release(enm);
+       }
+    }
+
+    printf(" %d requests, pool hits %llu misses %llu expired %llu idle %llu\n",
+           CLIENTS * REQUESTS - failed,
+           ce->ft->getCounter(ce, CIMC_CNT_POOL_HITS, NULL),
+           ce->ft->getCounter(ce, CIMC_CNT_POOL_MISSES, NULL),
+           ce->ft->getCounter(ce, CIMC_CNT_POOL_EXPIRED, NULL),
+           ce->ft->getCounter(ce, CIMC_CNT_POOL_IDLE, NULL));
+
+    if(cop) cop->ft->release(cop);
+    for (c = 0; c < CLIENTS; c++)
+       client[c]->ft->release(client[c]);
+    if(ce) ReleaseCIMCEnv(ce);
+    if(status.msg) CMRelease(status.msg);
+
+    return 0;
+}
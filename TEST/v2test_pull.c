@@ -0,0 +1,99 @@
+#include <cimc.h>
+#include <cmci.h>
+#include <native.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "cmcimacs.h"
+
+/*
+ * enumerateInstances and enumerateInstanceNames with the pull operations:
+ * the enumerations are fetched page by page while they are iterated, the
+ * instance enumeration is released halfway to close it on the server
+ * usage: v2test_pull [objects per pull]
+ */
+
+static int pull(CIMCEnumeration *enm, CIMCStatus *status, int max)
+{
+   int count = 0;
+
+   if (enm == NULL)
+      return 0;
+   while ((max == 0 || count < max) && enm->ft->hasNext(enm, status)) {
+      enm->ft->getNext(enm, status);
+      count++;
+   }
+   if (status->rc) {
+      printf("  ERROR received from pull status.rc = %d\n", status->rc);
+      if (status->msg)
+         printf("  ERROR msg = %s\n", CMGetCharPtr(status->msg));
+   }
+   enm->ft->release(enm);
+   return count;
+}
+
+int main(int argc, char *argv[])
+{
+CIMCEnv *ce;
+char *msg = NULL;
+int rc;
+
+CIMCStatus status;
+CIMCObjectPath *op = NULL;
+CIMCEnumeration *enm;
+CIMCClient *client = NULL;
+char 	*cim_host, *cim_host_passwd, *cim_host_userid, *cim_host_port;
+long maxObjects = argc > 1 ? atol(argv[1]) : 100;
+int count, failed = 0;
+
+    /*
+     * Setup a connection to the CIMOM by checking environment
+     * if not found we default those values
+     */
+    cim_host = getenv("CIM_HOST");
+    if (cim_host == NULL)
+       cim_host = "localhost";
+    cim_host_userid = getenv("CIM_HOST_USERID");
+    if (cim_host_userid == NULL)
+       cim_host_userid = "root";
+    cim_host_passwd = getenv("CIM_HOST_PASSWD");
+    if (cim_host_passwd == NULL)
+       cim_host_passwd = "password";
+    cim_host_port = getenv("CIM_HOST_PORT");
+    if (cim_host_port == NULL)
+	     cim_host_port = "5988";
+
+    printf(" Testing pulled enumerateInstances and enumerateInstanceNames \n") ;
+    printf(" using XML HTTP interface : host = %s userid = %s port=%s\n",
+                          cim_host,cim_host_userid,cim_host_port) ;
+
+    ce = NewCIMCEnv("XML",0,&rc,&msg);
+    if(ce == NULL) {
+      printf(" local connect failed call to NewCIMCEnv message = [%s] \n",msg) ;
+      return 1;
+    }
+    ce->ft->setOption(ce, CIMC_OPT_PULL_MAX_OBJECT_COUNT, maxObjects);
+
+    client = ce->ft->connect(ce, cim_host , "http", cim_host_port, cim_host_userid, cim_host_passwd , &status);
+    if (client == NULL) {
+	printf("Coudn't connect to the server. Check if sfcb is running.\n");
+	return 1;
+    }
+
+    op = ce->ft->newObjectPath(ce, "root/cimv2", "CIM_ManagedElement" , &status);
+
+    enm = client->ft->openEnumInstanceNames(client, op, &status);
+    count = pull(enm, &status, 0);
+    printf(" %d instance names pulled, %ld per page\n", count, maxObjects);
+    failed += status.rc != 0;
+
+    enm = client->ft->openEnumInstances(client, op, 0, NULL, &status);
+    count = pull(enm, &status, count / 2);
+    printf(" %d instances pulled before releasing the enumeration\n", count);
+    failed += status.rc != 0;
+
+    if(op) op->ft->release(op);
+    if(client) client->ft->release(client);
+    if(ce) ReleaseCIMCEnv(ce);
+
+    return failed != 0;
+}
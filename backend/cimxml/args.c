@@ -41,7 +41,7 @@
  */
 struct native_args {
 	CMPIArgs args;	        /*!< the inheriting data structure  */
-	struct native_property * data;	/*!< argument content */
+	struct native_propertyTable * data;	/*!< argument content */
 };
 
 
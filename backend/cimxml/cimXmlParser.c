@@ -25,6 +25,14 @@
 #include <stdlib.h>
 #include <cmcidt.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && __GNUC__ >= 5 && defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_AVX2
+#endif
+
 #include "cimXmlParser.h"
 #include "grammar.h"
 
@@ -32,8 +40,6 @@
 #include "dmalloc.h"
 #endif
 
-#include <pthread.h>
-
 static int attrsOk(XmlBuffer * xb, const XmlElement * e, XmlAttr * r,
                    const char *tag, int etag);
 static char *getValue(XmlBuffer * xb, const char *v);
@@ -48,38 +54,164 @@ typedef struct tags {
 #define TAG(t) t,(sizeof(t)-1)
 
 
+/*
+ * Syntax errors unwind to the parse entry point, see parseXml(), which
+ * turns them into a CMPI_RC_ERR_FAILED response.
+ */
 static void Throw(XmlBuffer * xb, char *msg)
 {
-   printf("*** Error: %s\n", msg);
-   exit(1);
+   xb->error = strdup(msg);
+   longjmp(*xb->onError, 1);
 }
 
-static XmlBuffer *newXmlBuffer(const char *s)
+/*
+ * The lexer works in place: s belongs to the caller but is modified, the
+ * tokens are terminated by nulling the character following them. It must
+ * not be used as XML again once it has been parsed.
+ */
+static XmlBuffer *newXmlBuffer(char *s)
 {
    XmlBuffer *xb = (XmlBuffer *) malloc(sizeof(XmlBuffer));
    if(s){
-      xb->base = xb->cur = (char *) strdup(s);
+      xb->base = xb->cur = s;
       xb->last = xb->cur + strlen(xb->cur);
    }
    xb->nulledChar = 0;
    xb->eTagFound = 0;
    xb->etag = 0;
+   xb->onError = NULL;
+   xb->error = NULL;
    return xb;
 }
 
 static void releaseXmlBuffer(XmlBuffer *xb)
 {
-	  if(xb->base)
-       free (xb->base);
+    free (xb->error);
     free (xb);
 }
 
-inline void skipWS(XmlBuffer * xb)
+/*
+ * Scanning kernels: scanWS returns the first byte in [p, last) that is
+ * not white space, scanChar the first one that is c, both return last if
+ * there is none. Where SSE2 is available 16 bytes are compared at a time,
+ * 32 with AVX2 if the cpu supports it, the remainder before last is done
+ * bytewise so nothing beyond last is ever read. White space is compared
+ * signed, like the char compares they replace.
+ */
+#if defined(__SSE2__)
+
+static char *scanWS16(char *p, char *last)
+{
+   const __m128i sp = _mm_set1_epi8(' ');
+   int m;
+
+   for (; last - p >= 16; p += 16) {
+      m = _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((__m128i *) p), sp));
+      if (m)
+         return p + __builtin_ctz(m);
+   }
+   while (p < last && *p <= ' ')
+      p++;
+   return p;
+}
+
+static char *scanChar16(char *p, char *last, char c)
 {
-   static int c = 0;
-   c++;
-   while (*xb->cur <= ' ' && xb->last > xb->cur)
-      xb->cur++;
+   const __m128i cv = _mm_set1_epi8(c);
+   int m;
+
+   for (; last - p >= 16; p += 16) {
+      m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) p), cv));
+      if (m)
+         return p + __builtin_ctz(m);
+   }
+   while (p < last && *p != c)
+      p++;
+   return p;
+}
+
+#endif
+
+#ifdef SCAN_AVX2
+
+__attribute__((target("avx2")))
+static char *scanWS32(char *p, char *last)
+{
+   const __m256i sp = _mm256_set1_epi8(' ');
+   unsigned int m;
+
+   for (; last - p >= 32; p += 32) {
+      m = _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256((__m256i *) p), sp));
+      if (m)
+         return p + __builtin_ctz(m);
+   }
+   return scanWS16(p, last);
+}
+
+__attribute__((target("avx2")))
+static char *scanChar32(char *p, char *last, char c)
+{
+   const __m256i cv = _mm256_set1_epi8(c);
+   unsigned int m;
+
+   for (; last - p >= 32; p += 32) {
+      m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) p), cv));
+      if (m)
+         return p + __builtin_ctz(m);
+   }
+   return scanChar16(p, last, c);
+}
+
+/* -1 until the first scan asks the cpu, the answer is the same for all threads */
+static int haveAvx2 = -1;
+
+static int useAvx2(void)
+{
+   if (haveAvx2 < 0)
+      haveAvx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+   return haveAvx2;
+}
+
+#endif
+
+static inline char *scanWS(char *p, char *last)
+{
+   /* most runs are a newline or nothing, don't bother the vector unit */
+   if (p >= last || *p > ' ')
+      return p;
+   if (++p >= last || *p > ' ')
+      return p;
+#if defined(SCAN_AVX2)
+   if (last - p >= 32 && useAvx2())
+      return scanWS32(p, last);
+#endif
+#if defined(__SSE2__)
+   return scanWS16(p, last);
+#else
+   while (p < last && *p <= ' ')
+      p++;
+   return p;
+#endif
+}
+
+static inline char *scanChar(char *p, char *last, char c)
+{
+#if defined(SCAN_AVX2)
+   if (last - p >= 32 && useAvx2())
+      return scanChar32(p, last, c);
+#endif
+#if defined(__SSE2__)
+   return scanChar16(p, last, c);
+#else
+   while (p < last && *p != c)
+      p++;
+   return p;
+#endif
+}
+
+static inline void skipWS(XmlBuffer * xb)
+{
+   xb->cur = scanWS(xb->cur, xb->last);
 }
 
 static int getChars(XmlBuffer * xb, const char *s)
@@ -100,7 +232,7 @@ static int getChar(XmlBuffer * xb, const char c)
    return 0;
 }
 
-inline char *nextTag(XmlBuffer * xb)
+static inline char *nextTag(XmlBuffer * xb)
 {
    if (xb->nulledChar) {
       xb->nulledChar = 0;
@@ -112,7 +244,7 @@ inline char *nextTag(XmlBuffer * xb)
    return NULL;
 }
 
-inline  int nextEquals(const char *n, const char *t, const int l)
+static inline int nextEquals(const char *n, const char *t, const int l)
 {
    if (strncmp(n, t, l) == 0) {
       if (!isalnum(*(n + l))) {
@@ -124,8 +256,7 @@ inline  int nextEquals(const char *n, const char *t, const int l)
 
 static char skipTag(XmlBuffer * xb)
 {
-   while (*xb->cur != '>' && xb->last > xb->cur)
-      xb->cur++;
+   xb->cur = scanChar(xb->cur, xb->last, '>');
    xb->cur++;
    return *xb->cur;
 }
@@ -145,14 +276,12 @@ static int getWord(XmlBuffer * xb, const char *w, int xCase)
 
 static int tagEquals(XmlBuffer * xb, const char *t)
 {
-   char *start = NULL;
+   char *start = xb->cur;
    int sz = 0;
    if (*xb->cur == 0) {
       xb->cur++;
       sz = 1;
    }                            // why is this needed ?
-   else
-      start = xb->cur;
    skipWS(xb);
    if (sz || getChar(xb, '<')) {
       skipWS(xb);
@@ -209,6 +338,14 @@ static int attrsOk(XmlBuffer * xb, const XmlElement * e, XmlAttr * r,
     ok:;
    }
 
+   for (n = 0; (e + n)->attr; n++) {
+      if ((e + n)->required && (r + n)->attr == NULL) {
+         ptr = (char *) alloca(strlen(tag) + strlen((e + n)->attr) + 32);
+         sprintf(ptr, "Attribute %s missing in %s", (e + n)->attr, tag);
+         Throw(xb, ptr);
+      }
+   }
+
    if (getChars(xb, "/>")) {
       xb->eTagFound = 1;
       xb->etag = etag;
@@ -245,11 +382,11 @@ static char *getValue(XmlBuffer * xb, const char *v)
    char *start = NULL;
    if ((dlm = getChar(xb, '"')) || (dlm = getChar(xb, '\''))) {
       start = xb->cur;
-      while (*xb->cur != dlm) {
+      xb->cur = scanChar(xb->cur, xb->last, dlm);
+      if (xb->cur < xb->last) {
+         *xb->cur = 0;
          xb->cur++;
       }
-      *xb->cur = 0;
-      xb->cur++;
       return start;
    }
    return NULL;
@@ -262,7 +399,7 @@ static char *getContent(XmlBuffer * xb)
    char *start = xb->cur,*end;
    if (xb->eTagFound)
       return NULL;
-   for (; *xb->cur != '<' && xb->cur < xb->last; xb->cur++);
+   xb->cur = scanChar(xb->cur, xb->last, '<');
    if (start == xb->cur) return "";
 
    while (*start && *start<=' ') start++;
@@ -390,6 +527,19 @@ static int procSimpleResp(parseUnion * lvalp, ParserControl * parm)
    return 0;
 }
 
+static int procMultiResp(parseUnion * lvalp, ParserControl * parm)
+{
+   static XmlElement elm[] = {
+      {NULL}
+   };
+   XmlAttr attr[1];
+   if (tagEquals(parm->xmb, "MULTIRSP")) {
+      if (attrsOk(parm->xmb, elm, attr, "MULTIRSP", ZTOK_MULTIRSP))
+         return XTOK_MULTIRSP;
+   }
+   return 0;
+}
+
 static int procIMethodResp(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
@@ -433,7 +583,7 @@ static int procMethodResp(parseUnion * lvalp, ParserControl * parm)
 static int procErrorResp(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"CODE"},
+      {"CODE", 1},
       {"DESCRIPTION"},
       {NULL}
    };
@@ -569,7 +719,7 @@ static int procObjectPath(parseUnion * lvalp, ParserControl * parm)
 static int procNameSpace(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"NAME"},
+      {"NAME", 1},
       {NULL}
    };
    XmlAttr attr[1];
@@ -587,7 +737,7 @@ static int procNameSpace(parseUnion * lvalp, ParserControl * parm)
 static int procParamValue(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"NAME"},
+      {"NAME", 1},
       {"PARAMTYPE"},
       {"EMBEDDEDOBJECT"},
       {NULL}
@@ -606,7 +756,7 @@ static int procParamValue(parseUnion * lvalp, ParserControl * parm)
                || strcasecmp(attr[2].attr, "object") == 0) {
              lvalp->xtokParamValue.type = CMPI_instance;
            } else {
-             Throw(NULL, "Invalid value for attribute EmbeddedObject");
+             Throw(parm->xmb, "Invalid value for attribute EmbeddedObject");
            }
          }
          return XTOK_PARAMVALUE;
@@ -618,7 +768,7 @@ static int procParamValue(parseUnion * lvalp, ParserControl * parm)
 static int procClassName(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"NAME"},
+      {"NAME", 1},
       {NULL}
    };
    XmlAttr attr[1];
@@ -636,7 +786,7 @@ static int procClassName(parseUnion * lvalp, ParserControl * parm)
 static int procInstanceName(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"CLASSNAME"},
+      {"CLASSNAME", 1},
       {NULL}
    };
    XmlAttr attr[1];
@@ -655,7 +805,7 @@ static int procInstanceName(parseUnion * lvalp, ParserControl * parm)
 static int procKeyBinding(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"NAME"},
+      {"NAME", 1},
       {NULL}
    };
    XmlAttr attr[1];
@@ -673,7 +823,7 @@ static int procKeyBinding(parseUnion * lvalp, ParserControl * parm)
 static int procInstance(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"CLASSNAME"},
+      {"CLASSNAME", 1},
       {NULL}
    };
    XmlAttr attr[1];
@@ -692,7 +842,7 @@ static int procInstance(parseUnion * lvalp, ParserControl * parm)
 static int procClass(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-      {"NAME"},
+      {"NAME", 1},
       {"SUPERCLASS"},
       {NULL}
    };
@@ -877,9 +1027,24 @@ static int procValueObjectWithPath(parseUnion * lvalp, ParserControl * parm)
    return 0;
 }
 
+static int procValueInstanceWithPath(parseUnion * lvalp, ParserControl * parm)
+{
+   static XmlElement elm[] = {
+      {NULL}
+   };
+   XmlAttr attr[1];
+   if (tagEquals(parm->xmb, "VALUE.INSTANCEWITHPATH")) {
+      if (attrsOk(parm->xmb, elm, attr, "VALUE.INSTANCEWITHPATH",
+           ZTOK_VALUEINSTANCEWITHPATH)) {
+         return XTOK_VALUEINSTANCEWITHPATH;
+      }
+   }
+   return 0;
+}
+
 static int procQualifier(parseUnion * lvalp, ParserControl * parm)
 {
-   static XmlElement elm[] = { {"NAME"},
+   static XmlElement elm[] = { {"NAME", 1},
    {"TYPE"},
    {"PROPAGATED"},
    {"OVERRIDABLE"},
@@ -917,7 +1082,7 @@ static int procQualifier(parseUnion * lvalp, ParserControl * parm)
 
 static int procProperty(parseUnion * lvalp, ParserControl * parm)
 {
-   static XmlElement elm[] = { {"NAME"},
+   static XmlElement elm[] = { {"NAME", 1},
    {"TYPE"},
    {"CLASSORIGIN"},
    {"PROPAGATED"},
@@ -948,7 +1113,7 @@ static int procProperty(parseUnion * lvalp, ParserControl * parm)
 
 static int procPropertyArray(parseUnion * lvalp, ParserControl * parm)
 {
-   static XmlElement elmPA[] = { {"NAME"},
+   static XmlElement elmPA[] = { {"NAME", 1},
    {"TYPE"},
    {"CLASSORIGIN"},
    {"PROPAGATED"},
@@ -979,7 +1144,7 @@ static int procPropertyArray(parseUnion * lvalp, ParserControl * parm)
 
 static int procPropertyReference(parseUnion * lvalp, ParserControl * parm)
 {
-   static XmlElement elm[] = { {"NAME"},
+   static XmlElement elm[] = { {"NAME", 1},
    {"REFERENCECLASS"},
    {"CLASSORIGIN"},
    {"PROPAGATED"},
@@ -1007,7 +1172,7 @@ static int procPropertyReference(parseUnion * lvalp, ParserControl * parm)
 
 static int procMethod(parseUnion * lvalp, ParserControl * parm)
 {
-   static XmlElement elm[] = { {"NAME"},
+   static XmlElement elm[] = { {"NAME", 1},
    {"TYPE"},
    {"CLASSORIGIN"},
    {"PROPAGATED"},
@@ -1036,7 +1201,7 @@ static int procMethod(parseUnion * lvalp, ParserControl * parm)
 static int procParam(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] =
-   { {"NAME"},
+   { {"NAME", 1},
      {"TYPE"},
      {NULL}
    };
@@ -1061,7 +1226,7 @@ static int procParam(parseUnion * lvalp, ParserControl * parm)
 static int procParamArray(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] =
-   { {"NAME"},
+   { {"NAME", 1},
      {"TYPE"},
      {"ARRAYSIZE"},
      {NULL}
@@ -1088,7 +1253,7 @@ static int procParamArray(parseUnion * lvalp, ParserControl * parm)
 static int procParamRef(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] =
-   { {"NAME"},
+   { {"NAME", 1},
      {"REFERENCECLASS"},
      {NULL}
    };
@@ -1112,7 +1277,7 @@ static int procParamRef(parseUnion * lvalp, ParserControl * parm)
 static int procParamRefArray(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] =
-   { {"NAME"},
+   { {"NAME", 1},
      {"REFERENCECLASS"},
      {"ARRAYSIZE"},
      {NULL}
@@ -1155,7 +1320,7 @@ static int procSimpleExpReq(parseUnion * lvalp, ParserControl * parm)
 static int procExportMethodCall(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-     {"NAME"},
+     {"NAME", 1},
       {NULL}
    };
    XmlAttr   attr[1];
@@ -1174,7 +1339,7 @@ static int procExportMethodCall(parseUnion * lvalp, ParserControl * parm)
 static int procExParamValue(parseUnion * lvalp, ParserControl * parm)
 {
    static XmlElement elm[] = {
-     {"NAME"},
+     {"NAME", 1},
       {NULL}
    };
    XmlAttr   attr[1];
@@ -1216,59 +1381,315 @@ static int procCdata(parseUnion * lvalp, ParserControl * parm)
    return 0;
 }
 
-static Tags tags[] = {
-   {TAG("?xml"), procXml, ZTOK_XML},
-   {TAG("CIM"), procCim, ZTOK_CIM},
-   {TAG("MESSAGE"), procMessage, ZTOK_MESSAGE},
-   {TAG("SIMPLERSP"), procSimpleResp, ZTOK_SIMPLERSP},
-   {TAG("ERROR"), procErrorResp, ZTOK_ERROR},
-   {TAG("IMETHODRESPONSE"), procIMethodResp, ZTOK_IMETHODRESP},
-   {TAG("IRETURNVALUE"), procIRetValue, ZTOK_IRETVALUE},
-   {TAG("LOCALNAMESPACEPATH"), procLocalNameSpacePath, ZTOK_LOCALNAMESPACEPATH},
-   {TAG("LOCALINSTANCEPATH"), procLocalInstancePath, ZTOK_LOCALINSTANCEPATH},
-   {TAG("LOCALCLASSPATH"), procLocalClassPath, ZTOK_LOCALCLASSPATH},
-   {TAG("NAMESPACEPATH"), procNameSpacePath, ZTOK_NAMESPACEPATH},
-   {TAG("NAMESPACE"), procNameSpace, ZTOK_NAMESPACE},
-   {TAG("PARAMVALUE"), procParamValue, ZTOK_PARAMVALUE},
-   {TAG("CLASSNAME"), procClassName, ZTOK_CLASSNAME},
-   {TAG("VALUE.ARRAY"), procValueArray, ZTOK_VALUEARRAY},
-   {TAG("VALUE.NAMEDINSTANCE"), procValueNamedInstance, ZTOK_VALUENAMEDINSTANCE},
-   {TAG("VALUE.REFERENCE"), procValueReference, ZTOK_VALUEREFERENCE},
-   {TAG("VALUE.REFARRAY"), procValueRefArray, ZTOK_VALUEREFARRAY},
-   {TAG("VALUE.OBJECTWITHPATH"), procValueObjectWithPath, ZTOK_VALUEOBJECTWITHPATH},
-   {TAG("VALUE"), procValue, ZTOK_VALUE},
-   {TAG("HOST"), procHost, ZTOK_HOST},
-   {TAG("KEYVALUE"), procKeyValue, ZTOK_KEYVALUE},
-   {TAG("KEYBINDING"), procKeyBinding, ZTOK_KEYBINDING},
-   {TAG("INSTANCEPATH"), procInstancePath, ZTOK_INSTANCEPATH},
-   {TAG("INSTANCENAME"), procInstanceName, ZTOK_INSTANCENAME},
-   {TAG("INSTANCE"), procInstance, ZTOK_INSTANCE},
-   {TAG("PROPERTY.REFERENCE"), procPropertyReference, ZTOK_PROPERTYREFERENCE},
-   {TAG("PROPERTY.ARRAY"), procPropertyArray, ZTOK_PROPERTYARRAY},
-   {TAG("PROPERTY"), procProperty, ZTOK_PROPERTY},
-   {TAG("QUALIFIER"), procQualifier, ZTOK_QUALIFIER},
-   {TAG("PARAMETER.ARRAY"), procParamArray, ZTOK_PARAMARRAY},
-   {TAG("PARAMETER.REFERENCE"), procParamRef, ZTOK_PARAMREF},
-   {TAG("PARAMETER.REFARRAY"), procParamRefArray, ZTOK_PARAMREFARRAY},
-   {TAG("PARAMETER"), procParam, ZTOK_PARAM},
-   {TAG("METHOD"), procMethod, ZTOK_METHOD},
-   {TAG("CLASS"), procClass, ZTOK_CLASS},
-   {TAG("OBJECTPATH"), procObjectPath, ZTOK_OBJECTPATH},
-   {TAG("METHODRESPONSE"), procMethodResp, ZTOK_METHODRESP},
-   {TAG("RETURNVALUE"), procRetValue, ZTOK_RETVALUE},
-   {TAG("CLASSPATH"), procClassPath, ZTOK_CLASSPATH},
-   {TAG("SIMPLEEXPREQ"), procSimpleExpReq, ZTOK_SIMPLEEXPREQ},
-   {TAG("EXPMETHODCALL"), procExportMethodCall, ZTOK_EXPMETHODCALL},
-   {TAG("EXPPARAMVALUE"), procExParamValue, ZTOK_EXPPARAMVALUE},
-   {TAG("![CDATA["), procCdata, ZTOK_CDATA},
-   {TAG(""), procCdata, ZTOK_CDATA},
+enum {
+   T_XML,
+   T_CIM,
+   T_MESSAGE,
+   T_SIMPLERSP,
+   T_MULTIRSP,
+   T_ERROR,
+   T_IMETHODRESPONSE,
+   T_IRETURNVALUE,
+   T_LOCALNAMESPACEPATH,
+   T_LOCALINSTANCEPATH,
+   T_LOCALCLASSPATH,
+   T_NAMESPACEPATH,
+   T_NAMESPACE,
+   T_PARAMVALUE,
+   T_CLASSNAME,
+   T_VALUE_ARRAY,
+   T_VALUE_NAMEDINSTANCE,
+   T_VALUE_REFERENCE,
+   T_VALUE_REFARRAY,
+   T_VALUE_OBJECTWITHPATH,
+   T_VALUE_INSTANCEWITHPATH,
+   T_VALUE,
+   T_HOST,
+   T_KEYVALUE,
+   T_KEYBINDING,
+   T_INSTANCEPATH,
+   T_INSTANCENAME,
+   T_INSTANCE,
+   T_PROPERTY_REFERENCE,
+   T_PROPERTY_ARRAY,
+   T_PROPERTY,
+   T_QUALIFIER,
+   T_PARAMETER_ARRAY,
+   T_PARAMETER_REFERENCE,
+   T_PARAMETER_REFARRAY,
+   T_PARAMETER,
+   T_METHOD,
+   T_CLASS,
+   T_OBJECTPATH,
+   T_METHODRESPONSE,
+   T_RETURNVALUE,
+   T_CLASSPATH,
+   T_SIMPLEEXPREQ,
+   T_EXPMETHODCALL,
+   T_EXPPARAMVALUE,
+   T_CDATA,
+   T_CDATA_END,
+   TAGS_NITEMS
+};
+
+static const Tags tags[TAGS_NITEMS] = {
+   [T_XML] = {TAG("?xml"), procXml, ZTOK_XML},
+   [T_CIM] = {TAG("CIM"), procCim, ZTOK_CIM},
+   [T_MESSAGE] = {TAG("MESSAGE"), procMessage, ZTOK_MESSAGE},
+   [T_SIMPLERSP] = {TAG("SIMPLERSP"), procSimpleResp, ZTOK_SIMPLERSP},
+   [T_MULTIRSP] = {TAG("MULTIRSP"), procMultiResp, ZTOK_MULTIRSP},
+   [T_ERROR] = {TAG("ERROR"), procErrorResp, ZTOK_ERROR},
+   [T_IMETHODRESPONSE] = {TAG("IMETHODRESPONSE"), procIMethodResp, ZTOK_IMETHODRESP},
+   [T_IRETURNVALUE] = {TAG("IRETURNVALUE"), procIRetValue, ZTOK_IRETVALUE},
+   [T_LOCALNAMESPACEPATH] = {TAG("LOCALNAMESPACEPATH"), procLocalNameSpacePath, ZTOK_LOCALNAMESPACEPATH},
+   [T_LOCALINSTANCEPATH] = {TAG("LOCALINSTANCEPATH"), procLocalInstancePath, ZTOK_LOCALINSTANCEPATH},
+   [T_LOCALCLASSPATH] = {TAG("LOCALCLASSPATH"), procLocalClassPath, ZTOK_LOCALCLASSPATH},
+   [T_NAMESPACEPATH] = {TAG("NAMESPACEPATH"), procNameSpacePath, ZTOK_NAMESPACEPATH},
+   [T_NAMESPACE] = {TAG("NAMESPACE"), procNameSpace, ZTOK_NAMESPACE},
+   [T_PARAMVALUE] = {TAG("PARAMVALUE"), procParamValue, ZTOK_PARAMVALUE},
+   [T_CLASSNAME] = {TAG("CLASSNAME"), procClassName, ZTOK_CLASSNAME},
+   [T_VALUE_ARRAY] = {TAG("VALUE.ARRAY"), procValueArray, ZTOK_VALUEARRAY},
+   [T_VALUE_NAMEDINSTANCE] = {TAG("VALUE.NAMEDINSTANCE"), procValueNamedInstance, ZTOK_VALUENAMEDINSTANCE},
+   [T_VALUE_REFERENCE] = {TAG("VALUE.REFERENCE"), procValueReference, ZTOK_VALUEREFERENCE},
+   [T_VALUE_REFARRAY] = {TAG("VALUE.REFARRAY"), procValueRefArray, ZTOK_VALUEREFARRAY},
+   [T_VALUE_OBJECTWITHPATH] = {TAG("VALUE.OBJECTWITHPATH"), procValueObjectWithPath, ZTOK_VALUEOBJECTWITHPATH},
+   [T_VALUE_INSTANCEWITHPATH] = {TAG("VALUE.INSTANCEWITHPATH"), procValueInstanceWithPath, ZTOK_VALUEINSTANCEWITHPATH},
+   [T_VALUE] = {TAG("VALUE"), procValue, ZTOK_VALUE},
+   [T_HOST] = {TAG("HOST"), procHost, ZTOK_HOST},
+   [T_KEYVALUE] = {TAG("KEYVALUE"), procKeyValue, ZTOK_KEYVALUE},
+   [T_KEYBINDING] = {TAG("KEYBINDING"), procKeyBinding, ZTOK_KEYBINDING},
+   [T_INSTANCEPATH] = {TAG("INSTANCEPATH"), procInstancePath, ZTOK_INSTANCEPATH},
+   [T_INSTANCENAME] = {TAG("INSTANCENAME"), procInstanceName, ZTOK_INSTANCENAME},
+   [T_INSTANCE] = {TAG("INSTANCE"), procInstance, ZTOK_INSTANCE},
+   [T_PROPERTY_REFERENCE] = {TAG("PROPERTY.REFERENCE"), procPropertyReference, ZTOK_PROPERTYREFERENCE},
+   [T_PROPERTY_ARRAY] = {TAG("PROPERTY.ARRAY"), procPropertyArray, ZTOK_PROPERTYARRAY},
+   [T_PROPERTY] = {TAG("PROPERTY"), procProperty, ZTOK_PROPERTY},
+   [T_QUALIFIER] = {TAG("QUALIFIER"), procQualifier, ZTOK_QUALIFIER},
+   [T_PARAMETER_ARRAY] = {TAG("PARAMETER.ARRAY"), procParamArray, ZTOK_PARAMARRAY},
+   [T_PARAMETER_REFERENCE] = {TAG("PARAMETER.REFERENCE"), procParamRef, ZTOK_PARAMREF},
+   [T_PARAMETER_REFARRAY] = {TAG("PARAMETER.REFARRAY"), procParamRefArray, ZTOK_PARAMREFARRAY},
+   [T_PARAMETER] = {TAG("PARAMETER"), procParam, ZTOK_PARAM},
+   [T_METHOD] = {TAG("METHOD"), procMethod, ZTOK_METHOD},
+   [T_CLASS] = {TAG("CLASS"), procClass, ZTOK_CLASS},
+   [T_OBJECTPATH] = {TAG("OBJECTPATH"), procObjectPath, ZTOK_OBJECTPATH},
+   [T_METHODRESPONSE] = {TAG("METHODRESPONSE"), procMethodResp, ZTOK_METHODRESP},
+   [T_RETURNVALUE] = {TAG("RETURNVALUE"), procRetValue, ZTOK_RETVALUE},
+   [T_CLASSPATH] = {TAG("CLASSPATH"), procClassPath, ZTOK_CLASSPATH},
+   [T_SIMPLEEXPREQ] = {TAG("SIMPLEEXPREQ"), procSimpleExpReq, ZTOK_SIMPLEEXPREQ},
+   [T_EXPMETHODCALL] = {TAG("EXPMETHODCALL"), procExportMethodCall, ZTOK_EXPMETHODCALL},
+   [T_EXPPARAMVALUE] = {TAG("EXPPARAMVALUE"), procExParamValue, ZTOK_EXPPARAMVALUE},
+   [T_CDATA] = {TAG("![CDATA["), procCdata, ZTOK_CDATA},
+   [T_CDATA_END] = {TAG(""), procCdata, ZTOK_CDATA},
    /* The last two lines are a hack for embedded instances. The CDATA
     * construct does not have a <x> ... </x> form but rather something like
     * <bla ....>, which is not a real tag. so the second line is necessary
     * for our lexer to find the closing "tag" for that case, which is just
     * an empty string */
 };
-#define TAGS_NITEMS	(int)(sizeof(tags)/sizeof(Tags))
+
+/*
+ * Element names are looked up by length and first character instead of
+ * comparing them with all of tags[] in turn. Like nextEquals(), a name
+ * ends at the first character that is not alphanumeric, so VALUE.NULL is
+ * taken for VALUE when there is no entry for it.
+ */
+#define TAG_IS(n, t) (memcmp(n, t, sizeof(t) - 1) == 0)
+
+static int tagIndex(const char *n, int l)
+{
+   switch (l) {
+   case 3:
+      if (TAG_IS(n, "CIM")) return T_CIM;
+      break;
+   case 4:
+      if (TAG_IS(n, "HOST")) return T_HOST;
+      break;
+   case 5:
+      switch (*n) {
+      case 'C':
+         if (TAG_IS(n, "CLASS")) return T_CLASS;
+         break;
+      case 'E':
+         if (TAG_IS(n, "ERROR")) return T_ERROR;
+         break;
+      case 'V':
+         if (TAG_IS(n, "VALUE")) return T_VALUE;
+         break;
+      }
+      break;
+   case 6:
+      if (TAG_IS(n, "METHOD")) return T_METHOD;
+      break;
+   case 7:
+      if (TAG_IS(n, "MESSAGE")) return T_MESSAGE;
+      break;
+   case 8:
+      switch (*n) {
+      case 'I':
+         if (TAG_IS(n, "INSTANCE")) return T_INSTANCE;
+         break;
+      case 'K':
+         if (TAG_IS(n, "KEYVALUE")) return T_KEYVALUE;
+         break;
+      case 'M':
+         if (TAG_IS(n, "MULTIRSP")) return T_MULTIRSP;
+         break;
+      case 'P':
+         if (TAG_IS(n, "PROPERTY")) return T_PROPERTY;
+         break;
+      }
+      break;
+   case 9:
+      switch (*n) {
+      case 'C':
+         if (TAG_IS(n, "CLASSNAME")) return T_CLASSNAME;
+         if (TAG_IS(n, "CLASSPATH")) return T_CLASSPATH;
+         break;
+      case 'N':
+         if (TAG_IS(n, "NAMESPACE")) return T_NAMESPACE;
+         break;
+      case 'P':
+         if (TAG_IS(n, "PARAMETER")) return T_PARAMETER;
+         break;
+      case 'Q':
+         if (TAG_IS(n, "QUALIFIER")) return T_QUALIFIER;
+         break;
+      case 'S':
+         if (TAG_IS(n, "SIMPLERSP")) return T_SIMPLERSP;
+         break;
+      }
+      break;
+   case 10:
+      switch (*n) {
+      case 'K':
+         if (TAG_IS(n, "KEYBINDING")) return T_KEYBINDING;
+         break;
+      case 'O':
+         if (TAG_IS(n, "OBJECTPATH")) return T_OBJECTPATH;
+         break;
+      case 'P':
+         if (TAG_IS(n, "PARAMVALUE")) return T_PARAMVALUE;
+         break;
+      }
+      break;
+   case 11:
+      switch (*n) {
+      case 'R':
+         if (TAG_IS(n, "RETURNVALUE")) return T_RETURNVALUE;
+         break;
+      case 'V':
+         if (TAG_IS(n, "VALUE.ARRAY")) return T_VALUE_ARRAY;
+         break;
+      }
+      break;
+   case 12:
+      switch (*n) {
+      case 'I':
+         if (TAG_IS(n, "IRETURNVALUE")) return T_IRETURNVALUE;
+         if (TAG_IS(n, "INSTANCEPATH")) return T_INSTANCEPATH;
+         if (TAG_IS(n, "INSTANCENAME")) return T_INSTANCENAME;
+         break;
+      case 'S':
+         if (TAG_IS(n, "SIMPLEEXPREQ")) return T_SIMPLEEXPREQ;
+         break;
+      }
+      break;
+   case 13:
+      switch (*n) {
+      case 'E':
+         if (TAG_IS(n, "EXPMETHODCALL")) return T_EXPMETHODCALL;
+         if (TAG_IS(n, "EXPPARAMVALUE")) return T_EXPPARAMVALUE;
+         break;
+      case 'N':
+         if (TAG_IS(n, "NAMESPACEPATH")) return T_NAMESPACEPATH;
+         break;
+      }
+      break;
+   case 14:
+      switch (*n) {
+      case 'L':
+         if (TAG_IS(n, "LOCALCLASSPATH")) return T_LOCALCLASSPATH;
+         break;
+      case 'M':
+         if (TAG_IS(n, "METHODRESPONSE")) return T_METHODRESPONSE;
+         break;
+      case 'P':
+         if (TAG_IS(n, "PROPERTY.ARRAY")) return T_PROPERTY_ARRAY;
+         break;
+      case 'V':
+         if (TAG_IS(n, "VALUE.REFARRAY")) return T_VALUE_REFARRAY;
+         break;
+      }
+      break;
+   case 15:
+      switch (*n) {
+      case 'I':
+         if (TAG_IS(n, "IMETHODRESPONSE")) return T_IMETHODRESPONSE;
+         break;
+      case 'P':
+         if (TAG_IS(n, "PARAMETER.ARRAY")) return T_PARAMETER_ARRAY;
+         break;
+      case 'V':
+         if (TAG_IS(n, "VALUE.REFERENCE")) return T_VALUE_REFERENCE;
+         break;
+      }
+      break;
+   case 17:
+      if (TAG_IS(n, "LOCALINSTANCEPATH")) return T_LOCALINSTANCEPATH;
+      break;
+   case 18:
+      switch (*n) {
+      case 'L':
+         if (TAG_IS(n, "LOCALNAMESPACEPATH")) return T_LOCALNAMESPACEPATH;
+         break;
+      case 'P':
+         if (TAG_IS(n, "PROPERTY.REFERENCE")) return T_PROPERTY_REFERENCE;
+         if (TAG_IS(n, "PARAMETER.REFARRAY")) return T_PARAMETER_REFARRAY;
+         break;
+      }
+      break;
+   case 19:
+      switch (*n) {
+      case 'P':
+         if (TAG_IS(n, "PARAMETER.REFERENCE")) return T_PARAMETER_REFERENCE;
+         break;
+      case 'V':
+         if (TAG_IS(n, "VALUE.NAMEDINSTANCE")) return T_VALUE_NAMEDINSTANCE;
+         break;
+      }
+      break;
+   case 20:
+      if (TAG_IS(n, "VALUE.OBJECTWITHPATH")) return T_VALUE_OBJECTWITHPATH;
+      break;
+   case 22:
+      if (TAG_IS(n, "VALUE.INSTANCEWITHPATH")) return T_VALUE_INSTANCEWITHPATH;
+      break;
+   }
+   return -1;
+}
+
+static int findTag(const char *n)
+{
+   const char *e;
+   int i;
+
+   if (*n == '?' && nextEquals(n, "?xml", 4))
+      return T_XML;
+   if (*n == '!' && nextEquals(n, "![CDATA[", 8))
+      return T_CDATA;
+   if (!isalnum(*n))
+      return T_CDATA_END;
+
+   for (e = n; isalnum(*e) || *e == '.'; e++);
+   while ((i = tagIndex(n, e - n)) < 0) {
+      /* VALUE.NULL and the like: retry with what is before the last dot */
+      for (e--; e > n && *e != '.'; e--);
+      if (e == n)
+         return -1;
+   }
+   return i;
+}
+
 
 int sfccLex(parseUnion * lvalp, ParserControl * parm)
 {
@@ -1287,25 +1708,23 @@ int sfccLex(parseUnion * lvalp, ParserControl * parm)
       }
 
       if (*next == '/') {
-         for (i = 0; i < TAGS_NITEMS; i++) {
-            if (nextEquals(next + 1, tags[i].tag, tags[i].tagLen) == 1) {
-               skipTag(parm->xmb);
-               return tags[i].etag;
-            }
+         if ((i = findTag(next + 1)) >= 0) {
+            skipTag(parm->xmb);
+            return tags[i].etag;
          }
       }
 
       else {
          if (strncmp(parm->xmb->cur, "<!--", 4) == 0) {
-            parm->xmb->cur = strstr(parm->xmb->cur, "-->") + 3;
+            if ((next = strstr(parm->xmb->cur, "-->")) == NULL)
+               Throw(parm->xmb, "Unterminated comment");
+            parm->xmb->cur = next + 3;
             continue;
          }
-         for (i = 0; i < TAGS_NITEMS; i++) {
-            if (nextEquals(next, tags[i].tag, tags[i].tagLen) == 1) {
-//	       printf("+++ %d\n",i);
-               rc=tags[i].process(lvalp, parm);
-               return rc;
-            }
+         if ((i = findTag(next)) >= 0) {
+//	    printf("+++ %d\n",i);
+            rc=tags[i].process(lvalp, parm);
+            return rc;
          }
       }
       break;
@@ -1313,12 +1732,75 @@ int sfccLex(parseUnion * lvalp, ParserControl * parm)
    return 0;
 }
 
-static pthread_mutex_t scan_mutex = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * Runs parse() on control. A syntax error found on the way unwinds to here
+ * and becomes the CMPI_RC_ERR_FAILED error of control->respHdr, -1 is
+ * returned then. What the grammar had allocated from the parser heap is
+ * given up with the heap by the caller.
+ */
+static int parseXml(ParserControl *control, void (*parse)(ParserControl *))
+{
+   ResponseHdr *hdr = &control->respHdr;
+   XmlBuffer *xmb = control->xmb;
+   jmp_buf env;
+
+   xmb->onError = &env;
+   if (setjmp(env) == 0) {
+      parse(control);
+      xmb->onError = NULL;
+      return 0;
+   }
+   xmb->onError = NULL;
+   free(hdr->description);
+   hdr->errCode = CMPI_RC_ERR_FAILED;
+   hdr->description = xmb->error;
+   xmb->error = NULL;
+   return -1;
+}
+
+/* the results decoded before a syntax error are not returned */
+static void dropResults(ResponseHdr *hdr)
+{
+   CMRelease(hdr->rvArray);
+   hdr->rvArray = newCMPIArray(0, 0, NULL);
+   if (hdr->outArgs) {
+      CMRelease(hdr->outArgs);
+      hdr->outArgs = NULL;
+   }
+   free(hdr->enumerationContext);
+   hdr->enumerationContext = NULL;
+}
 
-ResponseHdr scanCimXmlResponse(const char *xmlData, CMPIObjectPath *cop)
+/*
+ * Scans xmlData with control, on which the caller has set what to decode
+ * into and the object paths of the request, if any.
+ */
+static ResponseHdr scanWithControl(ParserControl *control, char *xmlData,
+                                   ParserHeap *heap)
 {
+   XmlBuffer *xmb = newXmlBuffer(xmlData);
 
-   pthread_mutex_lock(&scan_mutex);
+   control->xmb = xmb;
+   control->respHdr.xmlBuffer = xmb;
+   control->respHdr.rvArray = newCMPIArray(0, 0, NULL);
+   control->heap = heap ? heap : parser_heap_init();
+
+   if (parseXml(control, startParsing))
+      dropResults(&control->respHdr);
+
+   if (heap)
+      parser_heap_reset(heap);
+   else
+      parser_heap_term(control->heap);
+
+   releaseXmlBuffer(xmb);
+
+   return control->respHdr;
+}
+
+ResponseHdr scanCimXmlResponse(char *xmlData, CMPIObjectPath *cop,
+                               ParserHeap *heap)
+{
    ParserControl control;
 #if DEBUG
    extern int do_debug;
@@ -1328,111 +1810,402 @@ ResponseHdr scanCimXmlResponse(const char *xmlData, CMPIObjectPath *cop)
 #endif
 
    memset(&control,0,sizeof(control));
+   control.requestObjectPath = cop;
 
-   XmlBuffer *xmb = newXmlBuffer(xmlData);
-   control.xmb = xmb;
-   control.respHdr.xmlBuffer = xmb;
+   return scanWithControl(&control, xmlData, heap);
+}
 
-   control.respHdr.rvArray=newCMPIArray(0,0,NULL);
+/*
+ * Like scanCimXmlResponse(), but the named instances of an EnumerateInstances
+ * response are added to table instead of respHdr.rvArray.
+ */
+ResponseHdr scanCimXmlTableResponse(char *xmlData, CMPIObjectPath *cop,
+                                    ParserHeap *heap,
+                                    struct _CIMCResultTable *table)
+{
+   ParserControl control;
 
+   memset(&control,0,sizeof(control));
    control.requestObjectPath = cop;
+   control.table = table;
+
+   return scanWithControl(&control, xmlData, heap);
+}
+
+/*
+ * Scans the response to a multiple operation request; the results of the
+ * operations are in respHdr.responses, cops are the object paths of the
+ * operations in the same order.
+ */
+ResponseHdr scanCimXmlMultiResponse(char *xmlData, CMPIObjectPath **cops,
+                                    int numCops, ParserHeap *heap)
+{
+   ParserControl control;
+
+   memset(&control,0,sizeof(control));
+   control.requestObjectPaths = cops;
+   control.numRequestObjectPaths = numCops;
+   control.requestObjectPath = numCops ? cops[0] : NULL;
+
+   return scanWithControl(&control, xmlData, heap);
+}
+
+/* --------------------------------------------------------------------------*/
+
+/*
+ * Incremental scanning of intrinsic method responses: result elements
+ * inside IRETURNVALUE are cut out of the data received so far as soon as
+ * their closing tag has arrived and are run through the grammar on their
+ * own. Only the unparsed tail of the response is kept in memory.
+ */
+
+XmlStream *newXmlStream(CMPIObjectPath *cop)
+{
+   XmlStream *xs = (XmlStream *) calloc(1, sizeof(XmlStream));
+   xs->max = 8192;
+   xs->buf = (char *) malloc(xs->max);
+   xs->buf[0] = 0;
+   xs->state = XML_STREAM_PROLOG;
+   xs->requestObjectPath = cop ? CMClone(cop, NULL) : NULL;
+   xs->rvArray = newCMPIArray(0, 0, NULL);
+   xs->heap = parser_heap_init();
+   return xs;
+}
+
+void releaseXmlStream(XmlStream *xs)
+{
+   if (xs) {
+      if (xs->requestObjectPath)
+         CMRelease(xs->requestObjectPath);
+      if (xs->rvArray)
+         CMRelease(xs->rvArray);
+      if (xs->description)
+         free(xs->description);
+      parser_heap_term(xs->heap);
+      free(xs->buf);
+      free(xs);
+   }
+}
 
-   control.heap = parser_heap_init();
+static void consumeStream(XmlStream *xs, size_t n)
+{
+   memmove(xs->buf, xs->buf + n, xs->len - n + 1);
+   xs->len -= n;
+   xs->scan = 0;
+}
 
-   control.respHdr.rc = startParsing(&control);
+static void scanFragment(XmlStream *xs, char *frag)
+{
+   ParserControl control;
+   XmlBuffer *xmb;
 
-   parser_heap_term(control.heap);
+   memset(&control, 0, sizeof(control));
+   xmb = newXmlBuffer(frag);
+   control.xmb = xmb;
+   control.respHdr.xmlBuffer = xmb;
+   control.respHdr.rvArray = xs->rvArray;
+   control.requestObjectPath = xs->requestObjectPath;
+   control.heap = xs->heap;
+
+   if (parseXml(&control, startParsingFragment)) {
+      xs->errCode = control.respHdr.errCode;
+      xs->description = control.respHdr.description;
+      xs->state = XML_STREAM_DONE;
+   }
 
+   parser_heap_reset(control.heap);
    releaseXmlBuffer(xmb);
+}
+
+static int streamProlog(XmlStream *xs)
+{
+   char *irv = strstr(xs->buf, "<IRETURNVALUE");
+   char *err = strstr(xs->buf, "<ERROR");
+   char *gt;
+
+   if (err && (irv == NULL || err < irv)) {
+      xs->state = XML_STREAM_BUFFERED;
+      return 0;
+   }
+   if (irv == NULL || (gt = strchr(irv, '>')) == NULL)
+      return 0;
+   if (gt[-1] == '/') {
+      xs->state = XML_STREAM_DONE;
+      return 0;
+   }
+   consumeStream(xs, gt + 1 - xs->buf);
+   xs->state = XML_STREAM_BODY;
+   return 1;
+}
+
+static void streamBody(XmlStream *xs)
+{
+   char *p, *e, *n, *end = NULL, *name, c;
+   size_t tl, cut, scan;
+   int close;
 
-   pthread_mutex_unlock(&scan_mutex);
+   if (xs->etag[0] == 0) {
+      /* the first result element determines what to look for */
+      for (p = xs->buf; *p && *p <= ' '; p++);
+      if (*p == 0)
+         return;
+      if (strncmp(p, "</", 2) == 0) {
+         xs->state = XML_STREAM_DONE;
+         return;
+      }
+      if (*p != '<')
+         return;
+      for (e = p + 1; *e > ' ' && *e != '>' && *e != '/'; e++);
+      if (*e == 0)
+         return;
+      if (e - p + 1 >= sizeof(xs->etag))
+         e = p + sizeof(xs->etag) - 2;  /* never matches, parsed at the end */
+      xs->etag[0] = '<';
+      xs->etag[1] = '/';
+      memcpy(xs->etag + 2, p + 1, e - p - 1);
+      xs->etag[e - p + 1] = 0;
+   }
+
+   /* result elements nest, e.g. INSTANCENAMEs in reference keys, so the
+      tags are counted and an element ends where the depth is back to 0 */
+   name = xs->etag + 2;
+   tl = strlen(name);
+   for (p = xs->buf + xs->scan; (p = strchr(p, '<')) != NULL; p = e + 1) {
+      close = p[1] == '/';
+      n = p + 1 + close;
+      if (xs->buf + xs->len - n <= tl)
+         break;                 /* can't tell yet */
+      e = p;
+      if (strncmp(n, name, tl) || isalnum(n[tl]) || n[tl] == '.')
+         continue;
+      if ((e = strchr(n + tl, '>')) == NULL)
+         break;
+      if (close)
+         xs->depth--;
+      else if (e[-1] != '/')
+         xs->depth++;
+      if (xs->depth == 0)
+         end = e + 1;
+   }
+   /* an incomplete tag is looked at again */
+   xs->scan = p ? p - xs->buf : xs->len;
 
-   return control.respHdr;
+   if (end == NULL)
+      return;
+
+   c = *end;
+   *end = 0;
+   scanFragment(xs, xs->buf);
+   *end = c;
+   cut = end - xs->buf;
+   scan = xs->scan;
+   consumeStream(xs, cut);
+   xs->scan = scan - cut;
+
+   for (p = xs->buf; *p && *p <= ' '; p++);
+   if (strncmp(p, "</IRETURNVALUE", 14) == 0)
+      xs->state = XML_STREAM_DONE;
 }
 
-#define PARSER_HEAP_INCREMENT 100
+void xmlStreamFeed(XmlStream *xs, const char *data, size_t len)
+{
+   if (xs->state == XML_STREAM_DONE)
+      return;
+
+   if (xs->len + len + 1 > xs->max) {
+      while (xs->len + len + 1 > xs->max)
+         xs->max *= 2;
+      xs->buf = (char *) realloc(xs->buf, xs->max);
+   }
+   memcpy(xs->buf + xs->len, data, len);
+   xs->len += len;
+   xs->buf[xs->len] = 0;
+
+   if (xs->state == XML_STREAM_PROLOG && streamProlog(xs) == 0)
+      return;
+   if (xs->state == XML_STREAM_BODY)
+      streamBody(xs);
+}
+
+void xmlStreamEnd(XmlStream *xs)
+{
+   ResponseHdr rh;
+   char *p;
+
+   switch (xs->state) {
+   case XML_STREAM_BODY:
+      /* what is left, e.g. empty elements that have no closing tag */
+      if ((p = strstr(xs->buf, "</IRETURNVALUE")) == NULL) {
+         xs->errCode = CMPI_RC_ERR_FAILED;
+         xs->description = strdup("Incomplete response received from server");
+         break;
+      }
+      *p = 0;
+      for (p = xs->buf; *p && *p <= ' '; p++);
+      if (*p)
+         scanFragment(xs, p);
+      break;
+   case XML_STREAM_PROLOG:
+   case XML_STREAM_BUFFERED:
+      rh = scanCimXmlResponse(xs->buf, xs->requestObjectPath, xs->heap);
+      CMRelease(xs->rvArray);
+      xs->rvArray = rh.rvArray;
+      xs->errCode = rh.errCode;
+      xs->description = rh.description;
+      break;
+   }
+   xs->state = XML_STREAM_DONE;
+   consumeStream(xs, xs->len);
+}
+
+/*
+ * Chunks start small so that short responses stay cheap and double up to
+ * PARSER_HEAP_MAX_CHUNK. Requests larger than a quarter of that get a
+ * chunk of their own, which is put behind the one being allocated from.
+ */
+#define PARSER_HEAP_MIN_CHUNK 8192
+#define PARSER_HEAP_MAX_CHUNK 262144
+#define PARSER_HEAP_ALIGN(s) (((s) + 2 * sizeof(void*) - 1) & ~(2 * sizeof(void*) - 1))
+#define PARSER_HEAP_HDR PARSER_HEAP_ALIGN(sizeof(ParserHeapChunk))
+#define PARSER_HEAP_DATA(c) ((char*)(c) + PARSER_HEAP_HDR)
 
 ParserHeap* parser_heap_init()
 {
-  return calloc(1,sizeof(ParserHeap));
+  ParserHeap *ph = calloc(1,sizeof(ParserHeap));
+  if (ph)
+    ph->chunkSize = PARSER_HEAP_MIN_CHUNK;
+  return ph;
+}
+
+/*
+ * Frees all chunks but the current one, which is emptied for reuse unless
+ * it is an oversized one.
+ */
+void parser_heap_reset(ParserHeap* ph)
+{
+  ParserHeapChunk *c, *next;
+  if (ph && ph->chunks) {
+    for (c = ph->chunks->next; c; c = next) {
+      next = c->next;
+      free(c);
+    }
+    ph->chunks->next = NULL;
+    ph->chunks->used = 0;
+    if (ph->chunks->size > PARSER_HEAP_MAX_CHUNK) {
+      free(ph->chunks);
+      ph->chunks = NULL;
+    }
+    ph->lastAlloc = NULL;
+  }
 }
 
 void parser_heap_term(ParserHeap* ph)
 {
-  int i;
+  ParserHeapChunk *c, *next;
   if (ph) {
-    for (i=ph->numBlocks - 1; i >= 0; i--) {
-      void * blk = ph->blocks[i];
-      if (blk != NULL)
-	  free(ph->blocks[i]);
+    for (c = ph->chunks; c; c = next) {
+      next = c->next;
+      free(c);
     }
-    free(ph->blocks);
     free(ph);
   }
 }
 
-static int parser_heap_grow(ParserHeap *ph)
+static ParserHeapChunk *parser_heap_grow(ParserHeap *ph, size_t sz)
 {
-  if (ph) {
-    if (ph->numBlocks >= ph->capacity) {
-      ph->blocks = realloc(ph->blocks,
-			   sizeof(void*)*(ph->capacity+PARSER_HEAP_INCREMENT));
-      if (ph->blocks) {
-	ph->capacity += PARSER_HEAP_INCREMENT;
-      } else {
-	return -1;
-      }
-    }
-    ph->numBlocks += 1; 
-    return ph->numBlocks - 1;
+  ParserHeapChunk *c;
+  size_t size = ph->chunkSize;
+  int large = sz > PARSER_HEAP_MAX_CHUNK / 4;
+
+  if (large)
+    size = sz;
+  else {
+    while (size < sz)
+      size *= 2;
+    if (ph->chunkSize < PARSER_HEAP_MAX_CHUNK)
+      ph->chunkSize *= 2;
+  }
+  c = malloc(PARSER_HEAP_HDR + size);
+  if (c == NULL)
+    return NULL;
+  c->size = size;
+  c->used = 0;
+  if (large && ph->chunks) {
+    /* a large block of its own, keep allocating from the current chunk */
+    c->next = ph->chunks->next;
+    ph->chunks->next = c;
   } else {
-    return -1;
+    c->next = ph->chunks;
+    ph->chunks = c;
   }
+  return c;
 }
 
 void* parser_malloc(ParserHeap *ph, size_t sz)
 {
-  int idx = parser_heap_grow(ph);
-  if (idx >= 0) {
-    return (ph->blocks[idx]=malloc(sz));
-  } else {
+  ParserHeapChunk *c;
+  void *p;
+
+  if (ph == NULL)
     return NULL;
+  sz = PARSER_HEAP_ALIGN(sz);
+  c = ph->chunks;
+  if (c == NULL || c->size - c->used < sz) {
+    if ((c = parser_heap_grow(ph, sz)) == NULL)
+      return NULL;
   }
+  p = PARSER_HEAP_DATA(c) + c->used;
+  c->used += sz;
+  ph->lastAlloc = p;
+  return p;
 }
 
 void* parser_calloc(ParserHeap *ph, size_t num, size_t sz)
 {
-  int idx = parser_heap_grow(ph);
-  if (idx >= 0) {
-    return (ph->blocks[idx]=calloc(num,sz));
-  } else {
-    return NULL;
-  }
+  void *p = parser_malloc(ph, num * sz);
+  if (p)
+    memset(p, 0, num * sz);
+  return p;
 }
 
+/*
+ * The last block allocated is resized in place if its chunk has room.
+ * Block sizes are not recorded, otherwise as much of the old block is
+ * copied as its chunk holds, which covers the old block itself.
+ */
 void* parser_realloc(ParserHeap *ph, void *p, size_t sz)
 {
-   int i;
-   for (i=ph->numBlocks - 1; i >= 0; i--) 
-      if(ph->blocks[i]==p) ph->blocks[i]=NULL;
-
-  int idx = parser_heap_grow(ph);
-  if (idx >= 0) {
-    return (ph->blocks[idx]=realloc(p,sz));
-  } else {
-    return NULL;
+  ParserHeapChunk *c;
+  char *np, *data;
+  size_t avail;
+
+  if (p == NULL || ph == NULL)
+    return parser_malloc(ph, sz);
+  c = ph->chunks;
+  data = PARSER_HEAP_DATA(c);
+  if (p == ph->lastAlloc && (char*)p >= data && (char*)p < data + c->used
+      && (size_t)((char*)p - data) + PARSER_HEAP_ALIGN(sz) <= c->size) {
+    c->used = (char*)p - data + PARSER_HEAP_ALIGN(sz);
+    return p;
+  }
+  for (avail = 0; c; c = c->next) {
+    data = PARSER_HEAP_DATA(c);
+    if ((char*)p >= data && (char*)p < data + c->used) {
+      avail = data + c->used - (char*)p;
+      break;
+    }
   }
+  np = parser_malloc(ph, sz);
+  if (np)
+    memcpy(np, p, avail < sz ? avail : sz);
+  return np;
 }
 
 void* parser_strdup(ParserHeap *ph, const char *s)
 {
-  int idx = parser_heap_grow(ph);
-  if (idx >= 0) {
-    return (ph->blocks[idx]=strdup(s));
-  } else {
-    return NULL;
-  }
+  size_t l = strlen(s) + 1;
+  char *p = parser_malloc(ph, l);
+  if (p)
+    memcpy(p, s, l);
+  return p;
 }
-
-
-
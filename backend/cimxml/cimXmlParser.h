@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <setjmp.h>
 
 #include "cmcidt.h"
 #include "cmcift.h"
@@ -65,10 +66,13 @@ typedef struct xmlBuffer {
    char eTagFound;
    int etag;
    char nulledChar;
+   jmp_buf *onError;            /* where a syntax error unwinds to */
+   char *error;                 /* and its message, must be free'd */
 } XmlBuffer;
 
 typedef struct xmlElement {
    char *attr;
+   int required;                /* the element is rejected without it */
 } XmlElement;
 
 typedef struct xmlAttr {
@@ -398,8 +402,6 @@ typedef struct xtokGetPropRetContent {
   };
 } XtokGetPropRetContent;
 
-#include <setjmp.h>
-
 typedef struct responseHdr {
    XmlBuffer *xmlBuffer;
    int rc;
@@ -414,22 +416,61 @@ typedef struct responseHdr {
    char *description;
    CMPIArray *rvArray;
    CMPIArgs *outArgs;
+   int numResponses;            /* MULTIRSP: one per SIMPLERSP, in order */
+   struct responseHdr *responses;
+   char *enumerationContext;    /* pull operations, must be free'd */
+   int endOfSequence;
 } ResponseHdr;
 
 
+/*
+ * The parser allocates from chunks by bumping a pointer, nothing is freed
+ * until the whole heap is reset or terminated.
+ */
+typedef struct parser_heap_chunk {
+  struct parser_heap_chunk *next;
+  size_t  size;                 /* bytes following the header */
+  size_t  used;
+} ParserHeapChunk;
+
 typedef struct parser_heap {
-  size_t  capacity;
-  size_t  numBlocks;
-  void  **blocks;
+  ParserHeapChunk *chunks;      /* the one allocated from first */
+  size_t  chunkSize;            /* of the next chunk */
+  void   *lastAlloc;            /* can be realloc'ed in place */
 } ParserHeap;
  
 typedef struct parser_control {
    XmlBuffer *xmb;
    ResponseHdr respHdr;
    CMPIObjectPath *requestObjectPath;
+   CMPIObjectPath **requestObjectPaths; /* per SIMPLERSP of a MULTIRSP */
+   int numRequestObjectPaths;
    ParserHeap *heap;
+   int ct;                      /* current token */
+   int dontLex;                 /* ct has been pushed back */
+   struct _CIMCResultTable *table; /* receives the named instances */
 } ParserControl;
 
+#define XML_STREAM_PROLOG   0   /* waiting for IRETURNVALUE */
+#define XML_STREAM_BODY     1   /* cutting out complete result elements */
+#define XML_STREAM_BUFFERED 2   /* no result elements, parse at the end */
+#define XML_STREAM_DONE     3
+
+typedef struct xml_stream {
+   char *buf;                   /* data received but not parsed yet */
+   size_t len;
+   size_t max;
+   size_t scan;                 /* where to continue counting tags */
+   int depth;                   /* result elements open at scan */
+   int state;
+   char etag[64];               /* "</NAME" of the result elements */
+   CMPIObjectPath *requestObjectPath;
+   CMPIArray *rvArray;          /* objects parsed so far */
+   int errCode;
+   char *description;
+   ParserHeap *heap;            /* reset after each element */
+} XmlStream;
+
 
 /* Tokens.  */
 #define XTOK_XML 258
@@ -523,6 +564,10 @@ typedef struct parser_control {
 #define ZTOK_VALUEREFARRAY 346
 #define XTOK_CDATA 347
 #define ZTOK_CDATA 348
+#define XTOK_MULTIRSP 349
+#define ZTOK_MULTIRSP 350
+#define XTOK_VALUEINSTANCEWITHPATH 351
+#define ZTOK_VALUEINSTANCEWITHPATH 352
 
 
 typedef union parseUnion
@@ -583,16 +628,41 @@ typedef union parseUnion
 
 
 ParserHeap* parser_heap_init();
+void parser_heap_reset(ParserHeap* ph);
 void parser_heap_term(ParserHeap* ph);
 void* parser_malloc(ParserHeap *ph, size_t sz);
 void* parser_calloc(ParserHeap *ph, size_t num, size_t sz);
 void* parser_realloc(ParserHeap *ph, void *p, size_t sz);
 void* parser_strdup(ParserHeap *ph, const char *s);
 
-extern ResponseHdr scanCimXmlResponse(const char *xmlData, CMPIObjectPath *cop);
+/* xmlData is parsed in place and overwritten */
+/* heap is reset and kept for the next response, NULL uses a private one */
+extern ResponseHdr scanCimXmlResponse(char *xmlData, CMPIObjectPath *cop,
+                                      ParserHeap *heap);
+extern ResponseHdr scanCimXmlMultiResponse(char *xmlData, CMPIObjectPath **cops,
+                                           int numCops, ParserHeap *heap);
+/* the named instances of the response become rows of table */
+extern ResponseHdr scanCimXmlTableResponse(char *xmlData, CMPIObjectPath *cop,
+                                           ParserHeap *heap,
+                                           struct _CIMCResultTable *table);
+extern XmlStream *newXmlStream(CMPIObjectPath *cop);
+extern void xmlStreamFeed(XmlStream *xs, const char *data, size_t len);
+extern void xmlStreamEnd(XmlStream *xs);
+extern void releaseXmlStream(XmlStream *xs);
 extern void freeCimXmlResponse(ResponseHdr * hdr);
 extern int sfccLex(parseUnion * lvalp, ParserControl * parm);
 
+/* building a CIMCResultTable row by row, see resultTable.c */
+extern void tableNewRow(struct _CIMCResultTable *rt, const char *className);
+extern void tableSetChars(struct _CIMCResultTable *rt, const char *name,
+                          CMPIType type, const char *text);
+extern void tableSetValue(struct _CIMCResultTable *rt, const char *name,
+                          CMPIValue *value, CMPIType type);
+extern void tableAdoptValue(struct _CIMCResultTable *rt, const char *name,
+                            CMPIValue *value, CMPIType type);
+extern void tableSetKey(struct _CIMCResultTable *rt, const char *name,
+                        CMPIValue *value, CMPIType type);
+
 #ifdef __cplusplus
  }
 #endif
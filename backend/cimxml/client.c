@@ -22,6 +22,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <limits.h>
 #include <pthread.h>
 #include <curl/curl.h>
 
@@ -73,6 +75,7 @@ static void addXmlReference(UtilStringBuffer *sb, CMPIObjectPath * cop);
 extern UtilList *getNameSpaceComponents(CMPIObjectPath * cop);
 extern void pathToXml(UtilStringBuffer *sb, CMPIObjectPath *cop);
 extern char *value2Chars(CMPIType type, CMPIValue * value);
+extern void value2Xml(CMPIType type, CMPIValue * value, UtilStringBuffer *sb);
 extern char *pathToChars(CMPIObjectPath * cop, CMPIStatus * rc, char *str,
 								 int uri);
 char * cmpiToXmlType(CMPIType cmpiType);
@@ -96,26 +99,6 @@ static void set_debug()
 #define SET_DEBUG()
 #endif
 
-//#if TIMING
-#if 0
-#define _T_FAILED	"FAIL"
-#define _T_GOOD         "GOOD"
-
-#define _T_STAMP(tv) \
-       ((unsigned long long)((tv).tv_sec*1000000ull + (tv).tv_usec))
-#define START_TIMING(funcstr) \
-       struct timeval _tvs, _tve; \
-       const char *fstr = funcstr; \
-       gettimeofday(&_tvs, NULL);
-#define END_TIMING(sitestr) \
-       gettimeofday(&_tve, NULL); \
-       printf("!#Timing - %s ticks: %llu - %s#!\n", \
-                  fstr, (unsigned long long)(_T_STAMP(_tve)-_T_STAMP(_tvs)), sitestr);
-#else
-#define START_TIMING(funcstr)
-#define END_TIMING(sitestr)
-#endif
-
 
 /* static const strings for IMETHODCALL names */
 static const char EnumerateInstanceNames[] = "EnumerateInstanceNames";
@@ -134,6 +117,15 @@ static const char GetProperty[] = "GetProperty";
 static const char GetClass[] = "GetClass";
 static const char EnumerateClassNames[] = "EnumerateClassNames";
 static const char EnumerateClasses[] = "EnumerateClasses";
+static const char OpenEnumerateInstances[] = "OpenEnumerateInstances";
+static const char OpenEnumerateInstancePaths[] = "OpenEnumerateInstancePaths";
+static const char PullInstancesWithPath[] = "PullInstancesWithPath";
+static const char PullInstancePaths[] = "PullInstancePaths";
+static const char CloseEnumeration[] = "CloseEnumeration";
+
+/* getMetrics() operation types besides the above */
+static const char InvokeMethod[] = "InvokeMethod";
+static const char Batch[] = "Batch";
 
 
 struct _ClientEnc {
@@ -141,6 +133,7 @@ struct _ClientEnc {
    CMCIClientData      data;
    CMCICredentialData  certData;
    CMCIConnection     *connection;
+   CIMCEnv            *env;
 };
 
 #define MAX_PLAUSIBLE_PROGRESS 30
@@ -240,12 +233,39 @@ static curl_socket_t opensockCb(void *clientp,
 
 /* --------------------------------------------------------------------------*/
 
+/* a response buffer grown beyond this is dropped before the next request */
+#define RESPONSE_KEEP_SIZE (1024 * 1024)
+
+/*
+ * The response is parsed in place and has to be contiguous. When the
+ * server sends a Content-Length the buffer is sized once for the body,
+ * instead of doubled and copied all along; a compressed body inflates
+ * past it and grows from there as before.
+ */
+static void presizeResponse(CMCIConnection *con)
+{
+#if LIBCURL_VERSION_NUM >= 0x073700
+   curl_off_t length = -1;
+
+   curl_easy_getinfo(con->mHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+#else
+   double     length = -1;
+
+   curl_easy_getinfo(con->mHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &length);
+#endif
+   if (length > 0 && length < INT_MAX / 2)
+      con->mResponse->ft->reserve(con->mResponse, (unsigned int) length);
+}
+
 static size_t writeCb(void *ptr, size_t size,
 					size_t nmemb, void *stream)
 {
-    UtilStringBuffer *sb=(UtilStringBuffer*)stream;
+    CMCIConnection *con=(CMCIConnection*)stream;
     unsigned int length = size * nmemb;
-    sb->ft->appendBlock(sb, ptr, length);
+    if (con->mDecoded == 0)
+        presizeResponse(con);
+    con->mResponse->ft->appendBlock(con->mResponse, ptr, length);
+    con->mDecoded += length;
     return length;
 }
 
@@ -286,17 +306,658 @@ static int checkProgress(void *data,
   }
 }
 
+static char *transferError(CMCIConnection *con, CURLcode rv)
+{
+    long responseCode = -1;
+
+    /* indicate timeout error for aborted by progess handler */
+    if (rv == CURLE_ABORTED_BY_CALLBACK) {
+      rv = CURLE_OPERATION_TIMEOUTED;
+    }
+
+    // Use CURLINFO_HTTP_CODE instead of CURLINFO_RESPONSE_CODE
+    // (more portable to older versions of curl)
+    curl_easy_getinfo(con->mHandle, CURLINFO_HTTP_CODE, &responseCode);
+    return (responseCode == 401) ? strdup("Invalid username/password") :
+				   getErrorMessage(rv);
+}
+
+/* --------------------------------------------------------------------------*/
+
+/*
+ * Connection pool: a curl handle keeps its connection to the CIMOM open
+ * (HTTP keep-alive) after a request. Instead of staying with one client,
+ * the handle is returned to the pool of the environment as soon as the
+ * response is received, so that all clients connected with the same
+ * scheme, host, port and credentials reuse it without a new TCP/SSL
+ * handshake.
+ */
+
+#define POOL_DEFAULT_SIZE         8
+#define POOL_DEFAULT_IDLE_TIMEOUT 15   /* sfcb's default keepaliveTimeout */
+
+typedef struct _PooledHandle {
+   struct _PooledHandle *next;
+   CURL                 *handle;
+   char                 *key;      /* stored behind the struct */
+   time_t                idleSince;
+} PooledHandle;
+
+typedef struct _ConnectionPool {
+   pthread_mutex_t  lock;
+   PooledHandle    *idle;          /* most recently returned first */
+   long             numIdle;
+   long             maxIdle;
+   long             idleTimeout;
+   CMPIUint64       hits;
+   CMPIUint64       misses;
+   CMPIUint64       expired;
+   CMPIUint64       received;      /* transfer statistics, see countTransfer() */
+   CMPIUint64       decoded;
+   struct _Metrics *metrics;       /* NULL unless CIMC_OPT_METRICS is on */
+} ConnectionPool;
+
+#define PULL_DEFAULT_MAX_OBJECT_COUNT 1000
+
+/*
+ * Class cache: getClass() results, and the classes of enumClasses(), are
+ * kept for the clients of an environment, keyed by server (the pool key),
+ * namespace, class name, the flags that affect the class and the property
+ * list. Entries are hashed and chained in least recently used order.
+ */
+
+#define CLASS_CACHE_DEFAULT_TTL 300
+
+typedef struct _ClassCacheEntry {
+   struct _ClassCacheEntry *chain;      /* same hash bucket */
+   struct _ClassCacheEntry *prev, *next; /* most recently used first */
+   unsigned int     hash;
+   time_t           expires;            /* 0: never */
+   CMPIConstClass  *cls;
+   char            *key;                /* stored behind the struct */
+   char            *nameSpace;          /* both point into key */
+   char            *className;
+} ClassCacheEntry;
+
+typedef struct _ClassCache {
+   pthread_mutex_t   lock;
+   ClassCacheEntry **buckets;
+   unsigned int      mask;              /* number of buckets - 1 */
+   ClassCacheEntry  *first, *last;
+   long              count;
+   long              maxEntries;
+   long              ttl;
+   CMPIUint64        hits;
+   CMPIUint64        misses;
+   CMPIUint64        evicted;
+} ClassCache;
+
+/*
+ * Metrics (CIMC_OPT_METRICS): prepareRequest() finds the counters of the
+ * operation type and leaves them in the connection, countTransfer() adds
+ * the bytes and the phases curl measured, countOperation() the rest once
+ * the response is parsed or the operation failed. While metrics are off
+ * con->mMetrics stays NULL and nothing else is done.
+ */
+
+typedef struct _OperationMetrics {
+   struct _OperationMetrics *next;
+   pthread_mutex_t   lock;
+   char             *name;              /* stored behind the struct */
+   CIMCMetrics       m;
+} OperationMetrics;
+
+typedef struct _Metrics {
+   pthread_mutex_t   lock;              /* for the list, entries stay
+					   until the environment is released */
+   OperationMetrics *operations;
+} Metrics;
+
+typedef struct _XmlEnv {
+   CIMCEnv         env;
+   ConnectionPool  pool;
+   ClassCache      classCache;
+   Metrics         metrics;
+   long            pullMaxObjectCount;
+   long            pullOperationTimeout;   /* 0: let the server decide */
+   long            listenerBacklog;        /* 0: the listener's defaults */
+   long            listenerWorkers;
+   long            listenerIdleTimeout;
+   long            listenerQueueSize;
+   long            listenerOverflow;
+   long            listenerBatchSize;
+   long            listenerLinger;
+} XmlEnv;
+
+/* unlinks the handles idle too long or beyond maxIdle, caller holds the lock */
+static PooledHandle *expireHandles(ConnectionPool *pool, time_t now)
+{
+   PooledHandle **p = &pool->idle, *ph, *expired = NULL;
+   long           kept = 0;
+
+   while ((ph = *p) != NULL) {
+      if (kept < pool->maxIdle && now - ph->idleSince < pool->idleTimeout) {
+	 kept++;
+	 p = &ph->next;
+      } else {
+	 *p = ph->next;
+	 ph->next = expired;
+	 expired = ph;
+	 pool->expired++;
+      }
+   }
+   pool->numIdle = kept;
+   return expired;
+}
+
+static void cleanupHandles(PooledHandle *ph)
+{
+   PooledHandle *next;
+
+   for (; ph; ph = next) {
+      next = ph->next;
+      curl_easy_cleanup(ph->handle);
+      free(ph);
+   }
+}
+
+/* takes an idle handle for con's key from the pool, NULL if there is none */
+static CURL *leaseHandle(CMCIConnection *con)
+{
+   ConnectionPool *pool = con->mPool;
+   PooledHandle  **p, *ph = NULL, *expired;
+   CURL           *handle = NULL;
+
+   pthread_mutex_lock(&pool->lock);
+   expired = expireHandles(pool, time(NULL));
+   for (p = &pool->idle; *p; p = &(*p)->next) {
+      if (strcmp((*p)->key, con->mPoolKey) == 0) {
+	 ph = *p;
+	 *p = ph->next;
+	 pool->numIdle--;
+	 break;
+      }
+   }
+   if (ph) pool->hits++;
+   else pool->misses++;
+   pthread_mutex_unlock(&pool->lock);
+
+   cleanupHandles(expired);
+   if (ph) {
+      handle = ph->handle;
+      free(ph);
+   }
+   return handle;
+}
+
+static CMPIUint64 microseconds()
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000ull + tv.tv_usec;
+}
+
+/* the counters of operation type name, created when first used */
+static OperationMetrics *operationMetrics(Metrics *metrics, const char *name)
+{
+   OperationMetrics *om;
+
+   pthread_mutex_lock(&metrics->lock);
+   for (om = metrics->operations; om; om = om->next)
+      if (strcmp(om->name, name) == 0)
+	 break;
+   if (om == NULL) {
+      om = (OperationMetrics*)calloc(1, sizeof(OperationMetrics) + strlen(name) + 1);
+      pthread_mutex_init(&om->lock, NULL);
+      om->name = strcpy((char*)(om + 1), name);
+      om->next = metrics->operations;
+      metrics->operations = om;
+   }
+   pthread_mutex_unlock(&metrics->lock);
+   return om;
+}
+
+/* adds a phase taking us microseconds, caller holds the lock */
+static void addPhase(CIMCMetrics *m, int phase, CMPIUint64 us)
+{
+   int bucket = 0;
+
+   while (us >> bucket && bucket < CIMC_METRICS_BUCKETS - 1)
+      bucket++;
+   m->time[phase] += us;
+   m->histogram[phase][bucket]++;
+}
+
+static CMPIUint64 span(CMPIUint64 from, CMPIUint64 to)
+{
+   return to > from ? to - from : 0;
+}
+
+#if LIBCURL_VERSION_NUM >= 0x073d00
+#define TRANSFER_TIME(con, what) transferTime((con)->mHandle, CURLINFO_##what##_TIME_T)
+
+static CMPIUint64 transferTime(CURL *handle, CURLINFO info)
+{
+   curl_off_t t = 0;
+
+   curl_easy_getinfo(handle, info, &t);
+   return t;
+}
+#else
+#define TRANSFER_TIME(con, what) transferTime((con)->mHandle, CURLINFO_##what##_TIME)
+
+static CMPIUint64 transferTime(CURL *handle, CURLINFO info)
+{
+   double t = 0;
+
+   curl_easy_getinfo(handle, info, &t);
+   return t * 1000000;
+}
+#endif
+
+/* adds the bytes and phases of con's transfer to its operation type */
+static void countTransferMetrics(CMCIConnection *con, CMPIUint64 received)
+{
+   OperationMetrics *om = con->mMetrics;
+   CMPIUint64        resolve, connect, tls = 0, pretransfer, first, total;
+   CMPIUint64        now = microseconds();
+   long              connects = 0;
+
+   resolve = TRANSFER_TIME(con, NAMELOOKUP);
+   connect = TRANSFER_TIME(con, CONNECT);
+#if LIBCURL_VERSION_NUM >= 0x071300
+   tls = TRANSFER_TIME(con, APPCONNECT);
+#endif
+   pretransfer = TRANSFER_TIME(con, PRETRANSFER);
+   first = TRANSFER_TIME(con, STARTTRANSFER);
+   total = TRANSFER_TIME(con, TOTAL);
+   curl_easy_getinfo(con->mHandle, CURLINFO_NUM_CONNECTS, &connects);
+
+   pthread_mutex_lock(&om->lock);
+   om->m.requestBytes += con->mSent;
+   om->m.responseBytes += received;
+   om->m.decodedBytes += con->mDecoded;
+   addPhase(&om->m, CIMC_PHASE_REQUEST, span(total, now - con->mStarted));
+   if (connects) {
+      addPhase(&om->m, CIMC_PHASE_RESOLVE, resolve);
+      addPhase(&om->m, CIMC_PHASE_CONNECT, span(resolve, connect));
+      if (tls)
+	 addPhase(&om->m, CIMC_PHASE_TLS, span(connect, tls));
+   }
+   if (first) {
+      addPhase(&om->m, CIMC_PHASE_SERVER, span(pretransfer, first));
+      addPhase(&om->m, CIMC_PHASE_TRANSFER, span(first, total));
+   }
+   pthread_mutex_unlock(&om->lock);
+}
+
+/* counts con's operation once it failed or its response was parsed, the
+   parse phase started at parseStart, 0 if the response wasn't parsed */
+static void countOperation(CMCIConnection *con, int failed, CMPIUint64 objects,
+			   CMPIUint64 parseStart)
+{
+   OperationMetrics *om = con->mMetrics;
+   CMPIUint64        now;
+
+   if (om == NULL) return;
+   now = microseconds();
+   con->mMetrics = NULL;
+
+   pthread_mutex_lock(&om->lock);
+   om->m.operations++;
+   if (failed)
+      om->m.failures++;
+   om->m.objects += objects;
+   if (parseStart)
+      addPhase(&om->m, CIMC_PHASE_PARSE, span(parseStart, now));
+   addPhase(&om->m, CIMC_PHASE_TOTAL, span(con->mStarted, now));
+   pthread_mutex_unlock(&om->lock);
+}
+
+/* adds the body sizes of the transfer just finished to the statistics */
+static void countTransfer(CMCIConnection *con)
+{
+   ConnectionPool *pool = con->mPool;
+#if LIBCURL_VERSION_NUM >= 0x073700
+   curl_off_t      received = 0;
+
+   curl_easy_getinfo(con->mHandle, CURLINFO_SIZE_DOWNLOAD_T, &received);
+#else
+   double          received = 0;
+
+   curl_easy_getinfo(con->mHandle, CURLINFO_SIZE_DOWNLOAD, &received);
+#endif
+
+   pthread_mutex_lock(&pool->lock);
+   pool->received += received;
+   pool->decoded += con->mDecoded;
+   pthread_mutex_unlock(&pool->lock);
+
+   if (con->mMetrics)
+      countTransferMetrics(con, received);
+}
+
+/* hands con's handle back to the pool, con keeps it if pooling is off */
+static void returnHandle(CMCIConnection *con)
+{
+   ConnectionPool *pool = con->mPool;
+   PooledHandle   *ph, *expired;
+
+   if (con->mHandle == NULL || pool->maxIdle <= 0) return;
+
+   ph = (PooledHandle*)malloc(sizeof(PooledHandle) + strlen(con->mPoolKey) + 1);
+   ph->handle = con->mHandle;
+   ph->key = strcpy((char*)(ph + 1), con->mPoolKey);
+   ph->idleSince = time(NULL);
+   con->mHandle = NULL;
+
+   pthread_mutex_lock(&pool->lock);
+   ph->next = pool->idle;
+   pool->idle = ph;
+   pool->numIdle++;
+   expired = expireHandles(pool, ph->idleSince);
+   pthread_mutex_unlock(&pool->lock);
+
+   cleanupHandles(expired);
+}
+
+/* handles are only shared between clients that agree in all of these */
+static char *poolKey(ClientEnc *cc)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(256);
+   char             *key;
+
+   sb->ft->append6Chars(sb, cc->data.scheme, "://", cc->data.hostName,
+			":", cc->data.port, "\n");
+   sb->ft->append5Chars(sb, cc->data.user ? cc->data.user : "", "\n",
+			cc->data.pwd ? cc->data.pwd : "", "\n",
+			cc->certData.verifyMode == CMCI_VERIFY_PEER ? "1\n" : "0\n");
+   sb->ft->append6Chars(sb, cc->certData.trustStore ? cc->certData.trustStore : "",
+			"\n", cc->certData.certFile ? cc->certData.certFile : "",
+			"\n", cc->certData.keyFile ? cc->certData.keyFile : "", "\n");
+   key = strdup(sb->ft->getCharPtr(sb));
+   CMRelease(sb);
+   return key;
+}
+
+/* --------------------------------------------------------------------------*/
+
+/*
+ * Streamed enumerations (CIMC_STREAM_ENUMERATIONS): the transfer is driven
+ * through a curl multi handle from within hasNext()/getNext(), the received
+ * data is fed into an XmlStream and handed out batch by batch, so memory
+ * use does not depend on the size of the result set.
+ */
+
+struct _StreamEnumeration {
+   CMPIEnumeration   enumeration;
+   CMCIConnection   *con;        /* NULL once the transfer is finished */
+   UtilStringBuffer *request;    /* posted from here, keep until finished */
+   XmlStream        *xs;
+   CMPICount         current;    /* next element of xs->rvArray */
+   CMPIUint64        handedOut;  /* objects of the batches before */
+   CMPIStatus        status;
+};
+
+static size_t streamCb(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+    struct _StreamEnumeration *se = (struct _StreamEnumeration*)stream;
+    unsigned int length = size * nmemb;
+    xmlStreamFeed(se->xs, ptr, length);
+    se->con->mDecoded += length;
+    return length;
+}
+
+static void finishStream(struct _StreamEnumeration *se, CURLcode rv)
+{
+   CMCIConnection *con = se->con;
+   XmlStream      *xs = se->xs;
+   char           *error = NULL;
+
+   curl_multi_remove_handle(con->mMulti, con->mHandle);
+   con->mStream = NULL;
+   se->con = NULL;
+   CMRelease(se->request);
+   se->request = NULL;
+
+   if (rv)
+      error = transferError(con, rv);
+   else if (xs->state == XML_STREAM_PROLOG && xs->len == 0)
+      error = strdup("No data received from server");
+   countTransfer(con);
+   returnHandle(con);
+
+   if (error) {
+      CMSetStatusWithChars(&se->status, CMPI_RC_ERR_FAILED, error);
+      free(error);
+   } else if (con->mStatus.rc != CMPI_RC_OK) {
+      se->status = cloneStatus(con->mStatus);
+   } else {
+      xmlStreamEnd(xs);
+      if (xs->errCode != 0)
+	 CMSetStatusWithChars(&se->status, xs->errCode, xs->description);
+   }
+   /* parsed while received, there is no parse phase */
+   countOperation(con, se->status.rc != CMPI_RC_OK,
+		  se->handedOut + CMGetArrayCount(xs->rvArray, NULL), 0);
+}
+
+/* waits up to timeout ms for activity on one of the transfers of multi */
+static void waitMulti(CURLM *multi, int timeout)
+{
+#if LIBCURL_VERSION_NUM >= 0x071c00
+   curl_multi_wait(multi, NULL, 0, timeout, NULL);
+#else
+   fd_set         rd, wr, ex;
+   int            maxfd = -1;
+   struct timeval tv;
+
+   tv.tv_sec = timeout / 1000;
+   tv.tv_usec = (timeout % 1000) * 1000;
+   FD_ZERO(&rd);
+   FD_ZERO(&wr);
+   FD_ZERO(&ex);
+   curl_multi_fdset(multi, &rd, &wr, &ex, &maxfd);
+   if (maxfd >= 0)
+      select(maxfd + 1, &rd, &wr, &ex, &tv);
+#endif
+}
+
+static void pumpStream(struct _StreamEnumeration *se)
+{
+   CMCIConnection *con = se->con;
+   CURLcode        rv = CURLE_OK;
+   CURLMsg        *msg;
+   int             running, left;
+
+   while (curl_multi_perform(con->mMulti, &running) == CURLM_CALL_MULTI_PERFORM);
+
+   if (running == 0) {
+      while ((msg = curl_multi_info_read(con->mMulti, &left)))
+	 if (msg->msg == CURLMSG_DONE)
+	    rv = msg->data.result;
+      finishStream(se, rv);
+      return;
+   }
+
+   waitMulti(con->mMulti, 1000);
+}
+
+/* complete the transfer, e.g. because the connection is needed otherwise */
+static void drainStream(struct _StreamEnumeration *se)
+{
+   while (se->con)
+      pumpStream(se);
+}
+
+static void abortStream(struct _StreamEnumeration *se, const char *msg)
+{
+   CMCIConnection *con = se->con;
+
+   curl_multi_remove_handle(con->mMulti, con->mHandle);
+   /* the connection is in the middle of a response, don't reuse it */
+   curl_easy_cleanup(con->mHandle);
+   con->mHandle = NULL;
+   con->mStream = NULL;
+   se->con = NULL;
+   CMRelease(se->request);
+   se->request = NULL;
+   if (se->status.rc == CMPI_RC_OK)
+      CMSetStatusWithChars(&se->status, CMPI_RC_ERR_FAILED, msg);
+   countOperation(con, 1, 0, 0);
+}
+
+static int streamHasNext(struct _StreamEnumeration *se)
+{
+   XmlStream *xs = se->xs;
+
+   while (se->current >= CMGetArrayCount(xs->rvArray, NULL)) {
+      if (se->con == NULL)
+	 return 0;
+      if (se->current) {
+	 /* everything handed out, start over with an empty batch */
+	 se->handedOut += se->current;
+	 CMRelease(xs->rvArray);
+	 xs->rvArray = newCMPIArray(0, 0, NULL);
+	 se->current = 0;
+      }
+      pumpStream(se);
+   }
+   return 1;
+}
+
+static CMPIStatus releaseStreamEnum(CMPIEnumeration *enm)
+{
+   struct _StreamEnumeration *se = (struct _StreamEnumeration *)enm;
+   CMPIStatus rc = {CMPI_RC_OK, NULL};
+
+   if (se->con)
+      abortStream(se, "Enumeration released");
+   if (se->status.msg)
+      CMRelease(se->status.msg);
+   releaseXmlStream(se->xs);
+   free(se);
+   return rc;
+}
+
+static CMPIEnumeration *cloneStreamEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   CMSetStatusWithChars(rc, CMPI_RC_ERR_NOT_SUPPORTED,
+			"Clone function not supported for streamed enumerations");
+   return NULL;
+}
+
+static CMPIData getNextStreamEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   struct _StreamEnumeration *se = (struct _StreamEnumeration *)enm;
+   CMPIData data = {CMPI_null, CMPI_nullValue};
+
+   if (streamHasNext(se))
+      return CMGetArrayElementAt(se->xs->rvArray, se->current++, rc);
+   if (rc)
+      *rc = se->status.rc == CMPI_RC_OK ? se->status : cloneStatus(se->status);
+   return data;
+}
+
+static CMPIBoolean hasNextStreamEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   struct _StreamEnumeration *se = (struct _StreamEnumeration *)enm;
+
+   if (streamHasNext(se)) {
+      CMSetStatus(rc, CMPI_RC_OK);
+      return 1;
+   }
+   if (rc)
+      *rc = se->status.rc == CMPI_RC_OK ? se->status : cloneStatus(se->status);
+   return 0;
+}
+
+/* receives the rest of the response, returns all objects still held */
+static CMPIArray *toArrayStreamEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   struct _StreamEnumeration *se = (struct _StreamEnumeration *)enm;
+
+   drainStream(se);
+   if (rc)
+      *rc = se->status.rc == CMPI_RC_OK ? se->status : cloneStatus(se->status);
+   return se->xs->rvArray;
+}
+
+static CMPIEnumerationFT streamEnumFt = {
+   NATIVE_FT_VERSION,
+   releaseStreamEnum,
+   cloneStreamEnum,
+   getNextStreamEnum,
+   hasNextStreamEnum,
+   toArrayStreamEnum
+};
+
+/* posts the request in sb and returns as soon as the first objects arrived */
+static CMPIEnumeration *streamEnumeration(ClientEnc *cl, UtilStringBuffer *sb,
+					  CMPIObjectPath *cop, CMPIStatus *rc)
+{
+   CMCIConnection            *con = cl->connection;
+   struct _StreamEnumeration *se;
+   char                      *error;
+
+   error = con->ft->addPayload(con, sb);
+   if (error == NULL && con->mMulti == NULL &&
+       (con->mMulti = curl_multi_init()) == NULL)
+      error = strdup("Unable to initialize curl multi interface.");
+   if (error) {
+      CMSetStatusWithChars(rc, CMPI_RC_ERR_FAILED, error);
+      free(error);
+      CMRelease(sb);
+      return NULL;
+   }
+
+   se = (struct _StreamEnumeration*)calloc(1, sizeof(struct _StreamEnumeration));
+   se->enumeration.hdl = "CMPIEnumeration";
+   se->enumeration.ft = &streamEnumFt;
+   se->con = con;
+   se->request = sb;
+   se->xs = newXmlStream(cop);
+
+   curl_easy_setopt(con->mHandle, CURLOPT_WRITEFUNCTION, streamCb);
+   curl_easy_setopt(con->mHandle, CURLOPT_FILE, se);
+   curl_multi_add_handle(con->mMulti, con->mHandle);
+   con->mStream = se;
+
+   /* errors are reported by the operation itself as long as possible */
+   if (!streamHasNext(se) && se->status.rc != CMPI_RC_OK) {
+      if (rc) {
+	 *rc = se->status;
+	 se->status.msg = NULL;
+      }
+      CMRelease(&se->enumeration);
+      return NULL;
+   }
+
+   CMSetStatus(rc, CMPI_RC_OK);
+   return &se->enumeration;
+}
+
 
 /* --------------------------------------------------------------------------*/
 
 static CMPIStatus releaseConnection(CMCIConnection *con)
 {
   CMPIStatus rc = {CMPI_RC_OK,NULL};
+  if (con->mStream) {
+    abortStream(con->mStream, "Client released");
+  }
+  if (con->mMulti) {
+    curl_multi_cleanup(con->mMulti);
+  }
   if (con->mHeaders) {
     curl_slist_free_all(con->mHeaders);
     con->mHeaders = NULL;
   }
-  curl_easy_cleanup(con->mHandle);
+  returnHandle(con);
+  if (con->mHandle) curl_easy_cleanup(con->mHandle);
+  if (con->mPoolKey) free(con->mPoolKey);
+  if (con->mHeap) parser_heap_term(con->mHeap);
   if (con->mBody) CMRelease(con->mBody);
   if (con->mUri) CMRelease(con->mUri);
   if (con->mUserPass) CMRelease(con->mUserPass);
@@ -324,6 +985,7 @@ static char *addPayload(CMCIConnection *con, UtilStringBuffer *pl)
     rv = curl_easy_setopt(con->mHandle, CURLOPT_POSTFIELDSIZE,
 					pl->ft->getSize(pl));
     if (rv) return getErrorMessage(rv);
+    con->mSent = pl->ft->getSize(pl);
     return NULL;
 }
 
@@ -331,23 +993,19 @@ static char *addPayload(CMCIConnection *con, UtilStringBuffer *pl)
 
 /* --------------------------------------------------------------------------*/
 
-static char* genRequest(ClientEnc *cle, const char *op,
-			CMPIObjectPath *cop, int classWithKeys)
+/*
+ * Options that stay the same for all requests on a handle. A pooled handle
+ * only moves between clients with the same pool key, so they are set once
+ * when the handle is created; curl copies the strings passed.
+ */
+static void setupHandle(ClientEnc *cle, CMCIConnection *con, CURL *handle)
 {
-   CMCIConnection   *con = cle->connection;
-   CMCIClientData   *cld = &cle->data;
-   UtilList 	    *nsc;
-   char		    method[256]    = "CIMMethod: ";
-   char		    CimObject[512] = "CIMObject: ";
-   char		    *nsp;
-
-   if (!con->mHandle) return "Unable to initialize curl interface.";
+   CMCIClientData     *cld = &cle->data;
+   CMCICredentialData *crd = &cle->certData;
 
 //    if (!supportsSSL() && url.scheme == "https")
 //        throw HttpException("this curl library does not support https urls.");
 
-   con->mResponse->ft->reset(con->mResponse);
-
    con->mUri->ft->reset(con->mUri);
 
 #if LIBCURL_VERSION_NUM >= 0x071101
@@ -355,8 +1013,7 @@ static char* genRequest(ClientEnc *cle, const char *op,
    // Setup connection to Unix Socket
       con->mUri->ft->append3Chars(con->mUri, cld->scheme, "://", cld->hostName);
       con->mUri->ft->appendChars(con->mUri, "/cimom"); 
-      curl_easy_setopt(con->mHandle, CURLOPT_OPENSOCKETDATA, cld->port);
-      curl_easy_setopt(con->mHandle, CURLOPT_OPENSOCKETFUNCTION, opensockCb);
+      curl_easy_setopt(handle, CURLOPT_OPENSOCKETFUNCTION, opensockCb);
    }
    else 
 #endif
@@ -364,25 +1021,40 @@ static char* genRequest(ClientEnc *cle, const char *op,
 			  cld->hostName, ":", cld->port, "/cimom");
 
    /* Initialize curl with the url */
-   curl_easy_setopt(con->mHandle, CURLOPT_URL,
+   curl_easy_setopt(handle, CURLOPT_URL,
 				  con->mUri->ft->getCharPtr(con->mUri));
 
    /* Enable progress checking */
-   curl_easy_setopt(con->mHandle, CURLOPT_NOPROGRESS, 0);
-   
-   /* Reset timeout control */
-   con->mTimeout.mTimestampStart = 0;
-   con->mTimeout.mTimestampLast = 0;
-   con->mTimeout.mFixups = 0;
+   curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0);
 
    /* This will be a HTTP post */
-   curl_easy_setopt(con->mHandle, CURLOPT_POST, 1);
+   curl_easy_setopt(handle, CURLOPT_POST, 1);
+
+   /* set SSL options */
+   curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER,
+		    crd->verifyMode == CMCI_VERIFY_PEER ? 1 : 0);
+   if (crd->trustStore)
+      curl_easy_setopt(handle, CURLOPT_CAINFO, crd->trustStore);
+   if (crd->certFile)
+      curl_easy_setopt(handle, CURLOPT_SSLCERT, crd->certFile);
+   if (crd->keyFile)
+      curl_easy_setopt(handle, CURLOPT_SSLKEY, crd->keyFile);
 
    /* Disable SSL Host verification */
-   curl_easy_setopt(con->mHandle, CURLOPT_SSL_VERIFYHOST, 0);
+   curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0);
 
    /* Setup authentication */
-   curl_easy_setopt(con->mHandle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+   curl_easy_setopt(handle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+
+   /* Accept-Encoding, curl decompresses before writeCb()/streamCb() */
+   if ((cle->env->options & CIMC_COMPRESS_RESPONSES) &&
+       (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_LIBZ)) {
+#if LIBCURL_VERSION_NUM >= 0x071506
+      curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip, deflate");
+#else
+      curl_easy_setopt(handle, CURLOPT_ENCODING, "gzip, deflate");
+#endif
+   }
 
    /* Set username and password */
    if (cld->user != NULL) {
@@ -393,43 +1065,112 @@ static char* genRequest(ClientEnc *cle, const char *op,
       if (cld->pwd)
 	 UserPass->ft->append3Chars(UserPass, ":", cld->pwd, NULL);
       /* Setup "<userid>:<password>" */
-      curl_easy_setopt(con->mHandle, CURLOPT_USERPWD,
+      curl_easy_setopt(handle, CURLOPT_USERPWD,
 				     UserPass->ft->getCharPtr(UserPass));
    }
 
+   /* Setup connect timeouts for cimserver operations */
+   curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
+   curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, CIMSERVER_TIMEOUT);
+
+   /* setup callback for client timeout calculations */
+   curl_easy_setopt(handle, CURLOPT_PROGRESSFUNCTION, checkProgress);
+
+   curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, writeHeaders);
+
+   // Fail if we receive an error (HTTP response code >= 300)
+   curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1);
+
+   // Turn this on to enable debugging
+#if DEBUG
+   curl_easy_setopt(handle, CURLOPT_VERBOSE, do_debug);
+#endif
+}
+
+/* --------------------------------------------------------------------------*/
+
+/* sets up con for a request of cle, see also genRequest(); op is NULL
+   for a multiple operation request */
+static char* prepareRequest(ClientEnc *cle, CMCIConnection *con, const char *op,
+			    CMPIObjectPath *cop, int classWithKeys)
+{
+   CMCIClientData   *cld = &cle->data;
+   UtilList 	    *nsc;
+   char		    method[256]    = "CIMMethod: ";
+   char		    CimObject[512] = "CIMObject: ";
+   char		    *nsp;
+
+   /* an enumeration still streaming from this connection is read up first */
+   if (con->mStream) drainStream(con->mStream);
+
+   con->mMetrics = NULL;
+   if (con->mPool->metrics) {
+      con->mMetrics = operationMetrics(con->mPool->metrics,
+				       op == NULL ? Batch :
+				       classWithKeys ? InvokeMethod : op);
+      con->mStarted = microseconds();
+   }
+
+   if (con->mHandle == NULL) {
+      con->mHandle = leaseHandle(con);
+      if (con->mHandle == NULL && (con->mHandle = curl_easy_init()) != NULL)
+	 setupHandle(cle, con, con->mHandle);
+   }
+   if (!con->mHandle) return "Unable to initialize curl interface.";
+
+   if (con->mResponse->max > RESPONSE_KEEP_SIZE) {
+      /* don't keep the pages of a huge response for the life of con */
+      CMRelease(con->mResponse);
+      con->mResponse = UtilFactory->newStringBuffer(2048);
+   }
+   else
+      con->mResponse->ft->reset(con->mResponse);
+   con->mDecoded = 0;
+
+#if LIBCURL_VERSION_NUM >= 0x071101
+   if (cld->port != NULL && cld->port[0] == '/')
+      curl_easy_setopt(con->mHandle, CURLOPT_OPENSOCKETDATA, cld->port);
+#endif
+
+   /* Reset timeout control */
+   con->mTimeout.mTimestampStart = 0;
+   con->mTimeout.mTimestampLast = 0;
+   con->mTimeout.mFixups = 0;
+
    /* initialize status */
    CMSetStatus(&con->mStatus,CMPI_RC_OK);
 
-   /* Setup connect timeouts for cimserver operations */
-   curl_easy_setopt(con->mHandle, CURLOPT_NOSIGNAL, 1);
-   curl_easy_setopt(con->mHandle, CURLOPT_CONNECTTIMEOUT, CIMSERVER_TIMEOUT);
-
    /* setup callback for client timeout calculations */
-   curl_easy_setopt(con->mHandle, CURLOPT_PROGRESSFUNCTION, checkProgress);
    curl_easy_setopt(con->mHandle, CURLOPT_PROGRESSDATA, &con->mTimeout);
 
    // Initialize default headers
    con->ft->initializeHeaders(con);
 
-   // Add CIMMethod header
-   strcat(method, op);
-   con->mHeaders = curl_slist_append(con->mHeaders, method);
-
-   // Add CIMObject header with cop's namespace, class, keys
-   if (classWithKeys)
-       pathToChars(cop, NULL, &CimObject[11], 1);
-   else {
-       nsc = getNameSpaceComponents(cop);
-       nsp = nsc->ft->getFirst(nsc);
-       while (nsp != NULL) {
-	   strcat(CimObject, nsp);
-	   free(nsp); /* VM: freeing strdup'ed memory - should be part of release */
-           if ((nsp = nsc->ft->getNext(nsc)) != NULL)
-	       strcat(CimObject, "%2F");
-       }
-       CMRelease(nsc);
+   if (op == NULL) {
+       // Multiple operation request: CIMBatch instead of CIMMethod/CIMObject,
+       // curl sends a header without a value when given with a ';'
+       con->mHeaders = curl_slist_append(con->mHeaders, "CIMBatch;");
+   } else {
+      // Add CIMMethod header
+      strcat(method, op);
+      con->mHeaders = curl_slist_append(con->mHeaders, method);
+
+      // Add CIMObject header with cop's namespace, class, keys
+      if (classWithKeys)
+          pathToChars(cop, NULL, &CimObject[11], 1);
+      else {
+          nsc = getNameSpaceComponents(cop);
+          nsp = nsc->ft->getFirst(nsc);
+          while (nsp != NULL) {
+	      strcat(CimObject, nsp);
+	      free(nsp); /* VM: freeing strdup'ed memory - should be part of release */
+              if ((nsp = nsc->ft->getNext(nsc)) != NULL)
+		  strcat(CimObject, "%2F");
+          }
+          CMRelease(nsc);
+      }
+      con->mHeaders = curl_slist_append(con->mHeaders, CimObject);
    }
-   con->mHeaders = curl_slist_append(con->mHeaders, CimObject);
 
    // Set all of the headers for the request
    curl_easy_setopt(con->mHandle, CURLOPT_HTTPHEADER, con->mHeaders);
@@ -438,50 +1179,66 @@ static char* genRequest(ClientEnc *cle, const char *op,
    curl_easy_setopt(con->mHandle, CURLOPT_WRITEFUNCTION, writeCb);
 
    // Use CURLOPT_FILE instead of CURLOPT_WRITEDATA - more portable
-   curl_easy_setopt(con->mHandle, CURLOPT_FILE, con->mResponse);
+   curl_easy_setopt(con->mHandle, CURLOPT_FILE, con);
 
    // Header processing: 
    curl_easy_setopt(con->mHandle, CURLOPT_WRITEHEADER, &con->mStatus);
-   curl_easy_setopt(con->mHandle, CURLOPT_HEADERFUNCTION, writeHeaders);
-
-   // Fail if we receive an error (HTTP response code >= 300)
-   curl_easy_setopt(con->mHandle, CURLOPT_FAILONERROR, 1);
-
-   // Turn this on to enable debugging
-#if DEBUG
-   curl_easy_setopt(con->mHandle, CURLOPT_VERBOSE, do_debug);
-#endif
 
    return NULL;
 }
+
+static char* genRequest(ClientEnc *cle, const char *op,
+			CMPIObjectPath *cop, int classWithKeys)
+{
+   return prepareRequest(cle, cle->connection, op, cop, classWithKeys);
+}
 /* --------------------------------------------------------------------------*/
 
 char *getResponse(CMCIConnection *con, CMPIObjectPath *cop)
 {
     CURLcode rv;
 
-    rv = curl_easy_perform(con->mHandle);
+    char *error = NULL;
 
-    /* indicate timeout error for aborted by progess handler */
-    if (rv == CURLE_ABORTED_BY_CALLBACK) {
-      rv = CURLE_OPERATION_TIMEOUTED;
-    }
+    rv = curl_easy_perform(con->mHandle);
 
     if (rv) {
-        long responseCode = -1;
-        // Use CURLINFO_HTTP_CODE instead of CURLINFO_RESPONSE_CODE
-        // (more portable to older versions of curl)
-        curl_easy_getinfo(con->mHandle, CURLINFO_HTTP_CODE, &responseCode);
-        return (responseCode == 401) ? strdup("Invalid username/password") :
-				       getErrorMessage(rv);
+        error = transferError(con, rv);
+    }
+    /* the response is in con->mResponse, others may use the handle now */
+    countTransfer(con);
+    returnHandle(con);
+    if (error) {
+        countOperation(con, 1, 0, 0);
+        return error;
     }
 
-    if (con->mResponse->ft->getSize(con->mResponse) == 0)
+    if (con->mResponse->ft->getSize(con->mResponse) == 0) {
+        countOperation(con, 1, 0, 0);
         return strdup("No data received from server");
+    }
+    if (con->mStatus.rc != CMPI_RC_OK)
+        countOperation(con, 1, 0, 0);
     
     return NULL;
 }
 
+/* parses con's response, counting the operation when metrics are on */
+static ResponseHdr scanResponse(CMCIConnection *con, CMPIObjectPath *cop)
+{
+    ResponseHdr rh;
+    CMPIUint64  parseStart;
+
+    if (con->mMetrics == NULL)
+        return scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop, con->mHeap);
+
+    parseStart = microseconds();
+    rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop, con->mHeap);
+    countOperation(con, rh.errCode != 0,
+                   rh.errCode ? 0 : CMGetArrayCount(rh.rvArray, NULL), parseStart);
+    return rh;
+}
+
 
 /* --------------------------------------------------------------------------*/
 
@@ -526,12 +1283,13 @@ CMCIConnection *initConnection(CMCIClientData *cld)
    CMCIConnection *c=(CMCIConnection*)calloc(1,sizeof(CMCIConnection));
 
    c->ft=&conFt;
-   c->mHandle = curl_easy_init();
+   c->mHandle = NULL;             /* taken from the pool by genRequest */
    c->mHeaders = NULL;
    c->mBody = UtilFactory->newStringBuffer(256);
    c->mUri = UtilFactory->newStringBuffer(256);
    c->mUserPass = UtilFactory->newStringBuffer(64);
    c->mResponse = UtilFactory->newStringBuffer(2048);
+   c->mHeap = parser_heap_init();
 
    return c;
 }
@@ -556,6 +1314,7 @@ static const XmlSpecialChar XmlEscapes[] = {
 
 char XmlToAscii(char **XmlStr);
 char * XmlToAsciiStr(char *XmlStr);
+char * XmlToAsciiInPlace(char *XmlStr);
 char * AsciiToXmlStr(char *Ap);
 
 char XmlToAscii(char **XmlStr)
@@ -591,6 +1350,22 @@ char * XmlToAsciiStr(char *XmlStr)
     return AsciiStr;
 }
 
+/* for the values in a parsed response, which is modified anyway */
+char * XmlToAsciiInPlace(char *XmlStr)
+{
+    char *Ap, *Xp;
+
+    if ((Xp = strchr(XmlStr, '&')) == NULL)
+        return XmlStr;
+    Ap = Xp;
+    while (*Xp != '\0')
+    {
+        *Ap++ = XmlToAscii(&Xp);
+    }
+    *Ap = '\0';
+    return XmlStr;
+}
+
 char * AsciiToXmlStr(char *AsciiStr)
 {
     char *Ap = NULL;
@@ -678,7 +1453,6 @@ static void addXmlValue(UtilStringBuffer *sb,
     char      *arrayStr   = isArray ? ".ARRAY" : "";
     CMPIType  valtyp      = data.type & ~CMPI_ARRAY; 
     char      *xmlTypeStr = cmpiToXmlType(valtyp);
-    char      *cv;
     int       i, n;
     /* If empty data item, skip out without outputting */
     if ((data.state & CMPI_nullValue) ||
@@ -705,15 +1479,9 @@ static void addXmlValue(UtilStringBuffer *sb,
         for (i = 0; i < n; ++i)
         {
             CMPIData ele = CMGetArrayElementAt(arr, i, NULL);
-            cv = value2Chars(valtyp, &ele.value);
-            if (valtyp == CMPI_string || valtyp == CMPI_chars)
-            {
-                char *xmlValStr  = AsciiToXmlStr(cv);
-                if (cv) free(cv);
-                cv = xmlValStr;
-            }
-            sb->ft->append3Chars(sb, "<VALUE>", cv, "</VALUE>\n");
-            free (cv);
+            sb->ft->appendBlock(sb, "<VALUE>", 7);
+            value2Xml(valtyp, &ele.value, sb);
+            sb->ft->appendBlock(sb, "</VALUE>\n", 9);
         }
         sb->ft->appendChars(sb, "</VALUE.ARRAY>\n");
     }
@@ -723,15 +1491,9 @@ static void addXmlValue(UtilStringBuffer *sb,
     }
     else 
     {
-        cv = value2Chars(valtyp, &(data.value));
-        if (valtyp == CMPI_string || valtyp == CMPI_chars)
-        {
-            char *xmlValStr  = AsciiToXmlStr(cv);
-            if (cv) free(cv);
-            cv = xmlValStr;
-        }
-        sb->ft->append3Chars(sb, "<VALUE>", cv, "</VALUE>\n");
-        free(cv);
+        sb->ft->appendBlock(sb, "<VALUE>", 7);
+        value2Xml(valtyp, &data.value, sb);
+        sb->ft->appendBlock(sb, "</VALUE>\n", 9);
     }
     if(strcasecmp(ContainerTag, "PARAMVALUE")) {
     	sb->ft->append5Chars(sb, "</", ContainerTag, arrayStr, ">", "\n");
@@ -833,6 +1595,46 @@ static inline void addXmlFooter(UtilStringBuffer *sb)
 
 /* --------------------------------------------------------------------------*/
 
+static inline void addXmlMultiHeader(UtilStringBuffer *sb)
+{
+   static const char xmlHeader[]={
+      "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+      "<CIM CIMVERSION=\"2.0\" DTDVERSION=\"2.0\">\n"
+      "<MESSAGE ID=\"4711\" PROTOCOLVERSION=\"1.0\">\n"
+      "<MULTIREQ>\n"
+   };
+
+   sb->ft->appendChars(sb, xmlHeader);
+}
+
+/* --------------------------------------------------------------------------*/
+
+static inline void addXmlMultiFooter(UtilStringBuffer *sb)
+{
+   static const char xmlFooter[]={
+      "</MULTIREQ>\n"
+      "</MESSAGE>\n"
+      "</CIM>\n"
+   };
+
+   sb->ft->appendChars(sb, xmlFooter);
+}
+
+/* --------------------------------------------------------------------------*/
+
+/* appends the SIMPLEREQ of a message built for a single request; markup
+   characters in the values of the request are escaped */
+static void addXmlSimpleReq(UtilStringBuffer *sb, UtilStringBuffer *req)
+{
+   const char *msg = req->ft->getCharPtr(req);
+   const char *start = strstr(msg, "<SIMPLEREQ>");
+   const char *end = strstr(start, "</SIMPLEREQ>\n");
+
+   sb->ft->appendBlock(sb, (void*)start, end - start + sizeof("</SIMPLEREQ>\n") - 1);
+}
+
+/* --------------------------------------------------------------------------*/
+
 static void addXmlPropertyListParam(UtilStringBuffer *sb, char** properties)
 {
    sb->ft->appendChars(sb, "<IPARAMVALUE NAME=\"PropertyList\"><VALUE.ARRAY>");
@@ -999,6 +1801,24 @@ static CMPIStatus releaseClient(CMCIClient * mb)
 }
 
 /* --------------------------------------------------------------------------*/
+static UtilStringBuffer *enumInstanceNamesRequest(CMPIObjectPath *cop)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", EnumerateInstanceNames, "\">");
+
+   addXmlNamespace(sb, cop);
+   addXmlClassnameParam(sb, cop);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIEnumeration * enumInstanceNames(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -1006,25 +1826,22 @@ static CMPIEnumeration * enumInstanceNames(
 {
    ClientEnc		* cl = (ClientEnc*)mb;
    CMCIConnection	* con = cl->connection;
-   UtilStringBuffer	* sb = UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer	* sb;
    char			* error;
    ResponseHdr		rh;
    CMPIEnumeration      *retval;
 
-   START_TIMING(EnumerateInstanceNames);
    SET_DEBUG();
 
    con->ft->genRequest(cl, EnumerateInstanceNames, cop, 0);
 
    /* Construct the CIM-XML request */
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", EnumerateInstanceNames, "\">");
-
-   addXmlNamespace(sb, cop);
-   addXmlClassnameParam(sb, cop);
+   sb = enumInstanceNamesRequest(cop);
 
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+      retval = streamEnumeration(cl, sb, cop, rc);
+      return retval;
+   }
 
    error = con->ft->addPayload(con, sb);
 
@@ -1032,7 +1849,6 @@ static CMPIEnumeration * enumInstanceNames(
       CMSetStatusWithChars(rc, CMPI_RC_ERR_FAILED, error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
  
@@ -1040,19 +1856,17 @@ static CMPIEnumeration * enumInstanceNames(
       if (rc)
 	*rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+   rh = scanResponse(con, cop);
 
    if (rh.errCode != 0) {
       CMSetStatusWithChars(rc, rh.errCode, rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1064,12 +1878,41 @@ static CMPIEnumeration * enumInstanceNames(
 
    CMSetStatus(rc,CMPI_RC_OK);
    retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
 
+static UtilStringBuffer *getInstanceRequest(CMPIObjectPath *cop,
+                                            CMPIFlags flags,
+                                            char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", GetInstance, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
+   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
+   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
+
+   if (properties != NULL)
+	addXmlPropertyListParam(sb, properties);
+
+   /* Add the instance classname */
+   addXmlObjectName(sb, cop, "InstanceName");
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIInstance * getInstance(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -1114,33 +1957,15 @@ static CMPIInstance * getInstance(
    CMPIInstance *cci;
    ClientEnc *cl=(ClientEnc*)mb;
    CMCIConnection *con=cl->connection;
-   UtilStringBuffer *sb=UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer *sb;
    char *error;
    ResponseHdr rh;
 
-   START_TIMING(GetInstance);
    SET_DEBUG();
 
    con->ft->genRequest(cl, GetInstance, cop, 0);
 
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", GetInstance, "\">");
-
-   addXmlNamespace(sb, cop);
-
-   emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
-   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
-   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
-
-   if (properties != NULL)
-	addXmlPropertyListParam(sb, properties);
-
-   /* Add the instance classname */
-   addXmlObjectName(sb, cop, "InstanceName");
-
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-
-   addXmlFooter(sb);
+   sb = getInstanceRequest(cop, flags, properties);
 
    error = con->ft->addPayload(con, sb);
 
@@ -1148,7 +1973,6 @@ static CMPIInstance * getInstance(
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1156,19 +1980,17 @@ static CMPIInstance * getInstance(
       if (rc)
 	*rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+   rh = scanResponse(con, cop);
 
    if (rh.errCode != 0) {
       CMSetStatusWithChars(rc, rh.errCode, rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1182,12 +2004,33 @@ static CMPIInstance * getInstance(
    cci = rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL).value.inst;
    cci = CMClone(cci,NULL);
    CMRelease(rh.rvArray);
-   END_TIMING(_T_GOOD);
    return cci;
 }
 
 /* --------------------------------------------------------------------------*/
 
+static UtilStringBuffer *createInstanceRequest(CMPIObjectPath *cop,
+                                               CMPIInstance *inst)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", CreateInstance, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   sb->ft->appendChars(sb, "<IPARAMVALUE NAME=\"NewInstance\">\n");
+   addXmlInstance(sb, cop, inst);
+   sb->ft->appendChars(sb,"</IPARAMVALUE>\n");
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIObjectPath * createInstance(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -1196,7 +2039,7 @@ static CMPIObjectPath * createInstance(
 {
    ClientEnc        *cl  = (ClientEnc*)mb;
    CMCIConnection   *con = cl->connection;
-   UtilStringBuffer *sb  = UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer *sb;
    char             *error;
    ResponseHdr	    rh;
    int		    i, numproperties = inst->ft->getPropertyCount(inst, NULL);
@@ -1204,23 +2047,12 @@ static CMPIObjectPath * createInstance(
    CMPIData	    propertydata;
    CMPIObjectPath   *retval;
 
-   START_TIMING(CreateInstance);
    SET_DEBUG();
 
    con->ft->genRequest(cl, CreateInstance, cop, 0);
 
    /* Construct the CIM-XML request */
-   addXmlHeader(sb);
-
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", CreateInstance, "\">");
-
-   addXmlNamespace(sb, cop);
-
-   sb->ft->appendChars(sb, "<IPARAMVALUE NAME=\"NewInstance\">\n");
-   addXmlInstance(sb, cop, inst);
-   sb->ft->appendChars(sb,"</IPARAMVALUE>\n");
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   sb = createInstanceRequest(cop, inst);
 
    error = con->ft->addPayload(con,sb);
 
@@ -1228,7 +2060,6 @@ static CMPIObjectPath * createInstance(
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1236,18 +2067,16 @@ static CMPIObjectPath * createInstance(
       if (rc)
      *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+   rh = scanResponse(con, cop);
    if (rh.errCode != 0) {
       CMSetStatusWithChars(rc, rh.errCode, rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1259,12 +2088,42 @@ static CMPIObjectPath * createInstance(
 
    CMSetStatus(rc,CMPI_RC_OK);
    retval = rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL).value.ref;
-   END_TIMING(_T_GOOD);
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
 
+static UtilStringBuffer *setInstanceRequest(CMPIObjectPath *cop,
+                                            CMPIInstance *inst,
+                                            CMPIFlags flags,
+                                            char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", ModifyInstance, "\">\n");
+
+   addXmlNamespace(sb, cop);
+
+   /* NOTE - IncludeQualifiers flag is now deprecated */
+   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
+
+   /* Add the property filter list */
+   if (properties != NULL)
+	addXmlPropertyListParam(sb, properties);
+
+   sb->ft->appendChars(sb, "<IPARAMVALUE NAME=\"ModifiedInstance\">\n");
+   addXmlNamedInstance(sb, cop, inst);
+   sb->ft->appendChars(sb,"</IPARAMVALUE>\n");
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIStatus setInstance(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -1327,35 +2186,17 @@ static CMPIStatus setInstance(
 {
    ClientEnc        *cl  = (ClientEnc*)mb;
    CMCIConnection   *con = cl->connection;
-   UtilStringBuffer *sb  = UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer *sb;
    char             *error;
    ResponseHdr      rh;
    CMPIStatus	    rc;
 
-   START_TIMING(ModifyInstance);
    SET_DEBUG();
 
    con->ft->genRequest(cl, ModifyInstance, cop, 0);
 
    /* Construct the CIM-XML request */
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", ModifyInstance, "\">\n");
-
-   addXmlNamespace(sb, cop);
-
-   /* NOTE - IncludeQualifiers flag is now deprecated */
-   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
-
-   /* Add the property filter list */
-   if (properties != NULL)
-	addXmlPropertyListParam(sb, properties);
-
-   sb->ft->appendChars(sb, "<IPARAMVALUE NAME=\"ModifiedInstance\">\n");
-   addXmlNamedInstance(sb, cop, inst);
-   sb->ft->appendChars(sb,"</IPARAMVALUE>\n");
-
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   sb = setInstanceRequest(cop, inst, flags, properties);
 
    error = con->ft->addPayload(con,sb);
 
@@ -1363,20 +2204,18 @@ static CMPIStatus setInstance(
       CMSetStatusWithChars(&rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return rc;
    }
 
    if (con->mStatus.rc != CMPI_RC_OK) {
       rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return rc;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+   rh = scanResponse(con, cop);
    if (rh.errCode != 0) {
       CMSetStatusWithChars(&rc, rh.errCode, rh.description);
       free(rh.description);
@@ -1385,12 +2224,40 @@ static CMPIStatus setInstance(
    else
    CMSetStatus(&rc, CMPI_RC_OK);
 
-   END_TIMING(_T_GOOD);
    return rc;
 }
 
 /* --------------------------------------------------------------------------*/
 
+static UtilStringBuffer *deleteInstanceRequest(CMPIObjectPath *cop)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+   CMPIString       *classname;
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", DeleteInstance, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   /* Add instance stuff */
+   classname = cop->ft->getClassName(cop, NULL);
+   sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"InstanceName\">\n"
+			    "<INSTANCENAME CLASSNAME=\"",
+			    (char*)classname->hdl,"\">\n");
+   CMRelease(classname);
+
+   pathToXml(sb, cop);
+
+   sb->ft->appendChars(sb,"</INSTANCENAME>\n");
+   sb->ft->appendChars(sb,"</IPARAMVALUE>\n");
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIStatus deleteInstance(
 	CMCIClient * mb,
 	CMPIObjectPath * cop)
@@ -1422,35 +2289,16 @@ static CMPIStatus deleteInstance(
 {
    ClientEnc		*cl = (ClientEnc*)mb;
    CMCIConnection	*con = cl->connection;
-   UtilStringBuffer	*sb = UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer	*sb;
    char			*error;
    ResponseHdr		rh;
-   CMPIString		*classname;
    CMPIStatus		rc;
 
-   START_TIMING(DeleteInstance);
    SET_DEBUG();
 
    con->ft->genRequest(cl, DeleteInstance, cop, 0);
 
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", DeleteInstance, "\">");
-
-   addXmlNamespace(sb, cop);
-
-   /* Add instance stuff */
-   classname = cop->ft->getClassName(cop, NULL);
-   sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"InstanceName\">\n"
-			    "<INSTANCENAME CLASSNAME=\"",
-			    (char*)classname->hdl,"\">\n");
-   CMRelease(classname);
-
-   pathToXml(sb, cop);
-
-   sb->ft->appendChars(sb,"</INSTANCENAME>\n");
-   sb->ft->appendChars(sb,"</IPARAMVALUE>\n");
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   sb = deleteInstanceRequest(cop);
 
    error = con->ft->addPayload(con,sb);
 
@@ -1458,20 +2306,18 @@ static CMPIStatus deleteInstance(
       CMSetStatusWithChars(&rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return rc;
    }
 
    if (con->mStatus.rc != CMPI_RC_OK) {
      rc=cloneStatus(con->mStatus);
      CMRelease(sb);
-      END_TIMING(_T_FAILED);
      return rc;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+   rh = scanResponse(con, cop);
    if (rh.errCode != 0) {
       CMSetStatusWithChars(&rc, rh.errCode, rh.description);
       free(rh.description);
@@ -1480,21 +2326,49 @@ static CMPIStatus deleteInstance(
    else
    CMSetStatus(&rc, CMPI_RC_OK);
 
-   END_TIMING(_T_GOOD);
    return rc;
 }
 
 /* --------------------------------------------------------------------------*/
 
-/* finish but not working - scanCimXmlResponse fails parsing results */
-static CMPIEnumeration * execQuery(
-	CMCIClient * mb,
-	CMPIObjectPath * cop,
-	const char * query,
-	const char * lang,
-	CMPIStatus * rc)
-/*
-<?xml version="1.0" encoding="utf-8"?>
+static UtilStringBuffer *execQueryRequest(CMPIObjectPath *cop,
+                                          const char *query, const char *lang)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", ExecQuery, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   /* Add the query language */
+   sb->ft->append3Chars(sb,
+        "<IPARAMVALUE NAME=\"QueryLanguage\">\n<VALUE>",
+        lang, "</VALUE>\n</IPARAMVALUE>");
+
+   /* Add the query */
+   sb->ft->append3Chars(sb,
+        "<IPARAMVALUE NAME=\"Query\">\n<VALUE>",
+        query, "</VALUE>\n</IPARAMVALUE>");
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+/* finish but not working - scanCimXmlResponse fails parsing results */
+static CMPIEnumeration * execQuery(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	const char * query,
+	const char * lang,
+	CMPIStatus * rc)
+/*
+<?xml version="1.0" encoding="utf-8"?>
 <CIM CIMVERSION="2.0" DTDVERSION="2.0">
   <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
     <SIMPLEREQ>
@@ -1517,34 +2391,21 @@ static CMPIEnumeration * execQuery(
 {
    ClientEnc        *cl  = (ClientEnc *)mb;
    CMCIConnection   *con = cl->connection;
-   UtilStringBuffer *sb  = UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer *sb;
    char             *error;
    ResponseHdr      rh;
    CMPIEnumeration  *retval;
 
-   START_TIMING(ExecQuery);
    SET_DEBUG();
 
    con->ft->genRequest(cl, ExecQuery, cop, 0);
 
-   addXmlHeader(sb);
-
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", ExecQuery, "\">");
-
-   addXmlNamespace(sb, cop);
-
-   /* Add the query language */
-   sb->ft->append3Chars(sb,
-        "<IPARAMVALUE NAME=\"QueryLanguage\">\n<VALUE>",
-        lang, "</VALUE>\n</IPARAMVALUE>");
-
-   /* Add the query */
-   sb->ft->append3Chars(sb,
-        "<IPARAMVALUE NAME=\"Query\">\n<VALUE>",
-        query, "</VALUE>\n</IPARAMVALUE>");
+   sb = execQueryRequest(cop, query, lang);
 
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+      retval = streamEnumeration(cl, sb, cop, rc);
+      return retval;
+   }
 
    error = con->ft->addPayload(con,sb);
 
@@ -1552,7 +2413,6 @@ static CMPIEnumeration * execQuery(
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1560,18 +2420,16 @@ static CMPIEnumeration * execQuery(
       if (rc)
      *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+   rh = scanResponse(con, cop);
    if (rh.errCode != 0) {
       CMSetStatusWithChars(rc, rh.errCode, rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -1583,11 +2441,39 @@ static CMPIEnumeration * execQuery(
 
    CMSetStatus(rc, CMPI_RC_OK);
    retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
+static UtilStringBuffer *enumInstancesRequest(CMPIObjectPath *cop,
+                                              CMPIFlags flags,
+                                              char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", EnumerateInstances, "\">");
+   addXmlNamespace(sb, cop);
+
+   addXmlClassnameParam(sb, cop);
+
+   emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
+   emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
+   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
+   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
+
+   if (properties != NULL)
+      addXmlPropertyListParam(sb, properties);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIEnumeration * enumInstances(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -1597,33 +2483,21 @@ static CMPIEnumeration * enumInstances(
 {
     ClientEnc	     *cl  = (ClientEnc *)mb;
     CMCIConnection   *con = cl->connection;
-    UtilStringBuffer *sb  = UtilFactory->newStringBuffer(2048);
+    UtilStringBuffer *sb;
     char             *error;
     ResponseHdr	     rh;
     CMPIEnumeration   *retval;
 
-    START_TIMING(EnumerateInstances);
     SET_DEBUG();
 
     con->ft->genRequest(cl, EnumerateInstances, cop, 0);
 
-    addXmlHeader(sb);
-
-    sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", EnumerateInstances, "\">");
-    addXmlNamespace(sb, cop);
-
-    addXmlClassnameParam(sb, cop);
-
-    emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
-    emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
-    emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
-    emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
-
-    if (properties != NULL)
-       addXmlPropertyListParam(sb, properties);
+    sb = enumInstancesRequest(cop, flags, properties);
 
-    sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-    addXmlFooter(sb);
+    if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+       retval = streamEnumeration(cl, sb, cop, rc);
+       return retval;
+    }
 
     error = con->ft->addPayload(con,sb);
 
@@ -1631,7 +2505,6 @@ static CMPIEnumeration * enumInstances(
         CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
         free(error);
         CMRelease(sb);
-        END_TIMING(_T_FAILED);
         return NULL;
     }
 
@@ -1639,19 +2512,17 @@ static CMPIEnumeration * enumInstances(
         if (rc)
       *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-        END_TIMING(_T_FAILED);
       return NULL;
     }
 
     CMRelease(sb);
 
-    rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+    rh = scanResponse(con, cop);
 
     if (rh.errCode != 0) {
         CMSetStatusWithChars(rc, rh.errCode, rh.description);
         free(rh.description);
         CMRelease(rh.rvArray);
-        END_TIMING(_T_FAILED);
         return NULL;
     }
 
@@ -1663,319 +2534,452 @@ static CMPIEnumeration * enumInstances(
 
     CMSetStatus(rc, CMPI_RC_OK);
     retval = newCMPIEnumeration(rh.rvArray, NULL);
-    END_TIMING(_T_GOOD);
     return retval;
 }
 
 /* --------------------------------------------------------------------------*/
-static CMPIEnumeration * associators(
-	CMCIClient	* mb,
-	CMPIObjectPath	* cop,
-	const char	* assocClass,
-	const char	* resultClass,
-	const char	* role,
-	const char	* resultRole,
-	CMPIFlags	flags,
-	char		** properties,
-	CMPIStatus	* rc)
+
 /*
-<?xml version="1.0" encoding="utf-8"?>
-<CIM CIMVERSION="2.0" DTDVERSION="2.0">
-  <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
-    <SIMPLEREQ>
-      <IMETHODCALL NAME="Associators">
-        <LOCALNAMESPACEPATH>
-          <NAMESPACE NAME="root"/>
-          <NAMESPACE NAME="cimv2"/>
-        </LOCALNAMESPACEPATH>
-        <IPARAMVALUE NAME="ObjectName">
-          <INSTANCENAME CLASSNAME="Linux_ComputerSystem">
-            <KEYBINDING NAME="CreationClassName">
-              <KEYVALUE VALUETYPE="string">Linux_ComputerSystem</KEYVALUE>
-            </KEYBINDING>
-            <KEYBINDING NAME="Name">
-              <KEYVALUE VALUETYPE="string">bestorga.ibm.com</KEYVALUE>
-            </KEYBINDING>
-          </INSTANCENAME>
-        </IPARAMVALUE>
-        <IPARAMVALUE NAME="AssocClass">
-          <CLASSNAME NAME="Linux_RunningOS"/>
-        </IPARAMVALUE>
-        <IPARAMVALUE NAME="IncludeQualifiers">
-          <VALUE>FALSE</VALUE>
-        </IPARAMVALUE>
-        <IPARAMVALUE NAME="IncludeClassOrigin">
-          <VALUE>TRUE</VALUE>
-        </IPARAMVALUE>
-      </IMETHODCALL>
-    </SIMPLEREQ>
-  </MESSAGE>
-</CIM>
-*/
+ * EnumerateInstances into a CIMCResultTable: the same request, the
+ * response is parsed straight into the table's columns. Qualifiers
+ * aren't requested since the table doesn't keep them.
+ */
+static CIMCResultTable * enumInstancesTable(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	CMPIFlags flags,
+	char ** properties,
+	CMPIStatus * rc)
 {
-   ClientEnc		*cl = (ClientEnc*)mb;
-   CMCIConnection	*con = cl->connection;
-   UtilStringBuffer	*sb = UtilFactory->newStringBuffer(2048);
-   char			*error;
-   CMPIEnumeration      *retval;
+    ClientEnc	     *cl  = (ClientEnc *)mb;
+    CMCIConnection   *con = cl->connection;
+    UtilStringBuffer *sb;
+    char             *error;
+    ResponseHdr	     rh;
+    CIMCResultTable  *table;
+    CMPIUint64       parseStart;
 
-   START_TIMING(Associators);
-   SET_DEBUG();
+    SET_DEBUG();
 
-   con->ft->genRequest(cl, Associators, cop, 0);
-   addXmlHeader(sb);
+    con->ft->genRequest(cl, EnumerateInstances, cop, 0);
 
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", Associators, "\">");
+    sb = enumInstancesRequest(cop, flags & ~CMPI_FLAG_IncludeQualifiers,
+			      properties);
 
-   addXmlNamespace(sb, cop);
+    error = con->ft->addPayload(con,sb);
 
-   /* TODO: Need to switch from ObjName to InstanceName? */
-   addXmlObjectName(sb, cop, "ObjectName");
+    if (error || (error = con->ft->getResponse(con, cop))) {
+        CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+        free(error);
+        CMRelease(sb);
+        return NULL;
+    }
 
-   /* Add optional parameters */
-   if (assocClass!=NULL)
-      sb->ft->append3Chars(sb,
-                   "<IPARAMVALUE NAME=\"AssocClass\"><CLASSNAME NAME=\"",
-                   assocClass,
-		  "\"/></IPARAMVALUE>\n");
+    CMRelease(sb);
 
-   if (resultClass!=NULL)
-      sb->ft->append3Chars(sb,
-                   "<IPARAMVALUE NAME=\"ResultClass\"><CLASSNAME NAME=\"",
-                   resultClass,
-		  "\"/></IPARAMVALUE>\n");
+    if (con->mStatus.rc != CMPI_RC_OK) {
+        if (rc)
+            *rc=cloneStatus(con->mStatus);
+        return NULL;
+    }
 
-   if (role)
-      sb->ft->append3Chars(sb,
-                   "<IPARAMVALUE NAME=\"Role\"><VALUE>",
-                   role,
-		 "</VALUE></IPARAMVALUE>\n");
+    table = newCIMCResultTable(getNameSpaceChars(cop));
+    parseStart = con->mMetrics ? microseconds() : 0;
+    rh = scanCimXmlTableResponse(CMGetCharPtr(con->mResponse), cop,
+				 con->mHeap, table);
+    CMRelease(rh.rvArray);
+    if (con->mMetrics)
+        countOperation(con, rh.errCode != 0,
+                       rh.errCode ? 0 : table->ft->getRowCount(table, NULL),
+                       parseStart);
 
-   if (resultRole)
-      sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"ResultRole\"><VALUE>", resultRole,
-		 "</VALUE></IPARAMVALUE>\n");
+    if (rh.errCode != 0) {
+        CMSetStatusWithChars(rc, rh.errCode, rh.description);
+        free(rh.description);
+        table->ft->release(table);
+        return NULL;
+    }
 
-   /* Add optional flags */
+    CMSetStatus(rc, CMPI_RC_OK);
+    return table;
+}
+
+/* --------------------------------------------------------------------------*/
+
+/*
+ * Pull operations (DSP0200 OpenEnumerateInstances and friends): the open
+ * request returns the first MaxObjectCount objects and an enumeration
+ * context, further pages are requested from within hasNext()/getNext()
+ * once the current one is handed out, so at most one page is held.
+ */
+
+static void emitPullParams(UtilStringBuffer *sb, ClientEnc *cl)
+{
+   XmlEnv *xenv = (XmlEnv*)cl->env;
+   char    num[32];
+
+   if (xenv->pullOperationTimeout) {
+      sprintf(num, "%ld", xenv->pullOperationTimeout);
+      sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"OperationTimeout\"><VALUE>",
+			   num, "</VALUE></IPARAMVALUE>\n");
+   }
+   sprintf(num, "%ld", xenv->pullMaxObjectCount);
+   sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"MaxObjectCount\"><VALUE>",
+			num, "</VALUE></IPARAMVALUE>\n");
+}
+
+static UtilStringBuffer *openEnumInstancesRequest(ClientEnc *cl,
+						  CMPIObjectPath *cop,
+						  CMPIFlags flags,
+						  char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", OpenEnumerateInstances, "\">");
+   addXmlNamespace(sb, cop);
+
+   addXmlClassnameParam(sb, cop);
+
+   emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
    emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
-   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
 
-   /* Add property list filter */
    if (properties != NULL)
-	addXmlPropertyListParam(sb, properties);
+      addXmlPropertyListParam(sb, properties);
+
+   emitPullParams(sb, cl);
 
    sb->ft->appendChars(sb,"</IMETHODCALL>\n");
    addXmlFooter(sb);
 
-   error = con->ft->addPayload(con, sb);
+   return sb;
+}
 
-   if (error || (error = con->ft->getResponse(con,cop))) {
-      CMSetStatusWithChars(rc, CMPI_RC_ERR_FAILED, error);
-      free(error);
-      CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
-   }
+static UtilStringBuffer *openEnumInstanceNamesRequest(ClientEnc *cl,
+						      CMPIObjectPath *cop)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
 
-   if (con->mStatus.rc != CMPI_RC_OK) {
-      if (rc)
-     *rc=cloneStatus(con->mStatus);
-      CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
-   }
+   addXmlHeader(sb);
 
-   CMRelease(sb);
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", OpenEnumerateInstancePaths, "\">");
+   addXmlNamespace(sb, cop);
 
-   ResponseHdr rh=scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   addXmlClassnameParam(sb, cop);
 
-   if (rh.errCode != 0) {
-      CMSetStatusWithChars(rc, rh.errCode, rh.description);
-      free(rh.description);
-      CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
-      return NULL;
-   }
+   emitPullParams(sb, cl);
 
-#if DEBUG
-   if (do_debug)
-       printf ("\treturn enumeration array type %d expected CMPI_instance %d\n",
-	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_instance);
-#endif
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
 
-   CMSetStatus(rc, CMPI_RC_OK);
-   retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
-   return retval;
+   return sb;
 }
 
-/* --------------------------------------------------------------------------*/
+/* PullInstancesWithPath, PullInstancePaths and CloseEnumeration */
+static UtilStringBuffer *pullRequest(ClientEnc *cl, const char *method,
+				     CMPIObjectPath *cop, char *context)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(1024);
+   char             *xmlContext = AsciiToXmlStr(context);
 
-static CMPIEnumeration * associatorNames(
-	CMCIClient	* mb,
-	CMPIObjectPath	* cop,
-	const char	* assocClass,
-	const char	* resultClass,
-	const char	* role,
-	const char	* resultRole,
-	CMPIStatus	* rc)
-/*
-<?xml version="1.0" encoding="utf-8"?>
-<CIM CIMVERSION="2.0" DTDVERSION="2.0">
-  <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
-    <SIMPLEREQ>
-      <IMETHODCALL NAME="AssociatorNames">
-	<LOCALNAMESPACEPATH>
-	  <NAMESPACE NAME="root"/>
-	  <NAMESPACE NAME="cimv2"/>
-	</LOCALNAMESPACEPATH>
-	<IPARAMVALUE NAME="ObjectName">
-	  <INSTANCENAME CLASSNAME="Linux_ComputerSystem">
-	    <KEYBINDING NAME="CreationClassName">
-	      <KEYVALUE VALUETYPE="string">Linux_ComputerSystem</KEYVALUE>
-	    </KEYBINDING>
-	    <KEYBINDING NAME="Name">
-	      <KEYVALUE VALUETYPE="string">bestorga.ibm.com</KEYVALUE>
-	    </KEYBINDING>
-	  </INSTANCENAME>
-	</IPARAMVALUE>
-	<IPARAMVALUE NAME="AssocClass">
-	  <CLASSNAME NAME="Linux_RunningOS"/>
-	</IPARAMVALUE>
-      </IMETHODCALL>
-    </SIMPLEREQ>
-  </MESSAGE>
-</CIM>
-*/
-{
-   ClientEnc		*cl = (ClientEnc*)mb;
-   CMCIConnection	*con = cl->connection;
-   UtilStringBuffer	*sb = UtilFactory->newStringBuffer(2048);
-   char			*error;
-   CMPIEnumeration      *retval;
-
-   START_TIMING(AssociatorNames);
-   SET_DEBUG();
-
-   con->ft->genRequest(cl, AssociatorNames, cop, 0);
    addXmlHeader(sb);
 
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", AssociatorNames, "\">");
-
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", method, "\">");
    addXmlNamespace(sb, cop);
 
-   addXmlObjectName(sb, cop, "ObjectName");
+   sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"EnumerationContext\"><VALUE>",
+			xmlContext, "</VALUE></IPARAMVALUE>\n");
+   free(xmlContext);
 
-   /* Add optional parameters */
-   if (assocClass!=NULL)
-      sb->ft->append3Chars(sb,
-                   "<IPARAMVALUE NAME=\"AssocClass\"><CLASSNAME NAME=\"",
-                   assocClass,
-          "\"/></IPARAMVALUE>\n");
+   if (method != CloseEnumeration)
+      emitPullParams(sb, cl);
 
-   if (resultClass!=NULL)
-      sb->ft->append3Chars(sb,
-                   "<IPARAMVALUE NAME=\"ResultClass\"><CLASSNAME NAME=\"",
-                   resultClass,
-          "\"/></IPARAMVALUE>\n");
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
 
-   if (role)
-      sb->ft->append3Chars(sb, 
-                   "<IPARAMVALUE NAME=\"Role\"><VALUE>", 
-                   role,
-         "</VALUE></IPARAMVALUE>\n");
+   return sb;
+}
 
-   if (resultRole)
-      sb->ft->append3Chars(sb,
-                   "<IPARAMVALUE NAME=\"ResultRole\"><VALUE>", 
-                   resultRole,
-         "</VALUE></IPARAMVALUE>\n");
+/* posts sb and parses the response into rh, returns 0 on success */
+static int pullPage(ClientEnc *cl, const char *method, CMPIObjectPath *cop,
+		    UtilStringBuffer *sb, ResponseHdr *rh, CMPIStatus *rc)
+{
+   CMCIConnection *con = cl->connection;
+   char           *error;
 
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   con->ft->genRequest(cl, method, cop, 0);
 
    error = con->ft->addPayload(con,sb);
 
-   if (error || (error=con->ft->getResponse(con,cop))) {
+   if (error || (error = con->ft->getResponse(con, cop))) {
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
+      return 1;
    }
 
+   CMRelease(sb);
+
    if (con->mStatus.rc != CMPI_RC_OK) {
       if (rc)
-     *rc=cloneStatus(con->mStatus);
-      CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
+	 *rc=cloneStatus(con->mStatus);
+      return 1;
    }
 
-   CMRelease(sb);
-
-   ResponseHdr rh=scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   *rh = scanResponse(con, cop);
 
-   if (rh.errCode != 0) {
-      CMSetStatusWithChars(rc, rh.errCode, rh.description);
-      free(rh.description);
-      CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
-      return NULL;
+   if (rh->errCode != 0) {
+      CMSetStatusWithChars(rc, rh->errCode, rh->description);
+      free(rh->description);
+      free(rh->enumerationContext);
+      CMRelease(rh->rvArray);
+      return 1;
    }
 
-#if DEBUG
-   if (do_debug)
-      printf ("\treturn enumeration array type %d expected CMPI_ref %d\n",
-	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_ref);
-#endif
+   if (!rh->endOfSequence && rh->enumerationContext == NULL) {
+      CMSetStatusWithChars(rc, CMPI_RC_ERR_FAILED,
+			   "No EnumerationContext returned by server");
+      CMRelease(rh->rvArray);
+      return 1;
+   }
+   if (rh->endOfSequence && rh->enumerationContext) {
+      free(rh->enumerationContext);
+      rh->enumerationContext = NULL;
+   }
 
    CMSetStatus(rc, CMPI_RC_OK);
-   retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
-   return retval;
+   return 0;
 }
 
-/* --------------------------------------------------------------------------*/
+struct _PullEnumeration {
+   CMPIEnumeration   enumeration;
+   ClientEnc        *cl;
+   CMPIObjectPath   *cop;
+   const char       *method;     /* pull method for the following pages */
+   char             *context;    /* NULL once the end of sequence is reached */
+   CMPIArray        *page;
+   CMPICount         current;    /* next element of page */
+   CMPIStatus        status;
+};
 
-static CMPIEnumeration * references(
+static int pullHasNext(struct _PullEnumeration *pe)
+{
+   ResponseHdr rh;
+
+   while (pe->current >= CMGetArrayCount(pe->page, NULL)) {
+      if (pe->context == NULL || pe->status.rc != CMPI_RC_OK)
+	 return 0;
+      if (pullPage(pe->cl, pe->method, pe->cop,
+		   pullRequest(pe->cl, pe->method, pe->cop, pe->context),
+		   &rh, &pe->status)) {
+	 /* the server closes the enumeration when a pull fails */
+	 free(pe->context);
+	 pe->context = NULL;
+	 return 0;
+      }
+      CMRelease(pe->page);
+      free(pe->context);
+      pe->page = rh.rvArray;
+      pe->context = rh.enumerationContext;
+      pe->current = 0;
+   }
+   return 1;
+}
+
+static CMPIStatus releasePullEnum(CMPIEnumeration *enm)
+{
+   struct _PullEnumeration *pe = (struct _PullEnumeration *)enm;
+   CMPIStatus rc = {CMPI_RC_OK, NULL};
+   CMPIStatus st = {CMPI_RC_OK, NULL};
+   ResponseHdr rh;
+
+   if (pe->context) {
+      /* released before the end, the server would keep it until timeout */
+      if (pullPage(pe->cl, CloseEnumeration, pe->cop,
+		   pullRequest(pe->cl, CloseEnumeration, pe->cop, pe->context),
+		   &rh, &st) == 0) {
+	 free(rh.enumerationContext);
+	 CMRelease(rh.rvArray);
+      } else if (st.msg)
+	 CMRelease(st.msg);
+      free(pe->context);
+   }
+   if (pe->status.msg)
+      CMRelease(pe->status.msg);
+   if (pe->page)
+      CMRelease(pe->page);
+   CMRelease(pe->cop);
+   free(pe);
+   return rc;
+}
+
+static CMPIEnumeration *clonePullEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   CMSetStatusWithChars(rc, CMPI_RC_ERR_NOT_SUPPORTED,
+			"Clone function not supported for pulled enumerations");
+   return NULL;
+}
+
+static CMPIData getNextPullEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   struct _PullEnumeration *pe = (struct _PullEnumeration *)enm;
+   CMPIData data = {CMPI_null, CMPI_nullValue};
+
+   if (pullHasNext(pe))
+      return CMGetArrayElementAt(pe->page, pe->current++, rc);
+   if (rc)
+      *rc = pe->status.rc == CMPI_RC_OK ? pe->status : cloneStatus(pe->status);
+   return data;
+}
+
+static CMPIBoolean hasNextPullEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   struct _PullEnumeration *pe = (struct _PullEnumeration *)enm;
+
+   if (pullHasNext(pe)) {
+      CMSetStatus(rc, CMPI_RC_OK);
+      return 1;
+   }
+   if (rc)
+      *rc = pe->status.rc == CMPI_RC_OK ? pe->status : cloneStatus(pe->status);
+   return 0;
+}
+
+/* pulls the remaining pages, returns all objects not handed out yet */
+static CMPIArray *toArrayPullEnum(CMPIEnumeration *enm, CMPIStatus *rc)
+{
+   struct _PullEnumeration *pe = (struct _PullEnumeration *)enm;
+   CMPIArray *all;
+   CMPIData   d;
+   CMPICount  i, n;
+
+   all = newCMPIArray(0, 0, NULL);
+   while (pullHasNext(pe)) {
+      n = CMGetArrayCount(pe->page, NULL);
+      for (i = pe->current; i < n; i++) {
+	 /* the array takes the value over, the page releases its own */
+	 d = CMGetArrayElementAt(pe->page, i, NULL);
+	 d.value = native_clone_CMPIValue(d.type, &d.value, NULL);
+	 simpleArrayAdd(all, &d.value, d.type);
+      }
+      pe->current = n;
+   }
+   /* keep it with the enumeration like the other enumeration types do */
+   CMRelease(pe->page);
+   pe->page = all;
+   pe->current = CMGetArrayCount(all, NULL);
+   if (rc)
+      *rc = pe->status.rc == CMPI_RC_OK ? pe->status : cloneStatus(pe->status);
+   return all;
+}
+
+static CMPIEnumerationFT pullEnumFt = {
+   NATIVE_FT_VERSION,
+   releasePullEnum,
+   clonePullEnum,
+   getNextPullEnum,
+   hasNextPullEnum,
+   toArrayPullEnum
+};
+
+/* posts the open request in sb and returns the enumeration of its pages */
+static CMPIEnumeration *pullEnumeration(ClientEnc *cl, const char *open,
+					const char *pull, UtilStringBuffer *sb,
+					CMPIObjectPath *cop, CMPIStatus *rc)
+{
+   struct _PullEnumeration *pe;
+   ResponseHdr              rh;
+
+   if (pullPage(cl, open, cop, sb, &rh, rc))
+      return NULL;
+
+   pe = (struct _PullEnumeration*)calloc(1, sizeof(struct _PullEnumeration));
+   pe->enumeration.hdl = "CMPIEnumeration";
+   pe->enumeration.ft = &pullEnumFt;
+   pe->cl = cl;
+   pe->cop = CMClone(cop, NULL);
+   pe->method = pull;
+   pe->context = rh.enumerationContext;
+   pe->page = rh.rvArray;
+   return &pe->enumeration;
+}
+
+static CMPIEnumeration * openEnumInstances(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
-	const char * resultClass,
-	const char * role ,
 	CMPIFlags flags,
 	char ** properties,
 	CMPIStatus * rc)
 {
-   ClientEnc		*cl = (ClientEnc*)mb;
-   CMCIConnection	*con = cl->connection;
-   UtilStringBuffer	*sb = UtilFactory->newStringBuffer(2048);
-   char			*error;
-   CMPIEnumeration      *retval;
+   ClientEnc       *cl = (ClientEnc *)mb;
+   CMPIEnumeration *retval;
 
-   START_TIMING(References);
    SET_DEBUG();
 
-   con->ft->genRequest(cl, References, cop, 0);
+   retval = pullEnumeration(cl, OpenEnumerateInstances, PullInstancesWithPath,
+			    openEnumInstancesRequest(cl, cop, flags, properties),
+			    cop, rc);
+   return retval;
+}
+
+static CMPIEnumeration * openEnumInstanceNames(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	CMPIStatus * rc)
+{
+   ClientEnc       *cl = (ClientEnc *)mb;
+   CMPIEnumeration *retval;
+
+   SET_DEBUG();
+
+   retval = pullEnumeration(cl, OpenEnumerateInstancePaths, PullInstancePaths,
+			    openEnumInstanceNamesRequest(cl, cop), cop, rc);
+   return retval;
+}
+
+/* --------------------------------------------------------------------------*/
+static UtilStringBuffer *associatorsRequest(CMPIObjectPath *cop,
+                                            const char *assocClass,
+                                            const char *resultClass,
+                                            const char *role,
+                                            const char *resultRole,
+                                            CMPIFlags flags,
+                                            char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
    addXmlHeader(sb);
 
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", References, "\">");
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", Associators, "\">");
 
    addXmlNamespace(sb, cop);
 
+   /* TODO: Need to switch from ObjName to InstanceName? */
    addXmlObjectName(sb, cop, "ObjectName");
 
    /* Add optional parameters */
-   if (resultClass)
-      sb->ft->append3Chars(sb, 
-                     "<IPARAMVALUE NAME=\"ResultClass\"><CLASSNAME NAME=\"",
-                     resultClass, 
-                     "\"/></IPARAMVALUE>\n");
+   if (assocClass!=NULL)
+      sb->ft->append3Chars(sb,
+                   "<IPARAMVALUE NAME=\"AssocClass\"><CLASSNAME NAME=\"",
+                   assocClass,
+		  "\"/></IPARAMVALUE>\n");
+
+   if (resultClass!=NULL)
+      sb->ft->append3Chars(sb,
+                   "<IPARAMVALUE NAME=\"ResultClass\"><CLASSNAME NAME=\"",
+                   resultClass,
+		  "\"/></IPARAMVALUE>\n");
 
    if (role)
       sb->ft->append3Chars(sb,
-                     "<IPARAMVALUE NAME=\"Role\"><VALUE>",
-	             role,
-         "</VALUE></IPARAMVALUE>\n");
+                   "<IPARAMVALUE NAME=\"Role\"><VALUE>",
+                   role,
+		 "</VALUE></IPARAMVALUE>\n");
+
+   if (resultRole)
+      sb->ft->append3Chars(sb, "<IPARAMVALUE NAME=\"ResultRole\"><VALUE>", resultRole,
+		 "</VALUE></IPARAMVALUE>\n");
 
    /* Add optional flags */
    emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
@@ -1988,12 +2992,78 @@ static CMPIEnumeration * references(
    sb->ft->appendChars(sb,"</IMETHODCALL>\n");
    addXmlFooter(sb);
 
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static CMPIEnumeration * associators(
+	CMCIClient	* mb,
+	CMPIObjectPath	* cop,
+	const char	* assocClass,
+	const char	* resultClass,
+	const char	* role,
+	const char	* resultRole,
+	CMPIFlags	flags,
+	char		** properties,
+	CMPIStatus	* rc)
+/*
+<?xml version="1.0" encoding="utf-8"?>
+<CIM CIMVERSION="2.0" DTDVERSION="2.0">
+  <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
+    <SIMPLEREQ>
+      <IMETHODCALL NAME="Associators">
+        <LOCALNAMESPACEPATH>
+          <NAMESPACE NAME="root"/>
+          <NAMESPACE NAME="cimv2"/>
+        </LOCALNAMESPACEPATH>
+        <IPARAMVALUE NAME="ObjectName">
+          <INSTANCENAME CLASSNAME="Linux_ComputerSystem">
+            <KEYBINDING NAME="CreationClassName">
+              <KEYVALUE VALUETYPE="string">Linux_ComputerSystem</KEYVALUE>
+            </KEYBINDING>
+            <KEYBINDING NAME="Name">
+              <KEYVALUE VALUETYPE="string">bestorga.ibm.com</KEYVALUE>
+            </KEYBINDING>
+          </INSTANCENAME>
+        </IPARAMVALUE>
+        <IPARAMVALUE NAME="AssocClass">
+          <CLASSNAME NAME="Linux_RunningOS"/>
+        </IPARAMVALUE>
+        <IPARAMVALUE NAME="IncludeQualifiers">
+          <VALUE>FALSE</VALUE>
+        </IPARAMVALUE>
+        <IPARAMVALUE NAME="IncludeClassOrigin">
+          <VALUE>TRUE</VALUE>
+        </IPARAMVALUE>
+      </IMETHODCALL>
+    </SIMPLEREQ>
+  </MESSAGE>
+</CIM>
+*/
+{
+   ClientEnc		*cl = (ClientEnc*)mb;
+   CMCIConnection	*con = cl->connection;
+   UtilStringBuffer	*sb;
+   char			*error;
+   CMPIEnumeration      *retval;
+
+   SET_DEBUG();
+
+   con->ft->genRequest(cl, Associators, cop, 0);
+   sb = associatorsRequest(cop, assocClass, resultClass, role, resultRole, flags, properties);
+
+   if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+      retval = streamEnumeration(cl, sb, cop, rc);
+      return retval;
+   }
+
    error = con->ft->addPayload(con, sb);
 
-   if (error || (error=con->ft->getResponse(con,cop))) {
-      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+   if (error || (error = con->ft->getResponse(con,cop))) {
+      CMSetStatusWithChars(rc, CMPI_RC_ERR_FAILED, error);
       free(error);
-      END_TIMING(_T_FAILED);
+      CMRelease(sb);
       return NULL;
    }
 
@@ -2006,13 +3076,12 @@ static CMPIEnumeration * references(
 
    CMRelease(sb);
 
-   ResponseHdr rh=scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   ResponseHdr rh=scanResponse(con, cop);
 
-   if (rh.errCode!=0) {
-      CMSetStatusWithChars(rc,rh.errCode,rh.description);
+   if (rh.errCode != 0) {
+      CMSetStatusWithChars(rc, rh.errCode, rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -2022,31 +3091,269 @@ static CMPIEnumeration * references(
 	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_instance);
 #endif
 
-   CMSetStatus(rc,CMPI_RC_OK);
+   CMSetStatus(rc, CMPI_RC_OK);
    retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
 
-static CMPIEnumeration * referenceNames(
-	CMCIClient * mb,
-	CMPIObjectPath * cop,
+static UtilStringBuffer *associatorNamesRequest(CMPIObjectPath *cop,
+                                                const char *assocClass,
+                                                const char *resultClass,
+                                                const char *role,
+                                                const char *resultRole)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", AssociatorNames, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   addXmlObjectName(sb, cop, "ObjectName");
+
+   /* Add optional parameters */
+   if (assocClass!=NULL)
+      sb->ft->append3Chars(sb,
+                   "<IPARAMVALUE NAME=\"AssocClass\"><CLASSNAME NAME=\"",
+                   assocClass,
+          "\"/></IPARAMVALUE>\n");
+
+   if (resultClass!=NULL)
+      sb->ft->append3Chars(sb,
+                   "<IPARAMVALUE NAME=\"ResultClass\"><CLASSNAME NAME=\"",
+                   resultClass,
+          "\"/></IPARAMVALUE>\n");
+
+   if (role)
+      sb->ft->append3Chars(sb,
+                   "<IPARAMVALUE NAME=\"Role\"><VALUE>",
+                   role,
+         "</VALUE></IPARAMVALUE>\n");
+
+   if (resultRole)
+      sb->ft->append3Chars(sb,
+                   "<IPARAMVALUE NAME=\"ResultRole\"><VALUE>",
+                   resultRole,
+         "</VALUE></IPARAMVALUE>\n");
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static CMPIEnumeration * associatorNames(
+	CMCIClient	* mb,
+	CMPIObjectPath	* cop,
+	const char	* assocClass,
+	const char	* resultClass,
+	const char	* role,
+	const char	* resultRole,
+	CMPIStatus	* rc)
+/*
+<?xml version="1.0" encoding="utf-8"?>
+<CIM CIMVERSION="2.0" DTDVERSION="2.0">
+  <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
+    <SIMPLEREQ>
+      <IMETHODCALL NAME="AssociatorNames">
+	<LOCALNAMESPACEPATH>
+	  <NAMESPACE NAME="root"/>
+	  <NAMESPACE NAME="cimv2"/>
+	</LOCALNAMESPACEPATH>
+	<IPARAMVALUE NAME="ObjectName">
+	  <INSTANCENAME CLASSNAME="Linux_ComputerSystem">
+	    <KEYBINDING NAME="CreationClassName">
+	      <KEYVALUE VALUETYPE="string">Linux_ComputerSystem</KEYVALUE>
+	    </KEYBINDING>
+	    <KEYBINDING NAME="Name">
+	      <KEYVALUE VALUETYPE="string">bestorga.ibm.com</KEYVALUE>
+	    </KEYBINDING>
+	  </INSTANCENAME>
+	</IPARAMVALUE>
+	<IPARAMVALUE NAME="AssocClass">
+	  <CLASSNAME NAME="Linux_RunningOS"/>
+	</IPARAMVALUE>
+      </IMETHODCALL>
+    </SIMPLEREQ>
+  </MESSAGE>
+</CIM>
+*/
+{
+   ClientEnc		*cl = (ClientEnc*)mb;
+   CMCIConnection	*con = cl->connection;
+   UtilStringBuffer	*sb;
+   char			*error;
+   CMPIEnumeration      *retval;
+
+   SET_DEBUG();
+
+   con->ft->genRequest(cl, AssociatorNames, cop, 0);
+   sb = associatorNamesRequest(cop, assocClass, resultClass, role, resultRole);
+
+   if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+      retval = streamEnumeration(cl, sb, cop, rc);
+      return retval;
+   }
+
+   error = con->ft->addPayload(con,sb);
+
+   if (error || (error=con->ft->getResponse(con,cop))) {
+      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+      free(error);
+      CMRelease(sb);
+      return NULL;
+   }
+
+   if (con->mStatus.rc != CMPI_RC_OK) {
+      if (rc)
+     *rc=cloneStatus(con->mStatus);
+      CMRelease(sb);
+      return NULL;
+   }
+
+   CMRelease(sb);
+
+   ResponseHdr rh=scanResponse(con, cop);
+
+   if (rh.errCode != 0) {
+      CMSetStatusWithChars(rc, rh.errCode, rh.description);
+      free(rh.description);
+      CMRelease(rh.rvArray);
+      return NULL;
+   }
+
+#if DEBUG
+   if (do_debug)
+      printf ("\treturn enumeration array type %d expected CMPI_ref %d\n",
+	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_ref);
+#endif
+
+   CMSetStatus(rc, CMPI_RC_OK);
+   retval = newCMPIEnumeration(rh.rvArray, NULL);
+   return retval;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static UtilStringBuffer *referencesRequest(CMPIObjectPath *cop,
+                                           const char *resultClass,
+                                           const char *role, CMPIFlags flags,
+                                           char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", References, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   addXmlObjectName(sb, cop, "ObjectName");
+
+   /* Add optional parameters */
+   if (resultClass)
+      sb->ft->append3Chars(sb,
+                     "<IPARAMVALUE NAME=\"ResultClass\"><CLASSNAME NAME=\"",
+                     resultClass,
+                     "\"/></IPARAMVALUE>\n");
+
+   if (role)
+      sb->ft->append3Chars(sb,
+                     "<IPARAMVALUE NAME=\"Role\"><VALUE>",
+	             role,
+         "</VALUE></IPARAMVALUE>\n");
+
+   /* Add optional flags */
+   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
+   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
+
+   /* Add property list filter */
+   if (properties != NULL)
+	addXmlPropertyListParam(sb, properties);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static CMPIEnumeration * references(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
 	const char * resultClass,
-	const char * role,
+	const char * role ,
+	CMPIFlags flags,
+	char ** properties,
 	CMPIStatus * rc)
 {
    ClientEnc		*cl = (ClientEnc*)mb;
    CMCIConnection	*con = cl->connection;
-   UtilStringBuffer	*sb = UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer	*sb;
    char			*error;
    CMPIEnumeration      *retval;
 
-   START_TIMING(ReferenceNames);
    SET_DEBUG();
 
-   con->ft->genRequest(cl, ReferenceNames, cop, 0);
+   con->ft->genRequest(cl, References, cop, 0);
+   sb = referencesRequest(cop, resultClass, role, flags, properties);
+
+   if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+      retval = streamEnumeration(cl, sb, cop, rc);
+      return retval;
+   }
+
+   error = con->ft->addPayload(con, sb);
+
+   if (error || (error=con->ft->getResponse(con,cop))) {
+      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+      free(error);
+      return NULL;
+   }
+
+   if (con->mStatus.rc != CMPI_RC_OK) {
+      if (rc)
+     *rc=cloneStatus(con->mStatus);
+      CMRelease(sb);
+      return NULL;
+   }
+
+   CMRelease(sb);
+
+   ResponseHdr rh=scanResponse(con, cop);
+
+   if (rh.errCode!=0) {
+      CMSetStatusWithChars(rc,rh.errCode,rh.description);
+      free(rh.description);
+      CMRelease(rh.rvArray);
+      return NULL;
+   }
+
+#if DEBUG
+   if (do_debug)
+       printf ("\treturn enumeration array type %d expected CMPI_instance %d\n",
+	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_instance);
+#endif
+
+   CMSetStatus(rc,CMPI_RC_OK);
+   retval = newCMPIEnumeration(rh.rvArray, NULL);
+   return retval;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static UtilStringBuffer *referenceNamesRequest(CMPIObjectPath *cop,
+                                               const char *resultClass,
+                                               const char *role)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
    addXmlHeader(sb);
 
    sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", ReferenceNames, "\">");
@@ -2061,7 +3368,7 @@ static CMPIEnumeration * referenceNames(
 	      resultClass,
               "\"/></IPARAMVALUE>\n");
    if (role)
-      sb->ft->append3Chars(sb, 
+      sb->ft->append3Chars(sb,
               "<IPARAMVALUE NAME=\"Role\"><VALUE>",
 	      role,
               "</VALUE></IPARAMVALUE>\n");
@@ -2069,13 +3376,40 @@ static CMPIEnumeration * referenceNames(
    sb->ft->appendChars(sb,"</IMETHODCALL>\n");
    addXmlFooter(sb);
 
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static CMPIEnumeration * referenceNames(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	const char * resultClass,
+	const char * role,
+	CMPIStatus * rc)
+{
+   ClientEnc		*cl = (ClientEnc*)mb;
+   CMCIConnection	*con = cl->connection;
+   UtilStringBuffer	*sb;
+   char			*error;
+   CMPIEnumeration      *retval;
+
+   SET_DEBUG();
+
+   con->ft->genRequest(cl, ReferenceNames, cop, 0);
+   sb = referenceNamesRequest(cop, resultClass, role);
+
+   if (cl->env->options & CIMC_STREAM_ENUMERATIONS) {
+      retval = streamEnumeration(cl, sb, cop, rc);
+      return retval;
+   }
+
    error = con->ft->addPayload(con, sb);
 
    if (error || (error=con->ft->getResponse(con,cop))) {
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -2083,19 +3417,17 @@ static CMPIEnumeration * referenceNames(
       if (rc)
      *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
    CMRelease(sb);
 
-   ResponseHdr rh=scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   ResponseHdr rh=scanResponse(con, cop);
 
    if (rh.errCode!=0) {
       CMSetStatusWithChars(rc,rh.errCode,rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -2107,66 +3439,22 @@ static CMPIEnumeration * referenceNames(
 
    CMSetStatus(rc,CMPI_RC_OK);
    retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
 
-CMPIData invokeMethod(
-	CMCIClient * mb,
-	CMPIObjectPath * cop,
-	const char * method,
-	CMPIArgs * in,
-	CMPIArgs * out,
-	CMPIStatus * rc)
-/*
-<?xml version="1.0" encoding="utf-8"?>
-<CIM CIMVERSION="2.0" DTDVERSION="2.0">
-  <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
-    <SIMPLEREQ>
-      <METHODCALL NAME="IsAuthorized">
-        <LOCALINSTANCEPATH>
-          <LOCALNAMESPACEPATH>
-            <NAMESPACE NAME="root"/>
-            <NAMESPACE NAME="cimv2"/>
-          </LOCALNAMESPACEPATH>
-          <INSTANCENAME CLASSNAME="CWS_Authorization">
-            <KEYBINDING NAME="Username">
-              <KEYVALUE VALUETYPE="string">schuur</KEYVALUE>
-            </KEYBINDING>
-            <KEYBINDING NAME="Classname">
-              <KEYVALUE VALUETYPE="string">CIM_ComputerSystem</KEYVALUE>
-            </KEYBINDING>
-          </INSTANCENAME>
-        </LOCALINSTANCEPATH>
-        <PARAMVALUE NAME="operation">
-          <VALUE>Query</VALUE>
-        </PARAMVALUE>
-      </METHODCALL>
-    </SIMPLEREQ>
-  </MESSAGE>
-</CIM>
-*/
+static UtilStringBuffer *invokeMethodRequest(CMPIObjectPath *cop,
+                                             const char *method,
+                                             CMPIArgs *in, CMPIStatus *rc)
 {
-   ClientEnc		*cl = (ClientEnc*)mb;
-   CMCIConnection	*con = cl->connection;
    UtilStringBuffer	*sb=UtilFactory->newStringBuffer(2048);
-   char			*error;
-   ResponseHdr		rh;
    CMPIString		*cn;
-   CMPIData		retval= { 0, CMPI_nullValue, {0} };
    int			i, numinargs = 0;
-   char                 *cv;
-
-   START_TIMING(method);
-   SET_DEBUG();
 
    if (in)
       numinargs = in->ft->getArgCount(in, NULL);
 
-   con->ft->genRequest(cl, (const char *)method, cop, 1);
-
    addXmlHeader(sb);
 
    /* Add the extrinsic method name */
@@ -2254,14 +3542,11 @@ CMPIData invokeMethod(
              sb->ft->appendChars(sb,"</PARAMVALUE>\n");
              break;
          default:
-
-           not_supported:
-
 	     CMSetStatusWithChars(rc, CMPI_RC_ERR_FAILED,
-                                  strdup("Unsupported IN argument type"));
-             retval.state = CMPI_notFound | CMPI_nullValue;
-             END_TIMING(_T_FAILED);
-             return retval;
+                                  "Unsupported IN argument type");
+             CMRelease(argname);
+             CMRelease(sb);
+             return NULL;
        }
        CMRelease(argname);
    }
@@ -2269,6 +3554,66 @@ CMPIData invokeMethod(
    sb->ft->appendChars(sb,"</METHODCALL>\n");
    addXmlFooter(sb);
 
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+CMPIData invokeMethod(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	const char * method,
+	CMPIArgs * in,
+	CMPIArgs * out,
+	CMPIStatus * rc)
+/*
+<?xml version="1.0" encoding="utf-8"?>
+<CIM CIMVERSION="2.0" DTDVERSION="2.0">
+  <MESSAGE ID="4711" PROTOCOLVERSION="1.0">
+    <SIMPLEREQ>
+      <METHODCALL NAME="IsAuthorized">
+        <LOCALINSTANCEPATH>
+          <LOCALNAMESPACEPATH>
+            <NAMESPACE NAME="root"/>
+            <NAMESPACE NAME="cimv2"/>
+          </LOCALNAMESPACEPATH>
+          <INSTANCENAME CLASSNAME="CWS_Authorization">
+            <KEYBINDING NAME="Username">
+              <KEYVALUE VALUETYPE="string">schuur</KEYVALUE>
+            </KEYBINDING>
+            <KEYBINDING NAME="Classname">
+              <KEYVALUE VALUETYPE="string">CIM_ComputerSystem</KEYVALUE>
+            </KEYBINDING>
+          </INSTANCENAME>
+        </LOCALINSTANCEPATH>
+        <PARAMVALUE NAME="operation">
+          <VALUE>Query</VALUE>
+        </PARAMVALUE>
+      </METHODCALL>
+    </SIMPLEREQ>
+  </MESSAGE>
+</CIM>
+*/
+{
+   ClientEnc		*cl = (ClientEnc*)mb;
+   CMCIConnection	*con = cl->connection;
+   UtilStringBuffer	*sb;
+   char			*error;
+   ResponseHdr		rh;
+   CMPIString		*cn;
+   CMPIData		retval= { 0, CMPI_nullValue, {0} };
+   int			i;
+
+   SET_DEBUG();
+
+   con->ft->genRequest(cl, (const char *)method, cop, 1);
+
+   sb = invokeMethodRequest(cop, method, in, rc);
+   if (sb == NULL) {
+      retval.state = CMPI_notFound | CMPI_nullValue;
+      return retval;
+   }
+
    error = con->ft->addPayload(con,sb);
 
    if (error || (error = con->ft->getResponse(con, cop))) {
@@ -2276,7 +3621,6 @@ CMPIData invokeMethod(
       free(error);
       retval.state = CMPI_notFound | CMPI_nullValue;
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return retval;
    }
 
@@ -2285,13 +3629,12 @@ CMPIData invokeMethod(
      *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
       retval.state = CMPI_notFound | CMPI_nullValue;
-      END_TIMING(_T_FAILED);
       return retval;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   rh = scanResponse(con, cop);
 
    if (rh.errCode != 0) {
       CMSetStatusWithChars(rc, rh.errCode, rh.description);
@@ -2299,7 +3642,6 @@ CMPIData invokeMethod(
       CMRelease(rh.rvArray);
       if (rh.outArgs) CMRelease(rh.outArgs);
       retval.state = CMPI_notFound | CMPI_nullValue;
-      END_TIMING(_T_FAILED);
       return retval;
    }
 
@@ -2326,12 +3668,49 @@ CMPIData invokeMethod(
    retval=rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL);
    retval.value=native_clone_CMPIValue(rh.rvArray->ft->getSimpleType(rh.rvArray, NULL),&retval.value,NULL);
    CMRelease(rh.rvArray);
-   END_TIMING(_T_GOOD)
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
 
+static UtilStringBuffer *setPropertyRequest(CMPIObjectPath *cop,
+                                            const char *name,
+                                            CMPIValue *value, CMPIType type)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+   CMPIString       *cn;
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", SetProperty, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   /* Add the property */
+   sb->ft->append3Chars(sb,
+        "<IPARAMVALUE NAME=\"PropertyName\">\n<VALUE>",
+        name, "</VALUE>\n</IPARAMVALUE>");
+
+   /* Add the new value */
+   sb->ft->appendChars(sb, "<IPARAMVALUE NAME=\"NewValue\">\n<VALUE>");
+   value2Xml(type, value, sb);
+   sb->ft->appendChars(sb, "</VALUE>\n</IPARAMVALUE>");
+
+   /* Add the objectpath */
+   cn = cop->ft->getClassName(cop,NULL);
+   sb->ft->append3Chars(sb,"<IPARAMVALUE NAME=\"InstanceName\">\n"
+          "<INSTANCENAME CLASSNAME=\"",(char*)cn->hdl,"\">\n");
+   pathToXml(sb, cop);
+   sb->ft->appendChars(sb,"</INSTANCENAME>\n</IPARAMVALUE>\n");
+   CMRelease(cn);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIStatus setProperty(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -2378,44 +3757,16 @@ static CMPIStatus setProperty(
 {
    ClientEnc        *cl = (ClientEnc*)mb;
    CMCIConnection   *con = cl->connection;
-   UtilStringBuffer *sb=UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer *sb;
    char		    *error;
    ResponseHdr      rh;
-   CMPIString	    *cn;
    CMPIStatus	    rc = {CMPI_RC_OK, NULL};
-   char             *cv;
 
-   START_TIMING(SetProperty);
    SET_DEBUG();
 
    con->ft->genRequest(cl, SetProperty, cop, 0);
 
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", SetProperty, "\">");
-
-   addXmlNamespace(sb, cop);
-
-   /* Add the property */
-   sb->ft->append3Chars(sb,
-        "<IPARAMVALUE NAME=\"PropertyName\">\n<VALUE>",
-        name, "</VALUE>\n</IPARAMVALUE>");
-
-   /* Add the new value */
-   sb->ft->append3Chars(sb,
-        "<IPARAMVALUE NAME=\"NewValue\">\n<VALUE>",
-        cv=value2Chars(type,value), "</VALUE>\n</IPARAMVALUE>");
-   if(cv) free(cv);
-
-   /* Add the objectpath */
-   cn = cop->ft->getClassName(cop,NULL);
-   sb->ft->append3Chars(sb,"<IPARAMVALUE NAME=\"InstanceName\">\n"
-          "<INSTANCENAME CLASSNAME=\"",(char*)cn->hdl,"\">\n");
-   pathToXml(sb, cop);
-   sb->ft->appendChars(sb,"</INSTANCENAME>\n</IPARAMVALUE>\n");
-   CMRelease(cn);
-
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   sb = setPropertyRequest(cop, name, value, type);
 
    error = con->ft->addPayload(con,sb);
 
@@ -2423,20 +3774,18 @@ static CMPIStatus setProperty(
       CMSetStatusWithChars(&rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return rc;
    }
 
    if (con->mStatus.rc != CMPI_RC_OK) {
      rc=cloneStatus(con->mStatus);
      CMRelease(sb);
-      END_TIMING(_T_FAILED);
      return rc;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   rh = scanResponse(con, cop);
 
    if (rh.errCode != 0) {
       CMSetStatusWithChars(&rc, rh.errCode, rh.description);
@@ -2444,12 +3793,43 @@ static CMPIStatus setProperty(
    }
    
    CMRelease(rh.rvArray);
-   END_TIMING(_T_GOOD);
    return rc;
 }
 
 /* --------------------------------------------------------------------------*/
 
+static UtilStringBuffer *getPropertyRequest(CMPIObjectPath *cop,
+                                            const char *name)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+   CMPIString       *cn;
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", GetProperty, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   /* Add the property */
+   sb->ft->append3Chars(sb,
+        "<IPARAMVALUE NAME=\"PropertyName\">\n<VALUE>",
+        name, "</VALUE>\n</IPARAMVALUE>");
+
+   /* Add the objectpath */
+   cn = cop->ft->getClassName(cop,NULL);
+   sb->ft->append3Chars(sb,"<IPARAMVALUE NAME=\"InstanceName\">\n"
+          "<INSTANCENAME CLASSNAME=\"",(char*)cn->hdl,"\">\n");
+   pathToXml(sb, cop);
+   sb->ft->appendChars(sb,"</INSTANCENAME>\n</IPARAMVALUE>\n");
+   CMRelease(cn);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
 static CMPIData getProperty(
 	CMCIClient * mb,
 	CMPIObjectPath * cop,
@@ -2492,131 +3872,497 @@ static CMPIData getProperty(
 {
    ClientEnc		*cl = (ClientEnc*)mb;
    CMCIConnection	*con = cl->connection;
-   UtilStringBuffer	*sb=UtilFactory->newStringBuffer(2048);
+   UtilStringBuffer	*sb;
    char			*error;
    ResponseHdr		rh;
-   CMPIString		*cn;
    CMPIData		retval= { 0, CMPI_nullValue, {0} };
 
-   START_TIMING(GetProperty);
    SET_DEBUG();
 
-   con->ft->genRequest(cl, GetProperty, cop, 0);
-
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", GetProperty, "\">");
-
-   addXmlNamespace(sb, cop);
-
-   /* Add the property */
-   sb->ft->append3Chars(sb,
-        "<IPARAMVALUE NAME=\"PropertyName\">\n<VALUE>",
-        name, "</VALUE>\n</IPARAMVALUE>");
-
-   /* Add the objectpath */
-   cn = cop->ft->getClassName(cop,NULL);
-   sb->ft->append3Chars(sb,"<IPARAMVALUE NAME=\"InstanceName\">\n"
-          "<INSTANCENAME CLASSNAME=\"",(char*)cn->hdl,"\">\n");
-   pathToXml(sb, cop);
-   sb->ft->appendChars(sb,"</INSTANCENAME>\n</IPARAMVALUE>\n");
-   CMRelease(cn);
+   con->ft->genRequest(cl, GetProperty, cop, 0);
+
+   sb = getPropertyRequest(cop, name);
+
+   error = con->ft->addPayload(con,sb);
+
+   if (error || (error = con->ft->getResponse(con, cop))) {
+      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+      free(error);
+      retval.state = CMPI_notFound | CMPI_nullValue;
+      CMRelease(sb);
+      return retval;
+   }
+
+   if (con->mStatus.rc != CMPI_RC_OK) {
+      if (rc)
+     *rc=cloneStatus(con->mStatus);
+      CMRelease(sb);
+      retval.state = CMPI_notFound | CMPI_nullValue;
+      return retval;
+   }
+
+   CMRelease(sb);
+
+   rh = scanResponse(con, cop);
+
+   if (rh.errCode != 0) {
+      CMSetStatusWithChars(rc, rh.errCode, rh.description);
+      free(rh.description);
+      CMRelease(rh.rvArray);
+      retval.state = CMPI_notFound | CMPI_nullValue;
+      return retval;
+   }
+
+   /* Set good return status and return */
+#if DEBUG
+   if (do_debug)
+       printf ("\treturn type %d\n",
+	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL));
+#endif
+
+   CMSetStatus(rc, CMPI_RC_OK);
+   retval=rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL);
+   retval.value=native_clone_CMPIValue(rh.rvArray->ft->getSimpleType(rh.rvArray, NULL),&retval.value,NULL);
+   CMRelease(rh.rvArray);
+   return retval;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static UtilStringBuffer *getClassRequest(CMPIObjectPath *cop, CMPIFlags flags,
+                                         char **properties)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+
+   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", GetClass, "\">");
+
+   addXmlNamespace(sb, cop);
+
+   emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
+   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
+   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
+
+   if (properties != NULL)
+	addXmlPropertyListParam(sb, properties);
+
+   addXmlClassnameParam(sb, cop);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+/* class cache, see ClassCache */
+
+#define CLASS_CACHE_FLAGS (CMPI_FLAG_LocalOnly | CMPI_FLAG_IncludeQualifiers | \
+			   CMPI_FLAG_IncludeClassOrigin)
+
+static void appendLower(char **p, const char *s)
+{
+   while (*s)
+      *(*p)++ = tolower(*s++);
+}
+
+/* "namespace\nclassname\nflags(property,...)\npool key", names lower case */
+static char *classCacheKey(CMCIConnection *con, const char *ns, const char *cn,
+			   CMPIFlags flags, char **properties)
+{
+   size_t  len;
+   char  **pl, *key, *p;
+
+   if (ns == NULL) ns = "";
+   len = strlen(ns) + strlen(cn) + strlen(con->mPoolKey) + 8;
+   if (properties)
+      for (pl = properties; *pl; pl++)
+	 len += strlen(*pl) + 1;
+
+   p = key = (char*)malloc(len);
+   appendLower(&p, ns);
+   *p++ = '\n';
+   appendLower(&p, cn);
+   *p++ = '\n';
+   *p++ = '0' + (flags & CLASS_CACHE_FLAGS);
+   if (properties) {
+      *p++ = '(';
+      for (pl = properties; *pl; pl++) {
+	 if (pl != properties) *p++ = ',';
+	 appendLower(&p, *pl);
+      }
+      *p++ = ')';
+   }
+   *p++ = '\n';
+   strcpy(p, con->mPoolKey);
+   return key;
+}
+
+static unsigned int classCacheHash(const char *key)
+{
+   unsigned int h = 2166136261u;
+
+   for (; *key; key++)
+      h = (h ^ (unsigned char)*key) * 16777619u;
+   return h;
+}
+
+/* removes e from the LRU list and its bucket, caller holds the lock */
+static void unlinkClassEntry(ClassCache *cache, ClassCacheEntry *e)
+{
+   ClassCacheEntry **b;
+
+   for (b = &cache->buckets[e->hash & cache->mask]; *b != e; b = &(*b)->chain)
+      ;
+   *b = e->chain;
+   if (e->prev) e->prev->next = e->next;
+   else cache->first = e->next;
+   if (e->next) e->next->prev = e->prev;
+   else cache->last = e->prev;
+   cache->count--;
+}
+
+static void dropClassEntry(ClassCache *cache, ClassCacheEntry *e)
+{
+   unlinkClassEntry(cache, e);
+   CMRelease(e->cls);
+   free(e);
+}
+
+/* evicts the least recently used entries beyond maxEntries */
+static void trimClassCache(ClassCache *cache)
+{
+   while (cache->count > cache->maxEntries) {
+      dropClassEntry(cache, cache->last);
+      cache->evicted++;
+   }
+}
+
+/* returns a reference to the cached class, NULL if there is none */
+static CMPIConstClass *lookupClass(ClassCache *cache, const char *key)
+{
+   unsigned int     hash = classCacheHash(key);
+   ClassCacheEntry *e = NULL;
+   CMPIConstClass  *cls = NULL;
+
+   pthread_mutex_lock(&cache->lock);
+   if (cache->buckets) {
+      for (e = cache->buckets[hash & cache->mask]; e; e = e->chain)
+	 if (e->hash == hash && strcmp(e->key, key) == 0)
+	    break;
+   }
+   if (e && e->expires && e->expires <= time(NULL)) {
+      dropClassEntry(cache, e);
+      cache->evicted++;
+      e = NULL;
+   }
+   if (e) {
+      if (e != cache->first) {
+	 /* move to the front */
+	 e->prev->next = e->next;
+	 if (e->next) e->next->prev = e->prev;
+	 else cache->last = e->prev;
+	 e->prev = NULL;
+	 e->next = cache->first;
+	 cache->first->prev = e;
+	 cache->first = e;
+      }
+      cls = native_ref_CMPIConstClass(e->cls);
+      cache->hits++;
+   } else
+      cache->misses++;
+   pthread_mutex_unlock(&cache->lock);
+   return cls;
+}
+
+/* adds a reference to cls under key, replacing an entry already there */
+static void cacheClass(ClassCache *cache, const char *key, CMPIConstClass *cls)
+{
+   unsigned int     hash = classCacheHash(key), mask, i;
+   size_t           len = strlen(key) + 1;
+   ClassCacheEntry *e, *m, *next, **buckets;
+
+   e = (ClassCacheEntry*)malloc(sizeof(ClassCacheEntry) + 2 * len);
+   e->hash = hash;
+   e->cls = native_ref_CMPIConstClass(cls);
+   e->key = memcpy((char*)(e + 1), key, len);
+   /* split a copy of the key at its first two newlines */
+   e->nameSpace = memcpy(e->key + len, key, len);
+   e->className = strchr(e->nameSpace, '\n');
+   *e->className++ = 0;
+   *strchr(e->className, '\n') = 0;
+   e->prev = NULL;
+
+   pthread_mutex_lock(&cache->lock);
+   e->expires = cache->ttl ? time(NULL) + cache->ttl : 0;
+   if (cache->buckets == NULL) {
+      cache->mask = 63;
+      cache->buckets = (ClassCacheEntry**)calloc(cache->mask + 1,
+						 sizeof(ClassCacheEntry*));
+   }
+   for (m = cache->buckets[hash & cache->mask]; m; m = m->chain)
+      if (m->hash == hash && strcmp(m->key, key) == 0) {
+	 dropClassEntry(cache, m);
+	 break;
+      }
+   if (cache->count > cache->mask) {
+      /* keep the chains short, rehash into twice the buckets */
+      mask = 2 * cache->mask + 1;
+      buckets = (ClassCacheEntry**)calloc(mask + 1, sizeof(ClassCacheEntry*));
+      for (i = 0; i <= cache->mask; i++)
+	 for (m = cache->buckets[i]; m; m = next) {
+	    next = m->chain;
+	    m->chain = buckets[m->hash & mask];
+	    buckets[m->hash & mask] = m;
+	 }
+      free(cache->buckets);
+      cache->buckets = buckets;
+      cache->mask = mask;
+   }
+   e->chain = cache->buckets[hash & cache->mask];
+   cache->buckets[hash & cache->mask] = e;
+   e->next = cache->first;
+   if (cache->first) cache->first->prev = e;
+   else cache->last = e;
+   cache->first = e;
+   cache->count++;
+   trimClassCache(cache);
+   pthread_mutex_unlock(&cache->lock);
+}
+
+/* drops the classes of ns and cn, NULL for all namespaces/classes */
+static void flushClasses(ClassCache *cache, const char *ns, const char *cn)
+{
+   ClassCacheEntry *e, *next;
+
+   pthread_mutex_lock(&cache->lock);
+   for (e = cache->first; e; e = next) {
+      next = e->next;
+      if ((ns == NULL || strcasecmp(e->nameSpace, ns) == 0) &&
+	  (cn == NULL || strcasecmp(e->className, cn) == 0))
+	 dropClassEntry(cache, e);
+   }
+   pthread_mutex_unlock(&cache->lock);
+}
+
+static CMPIConstClass * getClass(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	CMPIFlags flags,
+	char ** properties,
+	CMPIStatus * rc)
+{
+   CMPIConstClass *ccl, *ccc;
+   ClientEnc *cl=(ClientEnc*)mb;
+   CMCIConnection *con=cl->connection;
+   ClassCache *cache=&((XmlEnv*)cl->env)->classCache;
+   UtilStringBuffer *sb;
+   CMPIString *cn;
+   char *error, *key = NULL;
+
+   SET_DEBUG();
+
+   if (cache->maxEntries > 0) {
+      cn = CMGetClassName(cop, NULL);
+      key = classCacheKey(con, getNameSpaceChars(cop), CMGetCharPtr(cn),
+			  flags, properties);
+      CMRelease(cn);
+      if ((ccc = lookupClass(cache, key))) {
+	 free(key);
+	 CMSetStatus(rc, CMPI_RC_OK);
+	 return ccc;
+      }
+   }
+
+   con->ft->genRequest(cl, GetClass, cop, 0);
+
+   sb = getClassRequest(cop, flags, properties);
+
+   error = con->ft->addPayload(con,sb);
+
+   if (error || (error=con->ft->getResponse(con,cop))) {
+      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+      free(error);
+      free(key);
+      CMRelease(sb);
+      return NULL;
+   }
+
+   if (con->mStatus.rc != CMPI_RC_OK) {
+      if (rc)
+     *rc=cloneStatus(con->mStatus);
+      free(key);
+      CMRelease(sb);
+      return NULL;
+   }
+
+   CMRelease(sb);
+
+   ResponseHdr rh=scanResponse(con, cop);
+
+   if (rh.errCode!=0) {
+      CMSetStatusWithChars(rc,rh.errCode,rh.description);
+      free(rh.description);
+      free(key);
+      CMRelease(rh.rvArray);
+      return NULL;
+   }
+
+#if DEBUG
+   if (do_debug)
+       printf ("\treturn enumeration array type %d expected CMPI_class %d\n",
+	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_class);
+#endif
+
+   CMSetStatus(rc, CMPI_RC_OK);
+   ccl = rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL).value.cls;
+   ccc = native_ref_CMPIConstClass(ccl);
+   CMRelease(rh.rvArray);
+   if (key) {
+      cacheClass(cache, key, ccc);
+      free(key);
+   }
+   return ccc;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static UtilStringBuffer *enumClassNamesRequest(CMPIObjectPath *cop,
+                                               CMPIFlags flags)
+{
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
+
+   addXmlHeader(sb);
+   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", EnumerateClassNames, "\">");
+
+   addXmlNamespace(sb, cop);
+   emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
+   addXmlClassnameParam(sb, cop);
+
+   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
+   addXmlFooter(sb);
+
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+/* finished & working */
+static CMPIEnumeration* enumClassNames(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	CMPIFlags flags,
+	CMPIStatus * rc)
+{
+   ClientEnc *cl=(ClientEnc*)mb;
+   CMCIConnection *con=cl->connection;
+   UtilStringBuffer *sb;
+   char *error;
+   CMPIEnumeration   *retval;
+   ResponseHdr       rh;
+
+   SET_DEBUG();
+
+   con->ft->genRequest(cl, EnumerateClassNames, cop, 0);
 
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   /* Construct the CIM-XML request */
+   sb = enumClassNamesRequest(cop, flags);
 
    error = con->ft->addPayload(con,sb);
 
-   if (error || (error = con->ft->getResponse(con, cop))) {
+   if (error || (error = con->ft->getResponse(con,cop))) {
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
-      retval.state = CMPI_notFound | CMPI_nullValue;
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return retval;
+      return NULL;
    }
 
    if (con->mStatus.rc != CMPI_RC_OK) {
       if (rc)
      *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      retval.state = CMPI_notFound | CMPI_nullValue;
-      END_TIMING(_T_FAILED);
-      return retval;
+      return NULL;
    }
 
    CMRelease(sb);
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   rh=scanResponse(con, cop);
 
-   if (rh.errCode != 0) {
-      CMSetStatusWithChars(rc, rh.errCode, rh.description);
+   if (rh.errCode!=0) {
+      CMSetStatusWithChars(rc,rh.errCode,rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      retval.state = CMPI_notFound | CMPI_nullValue;
-      END_TIMING(_T_FAILED);
-      return retval;
+      return NULL;
    }
 
-   /* Set good return status and return */
 #if DEBUG
    if (do_debug)
-       printf ("\treturn type %d\n",
-	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL));
+       printf ("\treturn enumeration array type %d expected CMPI_ref %d\n",
+	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_ref);
 #endif
 
-   CMSetStatus(rc, CMPI_RC_OK);
-   retval=rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL);
-   retval.value=native_clone_CMPIValue(rh.rvArray->ft->getSimpleType(rh.rvArray, NULL),&retval.value,NULL);
-   CMRelease(rh.rvArray);
-   END_TIMING(_T_GOOD);
+   CMSetStatus(rc,CMPI_RC_OK);
+   retval = newCMPIEnumeration(rh.rvArray, NULL);
    return retval;
 }
 
 /* --------------------------------------------------------------------------*/
 
-static CMPIConstClass * getClass(
-	CMCIClient * mb,
-	CMPIObjectPath * cop,
-	CMPIFlags flags,
-	char ** properties,
-	CMPIStatus * rc)
+static UtilStringBuffer *enumClassesRequest(CMPIObjectPath *cop,
+                                            CMPIFlags flags)
 {
-   CMPIConstClass *ccl, *ccc;
-   ClientEnc *cl=(ClientEnc*)mb;
-   CMCIConnection *con=cl->connection;
-   UtilStringBuffer *sb=UtilFactory->newStringBuffer(2048);
-   char *error;
-
-   START_TIMING(GetClass);
-   SET_DEBUG();
-
-   con->ft->genRequest(cl, GetClass, cop, 0);
+   UtilStringBuffer *sb = UtilFactory->newStringBuffer(2048);
 
    addXmlHeader(sb);
-
-   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", GetClass, "\">");
+   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", EnumerateClasses, "\">");
 
    addXmlNamespace(sb, cop);
-
+   emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
    emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
-   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
    emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
-
-   if (properties != NULL)
-	addXmlPropertyListParam(sb, properties);
-
+   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
    addXmlClassnameParam(sb, cop);
 
    sb->ft->appendChars(sb,"</IMETHODCALL>\n");
    addXmlFooter(sb);
 
+   return sb;
+}
+
+/* --------------------------------------------------------------------------*/
+
+static CMPIEnumeration * enumClasses(
+	CMCIClient * mb,
+	CMPIObjectPath * cop,
+	CMPIFlags flags,
+	CMPIStatus * rc)
+{
+   ClientEnc	     *cl  = (ClientEnc *)mb;
+   CMCIConnection   *con = cl->connection;
+   UtilStringBuffer *sb;
+   char             *error;
+   CMPIEnumeration  *retval;
+   ResponseHdr	     rh;
+   ClassCache       *cache = &((XmlEnv*)cl->env)->classCache;
+   CMPIConstClass   *ccl;
+   CMPICount         i;
+   char             *key;
+
+   SET_DEBUG();
+
+   con->ft->genRequest(cl, EnumerateClasses, cop, 0);
+
+   /* Construct the CIM-XML request */
+   sb = enumClassesRequest(cop, flags);
+
    error = con->ft->addPayload(con,sb);
 
-   if (error || (error=con->ft->getResponse(con,cop))) {
+   if (error || (error = con->ft->getResponse(con, cop))) {
       CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
       free(error);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -2624,19 +4370,17 @@ static CMPIConstClass * getClass(
       if (rc)
      *rc=cloneStatus(con->mStatus);
       CMRelease(sb);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
    CMRelease(sb);
 
-   ResponseHdr rh=scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   rh = scanResponse(con, cop);
 
-   if (rh.errCode!=0) {
-      CMSetStatusWithChars(rc,rh.errCode,rh.description);
+   if (rh.errCode != 0) {
+      CMSetStatusWithChars(rc, rh.errCode, rh.description);
       free(rh.description);
       CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
       return NULL;
    }
 
@@ -2646,187 +4390,920 @@ static CMPIConstClass * getClass(
 	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_class);
 #endif
 
+   if (cache->maxEntries > 0) {
+      /* each class as getClass() would return it with these flags */
+      for (i = 0; i < CMGetArrayCount(rh.rvArray, NULL); i++) {
+	 ccl = CMGetArrayElementAt(rh.rvArray, i, NULL).value.cls;
+	 key = classCacheKey(con, getNameSpaceChars(cop),
+			     ((struct native_constClass*)ccl)->classname,
+			     flags, NULL);
+	 cacheClass(cache, key, ccl);
+	 free(key);
+      }
+   }
+
    CMSetStatus(rc, CMPI_RC_OK);
-   ccl = rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL).value.cls;
-   ccc = CMClone(ccl,NULL);
-   CMRelease(rh.rvArray);
-   END_TIMING(_T_GOOD);
-   return ccc;
+   retval = newCMPIEnumeration(rh.rvArray, NULL);
+
+   return retval;
+}
+
+
+static CMCIClientFT clientFt = {
+   NATIVE_FT_VERSION,
+   releaseClient,
+   cloneClient,
+   getClass,
+   enumClassNames,
+   enumClasses,
+   getInstance,
+   createInstance,
+   setInstance,
+   deleteInstance,
+   execQuery,
+   enumInstanceNames,
+   enumInstances,
+   associators,
+   associatorNames,
+   references,
+   referenceNames,
+   invokeMethod,
+   setProperty,
+   getProperty,
+   openEnumInstances,
+   openEnumInstanceNames,
+   enumInstancesTable
+};
+
+
+/* --------------------------------------------------------------------------*/
+
+/*
+ * Asynchronous operations: each operation gets a connection of its own,
+ * whose curl handle, leased from the pool like for synchronous requests,
+ * is added to the multi handle of the CIMCAsync object. Requests are built
+ * and responses parsed by the same functions the synchronous operations
+ * use; the callbacks are called from perform() and wait().
+ */
+
+/* what is made of the response, also used for batched operations */
+typedef enum {
+   ASYNC_NONE,                 /* status only */
+   ASYNC_ENUMERATION,
+   ASYNC_CLASS,
+   ASYNC_VALUE,                /* first return value */
+   ASYNC_METHOD                /* return value and output arguments */
+} AsyncResult;
+
+struct _CIMCAsyncOp {
+   struct _CIMCAsyncOp *next;
+   struct _CIMCAsyncOp *prev;
+   CMCIConnection      *con;
+   UtilStringBuffer    *request;   /* posted from here, keep until done */
+   CMPIObjectPath      *cop;
+   CMPIArgs            *out;
+   AsyncResult          result;
+   CIMCAsyncCallback    cb;
+   void                *data;
+   CURLcode             rv;
+   int                  done;      /* transfer finished, callback pending */
+   int                  canceled;
+};
+
+typedef struct _AsyncEnc {
+   CIMCAsync            enc;
+   CURLM               *multi;
+   CIMCAsyncOp         *ops;       /* transfers in progress */
+   int                  numOps;    /* including callbacks pending */
+} AsyncEnc;
+
+static void releaseAsyncOp(CIMCAsyncOp *op)
+{
+   if (op->con) CMRelease(op->con);
+   if (op->request) CMRelease(op->request);
+   if (op->cop) CMRelease(op->cop);
+   free(op);
+}
+
+static void unlinkAsyncOp(AsyncEnc *ae, CIMCAsyncOp *op)
+{
+   if (op->prev) op->prev->next = op->next;
+   else ae->ops = op->next;
+   if (op->next) op->next->prev = op->prev;
+   op->next = op->prev = NULL;
+   curl_multi_remove_handle(ae->multi, op->con->mHandle);
+}
+
+static CMPIData asyncResult(AsyncResult result, CMPIArgs *out, ResponseHdr *rh)
+{
+   CMPIData    data = { CMPI_null, CMPI_nullValue, {0} };
+   CMPIString *name;
+   int         i, n;
+
+   switch (result) {
+   case ASYNC_ENUMERATION:
+      data.type = CMPI_enumeration;
+      data.state = CMPI_goodValue;
+      data.value.Enum = newCMPIEnumeration(rh->rvArray, NULL);
+      return data;
+   case ASYNC_METHOD:
+      if (rh->outArgs && out) {
+	 n = rh->outArgs->ft->getArgCount(rh->outArgs, NULL);
+	 for (i = 0; i < n; i++) {
+	    data = rh->outArgs->ft->getArgAt(rh->outArgs, i, &name, NULL);
+	    out->ft->addArg(out, CMGetCharPtr(name), &data.value, data.type);
+	    CMRelease(name);
+	 }
+	 data.type = CMPI_null;
+	 data.state = CMPI_nullValue;
+      }
+      /* fall through */
+   case ASYNC_VALUE:
+      if (CMGetArrayCount(rh->rvArray, NULL) > 0) {
+	 data = rh->rvArray->ft->getElementAt(rh->rvArray, 0, NULL);
+	 data.value = native_clone_CMPIValue(rh->rvArray->ft->getSimpleType(rh->rvArray, NULL),
+					     &data.value, NULL);
+      }
+      break;
+   case ASYNC_CLASS:
+      if (CMGetArrayCount(rh->rvArray, NULL) > 0) {
+	 data = rh->rvArray->ft->getElementAt(rh->rvArray, 0, NULL);
+	 data.value.cls = native_ref_CMPIConstClass(data.value.cls);
+      }
+      break;
+   case ASYNC_NONE:
+      break;
+   }
+   if (rh->outArgs) CMRelease(rh->outArgs);
+   CMRelease(rh->rvArray);
+   return data;
+}
+
+static void completeAsyncOp(CIMCAsyncOp *op)
+{
+   CMCIConnection *con = op->con;
+   CMPIStatus      st = {CMPI_RC_OK, NULL};
+   CMPIData        result = { CMPI_null, CMPI_nullValue, {0} };
+   char           *error = NULL;
+   ResponseHdr     rh;
+
+   if (op->rv)
+      error = transferError(con, op->rv);
+   else if (con->mResponse->ft->getSize(con->mResponse) == 0)
+      error = strdup("No data received from server");
+   countTransfer(con);
+   returnHandle(con);
+
+   if (error) {
+      st.rc = CMPI_RC_ERR_FAILED;
+      st.msg = newCMPIString(error, NULL);
+      free(error);
+      countOperation(con, 1, 0, 0);
+   } else if (con->mStatus.rc != CMPI_RC_OK) {
+      st = cloneStatus(con->mStatus);
+      countOperation(con, 1, 0, 0);
+   } else {
+      rh = scanResponse(con, op->cop);
+      if (rh.errCode != 0) {
+	 st.rc = rh.errCode;
+	 st.msg = newCMPIString(rh.description, NULL);
+	 free(rh.description);
+	 CMRelease(rh.rvArray);
+	 if (rh.outArgs) CMRelease(rh.outArgs);
+      } else {
+	 result = asyncResult(op->result, op->out, &rh);
+      }
+   }
+
+   op->cb(op, op->data, (CIMCStatus*)&st, (CIMCData*)&result);
+   if (st.msg) CMRelease(st.msg);
+}
+
+static CIMCAsyncOp *submitAsyncOp(CIMCAsync *as, CIMCClient *mb, const char *method,
+				  CIMCObjectPath *cop, int classWithKeys,
+				  AsyncResult result, CIMCArgs *out,
+				  UtilStringBuffer *sb, CIMCAsyncCallback cb,
+				  void *data, CIMCStatus *rc)
+{
+   AsyncEnc    *ae = (AsyncEnc*)as;
+   ClientEnc   *cl = (ClientEnc*)mb;
+   CIMCAsyncOp *op;
+   char        *error = NULL;
+
+   /* rc is set already if the request could not be built */
+   if (sb == NULL) return NULL;
+
+   op = (CIMCAsyncOp*)calloc(1, sizeof(CIMCAsyncOp));
+   op->con = initConnection(&cl->data);
+   op->con->mPool = cl->connection->mPool;
+   op->con->mPoolKey = strdup(cl->connection->mPoolKey);
+   op->request = sb;
+   op->cop = CMClone((CMPIObjectPath*)cop, NULL);
+   op->out = (CMPIArgs*)out;
+   op->result = result;
+   op->cb = cb;
+   op->data = data;
+
+   if (prepareRequest(cl, op->con, method, (CMPIObjectPath*)cop, classWithKeys))
+      error = strdup("Unable to initialize curl interface.");
+   else
+      error = op->con->ft->addPayload(op->con, sb);
+   if (error == NULL) {
+      curl_easy_setopt(op->con->mHandle, CURLOPT_PRIVATE, op);
+      if (curl_multi_add_handle(ae->multi, op->con->mHandle) != CURLM_OK)
+	 error = strdup("Unable to initialize curl multi interface.");
+   }
+   if (error) {
+      CMSetStatusWithChars((CMPIStatus*)rc, CMPI_RC_ERR_FAILED, error);
+      free(error);
+      releaseAsyncOp(op);
+      return NULL;
+   }
+
+   op->next = ae->ops;
+   if (ae->ops) ae->ops->prev = op;
+   ae->ops = op;
+   ae->numOps++;
+
+   CMSetStatus(rc, CIMC_RC_OK);
+   return op;
+}
+
+static int performAsync(CIMCAsync *as, CIMCStatus *rc)
+{
+   AsyncEnc    *ae = (AsyncEnc*)as;
+   CIMCAsyncOp *op, *done = NULL, **tail = &done;
+   CURLMsg     *msg;
+   int          running, left;
+   char        *priv;
+
+   while (curl_multi_perform(ae->multi, &running) == CURLM_CALL_MULTI_PERFORM);
+
+   /* collect first, callbacks may submit or cancel operations */
+   while ((msg = curl_multi_info_read(ae->multi, &left))) {
+      if (msg->msg != CURLMSG_DONE)
+	 continue;
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &priv);
+      op = (CIMCAsyncOp*)priv;
+      op->rv = msg->data.result;
+      op->done = 1;
+      unlinkAsyncOp(ae, op);
+      *tail = op;
+      tail = &op->next;
+   }
+
+   while ((op = done) != NULL) {
+      done = op->next;
+      if (!op->canceled)
+	 completeAsyncOp(op);
+      ae->numOps--;
+      releaseAsyncOp(op);
+   }
+
+   CMSetStatus(rc, CIMC_RC_OK);
+   return ae->numOps;
+}
+
+static int waitAsync(CIMCAsync *as, int timeout, CIMCStatus *rc)
+{
+   AsyncEnc *ae = (AsyncEnc*)as;
+
+   if (ae->ops)
+      waitMulti(ae->multi, timeout);
+   return performAsync(as, rc);
+}
+
+static CIMCStatus cancelAsync(CIMCAsync *as, CIMCAsyncOp *op)
+{
+   AsyncEnc  *ae = (AsyncEnc*)as;
+   CIMCStatus rc = {CIMC_RC_OK, NULL};
+
+   if (op->done) {
+      /* called from a callback, released by performAsync() */
+      op->canceled = 1;
+      return rc;
+   }
+   unlinkAsyncOp(ae, op);
+   /* the connection is in the middle of a request, don't reuse it */
+   curl_easy_cleanup(op->con->mHandle);
+   op->con->mHandle = NULL;
+   ae->numOps--;
+   releaseAsyncOp(op);
+   return rc;
+}
+
+static CIMCStatus releaseAsync(CIMCAsync *as)
+{
+   AsyncEnc  *ae = (AsyncEnc*)as;
+   CIMCStatus rc = {CIMC_RC_OK, NULL};
+
+   while (ae->ops)
+      cancelAsync(as, ae->ops);
+   curl_multi_cleanup(ae->multi);
+   free(ae);
+   return rc;
+}
+
+static CIMCAsyncOp *asyncGetClass(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				  CIMCFlags flags, char **properties,
+				  CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, GetClass, cop, 0, ASYNC_CLASS, NULL,
+			getClassRequest((CMPIObjectPath*)cop, flags, properties),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncEnumClassNames(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+					CIMCFlags flags,
+					CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, EnumerateClassNames, cop, 0, ASYNC_ENUMERATION, NULL,
+			enumClassNamesRequest((CMPIObjectPath*)cop, flags),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncEnumClasses(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				     CIMCFlags flags,
+				     CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, EnumerateClasses, cop, 0, ASYNC_ENUMERATION, NULL,
+			enumClassesRequest((CMPIObjectPath*)cop, flags),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncGetInstance(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				     CIMCFlags flags, char **properties,
+				     CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, GetInstance, cop, 0, ASYNC_VALUE, NULL,
+			getInstanceRequest((CMPIObjectPath*)cop, flags, properties),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncCreateInstance(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+					CIMCInstance *inst,
+					CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, CreateInstance, cop, 0, ASYNC_VALUE, NULL,
+			createInstanceRequest((CMPIObjectPath*)cop, (CMPIInstance*)inst),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncSetInstance(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				     CIMCInstance *inst, CIMCFlags flags, char **properties,
+				     CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, ModifyInstance, cop, 0, ASYNC_NONE, NULL,
+			setInstanceRequest((CMPIObjectPath*)cop, (CMPIInstance*)inst,
+					   flags, properties),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncDeleteInstance(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+					CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, DeleteInstance, cop, 0, ASYNC_NONE, NULL,
+			deleteInstanceRequest((CMPIObjectPath*)cop),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncExecQuery(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				   const char *query, const char *lang,
+				   CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, ExecQuery, cop, 0, ASYNC_ENUMERATION, NULL,
+			execQueryRequest((CMPIObjectPath*)cop, query, lang),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncEnumInstanceNames(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+					   CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, EnumerateInstanceNames, cop, 0, ASYNC_ENUMERATION, NULL,
+			enumInstanceNamesRequest((CMPIObjectPath*)cop),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncEnumInstances(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				       CIMCFlags flags, char **properties,
+				       CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, EnumerateInstances, cop, 0, ASYNC_ENUMERATION, NULL,
+			enumInstancesRequest((CMPIObjectPath*)cop, flags, properties),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncAssociators(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				     const char *assocClass, const char *resultClass,
+				     const char *role, const char *resultRole,
+				     CIMCFlags flags, char **properties,
+				     CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, Associators, cop, 0, ASYNC_ENUMERATION, NULL,
+			associatorsRequest((CMPIObjectPath*)cop, assocClass, resultClass,
+					   role, resultRole, flags, properties),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncAssociatorNames(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+					 const char *assocClass, const char *resultClass,
+					 const char *role, const char *resultRole,
+					 CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, AssociatorNames, cop, 0, ASYNC_ENUMERATION, NULL,
+			associatorNamesRequest((CMPIObjectPath*)cop, assocClass, resultClass,
+					       role, resultRole),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncReferences(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				    const char *resultClass, const char *role,
+				    CIMCFlags flags, char **properties,
+				    CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, References, cop, 0, ASYNC_ENUMERATION, NULL,
+			referencesRequest((CMPIObjectPath*)cop, resultClass, role,
+					  flags, properties),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncReferenceNames(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+					const char *resultClass, const char *role,
+					CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, ReferenceNames, cop, 0, ASYNC_ENUMERATION, NULL,
+			referenceNamesRequest((CMPIObjectPath*)cop, resultClass, role),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncInvokeMethod(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				      const char *method, CIMCArgs *in, CIMCArgs *out,
+				      CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, method, cop, 1, ASYNC_METHOD, out,
+			invokeMethodRequest((CMPIObjectPath*)cop, method, (CMPIArgs*)in,
+					    (CMPIStatus*)rc),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncSetProperty(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				     const char *name, CIMCValue *value, CIMCType type,
+				     CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, SetProperty, cop, 0, ASYNC_NONE, NULL,
+			setPropertyRequest((CMPIObjectPath*)cop, name, (CMPIValue*)value,
+					   type),
+			cb, data, rc);
+}
+
+static CIMCAsyncOp *asyncGetProperty(CIMCAsync *as, CIMCClient *cl, CIMCObjectPath *cop,
+				     const char *name,
+				     CIMCAsyncCallback cb, void *data, CIMCStatus *rc)
+{
+   return submitAsyncOp(as, cl, GetProperty, cop, 0, ASYNC_VALUE, NULL,
+			getPropertyRequest((CMPIObjectPath*)cop, name),
+			cb, data, rc);
 }
 
-/* --------------------------------------------------------------------------*/
+static CIMCAsyncFT asyncFt = {
+   NATIVE_FT_VERSION,
+   releaseAsync,
+   performAsync,
+   waitAsync,
+   cancelAsync,
+   asyncGetClass,
+   asyncEnumClassNames,
+   asyncEnumClasses,
+   asyncGetInstance,
+   asyncCreateInstance,
+   asyncSetInstance,
+   asyncDeleteInstance,
+   asyncExecQuery,
+   asyncEnumInstanceNames,
+   asyncEnumInstances,
+   asyncAssociators,
+   asyncAssociatorNames,
+   asyncReferences,
+   asyncReferenceNames,
+   asyncInvokeMethod,
+   asyncSetProperty,
+   asyncGetProperty
+};
+
+/*
+ * Batched operations: the requests of the operations are built by the
+ * functions the synchronous operations use and their SIMPLEREQ elements
+ * are sent in one MULTIREQ over the connection of the client. The
+ * SIMPLERSP elements of the MULTIRSP are in the order of the requests.
+ */
+
+typedef struct _BatchOp {
+   char                *method;
+   CMPIObjectPath      *cop;
+   int                  classWithKeys;
+   AsyncResult          result;
+   CMPIArgs            *out;
+   UtilStringBuffer    *request;
+   CMPIStatus           st;
+   CMPIData             data;     /* result, owned by the batch */
+} BatchOp;
+
+typedef struct _BatchEnc {
+   CIMCBatch            enc;
+   ClientEnc           *client;
+   BatchOp             *ops;
+   int                  numOps;
+   int                  maxOps;
+   int                  numExecuted;
+} BatchEnc;
+
+static void setBatchResult(BatchOp *op, ResponseHdr *rh)
+{
+   if (rh->errCode != 0) {
+      CMSetStatusWithChars(&op->st, rh->errCode, rh->description);
+      free(rh->description);
+      CMRelease(rh->rvArray);
+      if (rh->outArgs) CMRelease(rh->outArgs);
+   } else {
+      CMSetStatus(&op->st, CMPI_RC_OK);
+      op->data = asyncResult(op->result, op->out, rh);
+   }
+}
 
-/* finished & working */
-static CMPIEnumeration* enumClassNames(
-	CMCIClient * mb,
-	CMPIObjectPath * cop,
-	CMPIFlags flags,
-	CMPIStatus * rc)
+/* fails ops first to last, taking the status from error or con */
+static void failBatchOps(BatchOp *first, BatchOp *last, CMCIConnection *con,
+			 const char *error)
 {
-   ClientEnc *cl=(ClientEnc*)mb;
-   CMCIConnection *con=cl->connection;
-   UtilStringBuffer *sb=UtilFactory->newStringBuffer(2048);
-   char *error;
-   CMPIEnumeration   *retval;
-   ResponseHdr       rh;
+   BatchOp *op;
 
-   START_TIMING(EnumerateClassNames);
-   SET_DEBUG();
+   for (op = first; op < last; op++) {
+      if (error) {
+	 CMSetStatusWithChars(&op->st, CMPI_RC_ERR_FAILED, error);
+      } else
+	 op->st = cloneStatus(con->mStatus);
+   }
+}
 
-   con->ft->genRequest(cl, EnumerateClassNames, cop, 0);
+/* the fallback for CIMOMs without multiple request support */
+static void executeBatchOp(ClientEnc *cl, BatchOp *op)
+{
+   CMCIConnection *con = cl->connection;
+   char           *error;
+   ResponseHdr     rh;
 
-   /* Construct the CIM-XML request */
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb,"<IMETHODCALL NAME=\"", EnumerateClassNames, "\">");
+   if (con->ft->genRequest(cl, op->method, op->cop, op->classWithKeys))
+      error = strdup("Unable to initialize curl interface.");
+   else
+      error = con->ft->addPayload(con, op->request);
+   if (error || (error = con->ft->getResponse(con, op->cop))) {
+      failBatchOps(op, op + 1, con, error);
+      free(error);
+   } else if (con->mStatus.rc != CMPI_RC_OK) {
+      failBatchOps(op, op + 1, con, NULL);
+   } else {
+      rh = scanResponse(con, op->cop);
+      setBatchResult(op, &rh);
+   }
+}
 
-   addXmlNamespace(sb, cop);
-   emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
-   addXmlClassnameParam(sb, cop);
+static CIMCStatus executeBatch(CIMCBatch *bt)
+{
+   BatchEnc         *be = (BatchEnc*)bt;
+   ClientEnc        *cl = be->client;
+   CMCIConnection   *con = cl->connection;
+   BatchOp          *first = be->ops + be->numExecuted, *last = be->ops + be->numOps;
+   CMPIObjectPath  **cops;
+   UtilStringBuffer *sb;
+   CIMCStatus        st = {CIMC_RC_OK, NULL};
+   CMPIStatus        failed;
+   ResponseHdr       rh;
+   CURLcode          rv;
+   long              responseCode = 0;
+   char             *error = NULL;
+   CMPIUint64        parseStart, objects = 0;
+   int               i, n = last - first;
+
+   be->numExecuted = be->numOps;
+   if (n == 0)
+      return st;
+
+   /* a MULTIREQ has at least two SIMPLEREQs */
+   if (n == 1) {
+      executeBatchOp(cl, first);
+      return st;
+   }
 
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+   sb = UtilFactory->newStringBuffer(4096);
+   addXmlMultiHeader(sb);
+   for (i = 0; i < n; i++)
+      addXmlSimpleReq(sb, first[i].request);
+   addXmlMultiFooter(sb);
 
-   error = con->ft->addPayload(con,sb);
+   if (prepareRequest(cl, con, NULL, NULL, 0))
+      error = strdup("Unable to initialize curl interface.");
+   else
+      error = con->ft->addPayload(con, sb);
+   if (error == NULL) {
+      rv = curl_easy_perform(con->mHandle);
+      curl_easy_getinfo(con->mHandle, CURLINFO_HTTP_CODE, &responseCode);
+      if (rv)
+	 error = transferError(con, rv);
+      else if (con->mResponse->ft->getSize(con->mResponse) == 0)
+	 error = strdup("No data received from server");
+      countTransfer(con);
+      returnHandle(con);
+   }
+   CMRelease(sb);
 
-   if (error || (error = con->ft->getResponse(con,cop))) {
-      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
+   if (error || con->mStatus.rc != CMPI_RC_OK)
+      countOperation(con, 1, 0, 0);
+
+   /* DSP0200: 501 with CIMError: multiple-requests-unsupported */
+   if (responseCode == 501) {
       free(error);
-      CMRelease(sb);\
-      END_TIMING(_T_FAILED);
-      return NULL;
+      if (con->mStatus.msg) CMRelease(con->mStatus.msg);
+      for (i = 0; i < n; i++)
+	 executeBatchOp(cl, first + i);
+      return st;
    }
 
+   if (error) {
+      failBatchOps(first, last, con, error);
+      st.rc = CIMC_RC_ERR_FAILED;
+      st.msg = (CIMCString*) newCMPIString(error, NULL);
+      free(error);
+      return st;
+   }
    if (con->mStatus.rc != CMPI_RC_OK) {
-      if (rc)
-     *rc=cloneStatus(con->mStatus);
-      CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
+      failBatchOps(first, last, con, NULL);
+      failed = cloneStatus(con->mStatus);
+      st.rc = (CIMCrc) failed.rc;
+      st.msg = (CIMCString*) failed.msg;
+      return st;
    }
 
-   CMRelease(sb);
+   cops = (CMPIObjectPath**)malloc(n * sizeof(CMPIObjectPath*));
+   for (i = 0; i < n; i++)
+      cops[i] = first[i].cop;
+   parseStart = con->mMetrics ? microseconds() : 0;
+   rh = scanCimXmlMultiResponse(CMGetCharPtr(con->mResponse), cops, n,
+                                con->mHeap);
+   free(cops);
+   if (con->mMetrics) {
+      for (i = 0; i < rh.numResponses; i++)
+	 if (rh.responses[i].errCode == 0)
+	    objects += CMGetArrayCount(rh.responses[i].rvArray, NULL);
+      countOperation(con, rh.numResponses < n, objects, parseStart);
+   }
 
-   rh=scanCimXmlResponse(CMGetCharPtr(con->mResponse),cop);
+   for (i = 0; i < rh.numResponses && i < n; i++)
+      setBatchResult(first + i, rh.responses + i);
+   for (; i < rh.numResponses; i++) {
+      free(rh.responses[i].description);
+      CMRelease(rh.responses[i].rvArray);
+      if (rh.responses[i].outArgs) CMRelease(rh.responses[i].outArgs);
+   }
+   if (rh.numResponses < n) {
+      failBatchOps(first + rh.numResponses, last, con,
+                   rh.errCode ? rh.description : "No response to the operation");
+      st.rc = CIMC_RC_ERR_FAILED;
+      st.msg = (CIMCString*) newCMPIString("Incomplete multiple operation response", NULL);
+   }
+   free(rh.description);
+   free(rh.responses);
+   CMRelease(rh.rvArray);
 
-   if (rh.errCode!=0) {
-      CMSetStatusWithChars(rc,rh.errCode,rh.description);
-      free(rh.description);
-      CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
-      return NULL;
+   return st;
+}
+
+static CIMCCount getBatchCount(CIMCBatch *bt, CIMCStatus *rc)
+{
+   CMSetStatus(rc, CIMC_RC_OK);
+   return ((BatchEnc*)bt)->numOps;
+}
+
+static CIMCData getBatchResult(CIMCBatch *bt, CIMCCount index, CIMCStatus *rc)
+{
+   BatchEnc  *be = (BatchEnc*)bt;
+   BatchOp   *op = be->ops + index;
+   CIMCData   data = { CIMC_null, CIMC_nullValue, {0} };
+   CMPIStatus st;
+
+   if (index >= (CIMCCount)be->numOps) {
+      CMSetStatus(rc, CIMC_RC_ERR_INVALID_PARAMETER);
+   } else if (index >= (CIMCCount)be->numExecuted) {
+      if (rc) {
+	 rc->rc = CIMC_RC_ERR_FAILED;
+	 rc->msg = (CIMCString*) newCMPIString("Operation not executed", NULL);
+      }
+   } else {
+      if (rc) {
+	 st = cloneStatus(op->st);
+	 rc->rc = (CIMCrc) st.rc;
+	 rc->msg = (CIMCString*) st.msg;
+      }
+      data.type = op->data.type;
+      data.state = op->data.state;
+      memcpy(&data.value, &op->data.value, sizeof(data.value));
    }
+   return data;
+}
 
-#if DEBUG
-   if (do_debug)
-       printf ("\treturn enumeration array type %d expected CMPI_ref %d\n",
-	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_ref);
-#endif
+static CIMCStatus releaseBatch(CIMCBatch *bt)
+{
+   BatchEnc  *be = (BatchEnc*)bt;
+   CIMCStatus rc = {CIMC_RC_OK, NULL};
+   BatchOp   *op;
+
+   for (op = be->ops; op < be->ops + be->numOps; op++) {
+      free(op->method);
+      CMRelease(op->cop);
+      CMRelease(op->request);
+      if (op->st.msg) CMRelease(op->st.msg);
+      native_release_CMPIValue(op->data.type, &op->data.value);
+   }
+   free(be->ops);
+   free(be);
+   return rc;
+}
 
-   CMSetStatus(rc,CMPI_RC_OK);
-   retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
-   return retval;
+static int addBatchOp(CIMCBatch *bt, const char *method, CIMCObjectPath *cop,
+		      int classWithKeys, AsyncResult result, CIMCArgs *out,
+		      UtilStringBuffer *sb, CIMCStatus *rc)
+{
+   BatchEnc *be = (BatchEnc*)bt;
+   BatchOp  *op;
+
+   /* rc is set already if the request could not be built */
+   if (sb == NULL) return -1;
+
+   if (be->numOps == be->maxOps) {
+      be->maxOps = be->maxOps ? be->maxOps * 2 : 16;
+      be->ops = (BatchOp*)realloc(be->ops, be->maxOps * sizeof(BatchOp));
+   }
+   op = memset(be->ops + be->numOps, 0, sizeof(BatchOp));
+   op->method = strdup(method);
+   op->cop = CMClone((CMPIObjectPath*)cop, NULL);
+   op->classWithKeys = classWithKeys;
+   op->result = result;
+   op->out = (CMPIArgs*)out;
+   op->request = sb;
+   op->data.state = CMPI_nullValue;
+
+   CMSetStatus(rc, CIMC_RC_OK);
+   return be->numOps++;
 }
 
-/* --------------------------------------------------------------------------*/
+static int batchGetClass(CIMCBatch *bt, CIMCObjectPath *cop, CIMCFlags flags,
+			 char **properties, CIMCStatus *rc)
+{
+   return addBatchOp(bt, GetClass, cop, 0, ASYNC_CLASS, NULL,
+		     getClassRequest((CMPIObjectPath*)cop, flags, properties), rc);
+}
 
-static CMPIEnumeration * enumClasses(
-	CMCIClient * mb,
-	CMPIObjectPath * cop,
-	CMPIFlags flags,
-	CMPIStatus * rc)
+static int batchEnumClassNames(CIMCBatch *bt, CIMCObjectPath *cop, CIMCFlags flags,
+			       CIMCStatus *rc)
 {
-   ClientEnc	     *cl  = (ClientEnc *)mb;
-   CMCIConnection   *con = cl->connection;
-   UtilStringBuffer *sb  = UtilFactory->newStringBuffer(2048);
-   char             *error;
-   CMPIEnumeration  *retval;
-   ResponseHdr	     rh;
+   return addBatchOp(bt, EnumerateClassNames, cop, 0, ASYNC_ENUMERATION, NULL,
+		     enumClassNamesRequest((CMPIObjectPath*)cop, flags), rc);
+}
 
-   START_TIMING(EnumerateClasses);
-   SET_DEBUG();
+static int batchEnumClasses(CIMCBatch *bt, CIMCObjectPath *cop, CIMCFlags flags,
+			    CIMCStatus *rc)
+{
+   return addBatchOp(bt, EnumerateClasses, cop, 0, ASYNC_ENUMERATION, NULL,
+		     enumClassesRequest((CMPIObjectPath*)cop, flags), rc);
+}
 
-   con->ft->genRequest(cl, EnumerateClasses, cop, 0);
+static int batchGetInstance(CIMCBatch *bt, CIMCObjectPath *cop, CIMCFlags flags,
+			    char **properties, CIMCStatus *rc)
+{
+   return addBatchOp(bt, GetInstance, cop, 0, ASYNC_VALUE, NULL,
+		     getInstanceRequest((CMPIObjectPath*)cop, flags, properties), rc);
+}
 
-   /* Construct the CIM-XML request */
-   addXmlHeader(sb);
-   sb->ft->append3Chars(sb, "<IMETHODCALL NAME=\"", EnumerateClasses, "\">");
+static int batchCreateInstance(CIMCBatch *bt, CIMCObjectPath *cop, CIMCInstance *inst,
+			       CIMCStatus *rc)
+{
+   return addBatchOp(bt, CreateInstance, cop, 0, ASYNC_VALUE, NULL,
+		     createInstanceRequest((CMPIObjectPath*)cop, (CMPIInstance*)inst), rc);
+}
 
-   addXmlNamespace(sb, cop);
-   emitdeep(sb,flags & CMPI_FLAG_DeepInheritance);
-   emitlocal(sb,flags & CMPI_FLAG_LocalOnly);
-   emitqual(sb,flags & CMPI_FLAG_IncludeQualifiers);
-   emitorigin(sb,flags & CMPI_FLAG_IncludeClassOrigin);
-   addXmlClassnameParam(sb, cop);
+static int batchSetInstance(CIMCBatch *bt, CIMCObjectPath *cop, CIMCInstance *inst,
+			    CIMCFlags flags, char **properties, CIMCStatus *rc)
+{
+   return addBatchOp(bt, ModifyInstance, cop, 0, ASYNC_NONE, NULL,
+		     setInstanceRequest((CMPIObjectPath*)cop, (CMPIInstance*)inst,
+					flags, properties), rc);
+}
 
-   sb->ft->appendChars(sb,"</IMETHODCALL>\n");
-   addXmlFooter(sb);
+static int batchDeleteInstance(CIMCBatch *bt, CIMCObjectPath *cop, CIMCStatus *rc)
+{
+   return addBatchOp(bt, DeleteInstance, cop, 0, ASYNC_NONE, NULL,
+		     deleteInstanceRequest((CMPIObjectPath*)cop), rc);
+}
 
-   error = con->ft->addPayload(con,sb);
+static int batchExecQuery(CIMCBatch *bt, CIMCObjectPath *cop, const char *query,
+			  const char *lang, CIMCStatus *rc)
+{
+   return addBatchOp(bt, ExecQuery, cop, 0, ASYNC_ENUMERATION, NULL,
+		     execQueryRequest((CMPIObjectPath*)cop, query, lang), rc);
+}
 
-   if (error || (error = con->ft->getResponse(con, cop))) {
-      CMSetStatusWithChars(rc,CMPI_RC_ERR_FAILED,error);
-      free(error);
-      CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
-   }
+static int batchEnumInstanceNames(CIMCBatch *bt, CIMCObjectPath *cop, CIMCStatus *rc)
+{
+   return addBatchOp(bt, EnumerateInstanceNames, cop, 0, ASYNC_ENUMERATION, NULL,
+		     enumInstanceNamesRequest((CMPIObjectPath*)cop), rc);
+}
 
-   if (con->mStatus.rc != CMPI_RC_OK) {
-      if (rc)
-     *rc=cloneStatus(con->mStatus);
-      CMRelease(sb);
-      END_TIMING(_T_FAILED);
-      return NULL;
-   }
+static int batchEnumInstances(CIMCBatch *bt, CIMCObjectPath *cop, CIMCFlags flags,
+			      char **properties, CIMCStatus *rc)
+{
+   return addBatchOp(bt, EnumerateInstances, cop, 0, ASYNC_ENUMERATION, NULL,
+		     enumInstancesRequest((CMPIObjectPath*)cop, flags, properties), rc);
+}
 
-   CMRelease(sb);
+static int batchAssociators(CIMCBatch *bt, CIMCObjectPath *cop,
+			    const char *assocClass, const char *resultClass,
+			    const char *role, const char *resultRole,
+			    CIMCFlags flags, char **properties, CIMCStatus *rc)
+{
+   return addBatchOp(bt, Associators, cop, 0, ASYNC_ENUMERATION, NULL,
+		     associatorsRequest((CMPIObjectPath*)cop, assocClass, resultClass,
+					role, resultRole, flags, properties), rc);
+}
 
-   rh = scanCimXmlResponse(CMGetCharPtr(con->mResponse), cop);
+static int batchAssociatorNames(CIMCBatch *bt, CIMCObjectPath *cop,
+				const char *assocClass, const char *resultClass,
+				const char *role, const char *resultRole, CIMCStatus *rc)
+{
+   return addBatchOp(bt, AssociatorNames, cop, 0, ASYNC_ENUMERATION, NULL,
+		     associatorNamesRequest((CMPIObjectPath*)cop, assocClass, resultClass,
+					    role, resultRole), rc);
+}
 
-   if (rh.errCode != 0) {
-      CMSetStatusWithChars(rc, rh.errCode, rh.description);
-      free(rh.description);
-      CMRelease(rh.rvArray);
-      END_TIMING(_T_FAILED);
-      return NULL;
-   }
+static int batchReferences(CIMCBatch *bt, CIMCObjectPath *cop,
+			   const char *resultClass, const char *role,
+			   CIMCFlags flags, char **properties, CIMCStatus *rc)
+{
+   return addBatchOp(bt, References, cop, 0, ASYNC_ENUMERATION, NULL,
+		     referencesRequest((CMPIObjectPath*)cop, resultClass, role,
+				       flags, properties), rc);
+}
 
-#if DEBUG
-   if (do_debug)
-       printf ("\treturn enumeration array type %d expected CMPI_class %d\n",
-	    rh.rvArray->ft->getSimpleType(rh.rvArray, NULL), CMPI_class);
-#endif
+static int batchReferenceNames(CIMCBatch *bt, CIMCObjectPath *cop,
+			       const char *resultClass, const char *role, CIMCStatus *rc)
+{
+   return addBatchOp(bt, ReferenceNames, cop, 0, ASYNC_ENUMERATION, NULL,
+		     referenceNamesRequest((CMPIObjectPath*)cop, resultClass, role), rc);
+}
 
-   CMSetStatus(rc, CMPI_RC_OK);
-   retval = newCMPIEnumeration(rh.rvArray, NULL);
-   END_TIMING(_T_GOOD);
+static int batchInvokeMethod(CIMCBatch *bt, CIMCObjectPath *cop, const char *method,
+			     CIMCArgs *in, CIMCArgs *out, CIMCStatus *rc)
+{
+   return addBatchOp(bt, method, cop, 1, ASYNC_METHOD, out,
+		     invokeMethodRequest((CMPIObjectPath*)cop, method, (CMPIArgs*)in,
+					 (CMPIStatus*)rc), rc);
+}
 
-   return retval;
+static int batchSetProperty(CIMCBatch *bt, CIMCObjectPath *cop, const char *name,
+			    CIMCValue *value, CIMCType type, CIMCStatus *rc)
+{
+   return addBatchOp(bt, SetProperty, cop, 0, ASYNC_NONE, NULL,
+		     setPropertyRequest((CMPIObjectPath*)cop, name, (CMPIValue*)value,
+					type), rc);
 }
 
+static int batchGetProperty(CIMCBatch *bt, CIMCObjectPath *cop, const char *name,
+			    CIMCStatus *rc)
+{
+   return addBatchOp(bt, GetProperty, cop, 0, ASYNC_VALUE, NULL,
+		     getPropertyRequest((CMPIObjectPath*)cop, name), rc);
+}
 
-static CMCIClientFT clientFt = {
+static CIMCBatchFT batchFt = {
    NATIVE_FT_VERSION,
-   releaseClient,
-   cloneClient,
-   getClass,
-   enumClassNames,
-   enumClasses,
-   getInstance,
-   createInstance,
-   setInstance,
-   deleteInstance,
-   execQuery,
-   enumInstanceNames,
-   enumInstances,
-   associators,
-   associatorNames,
-   references,
-   referenceNames,
-   invokeMethod,
-   setProperty,
-   getProperty
+   releaseBatch,
+   executeBatch,
+   getBatchCount,
+   getBatchResult,
+   batchGetClass,
+   batchEnumClassNames,
+   batchEnumClasses,
+   batchGetInstance,
+   batchCreateInstance,
+   batchSetInstance,
+   batchDeleteInstance,
+   batchExecQuery,
+   batchEnumInstanceNames,
+   batchEnumInstances,
+   batchAssociators,
+   batchAssociatorNames,
+   batchReferences,
+   batchReferenceNames,
+   batchInvokeMethod,
+   batchSetProperty,
+   batchGetProperty
 };
 
 
@@ -2846,6 +5323,7 @@ static CIMCClient *xmlConnect2(CIMCEnv *env, const char *hn, const char *scheme,
 
    cc->enc.hdl		= &cc->data;
    cc->enc.ft		= &clientFt;
+   cc->env		= env;
 
    cc->data.hostName	= hn ? strdup(hn) : strdup("localhost");
    cc->data.user	= user ? strdup(user) : NULL;
@@ -2864,18 +5342,8 @@ static CIMCClient *xmlConnect2(CIMCEnv *env, const char *hn, const char *scheme,
    cc->certData.keyFile = keyFile ? strdup(keyFile) : NULL;
    
    cc->connection=initConnection(&cc->data);
-
-   /* set SSL options */
-   if (cc->connection) {
-     curl_easy_setopt(cc->connection->mHandle,CURLOPT_SSL_VERIFYPEER,
-		      verifyMode == CMCI_VERIFY_PEER ? 1 : 0);
-      if (trustStore)
-       curl_easy_setopt(cc->connection->mHandle,CURLOPT_CAINFO,trustStore);
-      if (certFile)
-       curl_easy_setopt(cc->connection->mHandle,CURLOPT_SSLCERT,certFile);
-      if (keyFile)
-       curl_easy_setopt(cc->connection->mHandle,CURLOPT_SSLKEY,keyFile);       
-     }
+   cc->connection->mPool = &((XmlEnv*)env)->pool;
+   cc->connection->mPoolKey = poolKey(cc);
  
    CMSetStatus(rc, CIMC_RC_OK);
    return (CIMCClient*)cc;
@@ -2891,6 +5359,26 @@ static CIMCClient *xmlConnect(CIMCEnv *env, const char *hn, const char *scheme,
 static void *releaseEnv(CIMCEnv *env)
 {
   CMPIStatus rc = {CMPI_RC_OK,NULL};
+  ConnectionPool *pool = &((XmlEnv*)env)->pool;
+  ClassCache *cache = &((XmlEnv*)env)->classCache;
+  Metrics *metrics = &((XmlEnv*)env)->metrics;
+  OperationMetrics *om;
+
+  /* clients are released already, only idle handles are left */
+  cleanupHandles(pool->idle);
+  pool->idle = NULL;
+  pthread_mutex_destroy(&pool->lock);
+
+  while ((om = metrics->operations) != NULL) {
+    metrics->operations = om->next;
+    pthread_mutex_destroy(&om->lock);
+    free(om);
+  }
+  pthread_mutex_destroy(&metrics->lock);
+
+  flushClasses(cache, NULL, NULL);
+  free(cache->buckets);
+  pthread_mutex_destroy(&cache->lock);
   
   if (!(env->options & CIMC_NO_CURL_INIT)) {
     curl_global_cleanup();
@@ -2947,8 +5435,340 @@ static CIMCIndicationListener *newIndicationListener (CIMCEnv* ce,
                                                       void (*fp) (CIMCInstance *indInstance),
                                                       CIMCStatus *rc)
 {
+   XmlEnv *xenv = (XmlEnv*)ce;
+   struct native_indicationlistener *il;
+
    /* socket name not required, cimxml/tcpip mode */
-   return newCIMCIndicationListener(sslMode, portNumber, fp, rc);
+   il = (struct native_indicationlistener*)
+      newCIMCIndicationListener(sslMode, portNumber, fp, rc);
+   if (xenv->listenerBacklog)
+      il->backlog = xenv->listenerBacklog;
+   if (xenv->listenerWorkers)
+      il->workers = xenv->listenerWorkers;
+   if (xenv->listenerIdleTimeout)
+      il->idleTimeout = xenv->listenerIdleTimeout;
+   if (xenv->listenerQueueSize)
+      il->queueSize = xenv->listenerQueueSize;
+   if (xenv->listenerBatchSize)
+      il->batchSize = xenv->listenerBatchSize;
+   il->overflow = xenv->listenerOverflow;
+   il->linger = xenv->listenerLinger;
+   return (CIMCIndicationListener*)il;
+}
+
+static CIMCIndicationListener *newBatchIndicationListener (CIMCEnv* ce,
+                                                           int sslMode,
+                                                           int *portNumber,
+                                                           char **socketName,
+                                                           void (*fp) (CIMCInstance **indInstances, CIMCCount count),
+                                                           CIMCStatus *rc)
+{
+   struct native_indicationlistener *il;
+
+   il = (struct native_indicationlistener*)
+      newIndicationListener(ce, sslMode, portNumber, socketName, NULL, rc);
+   il->sendIndicationBatch = fp;
+   return (CIMCIndicationListener*)il;
+}
+
+static CIMCStatus setOption(CIMCEnv *env, int option, long value)
+{
+  CIMCStatus rc = {CIMC_RC_OK,NULL};
+  ConnectionPool *pool = &((XmlEnv*)env)->pool;
+  ClassCache *cache = &((XmlEnv*)env)->classCache;
+  PooledHandle *expired;
+
+  if (value < 0) {
+    rc.rc = CIMC_RC_ERR_INVALID_PARAMETER;
+    return rc;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  switch (option) {
+  case CIMC_OPT_POOL_SIZE:
+    pool->maxIdle = value;
+    break;
+  case CIMC_OPT_POOL_IDLE_TIMEOUT:
+    pool->idleTimeout = value;
+    break;
+  case CIMC_OPT_PULL_MAX_OBJECT_COUNT:
+    if (value == 0)
+      rc.rc = CIMC_RC_ERR_INVALID_PARAMETER;
+    else
+      ((XmlEnv*)env)->pullMaxObjectCount = value;
+    break;
+  case CIMC_OPT_PULL_OPERATION_TIMEOUT:
+    ((XmlEnv*)env)->pullOperationTimeout = value;
+    break;
+  case CIMC_OPT_CLASS_CACHE_SIZE:
+    pthread_mutex_lock(&cache->lock);
+    cache->maxEntries = value;
+    trimClassCache(cache);
+    pthread_mutex_unlock(&cache->lock);
+    break;
+  case CIMC_OPT_CLASS_CACHE_TTL:
+    pthread_mutex_lock(&cache->lock);
+    cache->ttl = value;
+    pthread_mutex_unlock(&cache->lock);
+    break;
+  case CIMC_OPT_TIMEZONE_REFRESH:
+    native_datetime_refresh_timezone();
+    break;
+  case CIMC_OPT_LISTENER_BACKLOG:
+    ((XmlEnv*)env)->listenerBacklog = value;
+    break;
+  case CIMC_OPT_LISTENER_WORKERS:
+    ((XmlEnv*)env)->listenerWorkers = value;
+    break;
+  case CIMC_OPT_LISTENER_IDLE_TIMEOUT:
+    ((XmlEnv*)env)->listenerIdleTimeout = value;
+    break;
+  case CIMC_OPT_LISTENER_QUEUE_SIZE:
+    ((XmlEnv*)env)->listenerQueueSize = value;
+    break;
+  case CIMC_OPT_LISTENER_OVERFLOW:
+    if (value > CIMC_OVERFLOW_DROP_NEWEST)
+      rc.rc = CIMC_RC_ERR_INVALID_PARAMETER;
+    else
+      ((XmlEnv*)env)->listenerOverflow = value;
+    break;
+  case CIMC_OPT_LISTENER_BATCH_SIZE:
+    ((XmlEnv*)env)->listenerBatchSize = value;
+    break;
+  case CIMC_OPT_LISTENER_LINGER:
+    ((XmlEnv*)env)->listenerLinger = value;
+    break;
+  case CIMC_OPT_METRICS:
+    if (value > 1)
+      rc.rc = CIMC_RC_ERR_INVALID_PARAMETER;
+    else
+      pool->metrics = value ? &((XmlEnv*)env)->metrics : NULL;
+    break;
+  default:
+    rc.rc = CIMC_RC_ERR_NOT_SUPPORTED;
+  }
+  expired = expireHandles(pool, time(NULL));
+  pthread_mutex_unlock(&pool->lock);
+
+  cleanupHandles(expired);
+  return rc;
+}
+
+static CIMCUint64 getCounter(CIMCEnv *env, int counter, CIMCStatus *rc)
+{
+  ConnectionPool *pool = &((XmlEnv*)env)->pool;
+  ClassCache *cache = &((XmlEnv*)env)->classCache;
+  CIMCUint64 value = 0;
+
+  CMSetStatus(rc, CIMC_RC_OK);
+  pthread_mutex_lock(&pool->lock);
+  switch (counter) {
+  case CIMC_CNT_POOL_HITS:
+    value = pool->hits;
+    break;
+  case CIMC_CNT_POOL_MISSES:
+    value = pool->misses;
+    break;
+  case CIMC_CNT_POOL_EXPIRED:
+    value = pool->expired;
+    break;
+  case CIMC_CNT_POOL_IDLE:
+    value = pool->numIdle;
+    break;
+  case CIMC_CNT_BYTES_RECEIVED:
+    value = pool->received;
+    break;
+  case CIMC_CNT_BYTES_DECODED:
+    value = pool->decoded;
+    break;
+  case CIMC_CNT_CLASS_CACHE_HITS:
+  case CIMC_CNT_CLASS_CACHE_MISSES:
+  case CIMC_CNT_CLASS_CACHE_EVICTED:
+  case CIMC_CNT_CLASS_CACHE_ENTRIES:
+    pthread_mutex_lock(&cache->lock);
+    value = counter == CIMC_CNT_CLASS_CACHE_HITS ? cache->hits :
+            counter == CIMC_CNT_CLASS_CACHE_MISSES ? cache->misses :
+            counter == CIMC_CNT_CLASS_CACHE_EVICTED ? cache->evicted :
+            (CIMCUint64) cache->count;
+    pthread_mutex_unlock(&cache->lock);
+    break;
+  default:
+    CMSetStatus(rc, CIMC_RC_ERR_NOT_SUPPORTED);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return value;
+}
+
+static void addMetrics(CIMCMetrics *sum, CIMCMetrics *m)
+{
+  int p, b;
+
+  sum->operations += m->operations;
+  sum->failures += m->failures;
+  sum->requestBytes += m->requestBytes;
+  sum->responseBytes += m->responseBytes;
+  sum->decodedBytes += m->decodedBytes;
+  sum->objects += m->objects;
+  for (p = 0; p < CIMC_PHASES; p++) {
+    sum->time[p] += m->time[p];
+    for (b = 0; b < CIMC_METRICS_BUCKETS; b++)
+      sum->histogram[p][b] += m->histogram[p][b];
+  }
+}
+
+/* operation NULL sums up all operation types */
+static CIMCStatus getMetrics(CIMCEnv *env, const char *operation,
+                             CIMCMetrics *metrics)
+{
+  CIMCStatus rc = {CIMC_RC_OK,NULL};
+  Metrics *mt = &((XmlEnv*)env)->metrics;
+  OperationMetrics *om;
+
+  if (metrics == NULL) {
+    rc.rc = CIMC_RC_ERR_INVALID_PARAMETER;
+    return rc;
+  }
+
+  memset(metrics, 0, sizeof(CIMCMetrics));
+  pthread_mutex_lock(&mt->lock);
+  for (om = mt->operations; om; om = om->next) {
+    if (operation && strcmp(om->name, operation) != 0)
+      continue;
+    pthread_mutex_lock(&om->lock);
+    addMetrics(metrics, &om->m);
+    pthread_mutex_unlock(&om->lock);
+  }
+  pthread_mutex_unlock(&mt->lock);
+  return rc;
+}
+
+static const char *phaseNames[CIMC_PHASES] = {
+  "total", "request", "resolve", "connect", "tls", "server", "transfer", "parse"
+};
+
+/* appends ,"name":n or ,n without name, sep replaces the leading ',' */
+static void appendNumber(UtilStringBuffer *sb, const char *sep,
+                         const char *name, CIMCUint64 n)
+{
+  char number[24];
+
+  sprintf(number, "%llu", (unsigned long long)n);
+  if (name)
+    sb->ft->append5Chars(sb, sep, "\"", name, "\":", number);
+  else
+    sb->ft->append3Chars(sb, sep, number, NULL);
+}
+
+static void appendMetrics(UtilStringBuffer *sb, const char *sep,
+                          const char *name, CIMCMetrics *m)
+{
+  CIMCUint64 count;
+  int p, b, used;
+
+  sb->ft->append5Chars(sb, sep, "\"", name, "\":", NULL);
+  appendNumber(sb, "{", "operations", m->operations);
+  appendNumber(sb, ",", "failures", m->failures);
+  appendNumber(sb, ",", "requestBytes", m->requestBytes);
+  appendNumber(sb, ",", "responseBytes", m->responseBytes);
+  appendNumber(sb, ",", "decodedBytes", m->decodedBytes);
+  appendNumber(sb, ",", "objects", m->objects);
+  sb->ft->appendChars(sb, ",\"phases\":");
+  for (p = 0, sep = "{"; p < CIMC_PHASES; p++) {
+    for (b = used = 0, count = 0; b < CIMC_METRICS_BUCKETS; b++) {
+      if (m->histogram[p][b])
+        used = b + 1;
+      count += m->histogram[p][b];
+    }
+    if (count == 0)
+      continue;
+    sb->ft->append5Chars(sb, sep, "\"", phaseNames[p], "\":", NULL);
+    appendNumber(sb, "{", "count", count);
+    appendNumber(sb, ",", "time", m->time[p]);
+    sb->ft->appendChars(sb, ",\"histogram\":");
+    for (b = 0; b < used; b++)
+      appendNumber(sb, b ? "," : "[", NULL, m->histogram[p][b]);
+    sb->ft->appendChars(sb, "]}");
+    sep = ",";
+  }
+  sb->ft->appendChars(sb, *sep == '{' ? "{}}" : "}}");
+}
+
+/* {"operations":{"GetInstance":{...},...},"total":{...}}, phases never
+   measured and the empty end of histograms are left out */
+static char *dumpMetrics(CIMCEnv *env, CIMCStatus *rc)
+{
+  Metrics *mt = &((XmlEnv*)env)->metrics;
+  UtilStringBuffer *sb = UtilFactory->newStringBuffer(4096);
+  OperationMetrics *om;
+  CIMCMetrics total, m;
+  const char *sep = "{";
+  char *json;
+
+  memset(&total, 0, sizeof(total));
+  sb->ft->appendChars(sb, "{\"operations\":");
+  pthread_mutex_lock(&mt->lock);
+  for (om = mt->operations; om; om = om->next) {
+    pthread_mutex_lock(&om->lock);
+    m = om->m;
+    pthread_mutex_unlock(&om->lock);
+    addMetrics(&total, &m);
+    appendMetrics(sb, sep, om->name, &m);
+    sep = ",";
+  }
+  pthread_mutex_unlock(&mt->lock);
+  sb->ft->appendChars(sb, *sep == '{' ? "{}" : "}");
+  appendMetrics(sb, ",", "total", &total);
+  sb->ft->appendChars(sb, "}");
+
+  json = strdup(sb->ft->getCharPtr(sb));
+  CMRelease(sb);
+  CMSetStatus(rc, CIMC_RC_OK);
+  return json;
+}
+
+static CIMCAsync *newAsync(CIMCEnv *env, CIMCStatus *rc)
+{
+  AsyncEnc *ae = (AsyncEnc*)calloc(1, sizeof(AsyncEnc));
+
+  ae->enc.hdl = ae;
+  ae->enc.ft = &asyncFt;
+  if ((ae->multi = curl_multi_init()) == NULL) {
+    free(ae);
+    CMSetStatusWithChars((CMPIStatus*)rc, CMPI_RC_ERR_FAILED,
+			 "Unable to initialize curl multi interface.");
+    return NULL;
+  }
+  CMSetStatus(rc, CIMC_RC_OK);
+  return &ae->enc;
+}
+
+static CIMCBatch *newBatch(CIMCEnv *env, CIMCClient *cl, CIMCStatus *rc)
+{
+  BatchEnc *be = (BatchEnc*)calloc(1, sizeof(BatchEnc));
+
+  be->enc.hdl = be;
+  be->enc.ft = &batchFt;
+  be->client = (ClientEnc*)cl;
+  CMSetStatus(rc, CIMC_RC_OK);
+  return &be->enc;
+}
+
+/* op NULL flushes all classes, one without class name a namespace */
+static CIMCStatus flushClassCache(CIMCEnv *env, CIMCObjectPath *op)
+{
+  CIMCStatus rc = {CIMC_RC_OK,NULL};
+  CMPIString *cn = NULL;
+  const char *ns = NULL, *cns = NULL;
+
+  if (op) {
+    ns = getNameSpaceChars((CMPIObjectPath*)op);
+    cn = CMGetClassName((CMPIObjectPath*)op, NULL);
+    if (cn && CMGetCharPtr(cn) && *CMGetCharPtr(cn))
+      cns = CMGetCharPtr(cn);
+  }
+  flushClasses(&((XmlEnv*)env)->classCache, ns, cns);
+  if (cn) CMRelease(cn);
+  return rc;
 }
 
 static CIMCEnvFT localFT = {
@@ -2966,7 +5786,15 @@ static CIMCEnvFT localFT = {
   newDateTimeFromChars,
   newIndicationListener,
   NULL, // markHeap, SfcbLocal only
-  NULL // releaseHeap, SfcbLocal only
+  NULL, // releaseHeap, SfcbLocal only
+  setOption,
+  getCounter,
+  newAsync,
+  newBatch,
+  flushClassCache,
+  newBatchIndicationListener,
+  getMetrics,
+  dumpMetrics
 };
 
 /* Factory function for CIMXML Client */
@@ -2974,11 +5802,22 @@ static CIMCEnvFT localFT = {
 CIMCEnv* _Create_XML_Env(const char *id, unsigned int options, int *rc, char **msg)
 {
  
-    CIMCEnv *env = (CIMCEnv*)malloc(sizeof(CIMCEnv));
+    XmlEnv *xenv = (XmlEnv*)calloc(1, sizeof(XmlEnv));
+    CIMCEnv *env = &xenv->env;
     env->hdl=NULL;
     env->ft=&localFT;
     env->options = options;
 
+    pthread_mutex_init(&xenv->pool.lock, NULL);
+    xenv->pool.maxIdle = POOL_DEFAULT_SIZE;
+    xenv->pool.idleTimeout = POOL_DEFAULT_IDLE_TIMEOUT;
+    xenv->pullMaxObjectCount = PULL_DEFAULT_MAX_OBJECT_COUNT;
+
+    pthread_mutex_init(&xenv->classCache.lock, NULL);
+    xenv->classCache.ttl = CLASS_CACHE_DEFAULT_TTL;
+
+    pthread_mutex_init(&xenv->metrics.lock, NULL);
+
     if (!(options & CIMC_NO_CURL_INIT)) {
       curl_global_init(CURL_GLOBAL_SSL);
     }
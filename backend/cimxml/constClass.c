@@ -29,6 +29,7 @@
 #include "cmcift.h"
 #include "cmcimacs.h"
 #include "native.h"
+#include "utilft.h"
 
 #ifdef DMALLOC
 #include "dmalloc.h"
@@ -43,7 +44,10 @@ static CMPIStatus __ccft_release ( CMPIConstClass * ccls )
 
 	if ( cc ) {
 
-		free ( cc->classname );
+		if ( __sync_sub_and_fetch ( &cc->refCount, 1 ) > 0 )
+			CMReturn ( CMPI_RC_OK );
+
+		internStringRelease ( cc->classname );
 		propertyFT.release ( cc->props );
 		qualifierFT.release ( cc->qualifiers );
         methodFT.release ( cc->methods );
@@ -63,7 +67,8 @@ static CMPIConstClass * __ccft_clone ( CMPIConstClass * ccls, CMPIStatus * rc )
 		calloc ( 1, sizeof ( struct native_constClass ) );
 
 	new->ccls      = cc->ccls;
-	new->classname = strdup ( cc->classname );
+	new->refCount  = 1;
+	new->classname = internStringRef ( cc->classname );
 	new->qualifiers= qualifierFT.clone ( cc->qualifiers, rc );
 	new->props     = propertyFT.clone ( cc->props, rc );
 	new->methods   = methodFT.clone ( cc->methods, rc );
@@ -322,13 +327,27 @@ CMPIConstClass * native_new_CMPIConstClass ( char  *cn, CMPIStatus * rc )
 		calloc ( 1, sizeof ( struct native_constClass ) );
 
 	ccls->ccls = cc;
+	ccls->refCount = 1;
 
-	ccls->classname = strdup (cn );
+	ccls->classname = internString ( cn );
 
 	return (CMPIConstClass *) ccls;
 }
 
 
+/*
+ * Classes are not modified once parsed: instead of a clone, another
+ * reference is handed out, each release() drops one of them.
+ */
+CMPIConstClass * native_ref_CMPIConstClass ( CMPIConstClass * ccls )
+{
+	struct native_constClass * cc = (struct native_constClass *) ccls;
+
+	__sync_fetch_and_add ( &cc->refCount, 1 );
+	return ccls;
+}
+
+
 int addClassProperty( CMPIConstClass * ccls,
 				      char * name,
 				      CMPIValue * value,
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
 #include "cmcidt.h"
 #include "cmcift.h"
 #include "cmcimacs.h"
@@ -95,99 +96,251 @@ static CMPIDateTime * __dtft_clone ( CMPIDateTime * dt, CMPIStatus * rc )
 	return (CMPIDateTime *) new;
 }
 
-static CMPIUint64 chars2bin(const char *string, CMPIStatus * rc)
+/*
+ * Conversions between the CIM datetime format and microseconds since the
+ * epoch are done with calendar arithmetic. mktime() and localtime_r()
+ * take a process wide lock in glibc and may check /etc/localtime each
+ * time, which serializes the parser threads converting datetimes.
+ */
+
+/* days since 1970-01-01 of a date of the proleptic Gregorian calendar */
+static long long daysFromCivil(long long y, unsigned int m, unsigned int d)
 {
-   CMPIUint64 msecs,secs;
-   CMPIBoolean interval;
-   char *str;
+   long long era;
+   unsigned int yoe, doy, doe;
+
+   y -= m <= 2;
+   era = (y >= 0 ? y : y - 399) / 400;
+   yoe = (unsigned int) (y - era * 400);
+   doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+   doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + doe - 719468;
+}
 
-   str = strdup(string);
-   interval = (str[21] == ':');
+static void civilFromDays(long long z, long long *y, unsigned int *m,
+                          unsigned int *d)
+{
+   long long era;
+   unsigned int doe, yoe, doy, mp;
+
+   z += 719468;
+   era = (z >= 0 ? z : z - 146096) / 146097;
+   doe = (unsigned int) (z - era * 146097);
+   yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+   doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+   mp = (5 * doy + 2) / 153;
+   *d = doy - (153 * mp + 2) / 5 + 1;
+   *m = mp < 10 ? mp + 3 : mp - 9;
+   *y = yoe + era * 400 + (*m <= 2);
+}
 
-// 0000000000111111111122222  
-// 0123456789012345678901234
-// yyyymmddhhmmss mmmmmmsutc 
-// 20050503104354.000000:000
+/* n digits, anything else like the '*' of wildcards counts as 0 */
+static unsigned long getDigits(const char *s, int n)
+{
+   unsigned long v = 0;
 
-   str[21] = 0;
-   msecs = strtoull(str+15,NULL,10);
+   while (n--) {
+      v *= 10;
+      if (*s >= '0' && *s <= '9')
+         v += *s - '0';
+      s++;
+   }
+   return v;
+}
 
-   str[14] = 0;
-   secs = strtoull(str+12,NULL,10);
-   str[12] = 0;
-   secs += strtoull(str+10,NULL,10) * 60ULL;
-   str[10] = 0;
-   secs += strtoull(str+8,NULL,10) * 60ULL * 60ULL;
-   str[8] = 0;
+static char *putDigits(char *s, unsigned long long v, int n)
+{
+   char *p = s + n;
 
-   if (interval) {
-      secs += strtoull(str,NULL,10) * 60ULL * 60ULL * 24ULL;
-      msecs=msecs+(secs*1000000ULL);
+   while (p > s) {
+      *--p = '0' + v % 10;
+      v /= 10;
    }
+   return s + n;
+}
 
-   else {
-      struct tm tmp;
+/*
+ * The UTC offset of local time, which is looked up with localtime_r() once
+ * and then holds until the next daylight saving time change. Instants out
+ * of that range are looked up each time. The cache is read without a lock:
+ * seq is odd while it is written, and a reader retries when seq changed.
+ */
+static struct {
+   unsigned int seq;
+   long   offset;     /* seconds east of UTC */
+   time_t from;       /* the first and the last instant it holds for */
+   time_t until;
+} tzCache;
 
-      memset(&tmp, 0, sizeof(struct tm));
-      tzset();
+static pthread_mutex_t tzLock = PTHREAD_MUTEX_INITIALIZER;
+
+static long gmtOffset(time_t t)
+{
+   struct tm tm;
+
+   if (localtime_r(&t, &tm) == NULL)
+      return 0;
+   return tm.tm_gmtoff;
+}
+
+/* the last instant in direction dir from t still having offset, looked
+   at a day at a time for up to 400 days */
+static time_t offsetEdge(time_t t, long offset, int dir)
+{
+   time_t last = t, next = t;
+   int i;
+
+   for (i = 0; i < 400; i++) {
+      next = last + dir * 86400;
+      if (gmtOffset(next) != offset)
+         break;
+      last = next;
+   }
+   if (i == 400)
+      return last;
+   while (next - last > 1 || last - next > 1) {
+      t = last + (next - last) / 2;
+      if (gmtOffset(t) == offset)
+         last = t;
+      else
+         next = t;
+   }
+   return last;
+}
 
-      tmp.tm_gmtoff = timezone;
-      tmp.tm_isdst = daylight;
-      tmp.tm_mday = atoi(str + 6);
-      str[6] = 0;
-      tmp.tm_mon = atoi(str + 4) - 1;
-      str[4] = 0;
-      tmp.tm_year = atoi(str) - 1900;
+static void loadTimezone(int always)
+{
+   time_t now, from, until;
+   long offset;
 
-      msecs=msecs+(secs*1000000ULL);
-      msecs += (CMPIUint64) mktime(&tmp) * 1000000ULL;
+   pthread_mutex_lock(&tzLock);
+   if (always || tzCache.seq == 0) {
+      tzset();
+      now = time(NULL);
+      offset = gmtOffset(now);
+      from = offsetEdge(now, offset, -1);
+      until = offsetEdge(now, offset, 1);
+
+      __atomic_store_n(&tzCache.seq, tzCache.seq + 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+      __atomic_store_n(&tzCache.offset, offset, __ATOMIC_RELAXED);
+      __atomic_store_n(&tzCache.from, from, __ATOMIC_RELAXED);
+      __atomic_store_n(&tzCache.until, until, __ATOMIC_RELAXED);
+      __atomic_store_n(&tzCache.seq, tzCache.seq + 1, __ATOMIC_RELEASE);
    }
+   pthread_mutex_unlock(&tzLock);
+}
 
-   free(str);
+static long localOffset(time_t t)
+{
+   unsigned int seq;
+   time_t from, until;
+   long offset;
+
+   for (;;) {
+      seq = __atomic_load_n(&tzCache.seq, __ATOMIC_ACQUIRE);
+      if (seq == 0) {
+         loadTimezone(0);
+         continue;
+      }
+      offset = __atomic_load_n(&tzCache.offset, __ATOMIC_RELAXED);
+      from = __atomic_load_n(&tzCache.from, __ATOMIC_RELAXED);
+      until = __atomic_load_n(&tzCache.until, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if ((seq & 1) == 0 &&
+          seq == __atomic_load_n(&tzCache.seq, __ATOMIC_RELAXED))
+         break;
+   }
+   if (t >= from && t <= until)
+      return offset;
+   return gmtOffset(t);
+}
 
-   return msecs;
+/*
+ * Looks up the local timezone again, after TZ or the system timezone was
+ * changed. Until then datetimes are created with the timezone as it was
+ * when the first one was.
+ */
+void native_datetime_refresh_timezone()
+{
+   loadTimezone(1);
 }
 
-static void bin2chars(CMPIUint64 msecs, CMPIBoolean interval, CMPIStatus * rc, char *str_time)
+static CMPIUint64 chars2bin(const char *str, CMPIStatus * rc)
 {
-   time_t secs = msecs / 1000000ULL;
-   unsigned long usecs = msecs % 1000000ULL;
+   long long secs;
+   long offset;
 
-   if (interval) {
+// 0000000000111111111122222
+// 0123456789012345678901234
+// yyyymmddhhmmss mmmmmmsutc
+// 20050503104354.000000:000
 
-      unsigned long long useconds, seconds, mins, hrs, days;
-      seconds= msecs / 1000000ULL;
-      useconds = msecs % 1000000ULL;
-
-      mins = seconds / 60ULL;
-      seconds %= 60ULL;
-      hrs = mins / 60ULL;
-      mins %= 60ULL;
-      days = hrs / 24ULL;
-      hrs %= 24ULL;
-		
-      sprintf(str_time, "%8.8llu%2.2llu%2.2llu%2.2llu.%6.6llu:000",
-              days, hrs, mins, seconds, useconds);
-   }
+   secs = getDigits(str + 8, 2) * 3600 + getDigits(str + 10, 2) * 60 +
+          getDigits(str + 12, 2);
 
+   if (str[21] == ':')
+      secs += getDigits(str, 8) * 86400LL;
    else {
-		struct tm tm_time;
-		char us_utc_time[11];
+      /* the string has its UTC offset in minutes */
+      secs += daysFromCivil(getDigits(str, 4), getDigits(str + 4, 2),
+                            getDigits(str + 6, 2)) * 86400;
+      offset = getDigits(str + 22, 3) * 60;
+      secs -= str[21] == '-' ? -offset : offset;
+   }
 
-		if ( localtime_r ( &secs, &tm_time ) == NULL ) {
-         CMSetStatus(rc, CMPI_RC_ERR_FAILED);
-         return;
-		}
+   return (CMPIUint64) (secs * 1000000LL) + getDigits(str + 15, 6);
+}
 
-		tzset ();
+static void bin2chars(CMPIUint64 msecs, CMPIBoolean interval, CMPIStatus * rc, char *str_time)
+{
+   long long secs, days, usecs;
+   long long year;
+   unsigned int mon, mday;
+   long offset;
+   char *p = str_time;
 
-		snprintf ( us_utc_time, 11, "%6.6ld%+4.3ld", 
-			   usecs, ( daylight != 0 ) * 60 - timezone / 60 );
+   if (interval) {
+      secs = msecs / 1000000ULL;
+      usecs = msecs % 1000000ULL;
+      days = secs / 86400;
+      p = putDigits(p, days, 8);
+      offset = 0;
+   }
 
-		strftime ( str_time, 26, "%Y%m%d%H%M%S.", &tm_time );
+   else {
+      /* times before 1970 have wrapped around */
+      secs = (long long) msecs / 1000000;
+      usecs = (long long) msecs % 1000000;
+      if (usecs < 0) {
+         usecs += 1000000;
+         secs--;
+      }
+      offset = localOffset(secs);
+      secs += offset;
+      days = (secs >= 0 ? secs : secs - 86399) / 86400;
+      civilFromDays(days, &year, &mon, &mday);
+      p = putDigits(p, year, 4);
+      p = putDigits(p, mon, 2);
+      p = putDigits(p, mday, 2);
+   }
 
-		strcat ( str_time, us_utc_time );
-	}
+   secs -= days * 86400;
+   p = putDigits(p, secs / 3600, 2);
+   p = putDigits(p, secs / 60 % 60, 2);
+   p = putDigits(p, secs % 60, 2);
+   *p++ = '.';
+   p = putDigits(p, usecs, 6);
+   if (interval)
+      *p++ = ':';
+   else if (offset < 0) {
+      *p++ = '-';
+      offset = -offset;
+   }
+   else
+      *p++ = '+';
+   p = putDigits(p, offset / 60, 3);
+   *p = 0;
 }
 
 //! Extracts the binary time from the encapsulated CMPIDateTime object.
@@ -23,30 +23,51 @@
 #include "sfcUtil/utilft.h"
 #include "parserUtil.h"
 
-
-static int ct = 0;
-static int dontLex = 0;
+/* not in grammar.h, which cimXmlParser.c includes as well */
+static void multiRspContent(ParserControl *parm, parseUnion *stateUnion);
+static void valueInstanceWithPath(ParserControl *parm, parseUnion *stateUnion);
 
 
+/* unwinds to the parse entry point, like Throw() in cimXmlParser.c */
 static void parseError(char* tokExp, int tokFound, ParserControl *parm)
 {
-	printf("Parse error. Expected token(s) %s, found tag number %d (see cimXmlParser.h) and following xml: %.255s...\nAborting.\n", tokExp, tokFound, parm->xmb->cur+1);
-	exit(0);
+	XmlBuffer *xmb = parm->xmb;
+	char msg[400];
+
+	snprintf(msg, sizeof(msg), "Parse error. Expected token(s) %s, found tag number %d (see cimXmlParser.h) and following xml: %.255s...",
+		tokExp, tokFound, xmb->cur < xmb->last ? xmb->cur+1 : "");
+	xmb->error = strdup(msg);
+	longjmp(*xmb->onError, 1);
 }
 
 
-static int localLex(parseUnion *lvalp, ParserControl *parm)
+/*
+ * The lexer stores the token it finds, which in malformed xml need not be
+ * the one expected and can be larger than the target, so a target that is
+ * a member of the union gets the token through a whole one.
+ */
+static int lexToken(parseUnion *lvalp, size_t size, ParserControl *parm)
 {
-    if(! dontLex) {
-        ct = sfccLex(lvalp, parm);
+    parseUnion token;
+
+    if(! parm->dontLex) {
+        if (size == sizeof(parseUnion))
+            parm->ct = sfccLex(lvalp, parm);
+        else {
+            memcpy(&token, lvalp, size);
+            parm->ct = sfccLex(&token, parm);
+            memcpy(lvalp, &token, size);
+        }
     }
     else {
-        dontLex = 0;
-        return ct;
+        parm->dontLex = 0;
+        return parm->ct;
     }
-    return ct;
+    return parm->ct;
 }
 
+#define localLex(lvalp, parm) lexToken((parseUnion*)(lvalp), sizeof(*(lvalp)), parm)
+
 
 void startParsing(ParserControl *parm)
 {
@@ -54,124 +75,164 @@ void startParsing(ParserControl *parm)
     start(parm, &stateUnion);
 }
 
+/* parse a sequence of IRETURNVALUE elements cut out of a response */
+void startParsingFragment(ParserControl *parm)
+{
+    parseUnion stateUnion;
+    iReturnValueContent(parm, &stateUnion);
+}
+
 static void start(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex(stateUnion, parm);
-	if(ct == XTOK_XML) {
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_XML) {
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_XML) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_XML) {
 			cim(parm, stateUnion);
 		}
 		else {
-			parseError("ZTOK_XML", ct, parm);
+			parseError("ZTOK_XML", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_XML", ct, parm);
+		parseError("XTOK_XML", parm->ct, parm);
 	}
 }
 
 static void cim(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex(stateUnion, parm);
-	if(ct == XTOK_CIM) {
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_CIM) {
 		message(parm, (parseUnion*)&stateUnion->xtokMessage);
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_CIM) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_CIM) {
 		}
 		else {
-			parseError("ZTOK_CIM", ct, parm);
+			parseError("ZTOK_CIM", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_CIM", ct, parm);
+		parseError("XTOK_CIM", parm->ct, parm);
 	}
 }
 
 static void message(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokMessage, parm);
-	if(ct == XTOK_MESSAGE) {
+	parm->ct = localLex(&stateUnion->xtokMessage, parm);
+	if(parm->ct == XTOK_MESSAGE) {
 		messageContent(parm, stateUnion);
-		ct = localLex((parseUnion*)&stateUnion->xtokMessage, parm);
-		if(ct == ZTOK_MESSAGE) {
+		parm->ct = localLex(&stateUnion->xtokMessage, parm);
+		if(parm->ct == ZTOK_MESSAGE) {
 		}
 		else {
-			parseError("ZTOK_MESSAGE", ct, parm);
+			parseError("ZTOK_MESSAGE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_MESSAGE", ct, parm);
+		parseError("XTOK_MESSAGE", parm->ct, parm);
 	}
 }
 
 static void messageContent(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex(stateUnion, parm);
-	if(ct == XTOK_SIMPLERSP) {
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_SIMPLERSP) {
 		simpleRspContent(parm, (parseUnion*)&stateUnion->xtokSimpleRespContent);
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_SIMPLERSP) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_SIMPLERSP) {
+		}
+		else {
+			parseError("ZTOK_SIMPLERSP", parm->ct, parm);
+		}
+	}
+	else if(parm->ct == XTOK_MULTIRSP) {
+		multiRspContent(parm, stateUnion);
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_MULTIRSP) {
 		}
 		else {
-			parseError("ZTOK_SIMPLERSP", ct, parm);
+			parseError("ZTOK_MULTIRSP", parm->ct, parm);
 		}
 	}
-	else if(ct == XTOK_SIMPLEEXPREQ) {
+	else if(parm->ct == XTOK_SIMPLEEXPREQ) {
 		exportIndication(parm, stateUnion);
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_SIMPLEEXPREQ) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_SIMPLEEXPREQ) {
 		}
 		else {
-			parseError("ZTOK_SIMPLEEXPREQ", ct, parm);
+			parseError("ZTOK_SIMPLEEXPREQ", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_SIMPLERSP", ct, parm);
+		parseError("XTOK_SIMPLERSP or XTOK_MULTIRSP", parm->ct, parm);
+	}
+}
+
+static void multiRspContent(ParserControl *parm, parseUnion *stateUnion)
+{
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_SIMPLERSP) {
+		do {
+			memset(&stateUnion->xtokSimpleRespContent, 0, sizeof(XtokSimpleRespContent));
+			simpleRspContent(parm, (parseUnion*)&stateUnion->xtokSimpleRespContent);
+			parm->ct = localLex(stateUnion, parm);
+			if(parm->ct == ZTOK_SIMPLERSP) {
+				addMultiResponse(parm);
+			}
+			else {
+				parseError("ZTOK_SIMPLERSP", parm->ct, parm);
+			}
+			parm->ct = localLex(stateUnion, parm);
+		}
+		while(parm->ct == XTOK_SIMPLERSP);
+		parm->dontLex = 1;
+	}
+	else {
+		parseError("XTOK_SIMPLERSP", parm->ct, parm);
 	}
 }
 
 static void simpleRspContent(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokSimpleRespContent, parm);
-	if(ct == XTOK_METHODRESP) {
+	parm->ct = localLex(&stateUnion->xtokSimpleRespContent, parm);
+	if(parm->ct == XTOK_METHODRESP) {
 		methodRespContent(parm, (parseUnion*)&stateUnion->xtokSimpleRespContent.resp);
 		setReturnArgs(parm, &stateUnion->xtokSimpleRespContent.resp.values);
-		ct = localLex((parseUnion*)&stateUnion->xtokSimpleRespContent, parm);
-		if(ct == ZTOK_METHODRESP) {
+		parm->ct = localLex(&stateUnion->xtokSimpleRespContent, parm);
+		if(parm->ct == ZTOK_METHODRESP) {
 		}
 		else {
-			parseError("ZTOK_METHODRESP", ct, parm);
+			parseError("ZTOK_METHODRESP", parm->ct, parm);
 		}
 	}
-	else if(ct == XTOK_IMETHODRESP) {
+	else if(parm->ct == XTOK_IMETHODRESP) {
 		iMethodRespContent(parm, stateUnion);
-		ct = localLex((parseUnion*)&stateUnion->xtokSimpleRespContent, parm);
-		if(ct == ZTOK_IMETHODRESP) {
+		parm->ct = localLex(&stateUnion->xtokSimpleRespContent, parm);
+		if(parm->ct == ZTOK_IMETHODRESP) {
 		}
 		else {
-			parseError("ZTOK_IMETHODRESP", ct, parm);
+			parseError("ZTOK_IMETHODRESP", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_METHODRESP", ct, parm);
+		parseError("XTOK_METHODRESP", parm->ct, parm);
 	}
 }
 
 static void exportIndication(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex(stateUnion, parm);
-	if(ct == XTOK_EXPORTINDICATION) {
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_EXPORTINDICATION) {
 		exParamValue(parm, stateUnion);
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_EXPMETHODCALL) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_EXPMETHODCALL) {
 		}
 		else {
-			parseError("ZTOK_EXPMETHODCALL", ct, parm);
+			parseError("ZTOK_EXPMETHODCALL", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_EXPORTINDICATION", ct, parm);
+		parseError("XTOK_EXPORTINDICATION", parm->ct, parm);
 	}
 }
 
@@ -179,96 +240,111 @@ static void exParamValue(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp = {0};
 	CMPIInstance *inst;
-	ct = localLex(stateUnion, parm);
-	if(ct == XTOK_EP_INSTANCE) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_INSTANCE) {
-			dontLex = 1;
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_EP_INSTANCE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_INSTANCE) {
+			parm->dontLex = 1;
 			instance(parm, (parseUnion*)&lvalp.xtokInstance);
 			inst = native_new_CMPIInstance(NULL,NULL);
 			setInstNsAndCn(inst,getNameSpaceChars(parm->requestObjectPath),lvalp.xtokInstance.className);
 			setInstProperties(inst, &lvalp.xtokInstance.properties);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&inst,CMPI_instance);
 		}
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_EXPPARAMVALUE) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_EXPPARAMVALUE) {
 		}
 		else {
-			parseError("ZTOK_EXPPARAMVALUE or XTOK_INSTANCE", ct, parm);
+			parseError("ZTOK_EXPPARAMVALUE or XTOK_INSTANCE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_EP_INSTANCE", ct, parm);
+		parseError("XTOK_EP_INSTANCE", parm->ct, parm);
 	}
 }
 
 static void methodRespContent(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex(&lvalp, parm);
-	if(ct == XTOK_ERROR) {
-		dontLex = 1;
+	parm->ct = localLex(&lvalp, parm);
+	if(parm->ct == XTOK_ERROR) {
+		parm->dontLex = 1;
 		error(parm, (parseUnion*)&lvalp.xtokErrorResp);
 	}
-	else if(ct == XTOK_RETVALUE || ct == XTOK_PARAMVALUE) {
-		dontLex = 1;
-		if(ct == XTOK_RETVALUE) {
-			dontLex = 1;
+	else if(parm->ct == XTOK_RETVALUE || parm->ct == XTOK_PARAMVALUE) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_RETVALUE) {
+			parm->dontLex = 1;
 			returnValue(parm, (parseUnion*)&lvalp.xtokReturnValue);
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_PARAMVALUE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PARAMVALUE) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				paramValue(parm, (parseUnion*)&lvalp.xtokParamValue);
 				addParamValue(parm, &stateUnion->xtokMethodRespContent.values, &lvalp.xtokParamValue);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_PARAMVALUE);
-			dontLex = 1;
+			while(parm->ct == XTOK_PARAMVALUE);
+			parm->dontLex = 1;
 		}
 	}
-	else if(ct == ZTOK_METHODRESP) {
-		dontLex = 1;
+	else if(parm->ct == ZTOK_METHODRESP) {
+		parm->dontLex = 1;
 	}
 	else {
-		parseError("XTOK_ERROR or XTOK_RETVALUE or XTOK_PARAMVALUE or ZTOK_METHODRESP", ct, parm);
+		parseError("XTOK_ERROR or XTOK_RETVALUE or XTOK_PARAMVALUE or ZTOK_METHODRESP", parm->ct, parm);
 	}
 }
 
 static void iMethodRespContent(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex(&lvalp, parm);
-	if(ct == XTOK_ERROR) {
-		dontLex = 1;
+	parm->ct = localLex(&lvalp, parm);
+	if(parm->ct == XTOK_ERROR) {
+		parm->dontLex = 1;
 		error(parm, (parseUnion*)&lvalp.xtokErrorResp);
 	}
-	else if(ct == XTOK_IRETVALUE) {
-		dontLex = 1;
-		iReturnValue(parm, stateUnion);
+	else if(parm->ct == XTOK_IRETVALUE || parm->ct == XTOK_PARAMVALUE) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_IRETVALUE) {
+			iReturnValue(parm, stateUnion);
+			parm->ct = localLex(&lvalp, parm);
+			parm->dontLex = 1;
+		}
+		/* output parameters of the pull operations */
+		while(parm->ct == XTOK_PARAMVALUE) {
+			paramValue(parm, (parseUnion*)&lvalp.xtokParamValue);
+			setPullParamValue(parm, &lvalp.xtokParamValue);
+			parm->ct = localLex(&lvalp, parm);
+			parm->dontLex = 1;
+		}
+	}
+	else if(parm->ct == ZTOK_IMETHODRESP) {
+		/* nothing returned, e.g. by CloseEnumeration */
+		parm->dontLex = 1;
 	}
 	else {
-		parseError("XTOK_ERROR or XTOK_IRETVALUE", ct, parm);
+		parseError("XTOK_ERROR or XTOK_IRETVALUE or XTOK_PARAMVALUE or ZTOK_IMETHODRESP", parm->ct, parm);
 	}
 }
 
 static void error(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokErrorResp, parm);
-	if(ct == XTOK_ERROR) {
+	parm->ct = localLex(&stateUnion->xtokErrorResp, parm);
+	if(parm->ct == XTOK_ERROR) {
 		setError(parm, &stateUnion->xtokErrorResp);
-		ct = localLex((parseUnion*)&stateUnion->xtokErrorResp, parm);
-		if(ct == ZTOK_ERROR) {
+		parm->ct = localLex(&stateUnion->xtokErrorResp, parm);
+		if(parm->ct == ZTOK_ERROR) {
 		}
 		else {
-			parseError("ZTOK_ERROR", ct, parm);
+			parseError("ZTOK_ERROR", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_ERROR", ct, parm);
+		parseError("XTOK_ERROR", parm->ct, parm);
 	}
 }
 
@@ -277,8 +353,8 @@ static void returnValue(ParserControl *parm, parseUnion *stateUnion)
 	CMPIType  t;
 	CMPIValue val;
 	CMPIInstance *inst;
-	ct = localLex((parseUnion*)&stateUnion->xtokReturnValue, parm);
-	if(ct == XTOK_RETVALUE) {
+	parm->ct = localLex(&stateUnion->xtokReturnValue, parm);
+	if(parm->ct == XTOK_RETVALUE) {
 		returnValueData(parm, (parseUnion*)&stateUnion->xtokReturnValue.data);
 		if(stateUnion->xtokReturnValue.data.type == CMPI_ref) {
 			t = CMPI_ref;
@@ -299,44 +375,44 @@ static void returnValue(ParserControl *parm, parseUnion *stateUnion)
 			val = str2CMPIValue(t, stateUnion->xtokReturnValue.data.value.data.value, NULL);
 		}
 		simpleArrayAdd(parm->respHdr.rvArray, (CMPIValue*)&val, t);
-		ct = localLex((parseUnion*)&stateUnion->xtokReturnValue, parm);
-		if(ct == ZTOK_RETVALUE) {
+		parm->ct = localLex(&stateUnion->xtokReturnValue, parm);
+		if(parm->ct == ZTOK_RETVALUE) {
 		}
 		else {
-			parseError("ZTOK_RETVALUE", ct, parm);
+			parseError("ZTOK_RETVALUE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_RETVALUE", ct, parm);
+		parseError("XTOK_RETVALUE", parm->ct, parm);
 	}
 }
 
 static void returnValueData(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokReturnValueData, parm);
-	if(ct == XTOK_VALUE) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokReturnValueData, parm);
+	if(parm->ct == XTOK_VALUE) {
+		parm->dontLex = 1;
 		value(parm, (parseUnion*)&stateUnion->xtokReturnValueData.value);
 	}
-	else if(ct == XTOK_VALUEREFERENCE) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEREFERENCE) {
+		parm->dontLex = 1;
 		valueReference(parm, (parseUnion*)&stateUnion->xtokReturnValueData.ref);
 		stateUnion->xtokReturnValueData.type = CMPI_ref;
 	}
 	else {
-		parseError("XTOK_VALUE or XTOK_VALUEREFERENCE", ct, parm);
+		parseError("XTOK_VALUE or XTOK_VALUEREFERENCE", parm->ct, parm);
 	}
 }
 
 static void paramValue(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokParamValue, parm);
-	if(ct == XTOK_PARAMVALUE) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUE || ct == XTOK_VALUEREFERENCE || ct == XTOK_VALUEARRAY || ct == XTOK_VALUEREFARRAY) {
-			dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokParamValue, parm);
+	if(parm->ct == XTOK_PARAMVALUE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUE || parm->ct == XTOK_VALUEREFERENCE || parm->ct == XTOK_VALUEARRAY || parm->ct == XTOK_VALUEREFARRAY) {
+			parm->dontLex = 1;
 			paramValueData(parm, (parseUnion*)&lvalp.xtokParamValueData);
 			stateUnion->xtokParamValue.data = lvalp.xtokParamValueData;
 			if(lvalp.xtokParamValueData.type == CMPI_instance) {
@@ -346,62 +422,62 @@ static void paramValue(ParserControl *parm, parseUnion *stateUnion)
 				stateUnion->xtokParamValue.type |= lvalp.xtokParamValueData.type;
 			}
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokParamValue, parm);
-		if(ct == ZTOK_PARAMVALUE) {
+		parm->ct = localLex(&stateUnion->xtokParamValue, parm);
+		if(parm->ct == ZTOK_PARAMVALUE) {
 		}
 		else {
-			parseError("ZTOK_PARAMVALUE or XTOK_VALUE or XTOK_VALUEREFERENCE or XTOK_VALUEARRAY or XTOK_VALUEREFARRAY", ct, parm);
+			parseError("ZTOK_PARAMVALUE or XTOK_VALUE or XTOK_VALUEREFERENCE or XTOK_VALUEARRAY or XTOK_VALUEREFARRAY", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PARAMVALUE", ct, parm);
+		parseError("XTOK_PARAMVALUE", parm->ct, parm);
 	}
 }
 
 static void paramValueData(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokParamValueData, parm);
-	if(ct == XTOK_VALUE) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokParamValueData, parm);
+	if(parm->ct == XTOK_VALUE) {
+		parm->dontLex = 1;
 		value(parm, (parseUnion*)&stateUnion->xtokParamValueData.value);
 		if(stateUnion->xtokParamValueData.value.type == typeValue_Instance) {
 			stateUnion->xtokParamValueData.type = CMPI_instance;
 		}
 	}
-	else if(ct == XTOK_VALUEREFERENCE) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEREFERENCE) {
+		parm->dontLex = 1;
 		valueReference(parm, (parseUnion*)&stateUnion->xtokParamValueData.valueRef);
 		stateUnion->xtokParamValueData.type = CMPI_ref;
 	}
-	else if(ct == XTOK_VALUEARRAY) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEARRAY) {
+		parm->dontLex = 1;
 		valueArray(parm, (parseUnion*)&stateUnion->xtokParamValueData.valueArray);
 		stateUnion->xtokParamValueData.type |= CMPI_ARRAY;
 	}
-	else if(ct == XTOK_VALUEREFARRAY) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEREFARRAY) {
+		parm->dontLex = 1;
 		valueRefArray(parm, (parseUnion*)&stateUnion->xtokParamValueData.valueRefArray);
 		stateUnion->xtokParamValueData.type = CMPI_refA;
 	}
 	else {
-		parseError("XTOK_VALUE or XTOK_VALUEREFERENCE or XTOK_VALUEARRAY or XTOK_VALUEREFARRAY", ct, parm);
+		parseError("XTOK_VALUE or XTOK_VALUEREFERENCE or XTOK_VALUEARRAY or XTOK_VALUEREFARRAY", parm->ct, parm);
 	}
 }
 
 static void iReturnValue(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex(stateUnion, parm);
-	if(ct == XTOK_IRETVALUE) {
+	parm->ct = localLex(stateUnion, parm);
+	if(parm->ct == XTOK_IRETVALUE) {
 		iReturnValueContent(parm, stateUnion);
-		ct = localLex(stateUnion, parm);
-		if(ct == ZTOK_IRETVALUE) {
+		parm->ct = localLex(stateUnion, parm);
+		if(parm->ct == ZTOK_IRETVALUE) {
 		}
 		else {
-			parseError("ZTOK_IRETVALUE", ct, parm);
+			parseError("ZTOK_IRETVALUE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_IRETVALUE", ct, parm);
+		parseError("XTOK_IRETVALUE", parm->ct, parm);
 	}
 }
 
@@ -411,60 +487,65 @@ static void iReturnValueContent(ParserControl *parm, parseUnion *stateUnion)
 	CMPIObjectPath *op;
 	CMPIInstance *inst;
 	CMPIConstClass *cls;
-	ct = localLex(&lvalp, parm);
-	dontLex = 1;
-	if(ct == XTOK_CLASS) {
+	parm->ct = localLex(&lvalp, parm);
+	parm->dontLex = 1;
+	if(parm->ct == XTOK_CLASS) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			class(parm, (parseUnion*)&lvalp.xtokClass);
 			cls = native_new_CMPIConstClass(lvalp.xtokClass.className,NULL);
 			setClassQualifiers(cls, &lvalp.xtokClass.qualifiers);
 			setClassProperties(cls, &lvalp.xtokClass.properties);
 			setClassMethods(cls, &lvalp.xtokClass.methods);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&cls,CMPI_class);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_CLASS);
-		dontLex = 1;
+		while(parm->ct == XTOK_CLASS);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_CLASSNAME) {
+	else if(parm->ct == XTOK_CLASSNAME) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			className(parm, (parseUnion*)&lvalp.xtokClassName);
 			op = newCMPIObjectPath(NULL, lvalp.xtokClassName.value, NULL);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&op,CMPI_ref);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_CLASSNAME);
-		dontLex = 1;
+		while(parm->ct == XTOK_CLASSNAME);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_INSTANCE) {
+	else if(parm->ct == XTOK_INSTANCE) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			instance(parm, (parseUnion*)&lvalp.xtokInstance);
 			inst = native_new_CMPIInstance(parm->requestObjectPath,NULL);
 			setInstProperties(inst, &lvalp.xtokInstance.properties);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&inst,CMPI_instance);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_INSTANCE);
-		dontLex = 1;
+		while(parm->ct == XTOK_INSTANCE);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_INSTANCENAME) {
+	else if(parm->ct == XTOK_INSTANCENAME) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			instanceName(parm, (parseUnion*)&lvalp.xtokInstanceName);
 			createPath(&op, &lvalp.xtokInstanceName);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&op,CMPI_ref);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_INSTANCENAME);
-		dontLex = 1;
+		while(parm->ct == XTOK_INSTANCENAME);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_VALUENAMEDINSTANCE) {
+	else if(parm->ct == XTOK_VALUENAMEDINSTANCE) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			valueNamedInstance(parm, (parseUnion*)&lvalp.xtokNamedInstance);
+			if (parm->table) {
+				addTableRow(parm->table, &lvalp.xtokNamedInstance);
+				parm->ct = localLex(&lvalp, parm);
+				continue;
+			}
 			createPath(&op,&(lvalp.xtokNamedInstance.path));
 			CMSetNameSpace(op, getNameSpaceChars(parm->requestObjectPath));
 			inst = native_new_CMPIInstance(op,NULL);
@@ -472,45 +553,67 @@ static void iReturnValueContent(ParserControl *parm, parseUnion *stateUnion)
 			//setInstQualifiers(inst, &lvalp.xtokNamedInstance.instance.qualifiers);
 			setInstProperties(inst, &lvalp.xtokNamedInstance.instance.properties);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&inst,CMPI_instance);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_VALUENAMEDINSTANCE);
-		dontLex = 1;
+		while(parm->ct == XTOK_VALUENAMEDINSTANCE);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_OBJECTPATH) {
+	else if(parm->ct == XTOK_OBJECTPATH) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			objectPath(parm, (parseUnion*)&lvalp.xtokObjectPath);
 			createPath(&op, &lvalp.xtokObjectPath.path.instanceName);
 			CMSetNameSpace(op, lvalp.xtokObjectPath.path.path.nameSpacePath.value);
 			CMSetHostname(op, lvalp.xtokObjectPath.path.path.host.host);
 			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&op,CMPI_ref);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_OBJECTPATH);
-		dontLex = 1;
+		while(parm->ct == XTOK_OBJECTPATH);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_VALUEOBJECTWITHPATH) {
+	else if(parm->ct == XTOK_VALUEOBJECTWITHPATH) {
 		do {
-			dontLex = 1;
+			parm->dontLex = 1;
 			valueObjectWithPath(parm, (parseUnion*)&lvalp.xtokObjectWithPath);
-			ct = localLex(&lvalp, parm);
+			parm->ct = localLex(&lvalp, parm);
+		}
+		while(parm->ct == XTOK_VALUEOBJECTWITHPATH);
+		parm->dontLex = 1;
+	}
+	else if(parm->ct == XTOK_VALUEINSTANCEWITHPATH) {
+		do {
+			parm->dontLex = 1;
+			valueInstanceWithPath(parm, (parseUnion*)&lvalp.xtokInstanceWithPath);
+			parm->ct = localLex(&lvalp, parm);
 		}
-		while(ct == XTOK_VALUEOBJECTWITHPATH);
-		dontLex = 1;
+		while(parm->ct == XTOK_VALUEINSTANCEWITHPATH);
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_VALUE || ct == XTOK_VALUEARRAY || ct == XTOK_VALUEREFERENCE) {
-		dontLex = 1;
-		if(ct == XTOK_VALUE || ct == XTOK_VALUEARRAY || ct == XTOK_VALUEREFERENCE) {
-			dontLex = 1;
+	else if(parm->ct == XTOK_INSTANCEPATH) {
+		do {
+			parm->dontLex = 1;
+			instancePath(parm, (parseUnion*)&lvalp.xtokInstancePath);
+			createPath(&op, &lvalp.xtokInstancePath.instanceName);
+			CMSetNameSpace(op, lvalp.xtokInstancePath.path.nameSpacePath.value);
+			CMSetHostname(op, lvalp.xtokInstancePath.path.host.host);
+			simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&op,CMPI_ref);
+			parm->ct = localLex(&lvalp, parm);
+		}
+		while(parm->ct == XTOK_INSTANCEPATH);
+		parm->dontLex = 1;
+	}
+	else if(parm->ct == XTOK_VALUE || parm->ct == XTOK_VALUEARRAY || parm->ct == XTOK_VALUEREFERENCE) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUE || parm->ct == XTOK_VALUEARRAY || parm->ct == XTOK_VALUEREFERENCE) {
+			parm->dontLex = 1;
 			getPropertyRetValue(parm, (parseUnion*)&lvalp.xtokGetPropRetContent);
 		}
 	}
-	else if(ct == ZTOK_IRETVALUE) {
-		dontLex = 1;
+	else if(parm->ct == ZTOK_IRETVALUE) {
+		parm->dontLex = 1;
 	}
 	else {
-		parseError("XTOK_CLASS or XTOK_CLASSNAME or XTOK_INSTANCE or XTOK_INSTANCENAME or XTOK_VALUENAMEDINSTANCE or XTOK_OBJECTPATH or XTOK_VALUEOBJECTWITHPATH or XTOK_VALUE or ZTOK_IRETVALUE", ct, parm);
+		parseError("XTOK_CLASS or XTOK_CLASSNAME or XTOK_INSTANCE or XTOK_INSTANCENAME or XTOK_VALUENAMEDINSTANCE or XTOK_OBJECTPATH or XTOK_VALUEOBJECTWITHPATH or XTOK_VALUEINSTANCEWITHPATH or XTOK_INSTANCEPATH or XTOK_VALUE or ZTOK_IRETVALUE", parm->ct, parm);
 	}
 }
 
@@ -518,42 +621,42 @@ static void getPropertyRetValue(ParserControl *parm, parseUnion *stateUnion)
 {
 	CMPIType  t;
 	CMPIValue val;
-	ct = localLex((parseUnion*)&stateUnion->xtokGetPropRetContent, parm);
-	if(ct == XTOK_VALUE) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokGetPropRetContent, parm);
+	if(parm->ct == XTOK_VALUE) {
+		parm->dontLex = 1;
 		value(parm, (parseUnion*)&stateUnion->xtokGetPropRetContent.value);
 		t   = guessType(stateUnion->xtokGetPropRetContent.value.data.value);
 		val = str2CMPIValue(t, stateUnion->xtokGetPropRetContent.value.data.value, NULL);
 		simpleArrayAdd(parm->respHdr.rvArray, (CMPIValue*)&val, t);
 	}
-	else if(ct == XTOK_VALUEARRAY) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEARRAY) {
+		parm->dontLex = 1;
 		valueArray(parm, (parseUnion*)&stateUnion->xtokGetPropRetContent.arr);
 	}
-	else if(ct == XTOK_VALUEREFERENCE) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEREFERENCE) {
+		parm->dontLex = 1;
 		valueReference(parm, (parseUnion*)&stateUnion->xtokGetPropRetContent.ref);
 	}
 	else {
-		parseError("XTOK_VALUE or XTOK_VALUEARRAY or XTOK_VALUEREFERENCE", ct, parm);
+		parseError("XTOK_VALUE or XTOK_VALUEARRAY or XTOK_VALUEREFERENCE", parm->ct, parm);
 	}
 }
 
 static void valueObjectWithPath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokObjectWithPath, parm);
-	if(ct == XTOK_VALUEOBJECTWITHPATH) {
+	parm->ct = localLex(&stateUnion->xtokObjectWithPath, parm);
+	if(parm->ct == XTOK_VALUEOBJECTWITHPATH) {
 		valueObjectWithPathData(parm, (parseUnion*)&stateUnion->xtokObjectWithPath.object);
 		stateUnion->xtokObjectWithPath.type = stateUnion->xtokObjectWithPath.object.type;
-		ct = localLex((parseUnion*)&stateUnion->xtokObjectWithPath, parm);
-		if(ct == ZTOK_VALUEOBJECTWITHPATH) {
+		parm->ct = localLex(&stateUnion->xtokObjectWithPath, parm);
+		if(parm->ct == ZTOK_VALUEOBJECTWITHPATH) {
 		}
 		else {
-			parseError("ZTOK_VALUEOBJECTWITHPATH", ct, parm);
+			parseError("ZTOK_VALUEOBJECTWITHPATH", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_VALUEOBJECTWITHPATH", ct, parm);
+		parseError("XTOK_VALUEOBJECTWITHPATH", parm->ct, parm);
 	}
 }
 
@@ -561,14 +664,14 @@ static void valueObjectWithPathData(ParserControl *parm, parseUnion *stateUnion)
 {
 	CMPIObjectPath *op = NULL;
 	CMPIInstance *inst;
-	ct = localLex((parseUnion*)&stateUnion->xtokObjectWithPathData, parm);
-	if(ct == XTOK_CLASSPATH) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokObjectWithPathData, parm);
+	if(parm->ct == XTOK_CLASSPATH) {
+		parm->dontLex = 1;
 		classWithPath(parm, (parseUnion*)&stateUnion->xtokObjectWithPathData.cls);
 		stateUnion->xtokObjectWithPathData.type = 1;
 	}
-	else if(ct == XTOK_INSTANCEPATH) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_INSTANCEPATH) {
+		parm->dontLex = 1;
 		instanceWithPath(parm, (parseUnion*)&stateUnion->xtokObjectWithPathData.inst);
 		stateUnion->xtokObjectWithPathData.type = 0;
 		createPath(&op, &stateUnion->xtokObjectWithPathData.inst.path.instanceName);
@@ -581,409 +684,436 @@ static void valueObjectWithPathData(ParserControl *parm, parseUnion *stateUnion)
 		if (op) op->ft->release(op);
 	}
 	else {
-		parseError("XTOK_CLASSPATH or XTOK_INSTANCEPATH", ct, parm);
+		parseError("XTOK_CLASSPATH or XTOK_INSTANCEPATH", parm->ct, parm);
 	}
 }
 
 static void classWithPath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokClassWithPath, parm);
-	if(ct == XTOK_CLASSPATH) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokClassWithPath, parm);
+	if(parm->ct == XTOK_CLASSPATH) {
+		parm->dontLex = 1;
 		classPath(parm, (parseUnion*)&stateUnion->xtokClassWithPath.path);
 		class(parm, (parseUnion*)&stateUnion->xtokClassWithPath.cls);
 	}
 	else {
-		parseError("XTOK_CLASSPATH or XTOK_CLASS", ct, parm);
+		parseError("XTOK_CLASSPATH or XTOK_CLASS", parm->ct, parm);
 	}
 }
 
 static void instanceWithPath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokInstanceWithPath, parm);
-	if(ct == XTOK_INSTANCEPATH) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokInstanceWithPath, parm);
+	if(parm->ct == XTOK_INSTANCEPATH) {
+		parm->dontLex = 1;
 		instancePath(parm, (parseUnion*)&stateUnion->xtokInstanceWithPath.path);
 		instance(parm, (parseUnion*)&stateUnion->xtokInstanceWithPath.inst);
 	}
 	else {
-		parseError("XTOK_INSTANCEPATH or XTOK_INSTANCE", ct, parm);
+		parseError("XTOK_INSTANCEPATH or XTOK_INSTANCE", parm->ct, parm);
+	}
+}
+
+static void valueInstanceWithPath(ParserControl *parm, parseUnion *stateUnion)
+{
+	CMPIObjectPath *op = NULL;
+	CMPIInstance *inst;
+	parm->ct = localLex(&stateUnion->xtokInstanceWithPath, parm);
+	if(parm->ct == XTOK_VALUEINSTANCEWITHPATH) {
+		instanceWithPath(parm, stateUnion);
+		createPath(&op, &stateUnion->xtokInstanceWithPath.path.instanceName);
+		CMSetNameSpace(op, stateUnion->xtokInstanceWithPath.path.path.nameSpacePath.value);
+		CMSetHostname(op, stateUnion->xtokInstanceWithPath.path.path.host.host);
+		inst = native_new_CMPIInstance(op,NULL);
+		setInstQualifiers(inst, &stateUnion->xtokInstanceWithPath.inst.qualifiers);
+		setInstProperties(inst, &stateUnion->xtokInstanceWithPath.inst.properties);
+		simpleArrayAdd(parm->respHdr.rvArray,(CMPIValue*)&inst,CMPI_instance);
+		if (op) op->ft->release(op);
+		parm->ct = localLex(&stateUnion->xtokInstanceWithPath, parm);
+		if(parm->ct == ZTOK_VALUEINSTANCEWITHPATH) {
+		}
+		else {
+			parseError("ZTOK_VALUEINSTANCEWITHPATH", parm->ct, parm);
+		}
+	}
+	else {
+		parseError("XTOK_VALUEINSTANCEWITHPATH", parm->ct, parm);
 	}
 }
 
 static void class(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokClass, parm);
-	if(ct == XTOK_CLASS) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokClass, parm);
+	if(parm->ct == XTOK_CLASS) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
 				addQualifier(parm,&stateUnion->xtokClass.qualifiers,&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_PROPERTY || ct == XTOK_PROPERTYARRAY || ct == XTOK_PROPERTYREFERENCE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PROPERTY || parm->ct == XTOK_PROPERTYARRAY || parm->ct == XTOK_PROPERTYREFERENCE) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				genProperty(parm, (parseUnion*)&lvalp.xtokProperty);
 				addProperty(parm,&stateUnion->xtokClass.properties,&lvalp.xtokProperty);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_PROPERTY || ct == XTOK_PROPERTYARRAY || ct == XTOK_PROPERTYREFERENCE);
-			dontLex = 1;
+			while(parm->ct == XTOK_PROPERTY || parm->ct == XTOK_PROPERTYARRAY || parm->ct == XTOK_PROPERTYREFERENCE);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_METHOD) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_METHOD) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				method(parm, (parseUnion*)&lvalp.xtokMethod);
 				addMethod(parm,&stateUnion->xtokClass.methods,&lvalp.xtokMethod);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_METHOD);
-			dontLex = 1;
+			while(parm->ct == XTOK_METHOD);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokClass, parm);
-		if(ct == ZTOK_CLASS) {
+		parm->ct = localLex(&stateUnion->xtokClass, parm);
+		if(parm->ct == ZTOK_CLASS) {
 		}
 		else {
-			parseError("ZTOK_CLASS or XTOK_METHOD or XTOK_PROPERTY or XTOK_PROPERTYARRAY or XTOK_PROPERTYREFERENCE or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_CLASS or XTOK_METHOD or XTOK_PROPERTY or XTOK_PROPERTYARRAY or XTOK_PROPERTYREFERENCE or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_CLASS", ct, parm);
+		parseError("XTOK_CLASS", parm->ct, parm);
 	}
 }
 
 static void method(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokMethod, parm);
-	if(ct == XTOK_METHOD) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokMethod, parm);
+	if(parm->ct == XTOK_METHOD) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
 				addQualifier(parm,&stateUnion->xtokMethod.qualifiers,&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_PARAM || ct == XTOK_PARAMREF || ct == XTOK_PARAMARRAY || ct == XTOK_PARAMREFARRAY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PARAM || parm->ct == XTOK_PARAMREF || parm->ct == XTOK_PARAMARRAY || parm->ct == XTOK_PARAMREFARRAY) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				methodData(parm, (parseUnion*)&lvalp.xtokMethodData);
 				addParam(parm,&stateUnion->xtokMethod.params,&lvalp.xtokParam);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_PARAM || ct == XTOK_PARAMREF || ct == XTOK_PARAMARRAY || ct == XTOK_PARAMREFARRAY);
-			dontLex = 1;
+			while(parm->ct == XTOK_PARAM || parm->ct == XTOK_PARAMREF || parm->ct == XTOK_PARAMARRAY || parm->ct == XTOK_PARAMREFARRAY);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokMethod, parm);
-		if(ct == ZTOK_METHOD) {
+		parm->ct = localLex(&stateUnion->xtokMethod, parm);
+		if(parm->ct == ZTOK_METHOD) {
 		}
 		else {
-			parseError("ZTOK_METHOD or XTOK_PARAM or XTOK_PARAMREF or XTOK_PARAMARRAY or XTOK_PARAMREFARRAY or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_METHOD or XTOK_PARAM or XTOK_PARAMREF or XTOK_PARAMARRAY or XTOK_PARAMREFARRAY or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_METHOD", ct, parm);
+		parseError("XTOK_METHOD", parm->ct, parm);
 	}
 }
 
 static void methodData(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	if(ct == XTOK_PARAM) {
-		dontLex = 1;
-		if(ct == XTOK_PARAM) {
-			dontLex = 1;
+	if(parm->ct == XTOK_PARAM) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PARAM) {
+			parm->dontLex = 1;
 			parameter(parm, (parseUnion*)&lvalp.xtokParam);
 		}
 	}
-	else if(ct == XTOK_PARAMREF) {
-		dontLex = 1;
-		if(ct == XTOK_PARAMREF) {
-			dontLex = 1;
+	else if(parm->ct == XTOK_PARAMREF) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PARAMREF) {
+			parm->dontLex = 1;
 			parameterReference(parm, (parseUnion*)&lvalp.xtokParam);
 		}
 	}
-	else if(ct == XTOK_PARAMARRAY) {
-		dontLex = 1;
-		if(ct == XTOK_PARAMARRAY) {
-			dontLex = 1;
+	else if(parm->ct == XTOK_PARAMARRAY) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PARAMARRAY) {
+			parm->dontLex = 1;
 			parameterArray(parm, (parseUnion*)&lvalp.xtokParam);
 		}
 	}
-	else if(ct == XTOK_PARAMREFARRAY) {
-		dontLex = 1;
-		if(ct == XTOK_PARAMREFARRAY) {
-			dontLex = 1;
+	else if(parm->ct == XTOK_PARAMREFARRAY) {
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PARAMREFARRAY) {
+			parm->dontLex = 1;
 			parameterRefArray(parm, (parseUnion*)&lvalp.xtokParam);
 		}
 	}
 	else {
-		parseError("XTOK_PARAM or XTOK_PARAMREF or XTOK_PARAMARRAY or XTOK_PARAMREFARRAY", ct, parm);
+		parseError("XTOK_PARAM or XTOK_PARAMREF or XTOK_PARAMARRAY or XTOK_PARAMREFARRAY", parm->ct, parm);
 	}
 }
 
 static void parameter(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-	if(ct == XTOK_PARAM) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokParam, parm);
+	if(parm->ct == XTOK_PARAM) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-		if(ct == ZTOK_PARAM) {
+		parm->ct = localLex(&stateUnion->xtokParam, parm);
+		if(parm->ct == ZTOK_PARAM) {
 		}
 		else {
-			parseError("ZTOK_PARAM or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PARAM or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PARAM", ct, parm);
+		parseError("XTOK_PARAM", parm->ct, parm);
 	}
 }
 
 static void parameterReference(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-	if(ct == XTOK_PARAMREF) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokParam, parm);
+	if(parm->ct == XTOK_PARAMREF) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-		if(ct == ZTOK_PARAMREF) {
+		parm->ct = localLex(&stateUnion->xtokParam, parm);
+		if(parm->ct == ZTOK_PARAMREF) {
 		}
 		else {
-			parseError("ZTOK_PARAMREF or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PARAMREF or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PARAMREF", ct, parm);
+		parseError("XTOK_PARAMREF", parm->ct, parm);
 	}
 }
 
 static void parameterRefArray(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-	if(ct == XTOK_PARAMREFARRAY) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokParam, parm);
+	if(parm->ct == XTOK_PARAMREFARRAY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-		if(ct == ZTOK_PARAMREFARRAY) {
+		parm->ct = localLex(&stateUnion->xtokParam, parm);
+		if(parm->ct == ZTOK_PARAMREFARRAY) {
 		}
 		else {
-			parseError("ZTOK_PARAMREFARRAY or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PARAMREFARRAY or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PARAMREFARRAY", ct, parm);
+		parseError("XTOK_PARAMREFARRAY", parm->ct, parm);
 	}
 }
 
 static void parameterArray(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-	if(ct == XTOK_PARAMARRAY) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokParam, parm);
+	if(parm->ct == XTOK_PARAMARRAY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokParam, parm);
-		if(ct == ZTOK_PARAMARRAY) {
+		parm->ct = localLex(&stateUnion->xtokParam, parm);
+		if(parm->ct == ZTOK_PARAMARRAY) {
 		}
 		else {
-			parseError("ZTOK_PARAMARRAY or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PARAMARRAY or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PARAMARRAY", ct, parm);
+		parseError("XTOK_PARAMARRAY", parm->ct, parm);
 	}
 }
 
 static void objectPath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokObjectPath, parm);
-	if(ct == XTOK_OBJECTPATH) {
+	parm->ct = localLex(&stateUnion->xtokObjectPath, parm);
+	if(parm->ct == XTOK_OBJECTPATH) {
 		instancePath(parm, (parseUnion*)&stateUnion->xtokObjectPath.path);
-		ct = localLex((parseUnion*)&stateUnion->xtokObjectPath, parm);
-		if(ct == ZTOK_OBJECTPATH) {
+		parm->ct = localLex(&stateUnion->xtokObjectPath, parm);
+		if(parm->ct == ZTOK_OBJECTPATH) {
 		}
 		else {
-			parseError("ZTOK_OBJECTPATH", ct, parm);
+			parseError("ZTOK_OBJECTPATH", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_OBJECTPATH", ct, parm);
+		parseError("XTOK_OBJECTPATH", parm->ct, parm);
 	}
 }
 
 static void classPath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokClassPath, parm);
-	if(ct == XTOK_CLASSPATH) {
+	parm->ct = localLex(&stateUnion->xtokClassPath, parm);
+	if(parm->ct == XTOK_CLASSPATH) {
 		nameSpacePath(parm, (parseUnion*)&stateUnion->xtokClassPath.name);
 		className(parm, (parseUnion*)&stateUnion->xtokClassPath.className);
-		ct = localLex((parseUnion*)&stateUnion->xtokClassPath, parm);
-		if(ct == ZTOK_CLASSPATH) {
+		parm->ct = localLex(&stateUnion->xtokClassPath, parm);
+		if(parm->ct == ZTOK_CLASSPATH) {
 		}
 		else {
-			parseError("ZTOK_CLASSPATH", ct, parm);
+			parseError("ZTOK_CLASSPATH", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_CLASSPATH", ct, parm);
+		parseError("XTOK_CLASSPATH", parm->ct, parm);
 	}
 }
 
 static void className(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokClassName, parm);
-	if(ct == XTOK_CLASSNAME) {
-		ct = localLex((parseUnion*)&stateUnion->xtokClassName, parm);
-		if(ct == ZTOK_CLASSNAME) {
+	parm->ct = localLex(&stateUnion->xtokClassName, parm);
+	if(parm->ct == XTOK_CLASSNAME) {
+		parm->ct = localLex(&stateUnion->xtokClassName, parm);
+		if(parm->ct == ZTOK_CLASSNAME) {
 		}
 		else {
-			parseError("ZTOK_CLASSNAME", ct, parm);
+			parseError("ZTOK_CLASSNAME", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_CLASSNAME", ct, parm);
+		parseError("XTOK_CLASSNAME", parm->ct, parm);
 	}
 }
 
 static void instancePath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokInstancePath, parm);
-	if(ct == XTOK_INSTANCEPATH) {
+	parm->ct = localLex(&stateUnion->xtokInstancePath, parm);
+	if(parm->ct == XTOK_INSTANCEPATH) {
 		nameSpacePath(parm, (parseUnion*)&stateUnion->xtokInstancePath.path);
 		instanceName(parm, (parseUnion*)&stateUnion->xtokInstancePath.instanceName);
-		ct = localLex((parseUnion*)&stateUnion->xtokInstancePath, parm);
-		if(ct == ZTOK_INSTANCEPATH) {
+		parm->ct = localLex(&stateUnion->xtokInstancePath, parm);
+		if(parm->ct == ZTOK_INSTANCEPATH) {
 		}
 		else {
-			parseError("ZTOK_INSTANCEPATH", ct, parm);
+			parseError("ZTOK_INSTANCEPATH", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_INSTANCEPATH", ct, parm);
+		parseError("XTOK_INSTANCEPATH", parm->ct, parm);
 	}
 }
 
 static void localInstancePath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokLocalInstancePath, parm);
-	if(ct == XTOK_LOCALINSTANCEPATH) {
+	parm->ct = localLex(&stateUnion->xtokLocalInstancePath, parm);
+	if(parm->ct == XTOK_LOCALINSTANCEPATH) {
 		localNameSpacePath(parm, (parseUnion*)&stateUnion->xtokLocalInstancePath.path);
 		instanceName(parm, (parseUnion*)&stateUnion->xtokLocalInstancePath.instanceName);
-		ct = localLex((parseUnion*)&stateUnion->xtokLocalInstancePath, parm);
-		if(ct == ZTOK_LOCALINSTANCEPATH) {
+		parm->ct = localLex(&stateUnion->xtokLocalInstancePath, parm);
+		if(parm->ct == ZTOK_LOCALINSTANCEPATH) {
 		}
 		else {
-			parseError("ZTOK_LOCALINSTANCEPATH", ct, parm);
+			parseError("ZTOK_LOCALINSTANCEPATH", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_LOCALINSTANCEPATH", ct, parm);
+		parseError("XTOK_LOCALINSTANCEPATH", parm->ct, parm);
 	}
 }
 
 static void nameSpacePath(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokNameSpacePath, parm);
-	if(ct == XTOK_NAMESPACEPATH) {
+	parm->ct = localLex(&stateUnion->xtokNameSpacePath, parm);
+	if(parm->ct == XTOK_NAMESPACEPATH) {
 		host(parm, (parseUnion*)&stateUnion->xtokNameSpacePath.host);
 		localNameSpacePath(parm, (parseUnion*)&stateUnion->xtokNameSpacePath.nameSpacePath);
-		ct = localLex((parseUnion*)&stateUnion->xtokNameSpacePath, parm);
-		if(ct == ZTOK_NAMESPACEPATH) {
+		parm->ct = localLex(&stateUnion->xtokNameSpacePath, parm);
+		if(parm->ct == ZTOK_NAMESPACEPATH) {
 		}
 		else {
-			parseError("ZTOK_NAMESPACEPATH", ct, parm);
+			parseError("ZTOK_NAMESPACEPATH", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_NAMESPACEPATH", ct, parm);
+		parseError("XTOK_NAMESPACEPATH", parm->ct, parm);
 	}
 }
 
 static void host(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokHost, parm);
-	if(ct == XTOK_HOST) {
-		ct = localLex((parseUnion*)&stateUnion->xtokHost, parm);
-		if(ct == ZTOK_HOST) {
+	parm->ct = localLex(&stateUnion->xtokHost, parm);
+	if(parm->ct == XTOK_HOST) {
+		parm->ct = localLex(&stateUnion->xtokHost, parm);
+		if(parm->ct == ZTOK_HOST) {
 		}
 		else {
-			parseError("ZTOK_HOST", ct, parm);
+			parseError("ZTOK_HOST", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_HOST", ct, parm);
+		parseError("XTOK_HOST", parm->ct, parm);
 	}
 }
 
 static void localNameSpacePath(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokLocalNameSpacePath, parm);
-	if(ct == XTOK_LOCALNAMESPACEPATH) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_NAMESPACE) {
+	parm->ct = localLex(&stateUnion->xtokLocalNameSpacePath, parm);
+	if(parm->ct == XTOK_LOCALNAMESPACEPATH) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_NAMESPACE) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				nameSpace(parm, (parseUnion*)&lvalp.xtokNameSpace);
 				if(stateUnion->xtokLocalNameSpacePath.value) {
 					stateUnion->xtokLocalNameSpacePath.value = parser_realloc(parm->heap, stateUnion->xtokLocalNameSpacePath.value, strlen(stateUnion->xtokLocalNameSpacePath.value) + strlen(lvalp.xtokNameSpace.ns) + 2);
@@ -994,500 +1124,500 @@ static void localNameSpacePath(ParserControl *parm, parseUnion *stateUnion)
 					stateUnion->xtokLocalNameSpacePath.value = parser_malloc(parm->heap, strlen(lvalp.xtokNameSpace.ns) + 1);
 					strcpy(stateUnion->xtokLocalNameSpacePath.value, lvalp.xtokNameSpace.ns);
 				}
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_NAMESPACE);
-			dontLex = 1;
+			while(parm->ct == XTOK_NAMESPACE);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokLocalNameSpacePath, parm);
-		if(ct == ZTOK_LOCALNAMESPACEPATH) {
+		parm->ct = localLex(&stateUnion->xtokLocalNameSpacePath, parm);
+		if(parm->ct == ZTOK_LOCALNAMESPACEPATH) {
 		}
 		else {
-			parseError("ZTOK_LOCALNAMESPACEPATH or XTOK_NAMESPACE", ct, parm);
+			parseError("ZTOK_LOCALNAMESPACEPATH or XTOK_NAMESPACE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_LOCALNAMESPACEPATH", ct, parm);
+		parseError("XTOK_LOCALNAMESPACEPATH", parm->ct, parm);
 	}
 }
 
 static void nameSpace(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokNameSpace, parm);
-	if(ct == XTOK_NAMESPACE) {
-		ct = localLex((parseUnion*)&stateUnion->xtokNameSpace, parm);
-		if(ct == ZTOK_NAMESPACE) {
+	parm->ct = localLex(&stateUnion->xtokNameSpace, parm);
+	if(parm->ct == XTOK_NAMESPACE) {
+		parm->ct = localLex(&stateUnion->xtokNameSpace, parm);
+		if(parm->ct == ZTOK_NAMESPACE) {
 		}
 		else {
-			parseError("ZTOK_NAMESPACE", ct, parm);
+			parseError("ZTOK_NAMESPACE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_NAMESPACE", ct, parm);
+		parseError("XTOK_NAMESPACE", parm->ct, parm);
 	}
 }
 
 static void valueNamedInstance(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokNamedInstance, parm);
-	if(ct == XTOK_VALUENAMEDINSTANCE) {
+	parm->ct = localLex(&stateUnion->xtokNamedInstance, parm);
+	if(parm->ct == XTOK_VALUENAMEDINSTANCE) {
 		instanceName(parm, (parseUnion*)&stateUnion->xtokNamedInstance.path);
 		instance(parm, (parseUnion*)&stateUnion->xtokNamedInstance.instance);
-		ct = localLex((parseUnion*)&stateUnion->xtokNamedInstance, parm);
-		if(ct == ZTOK_VALUENAMEDINSTANCE) {
+		parm->ct = localLex(&stateUnion->xtokNamedInstance, parm);
+		if(parm->ct == ZTOK_VALUENAMEDINSTANCE) {
 		}
 		else {
-			parseError("ZTOK_VALUENAMEDINSTANCE", ct, parm);
+			parseError("ZTOK_VALUENAMEDINSTANCE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_VALUENAMEDINSTANCE", ct, parm);
+		parseError("XTOK_VALUENAMEDINSTANCE", parm->ct, parm);
 	}
 }
 
 static void instance(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokInstance, parm);
-	if(ct == XTOK_INSTANCE) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokInstance, parm);
+	if(parm->ct == XTOK_INSTANCE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
 				addQualifier(parm,&stateUnion->xtokInstance.qualifiers,&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_PROPERTY || ct == XTOK_PROPERTYARRAY || ct == XTOK_PROPERTYREFERENCE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_PROPERTY || parm->ct == XTOK_PROPERTYARRAY || parm->ct == XTOK_PROPERTYREFERENCE) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				genProperty(parm, (parseUnion*)&lvalp.xtokProperty);
 				addProperty(parm,&stateUnion->xtokInstance.properties,&lvalp.xtokProperty);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_PROPERTY || ct == XTOK_PROPERTYARRAY || ct == XTOK_PROPERTYREFERENCE);
-			dontLex = 1;
+			while(parm->ct == XTOK_PROPERTY || parm->ct == XTOK_PROPERTYARRAY || parm->ct == XTOK_PROPERTYREFERENCE);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokInstance, parm);
-		if(ct == ZTOK_INSTANCE) {
+		parm->ct = localLex(&stateUnion->xtokInstance, parm);
+		if(parm->ct == ZTOK_INSTANCE) {
 		}
 		else {
-			parseError("ZTOK_INSTANCE or XTOK_PROPERTY or XTOK_PROPERTYARRAY or XTOK_PROPERTYREFERENCE or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_INSTANCE or XTOK_PROPERTY or XTOK_PROPERTYARRAY or XTOK_PROPERTYREFERENCE or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_INSTANCE", ct, parm);
+		parseError("XTOK_INSTANCE", parm->ct, parm);
 	}
 }
 
 static void genProperty(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokProperty, parm);
-	if(ct == XTOK_PROPERTY) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokProperty, parm);
+	if(parm->ct == XTOK_PROPERTY) {
+		parm->dontLex = 1;
 		property(parm, (parseUnion*)&stateUnion->xtokProperty.val);
 		if(stateUnion->xtokProperty.val.value.type == typeValue_Instance) {
 			stateUnion->xtokProperty.valueType = CMPI_instance;
 		}
 	}
-	else if(ct == XTOK_PROPERTYARRAY) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_PROPERTYARRAY) {
+		parm->dontLex = 1;
 		propertyArray(parm, (parseUnion*)&stateUnion->xtokProperty.val);
 	}
-	else if(ct == XTOK_PROPERTYREFERENCE) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_PROPERTYREFERENCE) {
+		parm->dontLex = 1;
 		propertyReference(parm, (parseUnion*)&stateUnion->xtokProperty.val);
 	}
 	else {
-		parseError("XTOK_PROPERTY or XTOK_PROPERTYARRAY or XTOK_PROPERTYREFERENCE", ct, parm);
+		parseError("XTOK_PROPERTY or XTOK_PROPERTYARRAY or XTOK_PROPERTYREFERENCE", parm->ct, parm);
 	}
 }
 
 static void qualifier(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokQualifier, parm);
-	if(ct == XTOK_QUALIFIER) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUE || ct == XTOK_VALUEARRAY) {
-			dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokQualifier, parm);
+	if(parm->ct == XTOK_QUALIFIER) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUE || parm->ct == XTOK_VALUEARRAY) {
+			parm->dontLex = 1;
 			qualifierData(parm, (parseUnion*)&lvalp.xtokQualifierData);
 			stateUnion->xtokQualifier.data = lvalp.xtokQualifierData;
 			if(lvalp.xtokQualifierData.isArray) {
 				stateUnion->xtokQualifier.type |= CMPI_ARRAY;
 			}
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokQualifier, parm);
-		if(ct == ZTOK_QUALIFIER) {
+		parm->ct = localLex(&stateUnion->xtokQualifier, parm);
+		if(parm->ct == ZTOK_QUALIFIER) {
 		}
 		else {
-			parseError("ZTOK_QUALIFIER or XTOK_VALUE or XTOK_VALUEARRAY", ct, parm);
+			parseError("ZTOK_QUALIFIER or XTOK_VALUE or XTOK_VALUEARRAY", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_QUALIFIER", ct, parm);
+		parseError("XTOK_QUALIFIER", parm->ct, parm);
 	}
 }
 
 static void qualifierData(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokQualifierData, parm);
-	if(ct == XTOK_VALUE) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokQualifierData, parm);
+	if(parm->ct == XTOK_VALUE) {
+		parm->dontLex = 1;
 		value(parm, (parseUnion*)&stateUnion->xtokQualifierData.value);
 		stateUnion->xtokQualifierData.isArray = 0;
 	}
-	else if(ct == XTOK_VALUEARRAY) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEARRAY) {
+		parm->dontLex = 1;
 		valueArray(parm, (parseUnion*)&stateUnion->xtokQualifierData.array);
 		stateUnion->xtokQualifierData.isArray = 1;
 	}
 	else {
-		parseError("XTOK_VALUE or XTOK_VALUEARRAY", ct, parm);
+		parseError("XTOK_VALUE or XTOK_VALUEARRAY", parm->ct, parm);
 	}
 }
 
 static void property(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokPropertyData, parm);
-	if(ct == XTOK_PROPERTY) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokPropertyData, parm);
+	if(parm->ct == XTOK_PROPERTY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
 				addQualifier(parm,&stateUnion->xtokPropertyData.qualifiers,&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUE) {
-			dontLex = 1;
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUE) {
+			parm->dontLex = 1;
 			value(parm, (parseUnion*)&lvalp.xtokValue);
 			stateUnion->xtokPropertyData.value = lvalp.xtokValue;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokPropertyData, parm);
-		if(ct == ZTOK_PROPERTY) {
+		parm->ct = localLex(&stateUnion->xtokPropertyData, parm);
+		if(parm->ct == ZTOK_PROPERTY) {
 		}
 		else {
-			parseError("ZTOK_PROPERTY or XTOK_VALUE or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PROPERTY or XTOK_VALUE or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PROPERTY", ct, parm);
+		parseError("XTOK_PROPERTY", parm->ct, parm);
 	}
 }
 
 static void propertyArray(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokPropertyData, parm);
-	if(ct == XTOK_PROPERTYARRAY) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokPropertyData, parm);
+	if(parm->ct == XTOK_PROPERTYARRAY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
 				addQualifier(parm,&stateUnion->xtokPropertyData.qualifiers,&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUEARRAY) {
-			dontLex = 1;
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUEARRAY) {
+			parm->dontLex = 1;
 			valueArray(parm, (parseUnion*)&lvalp.xtokValueArray);
 			stateUnion->xtokPropertyData.array = lvalp.xtokValueArray;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokPropertyData, parm);
-		if(ct == ZTOK_PROPERTYARRAY) {
+		parm->ct = localLex(&stateUnion->xtokPropertyData, parm);
+		if(parm->ct == ZTOK_PROPERTYARRAY) {
 		}
 		else {
-			parseError("ZTOK_PROPERTYARRAY or XTOK_VALUEARRAY or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PROPERTYARRAY or XTOK_VALUEARRAY or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PROPERTYARRAY", ct, parm);
+		parseError("XTOK_PROPERTYARRAY", parm->ct, parm);
 	}
 }
 
 static void propertyReference(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokPropertyData, parm);
-	if(ct == XTOK_PROPERTYREFERENCE) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_QUALIFIER) {
+	parm->ct = localLex(&stateUnion->xtokPropertyData, parm);
+	if(parm->ct == XTOK_PROPERTYREFERENCE) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_QUALIFIER) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				qualifier(parm, (parseUnion*)&lvalp.xtokQualifier);
 				addQualifier(parm,&stateUnion->xtokPropertyData.qualifiers,&lvalp.xtokQualifier);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_QUALIFIER);
-			dontLex = 1;
+			while(parm->ct == XTOK_QUALIFIER);
+			parm->dontLex = 1;
 		}
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUEREFERENCE) {
-			dontLex = 1;
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUEREFERENCE) {
+			parm->dontLex = 1;
 			valueReference(parm, (parseUnion*)&lvalp.xtokValueReference);
 			stateUnion->xtokPropertyData.ref = lvalp.xtokValueReference;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokPropertyData, parm);
-		if(ct == ZTOK_PROPERTYREFERENCE) {
+		parm->ct = localLex(&stateUnion->xtokPropertyData, parm);
+		if(parm->ct == ZTOK_PROPERTYREFERENCE) {
 		}
 		else {
-			parseError("ZTOK_PROPERTYREFERENCE or XTOK_VALUEREFERENCE or XTOK_QUALIFIER", ct, parm);
+			parseError("ZTOK_PROPERTYREFERENCE or XTOK_VALUEREFERENCE or XTOK_QUALIFIER", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_PROPERTYREFERENCE", ct, parm);
+		parseError("XTOK_PROPERTYREFERENCE", parm->ct, parm);
 	}
 }
 
 static void instanceName(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokInstanceName, parm);
-	if(ct == XTOK_INSTANCENAME) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_KEYBINDING) {
+	parm->ct = localLex(&stateUnion->xtokInstanceName, parm);
+	if(parm->ct == XTOK_INSTANCENAME) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_KEYBINDING) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				keyBinding(parm, (parseUnion*)&lvalp.xtokKeyBinding);
 				addKeyBinding(parm, &stateUnion->xtokInstanceName.bindings, &lvalp.xtokKeyBinding);
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_KEYBINDING);
-			dontLex = 1;
+			while(parm->ct == XTOK_KEYBINDING);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokInstanceName, parm);
-		if(ct == ZTOK_INSTANCENAME) {
+		parm->ct = localLex(&stateUnion->xtokInstanceName, parm);
+		if(parm->ct == ZTOK_INSTANCENAME) {
 		}
 		else {
-			parseError("ZTOK_INSTANCENAME or XTOK_KEYBINDING", ct, parm);
+			parseError("ZTOK_INSTANCENAME or XTOK_KEYBINDING", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_INSTANCENAME", ct, parm);
+		parseError("XTOK_INSTANCENAME", parm->ct, parm);
 	}
 }
 
 static void keyBinding(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokKeyBinding, parm);
-	if(ct == XTOK_KEYBINDING) {
+	parm->ct = localLex(&stateUnion->xtokKeyBinding, parm);
+	if(parm->ct == XTOK_KEYBINDING) {
 		keyBindingContent(parm, (parseUnion*)&stateUnion->xtokKeyBinding.val);
 		stateUnion->xtokKeyBinding.type = stateUnion->xtokKeyBinding.val.type;
-		ct = localLex((parseUnion*)&stateUnion->xtokKeyBinding, parm);
-		if(ct == ZTOK_KEYBINDING) {
+		parm->ct = localLex(&stateUnion->xtokKeyBinding, parm);
+		if(parm->ct == ZTOK_KEYBINDING) {
 		}
 		else {
-			parseError("ZTOK_KEYBINDING", ct, parm);
+			parseError("ZTOK_KEYBINDING", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_KEYBINDING", ct, parm);
+		parseError("XTOK_KEYBINDING", parm->ct, parm);
 	}
 }
 
 static void keyBindingContent(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokKeyBindingContent, parm);
-	if(ct == XTOK_KEYVALUE) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokKeyBindingContent, parm);
+	if(parm->ct == XTOK_KEYVALUE) {
+		parm->dontLex = 1;
 		keyValue(parm, (parseUnion*)&stateUnion->xtokKeyBindingContent.keyValue);
 		stateUnion->xtokKeyBindingContent.type = stateUnion->xtokKeyBindingContent.keyValue.valueType;
 	}
-	else if(ct == XTOK_VALUEREFERENCE) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_VALUEREFERENCE) {
+		parm->dontLex = 1;
 		valueReference(parm, (parseUnion*)&stateUnion->xtokKeyBindingContent.ref);
 		stateUnion->xtokKeyBindingContent.type = "ref";
 	}
 	else {
-		parseError("XTOK_KEYVALUE or XTOK_VALUEREFERENCE", ct, parm);
+		parseError("XTOK_KEYVALUE or XTOK_VALUEREFERENCE", parm->ct, parm);
 	}
 }
 
 static void keyValue(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokKeyValue, parm);
-	if(ct == XTOK_KEYVALUE) {
-		ct = localLex((parseUnion*)&stateUnion->xtokKeyValue, parm);
-		if(ct == ZTOK_KEYVALUE) {
+	parm->ct = localLex(&stateUnion->xtokKeyValue, parm);
+	if(parm->ct == XTOK_KEYVALUE) {
+		parm->ct = localLex(&stateUnion->xtokKeyValue, parm);
+		if(parm->ct == ZTOK_KEYVALUE) {
 		}
 		else {
-			parseError("ZTOK_KEYVALUE", ct, parm);
+			parseError("ZTOK_KEYVALUE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_KEYVALUE", ct, parm);
+		parseError("XTOK_KEYVALUE", parm->ct, parm);
 	}
 }
 
 static void value(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokValue, parm);
-	if(ct == XTOK_VALUE) {
+	parm->ct = localLex(&stateUnion->xtokValue, parm);
+	if(parm->ct == XTOK_VALUE) {
 		valueData(parm, (parseUnion*)&stateUnion->xtokValue.data);
 		stateUnion->xtokValue.type = stateUnion->xtokValue.data.type;
-		ct = localLex((parseUnion*)&stateUnion->xtokValue, parm);
-		if(ct == ZTOK_VALUE) {
+		parm->ct = localLex(&stateUnion->xtokValue, parm);
+		if(parm->ct == ZTOK_VALUE) {
 		}
 		else {
-			parseError("ZTOK_VALUE", ct, parm);
+			parseError("ZTOK_VALUE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_VALUE", ct, parm);
+		parseError("XTOK_VALUE", parm->ct, parm);
 	}
 }
 
 static void valueData(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokValueData, parm);
-	if(ct == ZTOK_VALUE) {
+	parm->ct = localLex(&stateUnion->xtokValueData, parm);
+	if(parm->ct == ZTOK_VALUE) {
 		stateUnion->xtokValueData.type=typeValue_charP;
-		dontLex = 1;
+		parm->dontLex = 1;
 	}
-	else if(ct == XTOK_CDATA) {
+	else if(parm->ct == XTOK_CDATA) {
 		stateUnion->xtokValueData.inst = parser_malloc(parm->heap, sizeof(XtokInstance));
 		instance(parm, (parseUnion*)stateUnion->xtokValueData.inst);
 		stateUnion->xtokValueData.type=typeValue_Instance;
-		ct = localLex((parseUnion*)&stateUnion->xtokValueData, parm);
-		if(ct == ZTOK_CDATA) {
+		parm->ct = localLex(&stateUnion->xtokValueData, parm);
+		if(parm->ct == ZTOK_CDATA) {
 		}
 		else {
-			parseError("ZTOK_CDATA", ct, parm);
+			parseError("ZTOK_CDATA", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("ZTOK_VALUE", ct, parm);
+		parseError("ZTOK_VALUE", parm->ct, parm);
 	}
 }
 
 static void valueArray(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokValueArray, parm);
-	if(ct == XTOK_VALUEARRAY) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUE) {
+	parm->ct = localLex(&stateUnion->xtokValueArray, parm);
+	if(parm->ct == XTOK_VALUEARRAY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUE) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				value(parm, (parseUnion*)&lvalp.xtokValue);
 				if(stateUnion->xtokValueArray.next >= stateUnion->xtokValueArray.max) {
 					stateUnion->xtokValueArray.max *= 2;
 					stateUnion->xtokValueArray.values = (char**)parser_realloc(parm->heap, stateUnion->xtokValueArray.values, sizeof(char*) * stateUnion->xtokValueArray.max);
 				}
 				stateUnion->xtokValueArray.values[stateUnion->xtokValueArray.next++] = lvalp.xtokValue.data.value;
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_VALUE);
-			dontLex = 1;
+			while(parm->ct == XTOK_VALUE);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokValueArray, parm);
-		if(ct == ZTOK_VALUEARRAY) {
+		parm->ct = localLex(&stateUnion->xtokValueArray, parm);
+		if(parm->ct == ZTOK_VALUEARRAY) {
 		}
 		else {
-			parseError("ZTOK_VALUEARRAY or XTOK_VALUE", ct, parm);
+			parseError("ZTOK_VALUEARRAY or XTOK_VALUE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_VALUEARRAY", ct, parm);
+		parseError("XTOK_VALUEARRAY", parm->ct, parm);
 	}
 }
 
 static void valueRefArray(ParserControl *parm, parseUnion *stateUnion)
 {
 	parseUnion lvalp={0};
-	ct = localLex((parseUnion*)&stateUnion->xtokValueRefArray, parm);
-	if(ct == XTOK_VALUEREFARRAY) {
-		ct = localLex(&lvalp, parm);
-		dontLex = 1;
-		if(ct == XTOK_VALUEREFERENCE) {
+	parm->ct = localLex(&stateUnion->xtokValueRefArray, parm);
+	if(parm->ct == XTOK_VALUEREFARRAY) {
+		parm->ct = localLex(&lvalp, parm);
+		parm->dontLex = 1;
+		if(parm->ct == XTOK_VALUEREFERENCE) {
 			do {
-				dontLex = 1;
+				parm->dontLex = 1;
 				valueReference(parm, (parseUnion*)&lvalp.xtokValueReference);
 				if(stateUnion->xtokValueRefArray.next >= stateUnion->xtokValueRefArray.max) {
 					stateUnion->xtokValueRefArray.max *= 2;
 					stateUnion->xtokValueRefArray.values = (XtokValueReference*)parser_realloc(parm->heap, stateUnion->xtokValueRefArray.values, sizeof(XtokValueReference) * stateUnion->xtokValueRefArray.max);
 				}
 				stateUnion->xtokValueRefArray.values[stateUnion->xtokValueRefArray.next++] = lvalp.xtokValueReference;
-				ct = localLex(&lvalp, parm);
+				parm->ct = localLex(&lvalp, parm);
 			}
-			while(ct == XTOK_VALUEREFERENCE);
-			dontLex = 1;
+			while(parm->ct == XTOK_VALUEREFERENCE);
+			parm->dontLex = 1;
 		}
-		ct = localLex((parseUnion*)&stateUnion->xtokValueRefArray, parm);
-		if(ct == ZTOK_VALUEREFARRAY) {
+		parm->ct = localLex(&stateUnion->xtokValueRefArray, parm);
+		if(parm->ct == ZTOK_VALUEREFARRAY) {
 		}
 		else {
-			parseError("ZTOK_VALUEREFARRAY or XTOK_VALUEREFERENCE", ct, parm);
+			parseError("ZTOK_VALUEREFARRAY or XTOK_VALUEREFERENCE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_VALUEREFARRAY", ct, parm);
+		parseError("XTOK_VALUEREFARRAY", parm->ct, parm);
 	}
 }
 
 static void valueReference(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokValueReference, parm);
-	if(ct == XTOK_VALUEREFERENCE) {
+	parm->ct = localLex(&stateUnion->xtokValueReference, parm);
+	if(parm->ct == XTOK_VALUEREFERENCE) {
 		valueReferenceData(parm, (parseUnion*)&stateUnion->xtokValueReference.data);
 		stateUnion->xtokValueReference.type = stateUnion->xtokValueReference.data.type;
-		ct = localLex((parseUnion*)&stateUnion->xtokValueReference, parm);
-		if(ct == ZTOK_VALUEREFERENCE) {
+		parm->ct = localLex(&stateUnion->xtokValueReference, parm);
+		if(parm->ct == ZTOK_VALUEREFERENCE) {
 		}
 		else {
-			parseError("ZTOK_VALUEREFERENCE", ct, parm);
+			parseError("ZTOK_VALUEREFERENCE", parm->ct, parm);
 		}
 	}
 	else {
-		parseError("XTOK_VALUEREFERENCE", ct, parm);
+		parseError("XTOK_VALUEREFERENCE", parm->ct, parm);
 	}
 }
 
 static void valueReferenceData(ParserControl *parm, parseUnion *stateUnion)
 {
-	ct = localLex((parseUnion*)&stateUnion->xtokValueReferenceData, parm);
-	if(ct == XTOK_INSTANCEPATH) {
-		dontLex = 1;
+	parm->ct = localLex(&stateUnion->xtokValueReferenceData, parm);
+	if(parm->ct == XTOK_INSTANCEPATH) {
+		parm->dontLex = 1;
 		instancePath(parm, (parseUnion*)&stateUnion->xtokValueReferenceData.instancePath);
 		stateUnion->xtokValueReferenceData.type = typeValRef_InstancePath;
 	}
-	else if(ct == XTOK_LOCALINSTANCEPATH) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_LOCALINSTANCEPATH) {
+		parm->dontLex = 1;
 		localInstancePath(parm, (parseUnion*)&stateUnion->xtokValueReferenceData.localInstancePath);
 		stateUnion->xtokValueReferenceData.type = typeValRef_LocalInstancePath;
 	}
-	else if(ct == XTOK_INSTANCENAME) {
-		dontLex = 1;
+	else if(parm->ct == XTOK_INSTANCENAME) {
+		parm->dontLex = 1;
 		instanceName(parm, (parseUnion*)&stateUnion->xtokValueReferenceData.instanceName);
 		stateUnion->xtokValueReferenceData.type = typeValRef_InstanceName;
 	}
 	else {
-		parseError("XTOK_INSTANCEPATH or XTOK_LOCALINSTANCEPATH or XTOK_INSTANCENAME", ct, parm);
+		parseError("XTOK_INSTANCEPATH or XTOK_LOCALINSTANCEPATH or XTOK_INSTANCENAME", parm->ct, parm);
 	}
 }
 
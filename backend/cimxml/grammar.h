@@ -21,6 +21,8 @@
 
 #include "cimXmlParser.h"
 
+void startParsing(ParserControl *parm);
+void startParsingFragment(ParserControl *parm);
 
 
 static void start(ParserControl *parm, parseUnion *stateUnion);
@@ -19,6 +19,7 @@
  */
 
 
+#include "config.h"
 #include "nativeCimXml.h"
 #include "utilft.h"
 #include "cimXmlParser.h"
@@ -26,20 +27,46 @@
 #include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
-static int do_listen=1;
-
-#define SOCKBUFSZ 32768
 #define hdrBufsize 5000
 #define hdrLimmit 5000
 
+#define LISTENER_BUFFER_MIN           4096
+#define LISTENER_BUFFER_KEEP          65536      /* freed when idle beyond */
+#define LISTENER_MAX_PAYLOAD          (256 * 1024 * 1024)
+
+#define LISTENER_DEFAULT_BACKLOG      128
+#define LISTENER_DEFAULT_WORKERS      2
+#define LISTENER_DEFAULT_IDLE_TIMEOUT 15
+#define LISTENER_REQUEST_TIMEOUT      10         /* to send a whole request */
+#define LISTENER_WRITE_TIMEOUT        10         /* for a response to fit */
+#define LISTENER_MAX_EVENTS           64
+#define LISTENER_DEFAULT_QUEUE_SIZE   1024
+#define LISTENER_DEFAULT_BATCH_SIZE   64
+
 #ifdef __APPLE__
 # define __SOCKADDR_ARG   struct sockaddr *__restrict
 #endif
 
+/*
+ * A connection reads into one buffer, kept while the connection is and
+ * grown by doubling. A request is taken from it in place: the header
+ * lines are terminated where they are and the body is parsed where it
+ * was read. Whatever follows the body, the start of requests sent
+ * without waiting for the response, is moved to the front for the next
+ * request.
+ */
 typedef struct _buffer {
    char *data, *content;
    int length, size, ptr, content_length,trailers;
@@ -60,18 +87,47 @@ static void freeBuffer(Buffer * b)
    Buffer emptyBuf = { NULL, NULL, 0, 0, 0, 0, 0 ,0};
    if (b->data)
       free(b->data);
-   if (b->content)
-      free(b->content);
    *b=emptyBuf;   
 }
 
+/* makes room for len more bytes and a terminating 0, the header values
+   found so far move with the data */
+static void reserveBuffer(Buffer * b, int len)
+{
+   char **hdrs[] = { &b->httpHdr, &b->authorization, &b->content_type,
+                     &b->host, &b->useragent, &b->protocol };
+   long offset[sizeof(hdrs) / sizeof(hdrs[0])];
+   int size = b->size ? b->size : LISTENER_BUFFER_MIN, i;
+
+   while (size < b->length + len + 1)
+      size *= 2;
+   if (size == b->size)
+      return;
+
+   for (i = 0; i < (int) (sizeof(hdrs) / sizeof(hdrs[0])); i++) {
+      offset[i] = b->data && *hdrs[i] >= b->data &&
+                  *hdrs[i] < b->data + b->length ? *hdrs[i] - b->data : -1;
+   }
+   b->data = (char *) realloc(b->data, size);
+   b->size = size;
+   for (i = 0; i < (int) (sizeof(hdrs) / sizeof(hdrs[0])); i++) {
+      if (offset[i] >= 0)
+         *hdrs[i] = b->data + offset[i];
+   }
+}
+
 
 int commWrite(CommHndl to, void *data, size_t count)
 {
    int rc=0;
   
     if (to.file == NULL) { 
+#ifdef MSG_NOSIGNAL
+        /* a client gone away must not kill us with SIGPIPE */
+        rc = send(to.socket,data,count,MSG_NOSIGNAL);
+#else
         rc = write(to.socket,data,count);
+#endif
     } else {
         rc = fwrite(data,count,1,to.file);
         if (rc == 1) {
@@ -111,41 +167,38 @@ void commFlush(CommHndl hndl)
     }
 }
 
-static void add2buffer(Buffer * b, char *str, size_t len)
-{
-   if (b->size == 0) {
-      b->size = len + 500;
-      b->length = 0;
-      b->data = (char *) malloc(b->size);
-   }
-   else if (b->length + len >= b->size) {
-      b->size = b->length + len + 500;
-      b->data = (char *) realloc((void *) b->data, b->size);
-   }
-   memmove(&((b->data)[b->length]), str, len);
-   b->length += len;
-   (b->data)[b->length] = 0;
-}
-
+/* the response is written at once, the connection stays open if keepAlive */
 static void genError(CommHndl conn_fd, Buffer * b, int status, char *title,
-                     char *more)
+                     char *more, int keepAlive)
 {
     char head[1000];
-    char server[] = "Server: sfcc indListener\r\n";
-    char clength[] = "Content-Length: 0\r\n";
-    char cclose[] = "Connection: close\r\n";
-    char end[] = "\r\n";
+    struct pollfd pfd;
+    int len, sent, rc;
 
-    snprintf(head, sizeof(head), "%s %d %s\r\n", b->protocol, status, title);
-    commWrite(conn_fd, head, strlen(head));
-    if (more) {
-        commWrite(conn_fd, more, strlen(more));
+    len = snprintf(head, sizeof(head),
+                   "%s %d %s\r\n%sServer: sfcc indListener\r\n"
+                   "Content-Length: 0\r\nConnection: %s\r\n\r\n",
+                   b->protocol, status, title, more ? more : "",
+                   keepAlive ? "keep-alive" : "close");
+    if (len >= (int) sizeof(head)) {
+        len = sizeof(head) - 1;
+    }
+    for (sent = 0; sent < len; sent += rc) {
+        rc = commWrite(conn_fd, head + sent, len - sent);
+        if (rc < 0 && (errno == EINTR || errno == EAGAIN)) {
+            /* a client not reading its responses gets some time to */
+            pfd.fd = conn_fd.socket;
+            pfd.events = POLLOUT;
+            if (errno == EAGAIN &&
+                poll(&pfd, 1, LISTENER_WRITE_TIMEOUT * 1000) <= 0) {
+                break;
+            }
+            rc = 0;
+        }
+        else if (rc <= 0) {
+            break;
+        }
     }
-    commWrite(conn_fd, server, strlen(server));
-    commWrite(conn_fd, clength, strlen(clength));
-    commWrite(conn_fd, cclose, strlen(cclose));
-
-    commWrite(conn_fd, end, strlen(end));
     commFlush(conn_fd);
 }
 
@@ -169,85 +222,93 @@ static char *getNextHdr(Buffer * b)
     return NULL;
 }
 
-static int readData(CommHndl conn_fd, char *into, int length)
+/* reads what has arrived, up to want bytes more or as many as fit into b,
+   returns the number read, 0 if the connection was closed and -1 if
+   nothing has arrived yet */
+static int readSome(CommHndl conn_fd, Buffer * b, int want)
 {
-    int c = 0, r;
+    int r;
 
-    while (c < length) {
-        r = commRead(conn_fd, into + c, length - c);
-        if (r < 0 && (errno == EINTR || errno == EAGAIN)) {
+    reserveBuffer(b, want);
+    for (;;) {
+        r = commRead(conn_fd, b->data + b->length, b->size - b->length - 1);
+        if (r > 0) {
+            b->length += r;
+            return r;
+        }
+        if (r < 0 && errno == EINTR) {
             continue;
         }
-        c += r;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return -1;
+        }
+        /* closed, or shut down */
+        return 0;
     }
-    return c;
 }
 
-static void getPayload(CommHndl conn_fd, Buffer * b)
+/* looks for the end of the header at the start of b the way getNextHdr()
+   splits it into lines, and returns the length of the request, its
+   header and body, once the header is complete, 0 before and -1 if the
+   header is too long. A request without a valid length ends with its
+   header, handleRequest() rejects it. */
+static int requestLength(Buffer * b, int *hdrEnd)
 {
-    int c = b->length - b->ptr;
-    b->content = (char *) malloc(b->content_length + 8);
-    if (c) memcpy(b->content, (b->data) + b->ptr, c);
-
-    readData(conn_fd, (b->content) + c, b->content_length - c);
-    *((b->content) + b->content_length) = 0;
-}
+    int n = b->length < hdrLimmit ? b->length : hdrLimmit;
+    int i, line = 0, end;
+    long length = -1;
+    char c;
 
-static int  getHdrs(CommHndl conn_fd, Buffer * b, char *cmd)
-{
-   int first=1,total=0,isReady;
-   struct timeval httpTimeout;
-   fd_set httpfds;
-   int state=0;
-   
-   FD_ZERO(&httpfds);
-   FD_SET(conn_fd.socket,&httpfds);
-   httpTimeout.tv_sec=5;
-   httpTimeout.tv_usec=0;
-   isReady = select(conn_fd.socket+1,&httpfds,NULL,NULL,&httpTimeout);
-   if (isReady == 0) return 3;
-    
-   for (;;) {
-      char buf[hdrBufsize];
-      int r = commRead(conn_fd, buf, sizeof(buf));
-      
-      if (r < 0 && (errno == EINTR || errno == EAGAIN)) continue;
-      if (r <= 0) break;
-      
-      add2buffer(b, buf, r);
-      total+=r;
-      if (r && first) {
-         if (strncasecmp(buf,cmd,strlen(cmd)) != 0) { 
-       /* not what we expected - still continue to read to
-          not confuse the client */
-       state = 1;
-     }
-         first=0;
-      }
-      
-      if (strstr(b->data, "\r\n\r\n") != NULL ||
-          strstr(b->data, "\n\n") != NULL) {
-         break;
-      }
-      
-      if (total>=hdrLimmit) {
+    for (i = 0; i < n; i++) {
+        c = b->data[i];
+        if (c != '\n' && c != '\r') {
+            continue;
+        }
+        end = i;
+        if (c == '\r') {
+            if (i + 1 == b->length) {
+                /* a line feed may be following */
+                return 0;
+            }
+            if (b->data[i + 1] == '\n') {
+                ++i;
+            }
+        }
+        if (end == line) {
+            *hdrEnd = i + 1;
+            if (length < 0 || length > LISTENER_MAX_PAYLOAD) {
+                return *hdrEnd;
+            }
+            return *hdrEnd + (int) length;
+        }
+        if (end - line >= 15 &&
+            strncasecmp(b->data + line, "Content-Length:", 15) == 0) {
+            length = atol(b->data + line + 15);
+        }
+        line = i + 1;
+    }
+    if (b->length >= hdrLimmit) {
         fprintf(stderr, "-#- Possible DOS attempt detected\n");
-        state = 2;
-        break;
-      }
-   }
-   return state;
+        return -1;
+    }
+    return 0;
 }
 
-static void processIndication(struct native_indicationlistener *i, char *xml)
+struct _ListenerState;
+static void queueIndication(struct _ListenerState *s, CIMCInstance *inst);
+static void countMalformed(struct _ListenerState *s);
+
+static void processIndication(struct _ListenerState *s, char *xml,
+                              ParserHeap *heap)
 {
     ResponseHdr rh;
     
     CIMCInstance *inst;
     
-    rh = scanCimXmlResponse(xml, NULL);
+    rh = scanCimXmlResponse(xml, NULL, heap);
     
     if (rh.errCode != 0) {
+        countMalformed(s);
         free(rh.description);
         rh.rvArray->ft->release(rh.rvArray);
         return;
@@ -256,114 +317,123 @@ static void processIndication(struct native_indicationlistener *i, char *xml)
     inst = (CIMCInstance*)rh.rvArray->ft->getElementAt(rh.rvArray, 0, NULL).value.inst;
     
     if(inst) {
-        i->sendIndicationInstance(inst->ft->clone(inst, NULL));
+        queueIndication(s, inst->ft->clone(inst, NULL));
     }
+    else
+        countMalformed(s);
     
     rh.rvArray->ft->release(rh.rvArray);
 }
 
-static void handleConnection(int connFd, struct native_indicationlistener *i)
+/*
+ * Reads what has arrived on connFd into b and, once that is a whole
+ * request, acknowledges and decodes it. Returns 1 if the connection is to
+ * be kept for the next request, 0 if it is to be closed and -1 if the
+ * request hasn't been sent completely yet, what was is kept in b.
+ */
+static int handleRequest(int connFd, Buffer * b, struct _ListenerState *s,
+                         ParserHeap *heap)
 {
-    Buffer inBuf = { NULL, NULL, 0, 0, 0, 0, 0 ,0};
-    int badReq = 0;
     int discardInput=0;
+    int keepAlive;
+    int hdrEnd, end, r;
+    long length;
     char *path, *hdr;
-    char *cp;
+    char *cp, next;
     CommHndl conn_fd;
-    int rc;
     
-    inBuf.authorization = "";
-    inBuf.protocol="HTTP/1.1";
-    inBuf.content_type = NULL;
-    inBuf.content_length = -1;
-    inBuf.host = NULL;
-    inBuf.useragent = "";
+    b->ptr = 0;
+    b->content = NULL;
+    b->authorization = "";
+    b->protocol="HTTP/1.1";
+    b->content_type = NULL;
+    b->content_length = -1;
+    b->host = NULL;
+    b->useragent = "";
+    b->trailers = 0;
     
     conn_fd.socket=connFd;
-    conn_fd.file=fdopen(connFd,"a");
+    conn_fd.file=NULL;
     conn_fd.buf = NULL;
-    if (conn_fd.file == NULL) {
-        /* failed to create socket stream - continue with raw socket */
-    } else {
-        conn_fd.buf = malloc(SOCKBUFSZ);
-    if (conn_fd.buf) {
-        setbuffer(conn_fd.file,conn_fd.buf,SOCKBUFSZ);
-    } else {
-           /* failed to create socket buffer - continue unbuffered */
+
+    /* never wait for the rest, a slow client mustn't hold a worker up */
+    for (;;) {
+        end = requestLength(b, &hdrEnd);
+        if (end < 0) {
+            /* potential DOS attempt */
+            genError(conn_fd, b, 400, "Bad Request", NULL, 0);
+            return 0;
+        }
+        if (end && b->length >= end) {
+            break;
+        }
+        r = readSome(conn_fd, b, end ? end - b->length : hdrBufsize);
+        if (r == 0) {
+            /* the client closed the connection */
+            return 0;
+        }
+        if (r < 0) {
+            return -1;
         }
     }
-
-    rc=getHdrs(conn_fd, &inBuf,"POST ");
     
-    if (rc==1) { 
-        genError(conn_fd, &inBuf, 501, "Not Implemented", NULL);
+    if (strncasecmp(b->data, "POST ", 5) != 0) { 
+        genError(conn_fd, b, 501, "Not Implemented", NULL, 0);
         /* we continue to parse headers and empty the socket
         to be graceful with the client */
         discardInput=1;
     }
-    else if (rc==2) {
-        genError(conn_fd, &inBuf, 400, "Bad Request", NULL);
-        discardInput=2;
-        /* potential DOS attempt discovered */      
-    }
-    else if (rc==3) {
-        genError(conn_fd, &inBuf, 400, "Bad Request", NULL);
-        /* exiting after request timeout */
-        commClose(conn_fd);
-        exit(1);
-    }
-            
-    if (inBuf.size == 0) {
-        /* no buffer data - end of file - quit */   
-        commClose(conn_fd);
-        exit(1);
-    }
     
-    inBuf.httpHdr = getNextHdr(&inBuf);
-    for (badReq = 1;;) {
-        if (inBuf.httpHdr == NULL) {
-            break;
-        }
-        path = strpbrk(inBuf.httpHdr, " \t\r\n");
-        if (path == NULL) {
-            break;
-        }
-        *path++ = 0;
-        path += strspn(path, " \t\r\n");
-        inBuf.protocol = strpbrk(path, " \t\r\n");
-        *inBuf.protocol++ = 0;
-        if (inBuf.protocol == NULL) {
-            break;
-        }
-        badReq = 0;
+    b->httpHdr = getNextHdr(b);
+    path = strpbrk(b->httpHdr, " \t");
+    cp = path ? strpbrk(path + strspn(path, " \t"), " \t") : NULL;
+    if (cp == NULL) {
+        if (!discardInput)
+            genError(conn_fd, b, 400, "Bad Request", NULL, 0);
+        return 0;
     }
+    *path = 0;
+    *cp++ = 0;
+    b->protocol = cp + strspn(cp, " \t");
+    /* HTTP/1.1 connections are persistent unless told otherwise */
+    keepAlive = strcasecmp(b->protocol, "HTTP/1.1") == 0;
     
-    while ((hdr = getNextHdr(&inBuf)) != NULL) {
+    while ((hdr = getNextHdr(b)) != NULL) {
         if (hdr[0] == 0) {
             break;
         }
         else if (strncasecmp(hdr, "Authorization:", 14) == 0) {
             cp = &hdr[14];
             cp += strspn(cp, " \t");
-            inBuf.authorization = cp;
+            b->authorization = cp;
         }
         else if (strncasecmp(hdr, "Content-Length:", 15) == 0) {
             cp = &hdr[15];
             cp += strspn(cp, " \t");
-            inBuf.content_length = atol(cp);
+            length = atol(cp);
+            b->content_length = length > LISTENER_MAX_PAYLOAD ?
+                                LISTENER_MAX_PAYLOAD + 1 : (int) length;
         }
         else if (strncasecmp(hdr, "Content-Type:", 13) == 0) {
             cp = &hdr[13];
             cp += strspn(cp, " \t");
-            inBuf.content_type = cp;
+            b->content_type = cp;
+        }
+        else if (strncasecmp(hdr, "Connection:", 11) == 0) {
+            cp = &hdr[11];
+            cp += strspn(cp, " \t");
+            if (strncasecmp(cp, "close", 5) == 0)
+                keepAlive = 0;
+            else if (strncasecmp(cp, "keep-alive", 10) == 0)
+                keepAlive = 1;
         }
         else if (strncasecmp(hdr, "Host:", 5) == 0) {
             cp = &hdr[5];
             cp += strspn(cp, " \t");
-            inBuf.host = cp;
-            if (strchr(inBuf.host, '/') != NULL || inBuf.host[0] == '.') {
+            b->host = cp;
+            if (strchr(b->host, '/') != NULL || b->host[0] == '.') {
                 if (!discardInput) {
-                    genError(conn_fd, &inBuf, 400, "Bad Request", NULL);
+                    genError(conn_fd, b, 400, "Bad Request", NULL, 0);
                     discardInput=2;
                 }
             }
@@ -371,115 +441,693 @@ static void handleConnection(int connFd, struct native_indicationlistener *i)
         else if (strncasecmp(hdr, "User-Agent:", 11) == 0) {
             cp = &hdr[11];
             cp += strspn(cp, " \t");
-            inBuf.useragent = cp;
+            b->useragent = cp;
         }
         else if (strncasecmp(hdr, "TE:", 3) == 0) {
             char *cp = &hdr[3];
             cp += strspn(cp, " \t");
             if (strncasecmp(cp,"trailers",8)==0)
-            inBuf.trailers=1;
+            b->trailers=1;
         }
         else if (strncasecmp(hdr, "Expect:", 7) == 0) {
             if (!discardInput) {
-                genError(conn_fd, &inBuf, 417, "Expectation Failed", NULL);
+                genError(conn_fd, b, 417, "Expectation Failed", NULL, 0);
                 discardInput=2;
             }
         }
     }
     
-    if (inBuf.content_length < 0) {
+    if (b->content_length < 0) {
         if (!discardInput) {
-            genError(conn_fd, &inBuf, 411, "Length Required", NULL);
+            genError(conn_fd, b, 411, "Length Required", NULL, 0);
         }      
-        commClose(conn_fd);
-        exit(1);
+        return 0;
+    }
+    if (b->content_length > LISTENER_MAX_PAYLOAD) {
+        if (!discardInput) {
+            genError(conn_fd, b, 413, "Request Entity Too Large", NULL, 0);
+        }
+        return 0;
     }
 
-    getPayload(conn_fd, &inBuf);
     if (discardInput) {
-        freeBuffer(&inBuf);
-        return;
+        return 0;
     }
     
     /* well, not really an error ... op successful */
-    genError(conn_fd, &inBuf, 200, "OK", NULL);
-    
-    processIndication(i, inBuf.content);
+    genError(conn_fd, b, 200, "OK", NULL, keepAlive);
     
-    freeBuffer(&inBuf);
-    free(conn_fd.buf);
+    /* the byte after the body may be the next request's */
+    next = b->data[end];
+    b->data[end] = 0;
+    b->content = b->data + hdrEnd;
+    processIndication(s, b->content, heap);
+    b->data[end] = next;
+
+    b->length -= end;
+    if (b->length) {
+        memmove(b->data, b->data + end, b->length);
+    }
+    return keepAlive;
 }
 
-static void* establish_listener(int sslMode, int port, struct native_indicationlistener *i)
+/*
+ * A listener runs one thread waiting for connections and requests with
+ * epoll(), or poll() where there is none, a pool of workers and a
+ * delivery thread. A connection with something to read is handed to a
+ * worker, which reads what has arrived without waiting for more. Once
+ * that is a whole request, the worker acknowledges and decodes it and
+ * queues the indication for the delivery thread. Either way it gives the
+ * connection back to be waited on again, a request sent in parts is put
+ * together in the connection's buffer. Meanwhile the connection is not
+ * waited on, so a connection is served by one worker at a time, in the
+ * order of its requests. A request not complete in time is dropped with
+ * its connection. The delivery thread calls the callback, so a slow
+ * callback holds up the workers only once the queue is full.
+ */
+
+typedef struct _ListenerConn {
+    int fd;
+    int busy;                              /* handed to a worker */
+    time_t lastActive;
+    time_t deadline;                       /* of a request read in part */
+    Buffer in;                             /* read and not yet handled */
+    struct _ListenerConn *prev, *next;     /* all connections */
+    struct _ListenerConn *nextJob;         /* waiting for a worker */
+} ListenerConn;
+
+/*
+ * The queue is a ring of slots with sequence numbers, after Dmitry
+ * Vyukov's bounded MPMC queue: a thread claims a position by advancing
+ * tail (to put) or head (to take) with a compare and swap, and hands the
+ * slot over by advancing its sequence. Workers put, the delivery thread
+ * takes, and so does a worker dropping the oldest indication. No lock is
+ * taken unless a thread has to sleep.
+ */
+
+typedef struct _QueueSlot {
+    unsigned long seq;
+    CIMCInstance *inst;
+} QueueSlot;
+
+typedef struct _IndicationQueue {
+    QueueSlot *slots;
+    unsigned long mask;                    /* slots - 1, a power of 2 */
+    char pad1[64];
+    unsigned long tail;                    /* next position to put to */
+    char pad2[64];
+    unsigned long head;                    /* next position to take from */
+    char pad3[64];
+} IndicationQueue;
+
+typedef struct _ListenerState {
+    int listenFd;
+    int wakeFds[2];            /* pipe waking the listener thread up */
+#ifdef HAVE_SYS_EPOLL_H
+    int epollFd;
+#endif
+    int stopping;
+    int detached;              /* stopped by a callback, cleans up itself */
+    int idleTimeout;
+    void (*fp) (CIMCInstance *indInstance);
+    pthread_t thread;
+    pthread_t *workers;
+    int nWorkers;
+    pthread_mutex_t lock;      /* the connections and the jobs */
+    pthread_cond_t jobReady;
+    ListenerConn *conns;
+    ListenerConn *firstJob, *lastJob;
+
+    /* decoded indications waiting for the delivery thread */
+    IndicationQueue queue;
+    int overflow;              /* CIMC_OVERFLOW_BLOCK ... */
+    void (*batchFp) (CIMCInstance **indInstances, CIMCCount count);
+    int batchSize;
+    int linger;                /* milliseconds a batch may wait to fill */
+    pthread_t deliverer;
+    pthread_mutex_t queueLock; /* only to sleep and wake up */
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    int delivererWants;        /* indications the sleeping deliverer needs */
+    int roomWaiters;           /* workers sleeping on a full queue */
+    int workersDone;           /* nothing is put any more */
+    CIMCUint64 delivered, dropped, blocked, malformed;
+#ifndef HAVE_SYS_EPOLL_H
+    struct pollfd *fds;        /* the poll() set and its connections */
+    ListenerConn **fdConns;
+    int maxFds;
+#endif
+} ListenerState;
+
+static void wakeListener(ListenerState *s)
 {
-    struct sockaddr_in sin;
-    socklen_t sz,sin_len;
-    int listenFd, connFd;
-    int ru;
-    struct timeval timeout;
-    fd_set socksset;
-    int dataRead;
+    char c = 0;
+    int rc;
 
-    listenFd = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    sin_len = sizeof(sin);
+    do {
+        rc = write(s->wakeFds[1], &c, 1);
+    } while (rc < 0 && errno == EINTR);
+}
 
-    memset(&sin, 0, sin_len);
-    sin.sin_family = AF_INET;
-    sin.sin_addr.s_addr = INADDR_ANY;
-    sin.sin_port = htons(port);
-    
-    ru = 1;
-    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, (char *) &ru, sizeof(ru));
-    
-    if (bind(listenFd, (struct sockaddr *) &sin, sin_len) ||
-        listen(listenFd, 0)) {
-      exit(0);
+/* waits for the next request on c again, called with the lock held */
+static void watchConn(ListenerState *s, ListenerConn *c, int added)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = c;
+    epoll_ctl(s->epollFd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c->fd, &ev);
+#else
+    /* the pollfd set is built by the listener thread */
+    if (!added)
+        wakeListener(s);
+#endif
+}
+
+/* called with the lock held */
+static void closeConn(ListenerState *s, ListenerConn *c)
+{
+    if (c->prev)
+        c->prev->next = c->next;
+    else
+        s->conns = c->next;
+    if (c->next)
+        c->next->prev = c->prev;
+    close(c->fd);
+    freeBuffer(&c->in);
+    free(c);
+}
+
+static void acceptConns(ListenerState *s)
+{
+    ListenerConn *c;
+    int fd, one = 1;
+
+    for (;;) {
+        fd = accept(s->listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            /* EAGAIN, or out of descriptors until some are closed */
+            return;
+        }
+        /* the workers read without waiting, and answer pipelined requests
+           with small writes that mustn't wait for the client's ack */
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        c = (ListenerConn *) calloc(1, sizeof(ListenerConn));
+        c->fd = fd;
+        c->lastActive = time(NULL);
+
+        pthread_mutex_lock(&s->lock);
+        c->next = s->conns;
+        if (c->next)
+            c->next->prev = c;
+        s->conns = c;
+        watchConn(s, c, 1);
+        pthread_mutex_unlock(&s->lock);
     }
-    
-    sz = sizeof(sin);
-    listen(listenFd, 1);
-    
-    while(do_listen) {
-    
-        timeout.tv_sec = 3;
-        timeout.tv_usec = 0;
-        FD_ZERO(&socksset);
-        FD_SET(listenFd,&socksset);
-        
-        dataRead = select(listenFd+1, &socksset, NULL, NULL, &timeout);
-        
-        if(dataRead < 0) {
-            fprintf(stderr, "Error during select(), return value was: %d\n", dataRead);
-        }
-        else if(dataRead == 0) {
-            /* timed out, trying again */
-        } else {
-            if ((connFd = accept(listenFd, (__SOCKADDR_ARG) & sin, &sz))<0) {
-                fprintf(stderr, "Error during accept(), return value was: %d\n", connFd);
-                exit(0);
+}
+
+/* called with the lock held */
+static void queueJob(ListenerState *s, ListenerConn *c)
+{
+    c->busy = 1;
+    c->nextJob = NULL;
+    if (s->lastJob)
+        s->lastJob->nextJob = c;
+    else
+        s->firstJob = c;
+    s->lastJob = c;
+    pthread_cond_signal(&s->jobReady);
+}
+
+static void closeIdleConns(ListenerState *s, time_t now)
+{
+    ListenerConn *c, *next;
+
+    pthread_mutex_lock(&s->lock);
+    for (c = s->conns; c; c = next) {
+        next = c->next;
+        if (c->busy)
+            continue;
+        if (now - c->lastActive > s->idleTimeout ||
+            (c->deadline && now >= c->deadline))
+            closeConn(s, c);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void drainWakeups(ListenerState *s)
+{
+    char buf[64];
+
+    while (read(s->wakeFds[0], buf, sizeof(buf)) > 0);
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+
+static void waitForEvents(ListenerState *s)
+{
+    struct epoll_event ev[LISTENER_MAX_EVENTS];
+    int n, k;
+
+    n = epoll_wait(s->epollFd, ev, LISTENER_MAX_EVENTS, 1000);
+    for (k = 0; k < n; k++) {
+        if (ev[k].data.ptr == NULL)
+            acceptConns(s);
+        else if (ev[k].data.ptr == s)
+            drainWakeups(s);
+        else {
+            pthread_mutex_lock(&s->lock);
+            queueJob(s, (ListenerConn *) ev[k].data.ptr);
+            pthread_mutex_unlock(&s->lock);
+        }
+    }
+}
+
+#else
+
+static void waitForEvents(ListenerState *s)
+{
+    ListenerConn *c;
+    int n = 2, k;
+
+    pthread_mutex_lock(&s->lock);
+    for (c = s->conns; ; c = c->next) {
+        if (n >= s->maxFds) {
+            s->maxFds = s->maxFds ? s->maxFds * 2 : 64;
+            s->fds = (struct pollfd *)
+                realloc(s->fds, s->maxFds * sizeof(struct pollfd));
+            s->fdConns = (ListenerConn **)
+                realloc(s->fdConns, s->maxFds * sizeof(ListenerConn *));
+        }
+        if (c == NULL)
+            break;
+        if (c->busy)
+            continue;
+        s->fds[n].fd = c->fd;
+        s->fds[n].events = POLLIN;
+        s->fdConns[n++] = c;
+    }
+    pthread_mutex_unlock(&s->lock);
+    s->fds[0].fd = s->listenFd;
+    s->fds[0].events = POLLIN;
+    s->fds[1].fd = s->wakeFds[0];
+    s->fds[1].events = POLLIN;
+
+    if (poll(s->fds, n, 1000) <= 0)
+        return;
+    if (s->fds[1].revents)
+        drainWakeups(s);
+    if (s->fds[0].revents)
+        acceptConns(s);
+    pthread_mutex_lock(&s->lock);
+    for (k = 2; k < n; k++)
+        if (s->fds[k].revents)
+            queueJob(s, s->fdConns[k]);
+    pthread_mutex_unlock(&s->lock);
+}
+
+#endif
+
+static void initQueue(IndicationQueue *q, int size)
+{
+    unsigned long n = 2, k;
+
+    while (n < (unsigned long) size)
+        n *= 2;
+    q->slots = (QueueSlot *) malloc(n * sizeof(QueueSlot));
+    for (k = 0; k < n; k++)
+        q->slots[k].seq = k;
+    q->mask = n - 1;
+    q->head = q->tail = 0;
+}
+
+/* returns 0 if the queue is full */
+static int queuePut(IndicationQueue *q, CIMCInstance *inst)
+{
+    unsigned long pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    QueueSlot *slot;
+    long dif;
+
+    for (;;) {
+        slot = &q->slots[pos & q->mask];
+        dif = (long) (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (dif < 0)
+            return 0;
+        else
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    }
+    slot->inst = inst;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/* returns NULL if the queue is empty */
+static CIMCInstance *queueTake(IndicationQueue *q)
+{
+    unsigned long pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    QueueSlot *slot;
+    CIMCInstance *inst;
+    long dif;
+
+    for (;;) {
+        slot = &q->slots[pos & q->mask];
+        dif = (long) (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (dif < 0)
+            return NULL;
+        else
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    }
+    inst = slot->inst;
+    __atomic_store_n(&slot->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+    return inst;
+}
+
+/* counts the positions claimed, some may not be put or taken yet */
+static unsigned long queueDepth(IndicationQueue *q)
+{
+    unsigned long head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    unsigned long depth = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) - head;
+
+    return depth > q->mask + 1 ? q->mask + 1 : depth;
+}
+
+/*
+ * A thread about to sleep announces it, then looks at the queue again;
+ * a thread changing the queue does it the other way round, so one of
+ * them sees the other.
+ */
+
+static void waitForRoom(ListenerState *s)
+{
+    pthread_mutex_lock(&s->queueLock);
+    __atomic_add_fetch(&s->roomWaiters, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (queueDepth(&s->queue) > s->queue.mask)
+        pthread_cond_wait(&s->notFull, &s->queueLock);
+    __atomic_sub_fetch(&s->roomWaiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&s->queueLock);
+}
+
+/* waits for wants indications, until the workers are done or the
+   deadline, if any */
+static void waitForIndications(ListenerState *s, int wants,
+                               struct timespec *deadline)
+{
+    pthread_mutex_lock(&s->queueLock);
+    __atomic_store_n(&s->delivererWants, wants, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (queueDepth(&s->queue) < (unsigned long) wants && !s->workersDone) {
+        if (deadline == NULL)
+            pthread_cond_wait(&s->notEmpty, &s->queueLock);
+        else if (pthread_cond_timedwait(&s->notEmpty, &s->queueLock,
+                                        deadline) == ETIMEDOUT)
+            break;
+    }
+    __atomic_store_n(&s->delivererWants, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&s->queueLock);
+}
+
+/* called by a worker with a request that is not a valid indication */
+static void countMalformed(ListenerState *s)
+{
+    __sync_fetch_and_add(&s->malformed, 1);
+}
+
+/* called by a worker with a decoded indication, the listener owns inst */
+static void queueIndication(ListenerState *s, CIMCInstance *inst)
+{
+    CIMCInstance *old;
+    int waited = 0, wants;
+
+    while (!queuePut(&s->queue, inst)) {
+        if (s->overflow == CIMC_OVERFLOW_DROP_NEWEST) {
+            inst->ft->release(inst);
+            __sync_fetch_and_add(&s->dropped, 1);
+            return;
+        }
+        if (s->overflow == CIMC_OVERFLOW_DROP_OLDEST) {
+            if ((old = queueTake(&s->queue)) != NULL) {
+                old->ft->release(old);
+                __sync_fetch_and_add(&s->dropped, 1);
             }
-            handleConnection(connFd, i);
-            close(connFd);
+            continue;
         }
+        if (!waited++)
+            __sync_fetch_and_add(&s->blocked, 1);
+        waitForRoom(s);
     }
 
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    wants = __atomic_load_n(&s->delivererWants, __ATOMIC_RELAXED);
+    if (wants && queueDepth(&s->queue) >= (unsigned long) wants) {
+        pthread_mutex_lock(&s->queueLock);
+        pthread_cond_signal(&s->notEmpty);
+        pthread_mutex_unlock(&s->queueLock);
+    }
+}
+
+static int pastDeadline(struct timespec *deadline)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return now.tv_sec > deadline->tv_sec ||
+           (now.tv_sec == deadline->tv_sec &&
+            now.tv_usec * 1000 >= deadline->tv_nsec);
+}
+
+/*
+ * Calls the callback for each indication, or the batch callback with up
+ * to batchSize of them: as many as are queued, or, given a linger time,
+ * as many as are queued within it after the first one.
+ */
+static void *deliverIndications(void *parm)
+{
+    ListenerState *s = (ListenerState *) parm;
+    CIMCInstance **batch = NULL, *inst;
+    struct timespec deadline;
+    struct timeval now;
+    int n = 0, done;
+
+    if (s->batchFp)
+        batch = (CIMCInstance **) malloc(s->batchSize * sizeof(CIMCInstance *));
+
+    for (;;) {
+        done = __atomic_load_n(&s->workersDone, __ATOMIC_ACQUIRE);
+        inst = queueTake(&s->queue);
+        if (inst) {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&s->roomWaiters, __ATOMIC_RELAXED)) {
+                pthread_mutex_lock(&s->queueLock);
+                pthread_cond_broadcast(&s->notFull);
+                pthread_mutex_unlock(&s->queueLock);
+            }
+            if (batch == NULL) {
+                __sync_fetch_and_add(&s->delivered, 1);
+                s->fp(inst);
+                continue;
+            }
+            if (n == 0 && s->linger) {
+                gettimeofday(&now, NULL);
+                deadline.tv_sec = now.tv_sec + s->linger / 1000;
+                deadline.tv_nsec = now.tv_usec * 1000 +
+                                   (s->linger % 1000) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+            }
+            batch[n++] = inst;
+            if (n < s->batchSize)
+                continue;
+        }
+        else if (queueDepth(&s->queue)) {
+            /* claimed by a worker not done putting it */
+            sched_yield();
+            continue;
+        }
+        else if (n && s->linger && !done && !pastDeadline(&deadline)) {
+            waitForIndications(s, s->batchSize - n, &deadline);
+            continue;
+        }
+        else if (n == 0) {
+            if (done)
+                break;
+            waitForIndications(s, 1, NULL);
+            continue;
+        }
+        __sync_fetch_and_add(&s->delivered, n);
+        s->batchFp(batch, n);
+        n = 0;
+    }
+
+    free(batch);
     return NULL;
 }
 
-static void* start_listen_thread(void *parms)
+static void *listenWorker(void *parm)
 {
-    struct native_indicationlistener* i;
-    i = (struct native_indicationlistener*) parms;
-    establish_listener(i->sslMode, i->port, i);   
+    ListenerState *s = (ListenerState *) parm;
+    ParserHeap *heap = parser_heap_init();
+    ListenerConn *c;
+    int keep;
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (s->firstJob == NULL && !s->stopping)
+            pthread_cond_wait(&s->jobReady, &s->lock);
+        if ((c = s->firstJob) == NULL) {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        if ((s->firstJob = c->nextJob) == NULL)
+            s->lastJob = NULL;
+        pthread_mutex_unlock(&s->lock);
+
+        keep = handleRequest(c->fd, &c->in, s, heap);
+        if (c->in.length == 0 && c->in.size > LISTENER_BUFFER_KEEP)
+            freeBuffer(&c->in);
+
+        pthread_mutex_lock(&s->lock);
+        if (keep < 0 && !s->stopping) {
+            /* waits for the rest of the request, but not for ever */
+            c->lastActive = time(NULL);
+            if (c->deadline == 0)
+                c->deadline = c->lastActive + LISTENER_REQUEST_TIMEOUT;
+            c->busy = 0;
+            watchConn(s, c, 0);
+        }
+        else if (keep && !s->stopping) {
+            c->lastActive = time(NULL);
+            c->deadline = 0;
+            if (c->in.length)
+                /* the next request was read already, it won't be polled */
+                queueJob(s, c);
+            else {
+                c->busy = 0;
+                watchConn(s, c, 0);
+            }
+        }
+        else
+            closeConn(s, c);
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    parser_heap_term(heap);
     return NULL;
 }
 
+static void freeListenerState(ListenerState *s)
+{
+    while (s->conns)
+        closeConn(s, s->conns);
+    close(s->listenFd);
+    close(s->wakeFds[0]);
+    close(s->wakeFds[1]);
+#ifdef HAVE_SYS_EPOLL_H
+    close(s->epollFd);
+#else
+    free(s->fds);
+    free(s->fdConns);
+#endif
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->jobReady);
+    free(s->queue.slots);
+    pthread_mutex_destroy(&s->queueLock);
+    pthread_cond_destroy(&s->notEmpty);
+    pthread_cond_destroy(&s->notFull);
+    free(s->workers);
+    free(s);
+}
+
+static void* listenLoop(void *parms)
+{
+    ListenerState *s = (ListenerState *) parms;
+    ListenerConn *c;
+    time_t now, lastScan = 0;
+    int k;
+
+    while (!__atomic_load_n(&s->stopping, __ATOMIC_ACQUIRE)) {
+        waitForEvents(s);
+        now = time(NULL);
+        if (now != lastScan) {
+            closeIdleConns(s, now);
+            lastScan = now;
+        }
+    }
+
+    /* workers waiting for a client to read its responses give up */
+    pthread_mutex_lock(&s->lock);
+    for (c = s->conns; c; c = c->next)
+        shutdown(c->fd, SHUT_RDWR);
+    pthread_cond_broadcast(&s->jobReady);
+    pthread_mutex_unlock(&s->lock);
+    for (k = 0; k < s->nWorkers; k++)
+        pthread_join(s->workers[k], NULL);
+
+    /* what was queued is still delivered */
+    pthread_mutex_lock(&s->queueLock);
+    __atomic_store_n(&s->workersDone, 1, __ATOMIC_RELEASE);
+    pthread_cond_signal(&s->notEmpty);
+    pthread_mutex_unlock(&s->queueLock);
+    pthread_join(s->deliverer, NULL);
+
+    if (s->detached)
+        freeListenerState(s);
+    return NULL;
+}
+
+/* a socket bound to port, 0 for any, and listening */
+static int openListenSocket(int *port, int backlog)
+{
+    struct sockaddr_in sin;
+    socklen_t sin_len = sizeof(sin);
+    int listenFd;
+    int ru = 1;
+
+    listenFd = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenFd < 0)
+        return -1;
+
+    memset(&sin, 0, sin_len);
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = INADDR_ANY;
+    sin.sin_port = htons(*port);
+    
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, (char *) &ru, sizeof(ru));
+    
+    if (bind(listenFd, (struct sockaddr *) &sin, sin_len) ||
+        listen(listenFd, backlog) ||
+        getsockname(listenFd, (struct sockaddr *) &sin, &sin_len)) {
+        close(listenFd);
+        return -1;
+    }
+    *port = ntohs(sin.sin_port);
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+    return listenFd;
+}
+
 static CIMCStatus _ilft_release(CIMCIndicationListener* il)
 {
     struct native_indicationlistener* i = (struct native_indicationlistener*)
                                           il;
                                           
     if(i) {
+        il->ft->stop(il);
         free(i);
     }
     CIMCStatus ret;
@@ -499,31 +1147,125 @@ static CIMCIndicationListener* _ilft_clone(CIMCIndicationListener* il,
 
 static CIMCStatus _ilft_start(CIMCIndicationListener* il)
 {
-    pthread_t id;
     struct native_indicationlistener* i;
+    ListenerState *s;
+    CIMCStatus ret = { CIMC_RC_OK, NULL };
+    int k;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+#endif
     
     i = (struct native_indicationlistener*) il;
-    
-    do_listen = 1;
-    
-    pthread_create(&id, NULL, &start_listen_thread, i);
+    if (i->state)
+        return ret;
 
-    CIMCStatus ret;
-    ret.rc = CIMC_RC_OK;
-    ret.msg = NULL;
+    s = (ListenerState *) calloc(1, sizeof(ListenerState));
+    s->listenFd = openListenSocket(&i->port, i->backlog);
+    if (s->listenFd < 0) {
+        free(s);
+        ret.rc = CIMC_RC_ERR_FAILED;
+        ret.msg = (CIMCString *) native_new_CMPIString(
+                     "Unable to listen on the indication port", NULL);
+        return ret;
+    }
+    if (pipe(s->wakeFds) == 0) {
+        fcntl(s->wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(s->wakeFds[1], F_SETFL, O_NONBLOCK);
+    }
+    s->idleTimeout = i->idleTimeout;
+    s->fp = i->sendIndicationInstance;
+    s->batchFp = i->sendIndicationBatch;
+    s->overflow = i->overflow;
+    s->batchSize = i->batchSize > 0 ? i->batchSize : 1;
+    s->linger = i->linger;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->jobReady, NULL);
+    initQueue(&s->queue, i->queueSize);
+    pthread_mutex_init(&s->queueLock, NULL);
+    pthread_cond_init(&s->notEmpty, NULL);
+    pthread_cond_init(&s->notFull, NULL);
+
+#ifdef HAVE_SYS_EPOLL_H
+    s->epollFd = epoll_create(LISTENER_MAX_EVENTS);
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(s->epollFd, EPOLL_CTL_ADD, s->listenFd, &ev);
+    ev.data.ptr = s;
+    epoll_ctl(s->epollFd, EPOLL_CTL_ADD, s->wakeFds[0], &ev);
+#endif
+
+    s->nWorkers = i->workers > 0 ? i->workers : 1;
+    s->workers = (pthread_t *) calloc(s->nWorkers, sizeof(pthread_t));
+    pthread_create(&s->deliverer, NULL, deliverIndications, s);
+    for (k = 0; k < s->nWorkers; k++)
+        pthread_create(&s->workers[k], NULL, listenWorker, s);
+    pthread_create(&s->thread, NULL, listenLoop, s);
+
+    i->state = s;
     return ret;
 }
 
 static CIMCStatus _ilft_stop(CIMCIndicationListener* il)
 {
-    do_listen = 0;
+    struct native_indicationlistener* i = (struct native_indicationlistener*) il;
+    ListenerState *s = i->state;
+    CIMCStatus ret = { CIMC_RC_OK, NULL };
 
-    CIMCStatus ret;
-    ret.rc = CIMC_RC_OK;
-    ret.msg = NULL;
+    if (s == NULL)
+        return ret;
+    i->state = NULL;
+
+    pthread_mutex_lock(&s->lock);
+    __atomic_store_n(&s->stopping, 1, __ATOMIC_RELEASE);
+    /* a callback can't wait for its own thread */
+    s->detached = pthread_equal(s->deliverer, pthread_self());
+    pthread_mutex_unlock(&s->lock);
+    wakeListener(s);
+
+    if (s->detached)
+        pthread_detach(s->thread);
+    else
+        pthread_join(s->thread, NULL);
+    i->delivered += __sync_fetch_and_add(&s->delivered, 0);
+    i->dropped += __sync_fetch_and_add(&s->dropped, 0);
+    i->blocked += __sync_fetch_and_add(&s->blocked, 0);
+    i->malformed += __sync_fetch_and_add(&s->malformed, 0);
+    if (!s->detached)
+        freeListenerState(s);
     return ret;
 }
 
+static CIMCUint64 _ilft_getCounter(CIMCIndicationListener* il, int counter,
+                                   CIMCStatus* rc)
+{
+    struct native_indicationlistener* i = (struct native_indicationlistener*) il;
+    ListenerState *s = i->state;
+    CIMCUint64 value = 0;
+
+    CMSetStatus(rc, CIMC_RC_OK);
+    switch (counter) {
+    case CIMC_CNT_LISTENER_QUEUED:
+        if (s)
+            value = queueDepth(&s->queue);
+        break;
+    case CIMC_CNT_LISTENER_DELIVERED:
+        value = i->delivered + (s ? __sync_fetch_and_add(&s->delivered, 0) : 0);
+        break;
+    case CIMC_CNT_LISTENER_DROPPED:
+        value = i->dropped + (s ? __sync_fetch_and_add(&s->dropped, 0) : 0);
+        break;
+    case CIMC_CNT_LISTENER_BLOCKED:
+        value = i->blocked + (s ? __sync_fetch_and_add(&s->blocked, 0) : 0);
+        break;
+    case CIMC_CNT_LISTENER_MALFORMED:
+        value = i->malformed + (s ? __sync_fetch_and_add(&s->malformed, 0) : 0);
+        break;
+    default:
+        CMSetStatus(rc, CIMC_RC_ERR_NOT_SUPPORTED);
+    }
+    return value;
+}
+
 CIMCIndicationListener *newCIMCIndicationListener(int sslMode,
                                                   int *portNumber,
                                                   void (*fp) (CIMCInstance *indInstance),
@@ -534,7 +1276,8 @@ CIMCIndicationListener *newCIMCIndicationListener(int sslMode,
         _ilft_release,
         _ilft_clone,
         _ilft_start,
-        _ilft_stop
+        _ilft_stop,
+        _ilft_getCounter
     };
     
     static CIMCIndicationListener il = {
@@ -549,6 +1292,12 @@ CIMCIndicationListener *newCIMCIndicationListener(int sslMode,
     indicationlistener->il = il;
     indicationlistener->port = *portNumber;
     indicationlistener->sslMode = sslMode;
+    indicationlistener->backlog = LISTENER_DEFAULT_BACKLOG;
+    indicationlistener->workers = LISTENER_DEFAULT_WORKERS;
+    indicationlistener->idleTimeout = LISTENER_DEFAULT_IDLE_TIMEOUT;
+    indicationlistener->queueSize = LISTENER_DEFAULT_QUEUE_SIZE;
+    indicationlistener->overflow = CIMC_OVERFLOW_BLOCK;
+    indicationlistener->batchSize = LISTENER_DEFAULT_BATCH_SIZE;
     indicationlistener->sendIndicationInstance = fp;
     
     return (CIMCIndicationListener*) indicationlistener;
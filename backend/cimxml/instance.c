@@ -29,6 +29,7 @@
 #include "cmcift.h"
 #include "cmcimacs.h"
 #include "native.h"
+#include "utilft.h"
 
 #ifdef DMALLOC
 #include "dmalloc.h"
@@ -88,8 +89,8 @@ static CMPIStatus __ift_release ( CMPIInstance * instance )
 	struct native_instance * i = (struct native_instance *) instance;
 
 	if (i) {
-	    if (i->classname) free(i->classname);
-	    if (i->nameSpace) free(i->nameSpace);
+	    internStringRelease(i->classname);
+	    internStringRelease(i->nameSpace);
 	    __release_list ( i->property_list );
 	    __release_list ( i->key_list );
             propertyFT.release(i->props);
@@ -109,8 +110,8 @@ static CMPIInstance * __ift_clone ( CMPIInstance * instance, CMPIStatus * rc )
 			       calloc ( 1, sizeof ( struct native_instance ) );
 
 	new->instance.ft=i->instance.ft;
-        if (i->classname) new->classname     = strdup ( i->classname );
-	if (i->nameSpace) new->nameSpace     = strdup ( i->nameSpace );
+	new->classname     = internStringRef ( i->classname );
+	new->nameSpace     = internStringRef ( i->nameSpace );
 	new->property_list = __duplicate_list ( i->property_list );
 	new->key_list      = __duplicate_list ( i->key_list );
 	new->qualifiers    = qualifierFT.clone ( i->qualifiers, rc );
@@ -341,11 +342,11 @@ CMPIInstance * native_new_CMPIInstance ( CMPIObjectPath * cop,
 	   int j = CMGetKeyCount ( cop, &tmp1 );
     
       str = CMGetClassName ( cop, &tmp2 );
-	  instance->classname = strdup(CMGetCharPtr ( str ));
+	  instance->classname = internString(CMGetCharPtr ( str ));
       CMRelease(str);
       
       str = CMGetNameSpace ( cop, &tmp3 );
-      instance->nameSpace = (str && str->hdl) ? strdup(CMGetCharPtr ( str )) : NULL;
+      instance->nameSpace = (str && str->hdl) ? internString(CMGetCharPtr ( str )) : NULL;
       if (str) CMRelease(str);
 
 	   if ( tmp1.rc != CMPI_RC_OK ||
@@ -377,8 +378,14 @@ void setInstNsAndCn(CMPIInstance *ci, const char *ns, char *cn)
 {
    struct native_instance * i = (struct native_instance *) ci;
    
-   if (cn) i->classname=strdup(cn);
-   if (ns) i->nameSpace=strdup(ns);
+   if (cn) {
+      internStringRelease(i->classname);
+      i->classname=internString(cn);
+   }
+   if (ns) {
+      internStringRelease(i->nameSpace);
+      i->nameSpace=internString(ns);
+   }
 }
 
 int addInstQualifier( CMPIInstance* ci, char * name,
@@ -401,6 +408,15 @@ int addInstQualifier( CMPIInstance* ci, char * name,
 	return ( CMPI_RC_OK );
 }
 
+/* a property converted from its text when it is first read, see property.c */
+int setInstRawProperty( CMPIInstance* ci, char * name, CMPIType type,
+				      char ** values, unsigned int count)
+{
+   struct native_instance * i = (struct native_instance *) ci;
+
+   return propertyFT.setRawProperty ( &i->props, name, type, values, count );
+}
+
 int addInstPropertyQualifier( CMPIInstance* ci, char * pname, char *qname,
 				      CMPIValue * value,
 				      CMPIType type)
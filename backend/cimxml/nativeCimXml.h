@@ -31,14 +31,28 @@ CIMCIndicationListener *newCIMCIndicationListener (int sslMode,
                                                    void (*fp) (CIMCInstance *indInstance),
                                                    CIMCStatus *rc);
 
+CIMCResultTable *newCIMCResultTable (const char *nameSpace);
+
 
 struct native_indicationlistener {
 	CIMCIndicationListener il;
 
 	int sslMode;
-	int port;
+	int port;               /* 0 to pick one, set when started */
+	int backlog;            /* connections waiting to be accepted */
+	int workers;            /* threads reading and decoding indications */
+	int idleTimeout;        /* seconds a keep-alive connection may idle */
+	int queueSize;          /* decoded indications waiting to be delivered */
+	int overflow;           /* CIMC_OVERFLOW_BLOCK ... when the queue is full */
+	int batchSize;          /* most indications passed to sendIndicationBatch */
+	int linger;             /* milliseconds a batch may wait to fill */
     
     void (*sendIndicationInstance) (CIMCInstance *indInstance);
+    void (*sendIndicationBatch) (CIMCInstance **indInstances, CIMCCount count);
+
+	CIMCUint64 delivered, dropped, blocked, malformed;   /* by earlier starts */
+
+	struct _ListenerState *state;   /* while listening */
 };
 
 
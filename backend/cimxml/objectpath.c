@@ -44,13 +44,14 @@ UtilList *getNameSpaceComponents(CMPIObjectPath * cop);
 
 extern char *keytype2Chars(CMPIType type);
 extern char *value2Chars(CMPIType type, CMPIValue * value);
+extern void value2Xml(CMPIType type, CMPIValue * value, UtilStringBuffer *sb);
 
 
 struct native_cop {
 	CMPIObjectPath cop;
 	char * nameSpace;
 	char * classname;
-	struct native_property * keys;
+	struct native_propertyTable * keys;
 };
 
 
@@ -67,8 +68,8 @@ static CMPIStatus __oft_release ( CMPIObjectPath * cop )
 
 	if ( o ) {
  
-		if (o->classname) free ( o->classname );
-		if (o->nameSpace) free ( o->nameSpace );
+		internStringRelease ( o->classname );
+		internStringRelease ( o->nameSpace );
  		propertyFT.release ( o->keys );
 
 		free ( o );
@@ -84,11 +85,11 @@ static CMPIObjectPath * __oft_clone ( CMPIObjectPath * cop, CMPIStatus * rc )
 {
 	CMPIStatus tmp;
 	struct native_cop * o   = (struct native_cop *) cop;
-	struct native_cop * new = __new_empty_cop ( o->nameSpace,
-						    o->classname,
-						    &tmp );
+	struct native_cop * new = __new_empty_cop ( NULL, NULL, &tmp );
 
 	if ( tmp.rc == CMPI_RC_OK ) {
+		new->classname = internStringRef ( o->classname );
+		new->nameSpace = internStringRef ( o->nameSpace );
 		new->keys = propertyFT.clone ( o->keys, rc );
 
 	} else
@@ -105,10 +106,9 @@ static CMPIStatus __oft_setNameSpace ( CMPIObjectPath * cop,
 	struct native_cop * o = (struct native_cop *) cop;
 
 	if ( o ) {
-		char * ns = ( nameSpace )? strdup ( nameSpace ): NULL;
+		char * ns = internString ( nameSpace );
   
-		if ( o->nameSpace )
-		     free ( o->nameSpace );
+		internStringRelease ( o->nameSpace );
 	    o->nameSpace = ns;
 	}
 	CMReturn ( CMPI_RC_OK );
@@ -144,10 +144,9 @@ static CMPIStatus __oft_setClassName ( CMPIObjectPath * cop,
 	struct native_cop * o = (struct native_cop *) cop;
 
 	if ( o ) {
-		char * cn = ( classname )? strdup ( classname ): NULL;
+		char * cn = internString ( classname );
   
-		if ( o->classname )
-		    free ( o->classname );
+		internStringRelease ( o->classname );
 	    o->classname = cn;
 	}
 
@@ -255,8 +254,8 @@ static struct native_cop * __new_empty_cop ( const char * nameSpace,
 	      (struct native_cop *) calloc ( 1, sizeof ( struct native_cop ) );
 
 	cop->cop       = o;
-	cop->classname = ( classname )? strdup ( classname ): NULL;
-	cop->nameSpace = ( nameSpace )? strdup ( nameSpace ): NULL;
+	cop->classname = internString ( classname );
+	cop->nameSpace = internString ( nameSpace );
 
 	CMSetStatus ( rc, CMPI_RC_OK );
 	return cop;
@@ -311,11 +310,13 @@ int sameCMPIObjectPath (const CMPIObjectPath *cop1, const CMPIObjectPath *cop2)
    char *cv1, *cv2;
 
    /* Check if name spaces are the same */
-   if (strcasecmp(ncop1->nameSpace, ncop2->nameSpace) != 0)
+   if (ncop1->nameSpace != ncop2->nameSpace &&
+       strcasecmp(ncop1->nameSpace, ncop2->nameSpace) != 0)
       return 0;
 
    /* Check if classnames are the same */
-   if (strcasecmp(ncop1->classname, ncop2->classname) != 0)
+   if (ncop1->classname != ncop2->classname &&
+       strcasecmp(ncop1->classname, ncop2->classname) != 0)
       return 0;
 
    /* Check if the key count is the same */
@@ -474,7 +475,6 @@ void pathToXml(UtilStringBuffer *sb, CMPIObjectPath *cop)
    int i,s;
    CMPIData data;
    CMPIString *name;
-   char *cv;
 
    for (i=0,s=__oft_getKeyCount(cop,NULL); i<s; i++) {
       data=__oft_getKeyAt(cop,i,&name,NULL);
@@ -514,11 +514,10 @@ void pathToXml(UtilStringBuffer *sb, CMPIObjectPath *cop)
          CMRelease(cn);
       }
       else {
-         cv = value2Chars(data.type,&data.value);
-         sb->ft->append5Chars(sb,"<KEYVALUE VALUETYPE=\"",
-                                 keytype2Chars(data.type),"\">",cv,
-                                 "</KEYVALUE>");
-        if (cv) free (cv);
+         sb->ft->append3Chars(sb,"<KEYVALUE VALUETYPE=\"",
+                                 keytype2Chars(data.type),"\">");
+         value2Xml(data.type,&data.value,sb);
+         sb->ft->appendChars(sb,"</KEYVALUE>");
       }
 
       sb->ft->appendChars(sb,"</KEYBINDING>\n");
@@ -27,14 +27,13 @@
 #include "cimXmlParser.h"
 #include "sfcUtil/utilft.h"
 
-static int ct = 0;
-static int dontLex = 0;
-
 extern CMPIConstClass * native_new_CMPIConstClass ( char  *cn, CMPIStatus * rc );
 extern int addClassProperty( CMPIConstClass * ccls, char * name,
                  CMPIValue * value, CMPIType type,
                  CMPIValueState state);
 extern CMPIType guessType(char *val);
+extern int setInstRawProperty( CMPIInstance* ci, char * name, CMPIType type,
+                     char ** values, unsigned int count);
 extern int addInstPropertyQualifier( CMPIInstance* ci, char * pname,
                      char *qname, CMPIValue * value,
                      CMPIType type);
@@ -54,6 +53,7 @@ extern int addClassMethodParameter( CMPIConstClass* cc, char * mname,
                       char *pname,
                       CMPIType type);
 extern char *XmlToAsciiStr(char *XmlStr);
+extern char *XmlToAsciiInPlace(char *XmlStr);
 
 #if DEBUG
 extern int do_debug;
@@ -87,11 +87,43 @@ void createPath(CMPIObjectPath **op, XtokInstanceName *p)
    }
 }
 
+/*
+ * Values of these types are converted when the property is first read,
+ * embedded instances have been parsed already and the type of untyped
+ * values is only known after conversion.
+ */
+static int isRawType(CMPIType type)
+{
+   return type != CMPI_null && type != CMPI_instance && type != CMPI_ref;
+}
+
+/* the values of an array property */
+static CMPIArray *newPropertyArray(XtokProperty *p)
+{
+   CMPIType type = p->valueType;
+   CMPIArray *arr = newCMPIArray(0, type, NULL);
+   CMPIValue val;
+   char *valStr;
+   int i;
+
+   if (p->val.array.max > 0) {
+      for (i = 0; i < p->val.array.next; ++i) {
+         valStr = p->val.array.values[i];
+         if (type == CMPI_string || type == CMPI_chars)
+            val = str2CMPIValue(type, XmlToAsciiInPlace(valStr), NULL);
+         else
+            val = str2CMPIValue(type, valStr, NULL);
+         CMSetArrayElementAt(arr, i, &val, type);
+         native_release_CMPIValue(type, &val);
+      }
+   }
+   return arr;
+}
+
 void setInstProperties(CMPIInstance *ci, XtokProperties *ps)
 {
    XtokProperty *np = NULL,*p = ps ? ps->first : NULL;
    CMPIValue val;
-   CMPIStatus status;
    CMPIType   type = CMPI_null;
    XtokQualifier *nq = NULL,*q;
    XtokQualifiers *qs;
@@ -102,11 +134,12 @@ void setInstProperties(CMPIInstance *ci, XtokProperties *ps)
       switch (p->propType) {
       case typeProperty_Value:
          type = p->valueType;
-         if (p->val.value.data.value != NULL && p->val.null==0) {
+         if (p->val.value.data.value != NULL && p->val.null==0 && isRawType(type)) {
+            setInstRawProperty(ci, p->name, type, &p->val.value.data.value, 1);
+         }
+         else if (p->val.value.data.value != NULL && p->val.null==0) {
             if (type == CMPI_string || type == CMPI_chars) {
-                char *charsStr = XmlToAsciiStr(p->val.value.data.value);
-                val = str2CMPIValue(type, charsStr, NULL);
-                free (charsStr);
+                val = str2CMPIValue(type, XmlToAsciiInPlace(p->val.value.data.value), NULL);
             }
             else
                 val = str2CMPIValue(type, p->val.value.data.value, NULL);
@@ -125,27 +158,14 @@ void setInstProperties(CMPIInstance *ci, XtokProperties *ps)
          break;
       case typeProperty_Array:
          type = p->valueType;
-         if (p->val.array.next > 0) {
-            CMPIArray *arr = newCMPIArray(0, type, &status);
-            if (p->val.array.max > 0) {
-            int i;
-               for (i = 0; i < p->val.array.next; ++i)
-               {
-                   char *valStr = p->val.array.values[i];
-                   if (type == CMPI_string || type == CMPI_chars) {
-                       char *charsStr = XmlToAsciiStr(valStr);
-                       val = str2CMPIValue(type, charsStr, NULL);
-                       free (charsStr);
-                   }
-                   else
-                       val = str2CMPIValue(type, valStr, NULL);
-                   CMSetArrayElementAt(arr, i, &val, type);
-               native_release_CMPIValue(type, &val);
-               }
-            }
-            val.array = arr;
+         if (p->val.array.next > 0 && p->val.array.max > 0 && isRawType(type)) {
+            setInstRawProperty(ci, p->name, type | CMPI_ARRAY,
+                               p->val.array.values, p->val.array.next);
+         }
+         else if (p->val.array.next > 0) {
+            val.array = newPropertyArray(p);
             CMSetProperty(ci, p->name, &val, type | CMPI_ARRAY);
-            CMRelease(arr);         /* cloned in property */
+            CMRelease(val.array);   /* cloned in property */
          }
          else {
             CMSetProperty(ci, p->name, NULL, p->valueType | CMPI_ARRAY);
@@ -194,6 +214,65 @@ void setInstProperties(CMPIInstance *ci, XtokProperties *ps)
       ps->first = ps->last =  NULL;
 }
 
+/*
+ * The counterpart of createPath() and setInstProperties() for
+ * CIMCResultTables: adds a row and sets the properties, then the keys
+ * the instance doesn't have as properties. Strings and datetimes go to
+ * the table as text, without creating CMPIStrings.
+ */
+void addTableRow(struct _CIMCResultTable *rt, XtokNamedInstance *ni)
+{
+   XtokProperty *p;
+   XtokKeyBinding *b;
+   CMPIValue val, *valp;
+   CMPIType type;
+   char *text;
+
+   tableNewRow(rt, ni->instance.className);
+
+   for (p = ni->instance.properties.first; p; p = p->next) {
+      type = p->valueType;
+      switch (p->propType) {
+      case typeProperty_Value:
+         text = p->val.value.data.value;
+         if (text == NULL || p->val.null)
+            tableSetValue(rt, p->name, NULL, type);
+         else if (type == CMPI_string || type == CMPI_chars)
+            tableSetChars(rt, p->name, CMPI_string, XmlToAsciiInPlace(text));
+         else if (type == CMPI_dateTime)
+            tableSetChars(rt, p->name, type, text);
+         else {
+            val = str2CMPIValue(type, text, NULL);
+            tableSetValue(rt, p->name, &val, type);
+            native_release_CMPIValue(type, &val);
+         }
+         break;
+      case typeProperty_Reference:
+         val = str2CMPIValue(CMPI_ref, NULL, &p->val.ref);
+         tableAdoptValue(rt, p->name, &val, CMPI_ref);
+         break;
+      case typeProperty_Array:
+         if (p->val.array.next > 0) {
+            val.array = newPropertyArray(p);
+            tableAdoptValue(rt, p->name, &val, type | CMPI_ARRAY);
+         }
+         else
+            tableSetValue(rt, p->name, NULL, type | CMPI_ARRAY);
+         break;
+      }
+   }
+
+   for (b = ni->path.bindings.first; b; b = b->next) {
+      valp = getKeyValueTypePtr(b->type, b->val.keyValue.value,
+                                &b->val.ref, &val, &type);
+      tableSetKey(rt, b->name, valp, type);
+      if (type == CMPI_ref)
+         CMRelease(valp->ref);
+   }
+
+   ni->instance.properties.first = ni->instance.properties.last = NULL;
+}
+
 void setInstQualifiers(CMPIInstance *ci, XtokQualifiers *qs)
 {
    XtokQualifier *nq = NULL,*q = qs ? qs->first : NULL;
@@ -361,9 +440,7 @@ void setClassQualifiers(CMPIConstClass *cls, XtokQualifiers *qs)
                    char *valStr = q->data.array.values[i];
                    if (type == CMPI_string || type == CMPI_chars)
                    {
-                       char *charsStr = XmlToAsciiStr(valStr);
-                       val = str2CMPIValue(type, charsStr, NULL);
-                       free (charsStr);
+                       val = str2CMPIValue(type, XmlToAsciiInPlace(valStr), NULL);
                    }
                    else
                        val = str2CMPIValue(type, valStr, NULL);
@@ -378,9 +455,7 @@ void setClassQualifiers(CMPIConstClass *cls, XtokQualifiers *qs)
           char *valStr = q->data.value.data.value;
           if (q->type == CMPI_string || q->type == CMPI_chars)
           {
-              char *charsStr = XmlToAsciiStr(valStr);
-              val = str2CMPIValue(q->type, charsStr, NULL);
-              free (charsStr);
+              val = str2CMPIValue(q->type, XmlToAsciiInPlace(valStr), NULL);
           }
           else
               val = str2CMPIValue(q->type, valStr, NULL);
@@ -476,7 +551,8 @@ void setError(ParserControl *parm, XtokErrorResp *e)
                                  e->code, e->description);
 #endif
    parm->respHdr.errCode = atoi(e->code);
-   parm->respHdr.description = XmlToAsciiStr(e->description);
+   parm->respHdr.description = e->description ?
+                               XmlToAsciiStr(e->description) : NULL;
 }
 
 void setReturnArgs(ParserControl *parm, XtokParamValues *ps)
@@ -505,3 +581,50 @@ void setReturnArgs(ParserControl *parm, XtokParamValues *ps)
         */
     }
 }
+
+/* moves the results of the SIMPLERSP just parsed to respHdr.responses */
+void addMultiResponse(ParserControl *parm)
+{
+    ResponseHdr *hdr = &parm->respHdr;
+    ResponseHdr *rsp;
+
+    hdr->responses = (ResponseHdr *) realloc(hdr->responses,
+                              (hdr->numResponses + 1) * sizeof(ResponseHdr));
+    rsp = &hdr->responses[hdr->numResponses++];
+    memset(rsp, 0, sizeof(ResponseHdr));
+    rsp->errCode = hdr->errCode;
+    rsp->description = hdr->description;
+    rsp->rvArray = hdr->rvArray;
+    rsp->outArgs = hdr->outArgs;
+    rsp->enumerationContext = hdr->enumerationContext;
+    rsp->endOfSequence = hdr->endOfSequence;
+
+    hdr->errCode = 0;
+    hdr->description = NULL;
+    hdr->outArgs = NULL;
+    hdr->enumerationContext = NULL;
+    hdr->endOfSequence = 0;
+    hdr->rvArray = newCMPIArray(0, 0, NULL);
+
+    /* objects of the next response belong to the namespace of its request */
+    if (hdr->numResponses < parm->numRequestObjectPaths)
+        parm->requestObjectPath = parm->requestObjectPaths[hdr->numResponses];
+}
+
+/* EnumerationContext and EndOfSequence returned by the pull operations */
+void setPullParamValue(ParserControl *parm, XtokParamValue *p)
+{
+    char *v;
+
+    /* both are plain VALUEs */
+    if (p->name == NULL || p->data.type != CMPI_null ||
+        (v = p->data.value.data.value) == NULL)
+        return;
+    if (strcasecmp(p->name, "EnumerationContext") == 0) {
+        if (parm->respHdr.enumerationContext)
+            free(parm->respHdr.enumerationContext);
+        parm->respHdr.enumerationContext = strdup(XmlToAsciiInPlace(v));
+    }
+    else if (strcasecmp(p->name, "EndOfSequence") == 0)
+        parm->respHdr.endOfSequence = strcasecmp(v, "TRUE") == 0;
+}
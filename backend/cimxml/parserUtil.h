@@ -29,6 +29,7 @@ extern CMPIConstClass * native_new_CMPIConstClass ( char  *cn, CMPIStatus * rc )
 static inline int isBoolean(CMPIData data);
 void createPath(CMPIObjectPath **op, XtokInstanceName *p);
 void setInstProperties(CMPIInstance *ci, XtokProperties *ps);
+void addTableRow(struct _CIMCResultTable *rt, XtokNamedInstance *ni);
 void setInstQualifiers(CMPIInstance *ci, XtokQualifiers *qs);
 void setClassProperties(CMPIConstClass *cls, XtokProperties *ps);
 void setClassQualifiers(CMPIConstClass *cls, XtokQualifiers *qs);
@@ -40,4 +41,6 @@ void addMethod(ParserControl *parm, XtokMethods *ms, XtokMethod *m);
 void addParam(ParserControl *parm, XtokParams *ps, XtokParam *p);
 void setError(ParserControl *parm, XtokErrorResp *e);
 void setReturnArgs(ParserControl *parm, XtokParamValues *ps);
+void addMultiResponse(ParserControl *parm);
+void setPullParamValue(ParserControl *parm, XtokParamValue *p);
 
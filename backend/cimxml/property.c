@@ -6,8 +6,8 @@
   provider programmer. It is used to implement various other data types
   natively, such as instances, object-paths and args.
 
-  It provides means to maintain linked lists of named properties including
-  functionality to add, remove, clone and release them.
+  It provides means to maintain tables of named properties including
+  functionality to add, look up, clone and release them.
 
   (C) Copyright IBM Corp. 2003
 
@@ -24,16 +24,34 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
+#include <ctype.h>
+#include <sched.h>
 #include "cmcidt.h"
 #include "cmcift.h"
 #include "cmcimacs.h"
 #include "native.h"
+#include "utilft.h"
 
 #ifdef DMALLOC
 #include "dmalloc.h"
 #endif
 
+extern char *XmlToAsciiInPlace(char *XmlStr);
+
+/* raw values are copied into chunks doubling from the minimum to the
+   maximum size, larger values get one of their own */
+#define PROPERTY_RAW_MIN 128
+#define PROPERTY_RAW_MAX 4096
+
+struct native_rawChunk {
+	struct native_rawChunk * next;
+	size_t size;
+	size_t used;
+	char data[1];
+};
+
 //! Storage container for commonly needed data within native CMPI data types.
 /*!
   This structure is used to build linked lists of data containers as needed
@@ -41,12 +59,61 @@
 */
 /****************************************************************************/
 
+/* returns non-zero while the value is the text set with
+   __setRawProperty(), once it isn't the converted value can be read */
+static int __isRaw ( struct native_property * prop )
+{
+	return __atomic_load_n ( &prop->raw, __ATOMIC_ACQUIRE ) != NULL;
+}
+
+/* converts the text of a value set with __setRawProperty(). Readers of
+   the same object may get here at once: the first one claims the text,
+   which is unescaped in place, and the others wait until the value it
+   converted is published. */
+static void __convertRaw ( struct native_property * prop )
+{
+	CMPIType type = prop->type & ~CMPI_ARRAY;
+	CMPIValue value, v;
+	char * s, * next;
+	unsigned int i;
+
+	if ( ! __sync_bool_compare_and_swap ( &prop->converting, 0, 1 ) ) {
+		while ( __isRaw ( prop ) )
+			sched_yield ();
+		return;
+	}
+	s = prop->raw;
+
+	if ( ! ( prop->type & CMPI_ARRAY ) ) {
+		if ( type == CMPI_string )
+			XmlToAsciiInPlace ( s );
+		value = str2CMPIValue ( type, s, NULL );
+	}
+	else {
+		value.array = native_new_CMPIArray ( prop->rawCount, type, NULL );
+		for ( i = 0; i < prop->rawCount; i++, s = next ) {
+			next = s + strlen ( s ) + 1;
+			if ( type == CMPI_string )
+				XmlToAsciiInPlace ( s );
+			v = str2CMPIValue ( type, s, NULL );
+			CMSetArrayElementAt ( value.array, i, &v, type );
+			native_release_CMPIValue ( type, &v );
+		}
+	}
+
+	prop->value = value;
+	__atomic_store_n ( &prop->raw, NULL, __ATOMIC_RELEASE );
+}
+
+
 static CMPIData __convert2CMPIData ( struct native_property * prop,
 				     CMPIString ** propname )
 {
 	CMPIData result = { 0, CMPI_nullValue, {0} };
 
 	if ( prop != NULL ) {
+		if ( __isRaw ( prop ) )
+			__convertRaw ( prop );
 		result.type  = prop->type;
 		result.state = prop->state;
 		result.value = prop->value;
@@ -62,107 +129,193 @@ static CMPIData __convert2CMPIData ( struct native_property * prop,
 }
 
 
+/* tables up to this size are searched without an index */
+#define PROPERTY_INDEX_MIN 8
+
+static unsigned int __hashName ( const char * name )
+{
+	unsigned int h = 2166136261u;
+
+	for ( ; *name; name++ ) {
+		h ^= (unsigned char) tolower ( (unsigned char) *name );
+		h *= 16777619u;
+	}
+	return h;
+}
+
+
 /**
- * returns non-zero if already existant
+ * returns the position of name in the table or -1 if non-existant
  */
-static int __addProperty ( struct native_property ** prop,
-			   const char * name,
-			   CMPIType type,
-			   CMPIValueState state,
-			   CMPIValue * value )
+static int __findProperty ( struct native_propertyTable * t,
+			    const char * name,
+			    unsigned int hash )
 {
-   CMPIStatus rc;
+	struct native_property * p;
+	unsigned int i;
+
+	if ( t->index == NULL ) {
+		for ( i = 0; i < t->count; i++ ) {
+			p = t->props + i;
+			if ( p->name == name || ( p->hash == hash &&
+			     strcasecmp ( p->name, name ) == 0 ) )
+				return i;
+		}
+		return -1;
+	}
 
-   if ( *prop == NULL ) {
-      struct native_property * tmp = *prop =
-         (struct native_property *) calloc ( 1, sizeof ( struct native_property ) );
-
-      tmp->qualifiers = NULL;
-      tmp->name = strdup ( name );
-      tmp->type  = type;
-      tmp->state = state;
-      
-      if ( type != CMPI_null && state != CMPI_nullValue) {
-         if ( type == CMPI_chars ) {
-            tmp->type = CMPI_string;
-            tmp->value.string = native_new_CMPIString ( (char *) value, &rc );
-         }
-         else tmp->value = native_clone_CMPIValue ( type, value, &rc );
-      }      
-      else {
-         tmp->state = CMPI_nullValue;
-         tmp->value.uint64=0;
-      }
+	for ( i = hash & t->mask; t->index[i]; i = ( i + 1 ) & t->mask ) {
+		p = t->props + t->index[i] - 1;
+		if ( p->name == name || ( p->hash == hash &&
+		     strcasecmp ( p->name, name ) == 0 ) )
+			return t->index[i] - 1;
+	}
+	return -1;
+}
 
-      return 0;
-   }
-   
-   return ( strcasecmp ( (*prop)->name, name ) == 0 ||
-          __addProperty ( &( (*prop)->next ), name, type, state, value ) );
+
+/* rebuilds the index, sized to stay at most half full */
+static void __reindex ( struct native_propertyTable * t )
+{
+	unsigned int size = PROPERTY_INDEX_MIN * 4, i, j;
+
+	while ( size < t->count * 2 )
+		size *= 2;
+
+	free ( t->index );
+	t->index = (unsigned int *) calloc ( size, sizeof ( unsigned int ) );
+	t->mask  = size - 1;
+
+	for ( i = 0; i < t->count; i++ ) {
+		for ( j = t->props[i].hash & t->mask; t->index[j];
+		      j = ( j + 1 ) & t->mask );
+		t->index[j] = i + 1;
+	}
 }
 
 
 /**
- * returns -1 if non-existant
+ * returns non-zero if already existant
  */
-static int __setProperty ( struct native_property * prop,
+static int __addProperty ( struct native_propertyTable ** table,
 			   const char * name,
 			   CMPIType type,
+			   CMPIValueState state,
 			   CMPIValue * value )
 {
+   struct native_propertyTable * t = *table;
+   struct native_property * tmp;
+   unsigned int hash = __hashName ( name ), i;
    CMPIStatus rc;
-   
-   if ( prop == NULL ) return -1;
 
-   if ( strcasecmp ( prop->name, name ) == 0 ) {
+   if ( t == NULL )
+      t = *table = (struct native_propertyTable *)
+         calloc ( 1, sizeof ( struct native_propertyTable ) );
+   else if ( __findProperty ( t, name, hash ) >= 0 )
+      return 1;
 
-      if ( ! ( prop->state & CMPI_nullValue ) )
-         native_release_CMPIValue ( prop->type, &prop->value );
+   if ( t->count == t->max ) {
+      t->max = t->max ? t->max * 2 : PROPERTY_INDEX_MIN;
+      t->props = (struct native_property *)
+         realloc ( t->props, t->max * sizeof ( struct native_property ) );
+   }
 
-      prop->type  = type;
+   tmp = t->props + t->count++;
+   memset ( tmp, 0, sizeof ( struct native_property ) );
+   tmp->qualifiers = NULL;
+   tmp->name = internString ( name );
+   tmp->hash = hash;
+   tmp->type  = type;
+   tmp->state = state;
+
+   if ( type != CMPI_null && state != CMPI_nullValue) {
       if ( type == CMPI_chars ) {
-         prop->type = CMPI_string;
-         prop->value.string = native_new_CMPIString ( (char *) value, &rc );
+         tmp->type = CMPI_string;
+         tmp->value.string = native_new_CMPIString ( (char *) value, &rc );
       }
+      else tmp->value = native_clone_CMPIValue ( type, value, &rc );
+   }
+   else {
+      tmp->state = CMPI_nullValue;
+      tmp->value.uint64=0;
+   }
 
-      else { 
-         if ( type != CMPI_null && value != NULL) 
-             prop->value = native_clone_CMPIValue ( type, value, &rc );
-         else prop->state = CMPI_nullValue;
+   if ( t->index ) {
+      if ( t->count * 2 > t->mask + 1 )
+         __reindex ( t );
+      else {
+         for ( i = hash & t->mask; t->index[i]; i = ( i + 1 ) & t->mask );
+         t->index[i] = t->count;
       }
-      return 0;
    }
-   return __setProperty ( prop->next, name, type, value);
+   else if ( t->count > PROPERTY_INDEX_MIN )
+      __reindex ( t );
+
+   return 0;
 }
 
 
-static struct native_property * __getProperty ( struct native_property * prop,
+static struct native_property * __getProperty ( struct native_propertyTable * t,
 						const char * name )
 {
-	if ( ! prop || ! name ) {
+	int i;
+
+	if ( ! t || ! name ) {
 		return NULL;
 	}
-	return ( strcasecmp ( prop->name, name ) == 0 )?
-		prop: __getProperty ( prop->next, name );
+	i = __findProperty ( t, name, __hashName ( name ) );
+	return ( i >= 0 ) ? t->props + i : NULL;
 }
 
 
-static CMPIData __getDataProperty ( struct native_property * prop,
+/**
+ * returns -1 if non-existant
+ */
+static int __setProperty ( struct native_propertyTable * t,
+			   const char * name,
+			   CMPIType type,
+			   CMPIValue * value )
+{
+   struct native_property * prop = __getProperty ( t, name );
+   CMPIStatus rc;
+
+   if ( prop == NULL ) return -1;
+
+   if ( ! ( prop->state & CMPI_nullValue ) )
+      native_release_CMPIValue ( prop->type, &prop->value );
+
+   prop->raw   = NULL;
+   prop->type  = type;
+   if ( type == CMPI_chars ) {
+      prop->type = CMPI_string;
+      prop->value.string = native_new_CMPIString ( (char *) value, &rc );
+   }
+
+   else {
+      if ( type != CMPI_null && value != NULL)
+          prop->value = native_clone_CMPIValue ( type, value, &rc );
+      else prop->state = CMPI_nullValue;
+   }
+   return 0;
+}
+
+
+static CMPIData __getDataProperty ( struct native_propertyTable * t,
 				    const char * name,
 				    CMPIStatus * rc )
 {
-	struct native_property * p = __getProperty ( prop, name );
+	struct native_property * p = __getProperty ( t, name );
 
 	CMSetStatus( rc, ( p ) ? CMPI_RC_OK : CMPI_RC_ERR_NO_SUCH_PROPERTY );
 
 	return __convert2CMPIData ( p, NULL );
 }
 
-static struct native_qualifier *__getDataPropertyQualifiers ( struct native_property * prop,
+static struct native_qualifier *__getDataPropertyQualifiers ( struct native_propertyTable * t,
 				    const char * name,
 				    CMPIStatus * rc )
 {
-	struct native_property * p = __getProperty ( prop, name );
+	struct native_property * p = __getProperty ( t, name );
 
 	CMSetStatus( rc, ( p ) ? CMPI_RC_OK : CMPI_RC_ERR_NO_SUCH_PROPERTY );
 
@@ -170,24 +323,13 @@ static struct native_qualifier *__getDataPropertyQualifiers ( struct native_prop
 }
 
 
-static struct native_property * __getPropertyAt( struct native_property * prop, 
-unsigned int pos )
-{
-	if ( ! prop ) {
-		return NULL;
-	}
-
-	return ( pos == 0 )?
-		prop: __getPropertyAt ( prop->next, --pos );
-}
-
-
-static CMPIData __getDataPropertyAt ( struct native_property * prop,
+static CMPIData __getDataPropertyAt ( struct native_propertyTable * t,
 				      unsigned int pos,
 				      CMPIString ** propname,
 				      CMPIStatus * rc )
 {
-	struct native_property * p = __getPropertyAt ( prop, pos );
+	struct native_property * p = ( t && pos < t->count ) ?
+		t->props + pos : NULL;
 
 	CMSetStatus ( rc, ( p ) ? CMPI_RC_OK : CMPI_RC_ERR_NO_SUCH_PROPERTY );
 
@@ -195,71 +337,165 @@ static CMPIData __getDataPropertyAt ( struct native_property * prop,
 }
 
 
-static CMPICount __getPropertyCount ( struct native_property * prop,
+static CMPICount __getPropertyCount ( struct native_propertyTable * t,
 				      CMPIStatus * rc )
 {
-	CMPICount c = 0;
-
 	CMSetStatus ( rc, CMPI_RC_OK );
 
-	while ( prop != NULL ) {
-		c++;
-		prop = prop->next;
-	}
-
-	return c;
-} 
+	return t ? t->count : 0;
+}
 
 
-static void __release ( struct native_property * prop )
+static void __release ( struct native_propertyTable * t )
 {
-	struct native_property * next;
-	for ( ; prop; prop = next ) {
-		free ( prop->name );
+	struct native_property * prop;
+	struct native_rawChunk * c, * next;
+	unsigned int i;
+
+	if ( t == NULL )
+		return;
+
+	for ( i = 0; i < t->count; i++ ) {
+		prop = t->props + i;
+		internStringRelease ( prop->name );
                 if(prop->state != CMPI_nullValue)
                         native_release_CMPIValue ( prop->type, &prop->value );
                 qualifierFT.release(prop->qualifiers);
-                next=prop->next;
-		free ( prop );
- 	}
+	}
+	for ( c = t->raw; c; c = next ) {
+		next = c->next;
+		free ( c );
+	}
+	free ( t->props );
+	free ( t->index );
+	free ( t );
 }
 
 
-static struct native_property * __clone ( struct native_property * prop,
-					  CMPIStatus * rc )
+static struct native_propertyTable * __clone ( struct native_propertyTable * t,
+					       CMPIStatus * rc )
 {
-	struct native_property * result;
+	struct native_propertyTable * result;
+	struct native_property * prop, * dst;
 	CMPIStatus tmp;
+	unsigned int i;
 
-	if ( prop == NULL ) {
+	CMSetStatus ( rc, CMPI_RC_OK );
 
-		CMSetStatus ( rc, CMPI_RC_OK );
+	if ( t == NULL ) {
 		return NULL;
 	}
 
-	result = (struct native_property * )
-		 calloc ( 1, sizeof ( struct native_property ) );
-
-	result->name  = strdup ( prop->name );
-	result->type  = prop->type;
-	result->state = prop->state;
-        if (prop->state != CMPI_nullValue
-            && prop->state != CMPI_badValue) {
-          result->value = native_clone_CMPIValue ( prop->type,
-                                                   &prop->value,
-                                                   &tmp );
-          if ( tmp.rc != CMPI_RC_OK ) {
-
-		result->state = CMPI_nullValue;
-	  }
-        }
-	result->qualifiers    = qualifierFT.clone ( prop->qualifiers, rc );
-        
-	result->next  = __clone ( prop->next, rc );
+	result = (struct native_propertyTable *)
+		 calloc ( 1, sizeof ( struct native_propertyTable ) );
+	result->count = result->max = t->count;
+	result->props = (struct native_property *)
+		 calloc ( t->count ? t->count : 1, sizeof ( struct native_property ) );
+
+	for ( i = 0; i < t->count; i++ ) {
+		prop = t->props + i;
+		dst  = result->props + i;
+
+		if ( __isRaw ( prop ) )
+			__convertRaw ( prop );
+		dst->name  = internStringRef ( prop->name );
+		dst->hash  = prop->hash;
+		dst->type  = prop->type;
+		dst->state = prop->state;
+		if (prop->state != CMPI_nullValue
+		    && prop->state != CMPI_badValue) {
+			dst->value = native_clone_CMPIValue ( prop->type,
+							      &prop->value,
+							      &tmp );
+			if ( tmp.rc != CMPI_RC_OK ) {
+
+				dst->state = CMPI_nullValue;
+			}
+		}
+		dst->qualifiers = qualifierFT.clone ( prop->qualifiers, rc );
+	}
+
+	if ( t->index ) {
+		result->mask  = t->mask;
+		result->index = (unsigned int *)
+			malloc ( ( t->mask + 1 ) * sizeof ( unsigned int ) );
+		memcpy ( result->index, t->index,
+			 ( t->mask + 1 ) * sizeof ( unsigned int ) );
+	}
 	return result;
 }
 
 
+/* copies count strings into the table's chunks, one after another */
+static char * __copyRaw ( struct native_propertyTable * t,
+			  char ** values,
+			  unsigned int count )
+{
+	struct native_rawChunk * c = t->raw;
+	size_t len = 0, l;
+	unsigned int i;
+	char * copy, * p;
+
+	for ( i = 0; i < count; i++ )
+		len += strlen ( values[i] ) + 1;
+
+	if ( c == NULL || c->size - c->used < len ) {
+		l = c == NULL ? PROPERTY_RAW_MIN :
+			c->size < PROPERTY_RAW_MAX ? c->size * 2 : PROPERTY_RAW_MAX;
+		if ( l < len )
+			l = len;
+		c = (struct native_rawChunk *)
+			malloc ( offsetof ( struct native_rawChunk, data ) + l );
+		c->size = l;
+		c->used = 0;
+		c->next = t->raw;
+		t->raw  = c;
+	}
+
+	copy = p = c->data + c->used;
+	for ( i = 0; i < count; i++ ) {
+		l = strlen ( values[i] ) + 1;
+		memcpy ( p, values[i], l );
+		p += l;
+	}
+	c->used += len;
+	return copy;
+}
+
+
+/**
+ * Adds a property whose value is converted from its text when it is first
+ * read, or resets an existing one; values are count strings for arrays.
+ */
+static int __setRawProperty ( struct native_propertyTable ** table,
+			      const char * name,
+			      CMPIType type,
+			      char ** values,
+			      unsigned int count )
+{
+	struct native_property * prop;
+
+	if ( ( type & ~CMPI_ARRAY ) == CMPI_chars )
+		type = ( type & CMPI_ARRAY ) | CMPI_string;
+
+	if ( __addProperty ( table, name, type, CMPI_nullValue, NULL ) == 0 )
+		prop = ( *table )->props + ( *table )->count - 1;
+	else {
+		prop = __getProperty ( *table, name );
+		if ( ! ( prop->state & CMPI_nullValue ) )
+			native_release_CMPIValue ( prop->type, &prop->value );
+		prop->type = type;
+	}
+
+	prop->state &= ~CMPI_nullValue;
+	prop->value.uint64 = 0;
+	prop->raw = __copyRaw ( *table, values, count );
+	prop->rawCount = count;
+	prop->converting = 0;
+	return 0;
+}
+
+
 /**
  * Global function table to access native_property helper functions.
  */
@@ -273,7 +509,8 @@ struct native_propertyFT const propertyFT = {
 	__getDataProperty,
 	__getDataPropertyAt,
 	__getPropertyCount,
-        __getDataPropertyQualifiers
+        __getDataPropertyQualifiers,
+	__setRawProperty
 };
 
 /****************************************************************************/
@@ -29,6 +29,7 @@
 #include "cmcift.h"
 #include "cmcimacs.h"
 #include "native.h"
+#include "utilft.h"
 
 #ifdef DMALLOC
 #include "dmalloc.h"
@@ -78,7 +79,7 @@ static int __addQualifier ( struct native_qualifier ** qual,
       struct native_qualifier * tmp = *qual =
          (struct native_qualifier *) calloc ( 1, sizeof ( struct native_qualifier ) );
 
-      tmp->name = strdup ( name );
+      tmp->name = internString ( name );
       tmp->type  = type;
       tmp->state = state;
       
@@ -97,7 +98,7 @@ static int __addQualifier ( struct native_qualifier ** qual,
       return 0;
    }
    
-   return ( strcasecmp ( (*qual)->name, name ) == 0 ||
+   return ( (*qual)->name == name || strcasecmp ( (*qual)->name, name ) == 0 ||
           __addQualifier ( &( (*qual)->next ), name, type, state, value ) );
 }
 
@@ -114,7 +115,7 @@ static int __setQualifier ( struct native_qualifier * qual,
 
    if ( qual == NULL ) return -1;
 
-   if ( strcasecmp ( qual->name, name ) == 0 ) {
+   if ( qual->name == name || strcasecmp ( qual->name, name ) == 0 ) {
 
       if ( ! ( qual->state & CMPI_nullValue ) )
          native_release_CMPIValue ( qual->type, &qual->value );
@@ -142,7 +143,7 @@ static struct native_qualifier * __getQualifier ( struct native_qualifier * qual
 	if ( ! qual || ! name ) {
 		return NULL;
 	}
-	return ( strcasecmp ( qual->name, name ) == 0 )?
+	return ( qual->name == name || strcasecmp ( qual->name, name ) == 0 )?
 		qual: __getQualifier ( qual->next, name );
 }
 
@@ -204,7 +205,7 @@ static void __release ( struct native_qualifier * qual )
 {
         struct native_qualifier *next; 
         for ( ; qual; qual = next ) {
-		free ( qual->name );
+		internStringRelease ( qual->name );
 		native_release_CMPIValue ( qual->type, &qual->value );
                 next = qual->next;
 		free ( qual );
@@ -226,7 +227,7 @@ static struct native_qualifier * __clone ( struct native_qualifier * qual,
 	result = (struct native_qualifier * ) 
 		 calloc ( 1, sizeof ( struct native_qualifier ) );
 
-	result->name  = strdup ( qual->name );
+	result->name  = internStringRef ( qual->name );
 	result->type  = qual->type;
 	result->state = qual->state;
 	result->value = native_clone_CMPIValue ( qual->type,
@@ -0,0 +1,919 @@
+/*
+ * resultTable.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ * Native CIMCResultTable implementation, the instances of an enumeration
+ * stored column-wise. The parser adds a row per instance and sets its
+ * properties by name; since the instances of a response mostly have the
+ * same properties in the same order, the column of the next property is
+ * guessed before it is looked up.
+ *
+ * Numbers, booleans and char16 are stored in arrays of their type,
+ * strings and datetimes as codes into a per column dictionary of distinct
+ * values. Anything else, and columns whose rows have different types, are
+ * kept as CMPIData. Rows are handed out as read-only CMPIInstances
+ * sharing the table, which threads may read and release at once.
+ *
+*/
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cmcidt.h"
+#include "cmcift.h"
+#include "cmcimacs.h"
+#include "native.h"
+#include "utilft.h"
+#include "nativeCimXml.h"
+#include "cimXmlParser.h"
+
+#define TABLE_MIN_ROWS 64
+#define TABLE_MIN_DICT 16
+#define TABLE_CHUNK 65536
+#define ISNULL(c,r) ((c)->nulls[(r) >> 3] & (1 << ((r) & 7)))
+
+typedef struct _DictSlot {
+   unsigned int hash;
+   unsigned int code;           /* code + 1, 0 is free */
+} DictSlot;
+
+typedef struct _TableColumn {
+   char *name;                  /* interned */
+   CMPIType type;               /* of the first value */
+   int format;                  /* CIMC_COLUMN_... */
+   int key;
+   size_t size;                 /* of a value */
+   char *values;
+   unsigned char *nulls;
+   char **dict;                 /* distinct strings of a CODES column */
+   void **dictValues;           /* their CMPIString or CMPIDateTime, on demand */
+   unsigned int dictCount, dictMax;
+   DictSlot *dictIndex;         /* open addressing */
+   unsigned int dictMask;
+} TableColumn;
+
+/* the dictionaries' strings are allocated in chunks */
+typedef struct _TableChunk {
+   struct _TableChunk *next;
+   char data[1];
+} TableChunk;
+
+struct native_table {
+   CIMCResultTable rt;
+   int refCount;                /* the table and its row views */
+   char *nameSpace;             /* interned */
+   char **classes;              /* interned, distinct */
+   unsigned int classCount, classMax;
+   unsigned int *rowClass;      /* index into classes */
+   TableColumn *cols;
+   unsigned int colCount, colMax;
+   unsigned int rowCount, rowMax;
+   unsigned int next;           /* column expected to be set next */
+   TableChunk *chunks;
+   char *chunkNext;
+   size_t chunkLeft;
+};
+
+struct native_row {
+   CMPIInstance instance;
+   struct native_table *table;
+   unsigned int row;
+};
+
+static CMPIInstance *newRowInstance(struct native_table *t, unsigned int row);
+
+/****************************************************************************/
+
+static size_t valueSize(CMPIType type)
+{
+   switch (type) {
+   case CMPI_boolean:
+   case CMPI_uint8:
+   case CMPI_sint8:
+      return 1;
+   case CMPI_char16:
+   case CMPI_uint16:
+   case CMPI_sint16:
+      return 2;
+   case CMPI_uint32:
+   case CMPI_sint32:
+   case CMPI_real32:
+      return 4;
+   case CMPI_uint64:
+   case CMPI_sint64:
+   case CMPI_real64:
+      return 8;
+   }
+   return 0;
+}
+
+static int columnFormat(CMPIType type)
+{
+   if (type == CMPI_string || type == CMPI_dateTime)
+      return CIMC_COLUMN_CODES;
+   if (valueSize(type))
+      return CIMC_COLUMN_VALUES;
+   return CIMC_COLUMN_DATA;
+}
+
+static unsigned int hashChars(const char *s, size_t *len)
+{
+   const char *p;
+   unsigned int h = 2166136261u;
+
+   for (p = s; *p; p++) {
+      h ^= (unsigned char) *p;
+      h *= 16777619u;
+   }
+   *len = p - s;
+   return h;
+}
+
+static char *tableStrdup(struct native_table *t, const char *s, size_t len)
+{
+   TableChunk *c;
+   char *copy;
+
+   if (len + 1 > t->chunkLeft) {
+      /* long strings get a chunk of their own */
+      size_t size = len + 1 > TABLE_CHUNK / 4 ? len + 1 : TABLE_CHUNK;
+
+      c = malloc(offsetof(TableChunk, data) + size);
+      c->next = t->chunks;
+      t->chunks = c;
+      if (size != TABLE_CHUNK)
+         return memcpy(c->data, s, len + 1);
+      t->chunkNext = c->data;
+      t->chunkLeft = size;
+   }
+   copy = memcpy(t->chunkNext, s, len + 1);
+   t->chunkNext += len + 1;
+   t->chunkLeft -= len + 1;
+   return copy;
+}
+
+/****************************************************************************/
+
+static void growRows(struct native_table *t)
+{
+   unsigned int max = t->rowMax ? t->rowMax * 2 : TABLE_MIN_ROWS, i;
+   TableColumn *c;
+
+   t->rowClass = realloc(t->rowClass, max * sizeof(unsigned int));
+   for (i = 0; i < t->colCount; i++) {
+      c = t->cols + i;
+      c->values = realloc(c->values, max * c->size);
+      memset(c->values + t->rowMax * c->size, 0, (max - t->rowMax) * c->size);
+      c->nulls = realloc(c->nulls, max / 8);
+      memset(c->nulls + t->rowMax / 8, 0xff, (max - t->rowMax) / 8);
+   }
+   t->rowMax = max;
+}
+
+static TableColumn *newColumn(struct native_table *t, const char *name,
+                              CMPIType type)
+{
+   TableColumn *c;
+
+   if (t->colCount == t->colMax) {
+      t->colMax = t->colMax ? t->colMax * 2 : 16;
+      t->cols = realloc(t->cols, t->colMax * sizeof(TableColumn));
+   }
+   if (t->rowMax == 0)
+      growRows(t);
+
+   c = t->cols + t->colCount++;
+   memset(c, 0, sizeof(TableColumn));
+   c->name = internString(name);
+   c->type = type;
+   c->format = columnFormat(type);
+   c->size = c->format == CIMC_COLUMN_VALUES ? valueSize(type) :
+      c->format == CIMC_COLUMN_CODES ? sizeof(CMPIUint32) : sizeof(CMPIData);
+   c->values = calloc(t->rowMax, c->size);
+   /* earlier rows don't have the property */
+   c->nulls = malloc(t->rowMax / 8);
+   memset(c->nulls, 0xff, t->rowMax / 8);
+   t->next = t->colCount;
+   return c;
+}
+
+static int lookupColumn(struct native_table *t, const char *name)
+{
+   unsigned int i;
+
+   for (i = 0; i < t->colCount; i++)
+      if (t->cols[i].name == name || strcasecmp(t->cols[i].name, name) == 0)
+         return i;
+   return -1;
+}
+
+/* the column of the current row's property name, created if new */
+static TableColumn *rowColumn(struct native_table *t, const char *name)
+{
+   int i;
+
+   /* names are mostly interned, so compared by address first */
+   if (t->next < t->colCount && (t->cols[t->next].name == name ||
+                                 strcasecmp(t->cols[t->next].name, name) == 0))
+      return t->cols + t->next++;
+   if ((i = lookupColumn(t, name)) < 0)
+      return NULL;
+   t->next = i + 1;
+   return t->cols + i;
+}
+
+/* the CMPIString or CMPIDateTime of a dictionary entry. Rows may be read
+   from several threads at once, a reader losing the race to publish the
+   entry drops the one it made. */
+static void *dictValue(TableColumn *c, CMPIUint32 code)
+{
+   void *v = __atomic_load_n(&c->dictValues[code], __ATOMIC_ACQUIRE);
+
+   if (v)
+      return v;
+   if (c->type == CMPI_dateTime)
+      v = native_new_CMPIDateTime_fromChars(c->dict[code], NULL);
+   else
+      v = native_new_CMPIString(c->dict[code], NULL);
+   if (__sync_bool_compare_and_swap(&c->dictValues[code], NULL, v))
+      return v;
+
+   if (c->type == CMPI_dateTime)
+      CMRelease((CMPIDateTime *) v);
+   else
+      CMRelease((CMPIString *) v);
+   return __atomic_load_n(&c->dictValues[code], __ATOMIC_ACQUIRE);
+}
+
+static CMPIUint32 dictCode(struct native_table *t, TableColumn *c,
+                           const char *text)
+{
+   unsigned int i, j, h, size, mask;
+   DictSlot *ni;
+   size_t len;
+
+   if (c->dictIndex == NULL || c->dictCount * 2 >= c->dictMask + 1) {
+      size = c->dictIndex ? (c->dictMask + 1) * 2 : TABLE_MIN_DICT * 2;
+      mask = size - 1;
+      ni = calloc(size, sizeof(DictSlot));
+      for (j = 0; c->dictIndex && j <= c->dictMask; j++) {
+         if (c->dictIndex[j].code == 0)
+            continue;
+         for (i = c->dictIndex[j].hash & mask; ni[i].code; i = (i + 1) & mask);
+         ni[i] = c->dictIndex[j];
+      }
+      free(c->dictIndex);
+      c->dictIndex = ni;
+      c->dictMask = mask;
+   }
+
+   h = hashChars(text, &len);
+   for (i = h & c->dictMask; c->dictIndex[i].code; i = (i + 1) & c->dictMask)
+      if (c->dictIndex[i].hash == h &&
+          strcmp(c->dict[c->dictIndex[i].code - 1], text) == 0)
+         return c->dictIndex[i].code - 1;
+
+   if (c->dictCount == c->dictMax) {
+      c->dictMax = c->dictMax ? c->dictMax * 2 : TABLE_MIN_DICT;
+      c->dict = realloc(c->dict, c->dictMax * sizeof(char *));
+      c->dictValues = realloc(c->dictValues, c->dictMax * sizeof(void *));
+   }
+   c->dict[c->dictCount] = tableStrdup(t, text, len);
+   c->dictValues[c->dictCount] = NULL;
+   c->dictIndex[i].hash = h;
+   c->dictIndex[i].code = ++c->dictCount;
+   return c->dictCount - 1;
+}
+
+static CMPIData cellData(TableColumn *c, unsigned int row)
+{
+   CMPIData d;
+
+   if (ISNULL(c, row)) {
+      d.type = c->type;
+      d.state = CMPI_nullValue;
+      d.value.uint64 = 0;
+      return d;
+   }
+
+   switch (c->format) {
+   case CIMC_COLUMN_VALUES:
+      d.type = c->type;
+      d.state = 0;
+      d.value.uint64 = 0;
+      memcpy(&d.value, c->values + row * c->size, c->size);
+      break;
+   case CIMC_COLUMN_CODES:
+      d.type = c->type;
+      d.state = 0;
+      d.value.string = dictValue(c, ((CMPIUint32 *) c->values)[row]);
+      break;
+   default:
+      d = ((CMPIData *) c->values)[row];
+   }
+   if (c->key)
+      d.state |= CMPI_keyValue;
+   return d;
+}
+
+static void clearCell(TableColumn *c, unsigned int row)
+{
+   CMPIData *d;
+
+   if (c->format == CIMC_COLUMN_DATA && !ISNULL(c, row)) {
+      d = (CMPIData *) c->values + row;
+      native_release_CMPIValue(d->type, &d->value);
+      memset(d, 0, sizeof(CMPIData));
+   }
+   c->nulls[row >> 3] |= 1 << (row & 7);
+}
+
+static void releaseDict(TableColumn *c)
+{
+   unsigned int i;
+
+   for (i = 0; i < c->dictCount; i++) {
+      if (c->dictValues[i] && c->type == CMPI_dateTime)
+         CMRelease((CMPIDateTime *) c->dictValues[i]);
+      else if (c->dictValues[i])
+         CMRelease((CMPIString *) c->dictValues[i]);
+   }
+   free(c->dict);
+   free(c->dictValues);
+   free(c->dictIndex);
+   c->dict = NULL;
+   c->dictValues = NULL;
+   c->dictIndex = NULL;
+   c->dictCount = c->dictMax = 0;
+}
+
+/* turns a column into CMPIData, once a row has a value of another type */
+static void boxColumn(struct native_table *t, TableColumn *c)
+{
+   CMPIData *data = calloc(t->rowMax, sizeof(CMPIData)), d;
+   unsigned int row;
+
+   for (row = 0; row < t->rowCount; row++) {
+      if (ISNULL(c, row))
+         continue;
+      d = cellData(c, row);
+      d.state = 0;
+      d.value = native_clone_CMPIValue(d.type, &d.value, NULL);
+      data[row] = d;
+   }
+   releaseDict(c);
+   free(c->values);
+   c->values = (char *) data;
+   c->format = CIMC_COLUMN_DATA;
+   c->size = sizeof(CMPIData);
+}
+
+static void releaseColumn(struct native_table *t, TableColumn *c)
+{
+   unsigned int row;
+
+   if (c->format == CIMC_COLUMN_DATA)
+      for (row = 0; row < t->rowCount; row++)
+         clearCell(c, row);
+   releaseDict(c);
+   internStringRelease(c->name);
+   free(c->values);
+   free(c->nulls);
+}
+
+static void releaseTable(struct native_table *t)
+{
+   TableChunk *c, *next;
+   unsigned int i;
+
+   if (__sync_sub_and_fetch(&t->refCount, 1) > 0)
+      return;
+   for (c = t->chunks; c; c = next) {
+      next = c->next;
+      free(c);
+   }
+   for (i = 0; i < t->colCount; i++)
+      releaseColumn(t, t->cols + i);
+   for (i = 0; i < t->classCount; i++)
+      internStringRelease(t->classes[i]);
+   internStringRelease(t->nameSpace);
+   free(t->cols);
+   free(t->classes);
+   free(t->rowClass);
+   free(t);
+}
+
+/****************************************************************************/
+
+/*
+ * Building the table, used by the parser. Values are set for the row
+ * last added with tableNewRow().
+ */
+
+void tableNewRow(CIMCResultTable *rt, const char *className)
+{
+   struct native_table *t = (struct native_table *) rt;
+   unsigned int i;
+
+   if (t->rowCount == t->rowMax)
+      growRows(t);
+
+   for (i = t->classCount; i--; )
+      if (strcasecmp(t->classes[i], className) == 0)
+         break;
+   if (i == (unsigned int) -1) {
+      if (t->classCount == t->classMax) {
+         t->classMax = t->classMax ? t->classMax * 2 : 4;
+         t->classes = realloc(t->classes, t->classMax * sizeof(char *));
+      }
+      i = t->classCount++;
+      t->classes[i] = internString(className);
+   }
+   t->rowClass[t->rowCount++] = i;
+   t->next = 0;
+}
+
+/* sets a string or datetime value from its text */
+void tableSetChars(CIMCResultTable *rt, const char *name, CMPIType type,
+                   const char *text)
+{
+   struct native_table *t = (struct native_table *) rt;
+   unsigned int row = t->rowCount - 1;
+   TableColumn *c;
+   CMPIValue v;
+
+   if (text == NULL) {
+      tableSetValue(rt, name, NULL, type);
+      return;
+   }
+   if ((c = rowColumn(t, name)) == NULL)
+      c = newColumn(t, name, type);
+   else if (c->type != type && c->format != CIMC_COLUMN_DATA)
+      boxColumn(t, c);
+
+   clearCell(c, row);
+   if (c->format == CIMC_COLUMN_CODES)
+      ((CMPIUint32 *) c->values)[row] = dictCode(t, c, text);
+   else {
+      v = str2CMPIValue(type, (char *) text, NULL);
+      ((CMPIData *) c->values)[row].type = type;
+      ((CMPIData *) c->values)[row].value = v;
+   }
+   c->nulls[row >> 3] &= ~(1 << (row & 7));
+}
+
+/* sets a value, taken over by the table if adopt is set */
+static void setValue(CIMCResultTable *rt, const char *name, CMPIValue *value,
+                     CMPIType type, int adopt)
+{
+   struct native_table *t = (struct native_table *) rt;
+   unsigned int row = t->rowCount - 1;
+   TableColumn *c;
+   CMPIString *str;
+
+   if (type == CMPI_chars) {
+      tableSetChars(rt, name, CMPI_string, (char *) value);
+      return;
+   }
+   if (value && type == CMPI_string) {
+      tableSetChars(rt, name, type, CMGetCharPtr(value->string));
+      if (adopt)
+         native_release_CMPIValue(type, value);
+      return;
+   }
+   if (value && type == CMPI_dateTime) {
+      str = CMGetStringFormat(value->dateTime, NULL);
+      tableSetChars(rt, name, type, CMGetCharPtr(str));
+      CMRelease(str);
+      if (adopt)
+         native_release_CMPIValue(type, value);
+      return;
+   }
+
+   if ((c = rowColumn(t, name)) == NULL)
+      c = newColumn(t, name, type);
+   else if (value && c->type != type && c->format != CIMC_COLUMN_DATA)
+      boxColumn(t, c);
+
+   clearCell(c, row);
+   if (value == NULL)
+      return;
+   if (c->format == CIMC_COLUMN_VALUES) {
+      memcpy(c->values + row * c->size, value, c->size);
+      if (adopt)
+         native_release_CMPIValue(type, value);
+   }
+   else {
+      ((CMPIData *) c->values)[row].type = type;
+      ((CMPIData *) c->values)[row].value =
+         adopt ? *value : native_clone_CMPIValue(type, value, NULL);
+   }
+   c->nulls[row >> 3] &= ~(1 << (row & 7));
+}
+
+/*
+ * Sets a value, which is copied, or NULL if value is NULL. As with
+ * CMSetProperty(), a CMPI_chars value points to the characters.
+ */
+void tableSetValue(CIMCResultTable *rt, const char *name, CMPIValue *value,
+                   CMPIType type)
+{
+   setValue(rt, name, value, type, 0);
+}
+
+/*
+ * Like tableSetValue(), but a value the table keeps as CMPIData, e.g. an
+ * array or a reference the parser has just made, is taken over instead
+ * of copied. Otherwise it is released.
+ */
+void tableAdoptValue(CIMCResultTable *rt, const char *name, CMPIValue *value,
+                     CMPIType type)
+{
+   setValue(rt, name, value, type, 1);
+}
+
+/* marks a key property, setting it unless the instance had it already */
+void tableSetKey(CIMCResultTable *rt, const char *name, CMPIValue *value,
+                 CMPIType type)
+{
+   struct native_table *t = (struct native_table *) rt;
+   int i = lookupColumn(t, name);
+
+   if (i < 0 || ISNULL(t->cols + i, t->rowCount - 1)) {
+      tableSetValue(rt, name, value, type);
+      i = lookupColumn(t, name);
+   }
+   t->cols[i].key = 1;
+}
+
+/****************************************************************************/
+
+#define TABLE_COL(t,col,rc,ret) \
+   if (col >= t->colCount) { \
+      CMSetStatus(rc, CIMC_RC_ERR_NO_SUCH_PROPERTY); \
+      return ret; \
+   } \
+   CMSetStatus(rc, CIMC_RC_OK)
+
+static CIMCStatus __tft_release(CIMCResultTable *rt)
+{
+   CIMCStatus st = { CIMC_RC_OK, NULL };
+
+   if (rt)
+      releaseTable((struct native_table *) rt);
+   return st;
+}
+
+static CIMCCount __tft_getRowCount(CIMCResultTable *rt, CIMCStatus *rc)
+{
+   CMSetStatus(rc, CIMC_RC_OK);
+   return ((struct native_table *) rt)->rowCount;
+}
+
+static CIMCCount __tft_getColumnCount(CIMCResultTable *rt, CIMCStatus *rc)
+{
+   CMSetStatus(rc, CIMC_RC_OK);
+   return ((struct native_table *) rt)->colCount;
+}
+
+static const char *__tft_getColumnName(CIMCResultTable *rt, CIMCCount col,
+                                       CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   TABLE_COL(t, col, rc, NULL);
+   return t->cols[col].name;
+}
+
+static CIMCType __tft_getColumnType(CIMCResultTable *rt, CIMCCount col,
+                                    CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   TABLE_COL(t, col, rc, CIMC_null);
+   return t->cols[col].type;
+}
+
+static int __tft_findColumn(CIMCResultTable *rt, const char *name,
+                            CIMCStatus *rc)
+{
+   int i = lookupColumn((struct native_table *) rt, name);
+
+   CMSetStatus(rc, i < 0 ? CIMC_RC_ERR_NO_SUCH_PROPERTY : CIMC_RC_OK);
+   return i;
+}
+
+static const void *__tft_getColumn(CIMCResultTable *rt, CIMCCount col,
+                                   int *format, CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   TABLE_COL(t, col, rc, NULL);
+   if (format)
+      *format = t->cols[col].format;
+   return t->cols[col].values;
+}
+
+static const unsigned char *__tft_getNulls(CIMCResultTable *rt, CIMCCount col,
+                                           CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   TABLE_COL(t, col, rc, NULL);
+   return t->cols[col].nulls;
+}
+
+static const char *const *__tft_getDictionary(CIMCResultTable *rt,
+                                              CIMCCount col, CIMCCount *size,
+                                              CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   if (size)
+      *size = 0;
+   TABLE_COL(t, col, rc, NULL);
+   if (size)
+      *size = t->cols[col].dictCount;
+   return (const char *const *) t->cols[col].dict;
+}
+
+static CIMCData __tft_getData(CIMCResultTable *rt, CIMCCount row,
+                              CIMCCount col, CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+   CMPIData d = { 0, CMPI_nullValue | CMPI_notFound, {0} };
+
+   if (row >= t->rowCount) {
+      CMSetStatus(rc, CIMC_RC_ERR_NOT_FOUND);
+   }
+   else if (col >= t->colCount) {
+      CMSetStatus(rc, CIMC_RC_ERR_NO_SUCH_PROPERTY);
+   }
+   else {
+      CMSetStatus(rc, CIMC_RC_OK);
+      d = cellData(t->cols + col, row);
+   }
+   return *(CIMCData *) &d;
+}
+
+static const char *__tft_getClassName(CIMCResultTable *rt, CIMCCount row,
+                                      CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   if (row >= t->rowCount) {
+      CMSetStatus(rc, CIMC_RC_ERR_NOT_FOUND);
+      return NULL;
+   }
+   CMSetStatus(rc, CIMC_RC_OK);
+   return t->classes[t->rowClass[row]];
+}
+
+static CIMCInstance *__tft_getRow(CIMCResultTable *rt, CIMCCount row,
+                                  CIMCStatus *rc)
+{
+   struct native_table *t = (struct native_table *) rt;
+
+   if (row >= t->rowCount) {
+      CMSetStatus(rc, CIMC_RC_ERR_NOT_FOUND);
+      return NULL;
+   }
+   CMSetStatus(rc, CIMC_RC_OK);
+   return (CIMCInstance *) newRowInstance(t, row);
+}
+
+CIMCResultTable *newCIMCResultTable(const char *nameSpace)
+{
+   static CIMCResultTableFT tft = {
+      NATIVECIMXML_FT_VERSION,
+      __tft_release,
+      __tft_getRowCount,
+      __tft_getColumnCount,
+      __tft_getColumnName,
+      __tft_getColumnType,
+      __tft_findColumn,
+      __tft_getColumn,
+      __tft_getNulls,
+      __tft_getDictionary,
+      __tft_getData,
+      __tft_getClassName,
+      __tft_getRow
+   };
+   struct native_table *t = calloc(1, sizeof(struct native_table));
+
+   t->rt.hdl = "CIMCResultTable";
+   t->rt.ft = &tft;
+   t->refCount = 1;
+   t->nameSpace = internString(nameSpace);
+   return (CIMCResultTable *) t;
+}
+
+/****************************************************************************/
+
+/*
+ * Rows as CMPIInstances. Every column is a property of every row, NULL
+ * where the row's class doesn't have it.
+ */
+
+static CMPIStatus __rft_release(CMPIInstance *instance)
+{
+   struct native_row *r = (struct native_row *) instance;
+
+   if (r) {
+      releaseTable(r->table);
+      free(r);
+      CMReturn(CMPI_RC_OK);
+   }
+   CMReturn(CMPI_RC_ERR_FAILED);
+}
+
+static CMPIObjectPath *__rft_getObjectPath(CMPIInstance *instance,
+                                           CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+   struct native_table *t = r->table;
+   CMPIObjectPath *cop;
+   CMPIData d;
+   unsigned int i;
+
+   cop = newCMPIObjectPath(t->nameSpace, t->classes[t->rowClass[r->row]], rc);
+   for (i = 0; cop && i < t->colCount; i++) {
+      if (t->cols[i].key && !ISNULL(t->cols + i, r->row)) {
+         d = cellData(t->cols + i, r->row);
+         CMAddKey(cop, t->cols[i].name, &d.value, d.type);
+      }
+   }
+   return cop;
+}
+
+/* a regular instance with the row's values */
+static CMPIInstance *__rft_clone(CMPIInstance *instance, CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+   struct native_table *t = r->table;
+   CMPIObjectPath *cop = __rft_getObjectPath(instance, rc);
+   CMPIInstance *inst;
+   CMPIData d;
+   unsigned int i;
+
+   if (cop == NULL)
+      return NULL;
+   inst = native_new_CMPIInstance(cop, rc);
+   CMRelease(cop);
+   for (i = 0; i < t->colCount; i++) {
+      d = cellData(t->cols + i, r->row);
+      CMSetProperty(inst, t->cols[i].name,
+                    d.state & CMPI_nullValue ? NULL : &d.value, d.type);
+   }
+   return inst;
+}
+
+static CMPIData __rft_getProperty(CMPIInstance *instance, const char *name,
+                                  CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+   CMPIData d = { 0, CMPI_nullValue | CMPI_notFound, {0} };
+   int i = lookupColumn(r->table, name);
+
+   if (i < 0) {
+      CMSetStatus(rc, CMPI_RC_ERR_NO_SUCH_PROPERTY);
+      return d;
+   }
+   CMSetStatus(rc, CMPI_RC_OK);
+   return cellData(r->table->cols + i, r->row);
+}
+
+static CMPIData __rft_getPropertyAt(CMPIInstance *instance, unsigned int index,
+                                    CMPIString **name, CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+   CMPIData d = { 0, CMPI_nullValue | CMPI_notFound, {0} };
+
+   if (index >= r->table->colCount) {
+      if (name)
+         *name = NULL;
+      CMSetStatus(rc, CMPI_RC_ERR_NO_SUCH_PROPERTY);
+      return d;
+   }
+   if (name)
+      *name = native_new_CMPIString(r->table->cols[index].name, NULL);
+   CMSetStatus(rc, CMPI_RC_OK);
+   return cellData(r->table->cols + index, r->row);
+}
+
+static unsigned int __rft_getPropertyCount(CMPIInstance *instance,
+                                           CMPIStatus *rc)
+{
+   CMSetStatus(rc, CMPI_RC_OK);
+   return ((struct native_row *) instance)->table->colCount;
+}
+
+static CMPIStatus __rft_setProperty(CMPIInstance *instance, const char *name,
+                                    CMPIValue *value, CMPIType type)
+{
+   CMReturn(CMPI_RC_ERR_NOT_SUPPORTED);
+}
+
+static CMPIStatus __rft_setPropertyFilter(CMPIInstance *instance,
+                                          char **propertyList, char **keys)
+{
+   CMReturn(CMPI_RC_ERR_NOT_SUPPORTED);
+}
+
+/* qualifiers aren't kept */
+
+static CMPIData __rft_getQualifier(CMPIInstance *instance, const char *name,
+                                   CMPIStatus *rc)
+{
+   return qualifierFT.getDataQualifier(NULL, name, rc);
+}
+
+static CMPIData __rft_getQualifierAt(CMPIInstance *instance, unsigned int index,
+                                     CMPIString **name, CMPIStatus *rc)
+{
+   return qualifierFT.getDataQualifierAt(NULL, index, name, rc);
+}
+
+static unsigned int __rft_getQualifierCount(CMPIInstance *instance,
+                                            CMPIStatus *rc)
+{
+   return qualifierFT.getQualifierCount(NULL, rc);
+}
+
+static CMPIData __rft_getPropertyQualifier(CMPIInstance *instance,
+                                           const char *pname,
+                                           const char *qname, CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+   CMPIData ret = { 0, CMPI_nullValue, {0} };
+
+   if (lookupColumn(r->table, pname) >= 0)
+      return qualifierFT.getDataQualifier(NULL, qname, rc);
+   CMSetStatus(rc, CMPI_RC_ERR_NO_SUCH_PROPERTY);
+   return ret;
+}
+
+static CMPIData __rft_getPropertyQualifierAt(CMPIInstance *instance,
+                                             const char *pname,
+                                             unsigned int index,
+                                             CMPIString **name,
+                                             CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+   CMPIData ret = { 0, CMPI_nullValue, {0} };
+
+   if (lookupColumn(r->table, pname) >= 0)
+      return qualifierFT.getDataQualifierAt(NULL, index, name, rc);
+   CMSetStatus(rc, CMPI_RC_ERR_NO_SUCH_PROPERTY);
+   return ret;
+}
+
+static unsigned int __rft_getPropertyQualifierCount(CMPIInstance *instance,
+                                                    const char *pname,
+                                                    CMPIStatus *rc)
+{
+   struct native_row *r = (struct native_row *) instance;
+
+   if (lookupColumn(r->table, pname) >= 0)
+      return qualifierFT.getQualifierCount(NULL, rc);
+   CMSetStatus(rc, CMPI_RC_ERR_NO_SUCH_PROPERTY);
+   return 0;
+}
+
+static CMPIInstance *newRowInstance(struct native_table *t, unsigned int row)
+{
+   static CMPIInstanceFT rft = {
+      NATIVE_FT_VERSION,
+      __rft_release,
+      __rft_clone,
+      __rft_getProperty,
+      __rft_getPropertyAt,
+      __rft_getPropertyCount,
+      __rft_setProperty,
+      __rft_getObjectPath,
+      __rft_setPropertyFilter,
+      __rft_getQualifier,
+      __rft_getQualifierAt,
+      __rft_getQualifierCount,
+      __rft_getPropertyQualifier,
+      __rft_getPropertyQualifierAt,
+      __rft_getPropertyQualifierCount
+   };
+   struct native_row *r = malloc(sizeof(struct native_row));
+
+   r->instance.hdl = "CMPIInstance";
+   r->instance.ft = &rft;
+   r->table = t;
+   r->row = row;
+   __sync_fetch_and_add(&t->refCount, 1);
+   return (CMPIInstance *) r;
+}
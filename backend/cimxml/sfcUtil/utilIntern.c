@@ -0,0 +1,204 @@
+/*
+ * utilIntern.c
+ *
+ * THIS FILE IS PROVIDED UNDER THE TERMS OF THE ECLIPSE PUBLIC LICENSE
+ * ("AGREEMENT"). ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS FILE
+ * CONSTITUTES RECIPIENTS ACCEPTANCE OF THE AGREEMENT.
+ *
+ * You can obtain a current copy of the Eclipse Public License from
+ * http://www.opensource.org/licenses/eclipse-1.0.php
+ *
+ * Description:
+ *
+ * Interned strings for class, property, qualifier and namespace names.
+ * Every distinct name is stored once, whatever the number of objects
+ * using it, and counts its references. Two interned names are equal
+ * exactly when their pointers are, so comparing them needs no strcmp;
+ * names are case insensitive in CIM, and callers still fall back to
+ * strcasecmp when the pointers differ.
+ *
+ * Each thread keeps the names it interned lately in a small cache, so
+ * parser threads find the names they see over and over without taking
+ * the lock of the table.
+ *
+*/
+
+#include "utilft.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct _InternEntry {
+   struct _InternEntry *next;
+   unsigned int hash;
+   int refs;
+   char str[1];
+} InternEntry;
+
+#define INTERN_MIN_BUCKETS 256
+#define INTERN_CACHE_SIZE  256
+#define ENTRY(s) ((InternEntry *) ((s) - offsetof(InternEntry, str)))
+
+static pthread_mutex_t internLock = PTHREAD_MUTEX_INITIALIZER;
+static InternEntry **buckets;
+static unsigned int mask, count;
+
+/* per thread, the entry last interned in each slot; every cached entry
+   holds a reference, so it stays interned while it is cached */
+static pthread_key_t cacheKey;
+static pthread_once_t cacheOnce = PTHREAD_ONCE_INIT;
+
+static unsigned int hashString(const char *s, size_t *len)
+{
+   const char *p;
+   unsigned int h = 2166136261u;
+
+   for (p = s; *p; p++) {
+      h ^= (unsigned char) *p;
+      h *= 16777619u;
+   }
+   *len = p - s;
+   return h;
+}
+
+/* doubles the table, called with internLock held */
+static void grow()
+{
+   unsigned int size = buckets ? (mask + 1) * 2 : INTERN_MIN_BUCKETS, i;
+   InternEntry **nb = (InternEntry **) calloc(size, sizeof(InternEntry *));
+   InternEntry *e, *next;
+
+   for (i = 0; buckets && i <= mask; i++) {
+      for (e = buckets[i]; e; e = next) {
+         next = e->next;
+         e->next = nb[e->hash & (size - 1)];
+         nb[e->hash & (size - 1)] = e;
+      }
+   }
+   free(buckets);
+   buckets = nb;
+   mask = size - 1;
+}
+
+static void releaseCache(void *cache)
+{
+   InternEntry **c = (InternEntry **) cache;
+   int i;
+
+   for (i = 0; i < INTERN_CACHE_SIZE; i++)
+      if (c[i])
+         internStringRelease(c[i]->str);
+   free(c);
+}
+
+static void makeCacheKey()
+{
+   pthread_key_create(&cacheKey, releaseCache);
+}
+
+static InternEntry **threadCache()
+{
+   InternEntry **c;
+
+   pthread_once(&cacheOnce, makeCacheKey);
+   c = (InternEntry **) pthread_getspecific(cacheKey);
+   if (c == NULL) {
+      c = (InternEntry **) calloc(INTERN_CACHE_SIZE, sizeof(InternEntry *));
+      pthread_setspecific(cacheKey, c);
+   }
+   return c;
+}
+
+/*
+ * Returns the interned copy of s, holding a reference for the caller
+ * that has to be given back with internStringRelease(). The copy must
+ * not be modified.
+ */
+char *internString(const char *s)
+{
+   InternEntry *e, *old, **slot;
+   size_t len;
+   unsigned int hash;
+
+   if (s == NULL)
+      return NULL;
+   hash = hashString(s, &len);
+
+   /* cached entries can't go away, so no lock is needed to use them */
+   slot = threadCache() + (hash & (INTERN_CACHE_SIZE - 1));
+   e = *slot;
+   if (e && e->hash == hash && strcmp(e->str, s) == 0) {
+      __sync_fetch_and_add(&e->refs, 1);
+      return e->str;
+   }
+
+   pthread_mutex_lock(&internLock);
+   if (buckets) {
+      for (e = buckets[hash & mask]; e; e = e->next)
+         if (e->hash == hash && strcmp(e->str, s) == 0)
+            break;
+   }
+   else
+      e = NULL;
+   if (e)
+      __sync_fetch_and_add(&e->refs, 2);
+   else {
+      if (buckets == NULL || count >= mask + 1)
+         grow();
+      e = (InternEntry *) malloc(offsetof(InternEntry, str) + len + 1);
+      memcpy(e->str, s, len + 1);
+      e->hash = hash;
+      e->refs = 2;
+      e->next = buckets[hash & mask];
+      buckets[hash & mask] = e;
+      count++;
+   }
+   pthread_mutex_unlock(&internLock);
+
+   /* one reference for the caller, one for the cache */
+   old = *slot;
+   *slot = e;
+   if (old)
+      internStringRelease(old->str);
+   return e->str;
+}
+
+/* one more reference to an already interned string, no lookup */
+char *internStringRef(char *s)
+{
+   if (s)
+      __sync_fetch_and_add(&ENTRY(s)->refs, 1);
+   return s;
+}
+
+void internStringRelease(char *s)
+{
+   InternEntry *e, **p;
+   int refs;
+
+   if (s == NULL)
+      return;
+   e = ENTRY(s);
+   while ((refs = __atomic_load_n(&e->refs, __ATOMIC_RELAXED)) > 1)
+      if (__sync_bool_compare_and_swap(&e->refs, refs, refs - 1))
+         return;
+
+   /* the last reference is dropped under the lock internString() looks
+      up with, so it can't hand the entry out while it is freed */
+   pthread_mutex_lock(&internLock);
+   if (__sync_sub_and_fetch(&e->refs, 1) == 0) {
+      for (p = &buckets[e->hash & mask]; *p != e; p = &(*p)->next);
+      *p = e->next;
+      count--;
+      free(e);
+   }
+   pthread_mutex_unlock(&internLock);
+}
+
+/* the number of distinct names interned at the moment, including names
+   only the caches of threads still hold */
+unsigned int internStringCount()
+{
+   return count;
+}
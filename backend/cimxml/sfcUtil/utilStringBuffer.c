@@ -94,6 +94,15 @@ static void sbft_appendBlock(UtilStringBuffer * sb, void *data, unsigned int siz
    ((char*)sb->hdl)[sb->len]=0;
 }
 
+/* makes room for size more characters, so appending them won't realloc */
+static void sbft_reserve(UtilStringBuffer * sb, unsigned int size)
+{
+   if (size + sb->len + 1 >= sb->max) {
+      sb->max = size + sb->len + 2;
+      sb->hdl = realloc(sb->hdl, sb->max + 2);
+   }
+}
+
 static void sbft_append6Chars(UtilStringBuffer * sb, const char *chars1, const char *chars2, 
    const char *chars3, const char *chars4, const char *chars5, const char *chars6)
 {
@@ -159,7 +168,8 @@ UtilStringBuffer *newStringBuffer(int s)
       sbft_appendBlock,
       sbft_append3Chars,
       sbft_append5Chars,
-      sbft_append6Chars      
+      sbft_append6Chars,
+      sbft_reserve
    };
 
    UtilStringBuffer *sb = (UtilStringBuffer *) malloc(sizeof(UtilStringBuffer));
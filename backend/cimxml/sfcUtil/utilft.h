@@ -170,6 +170,7 @@ extern "C" {
          const char *chars3, const char *chars4, const char *chars5);
       void (*append6Chars) (UtilStringBuffer * sb, const char *chars1, const char *chars2,
          const char *chars3, const char *chars4, const char *chars5, const char *chars6);
+      void (*reserve) (UtilStringBuffer * sb, unsigned int size);
    };
 
 
@@ -188,6 +189,12 @@ extern "C" {
 
    extern Util_Factory_FT *UtilFactory;
 
+   /* interned names, see utilIntern.c */
+   char *internString(const char *s);
+   char *internStringRef(char *s);
+   void internStringRelease(char *s);
+   unsigned int internStringCount();
+
 
 #ifdef __cplusplus
 }
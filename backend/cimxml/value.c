@@ -21,6 +21,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <locale.h>
+#include <float.h>
+#include <limits.h>
 #include "cmcidt.h"
 #include "cmcift.h"
 #include "native.h"
@@ -253,6 +256,309 @@ char *value2Chars(CMPIType type, CMPIValue * value)
    return value2CharsUri(type,value,0);
 }
 
+/*
+ * Appends s to sb with the XML special characters replaced by their
+ * entities. The runs in between are copied as they are.
+ */
+void appendXmlEscaped(UtilStringBuffer *sb, const char *s)
+{
+   size_t n;
+
+   for (;;) {
+      n = strcspn(s, "\"&'<>");
+      if (n)
+         sb->ft->appendBlock(sb, (void *) s, n);
+      s += n;
+      switch (*s) {
+      case 0:
+         return;
+      case '"':
+         sb->ft->appendBlock(sb, "&quot;", 6);
+         break;
+      case '&':
+         sb->ft->appendBlock(sb, "&amp;", 5);
+         break;
+      case '\'':
+         sb->ft->appendBlock(sb, "&apos;", 6);
+         break;
+      case '<':
+         sb->ft->appendBlock(sb, "&lt;", 4);
+         break;
+      case '>':
+         sb->ft->appendBlock(sb, "&gt;", 4);
+         break;
+      }
+      s++;
+   }
+}
+
+static void appendDecimal(UtilStringBuffer *sb, unsigned long long u, int neg)
+{
+   char str[24], *p = str + sizeof(str);
+
+   do {
+      *--p = '0' + u % 10;
+      u /= 10;
+   } while (u);
+   if (neg)
+      *--p = '-';
+   sb->ft->appendBlock(sb, p, str + sizeof(str) - p);
+}
+
+static void appendSigned(UtilStringBuffer *sb, long long s)
+{
+   if (s < 0)
+      appendDecimal(sb, -(unsigned long long) s, 1);
+   else
+      appendDecimal(sb, s, 0);
+}
+
+/*
+ * Formats a value into sb the way value2Chars does, XML escaped, without
+ * the intermediate strings: numbers are converted on the stack and
+ * strings are escaped straight into the buffer.
+ */
+void value2Xml(CMPIType type, CMPIValue * value, UtilStringBuffer *sb)
+{
+   char str[64], *cv;
+   int  l;
+
+   switch (type) {
+   case CMPI_chars:
+      appendXmlEscaped(sb, value->chars ? (char *) value->chars : "NULL");
+      return;
+
+   case CMPI_string:
+   case CMPI_numericString:
+   case CMPI_booleanString:
+   case CMPI_dateTimeString:
+      appendXmlEscaped(sb, value->string && value->string->hdl ?
+                           (char *) value->string->hdl : "NULL");
+      return;
+
+   case CMPI_boolean:
+      if (value->boolean)
+         sb->ft->appendBlock(sb, "true", 4);
+      else
+         sb->ft->appendBlock(sb, "false", 5);
+      return;
+
+   case CMPI_uint8:  appendDecimal(sb, value->uint8, 0);  return;
+   case CMPI_uint16: appendDecimal(sb, value->uint16, 0); return;
+   case CMPI_uint32: appendDecimal(sb, value->uint32, 0); return;
+   case CMPI_uint64: appendDecimal(sb, value->uint64, 0); return;
+   case CMPI_sint8:  appendSigned(sb, value->sint8);      return;
+   case CMPI_sint16: appendSigned(sb, value->sint16);     return;
+   case CMPI_sint32: appendSigned(sb, value->sint32);     return;
+   case CMPI_sint64: appendSigned(sb, value->sint64);     return;
+
+   case CMPI_real32:
+      l = snprintf(str, sizeof(str), "%g", value->real32);
+      sb->ft->appendBlock(sb, str, l);
+      return;
+   case CMPI_real64:
+      l = snprintf(str, sizeof(str), "%g", value->real64);
+      sb->ft->appendBlock(sb, str, l);
+      return;
+   }
+
+   /* references, datetimes and the rest are rare, take the long way */
+   cv = value2Chars(type, value);
+   appendXmlEscaped(sb, cv);
+   free(cv);
+}
+
+/*
+ * Numbers are converted here rather than with sscanf(), which is slow
+ * and, for reals, depends on the decimal point of the current locale.
+ */
+
+#define IS_DIGIT(c) ((unsigned char) ((c) - '0') < 10)
+#define IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/*
+ * Parses a decimal integer with an optional sign into its magnitude.
+ * Returns 0, or -1 if val is not a number or has trailing characters
+ * other than white space, or if the magnitude doesn't fit into 64 bits,
+ * in which case it saturates. Like sscanf(), a number followed by
+ * other characters still yields the number.
+ */
+static int parseDecimal(const char *val, unsigned long long *mag, int *neg)
+{
+   const char *p = val, *start;
+   unsigned long long v = 0;
+   unsigned int d;
+
+   while (IS_SPACE(*p))
+      p++;
+   *neg = *p == '-';
+   if (*p == '-' || *p == '+')
+      p++;
+   while (*p == '0' && IS_DIGIT(p[1]))
+      p++;
+   start = p;
+
+   /* 19 digits can't overflow */
+   while (IS_DIGIT(*p) && p - start < 19)
+      v = v * 10 + (*p++ - '0');
+   if (p == start) {
+      *mag = 0;
+      return -1;
+   }
+   if (IS_DIGIT(*p)) {
+      d = *p++ - '0';
+      if (v > (~0ULL - d) / 10 || IS_DIGIT(*p)) {
+         *mag = ~0ULL;
+         return -1;
+      }
+      v = v * 10 + d;
+   }
+   *mag = v;
+
+   while (IS_SPACE(*p))
+      p++;
+   return *p ? -1 : 0;
+}
+
+/* an unsigned value of at most max, saturating at the bounds */
+static int str2Unsigned(const char *val, unsigned long long max,
+                        unsigned long long *v)
+{
+   int neg, rc = parseDecimal(val, v, &neg);
+
+   if (neg && *v) {
+      *v = 0;
+      return -1;
+   }
+   if (*v > max) {
+      *v = max;
+      return -1;
+   }
+   return rc;
+}
+
+/* a signed value between -max - 1 and max, saturating at the bounds */
+static int str2Signed(const char *val, long long max, long long *v)
+{
+   unsigned long long mag;
+   int neg, rc = parseDecimal(val, &mag, &neg);
+
+   if (neg ? mag > (unsigned long long) max + 1 : mag > (unsigned long long) max) {
+      *v = neg ? -max - 1 : max;
+      return -1;
+   }
+   *v = neg ? (long long) (0 - mag) : (long long) mag;
+   return rc;
+}
+
+/* the powers of 10 a double or a float holds exactly */
+static const double exactPow10[] = {
+   1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const float exactPow10f[] = {
+   1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+/*
+ * The common real values, up to 19 significant digits and a small
+ * exponent, are m * 10^e with m and 10^e exact, for which a single
+ * multiplication or division rounds correctly. Returns -1 for anything
+ * else, which is left to strtod().
+ */
+static int fastReal(const char *val, double *v, int single)
+{
+   const char *p = val;
+   unsigned long long m = 0;
+   int neg, digits = 0, e = 0, x = 0, xneg;
+
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD != 0
+   /* excess precision rounds twice */
+   return -1;
+#endif
+   while (IS_SPACE(*p))
+      p++;
+   neg = *p == '-';
+   if (*p == '-' || *p == '+')
+      p++;
+   for (; IS_DIGIT(*p); p++, digits++)
+      m = m * 10 + (*p - '0');
+   if (*p == '.') {
+      for (p++; IS_DIGIT(*p); p++, digits++, e--)
+         m = m * 10 + (*p - '0');
+   }
+   if (digits == 0 || digits > 19)
+      return -1;
+   if (*p == 'e' || *p == 'E') {
+      p++;
+      xneg = *p == '-';
+      if (*p == '-' || *p == '+')
+         p++;
+      if (!IS_DIGIT(*p))
+         return -1;
+      for (; IS_DIGIT(*p) && x < 1000; p++)
+         x = x * 10 + (*p - '0');
+      e += xneg ? -x : x;
+   }
+   while (IS_SPACE(*p))
+      p++;
+   if (*p)
+      return -1;
+
+   if (single) {
+      float f;
+      if (m > (1ULL << 24) || e < -10 || e > 10)
+         return -1;
+      f = (float) m;
+      f = e < 0 ? f / exactPow10f[-e] : f * exactPow10f[e];
+      *v = neg ? -f : f;
+   }
+   else {
+      if (m > (1ULL << 53) || e < -22 || e > 22)
+         return -1;
+      *v = e < 0 ? (double) m / exactPow10[-e] : (double) m * exactPow10[e];
+      if (neg)
+         *v = -*v;
+   }
+   return 0;
+}
+
+/*
+ * strtod() or strtof() for the XML decimal point whatever the locale:
+ * the '.' is replaced by the locale's decimal point if that differs.
+ */
+static double localeFreeStrtod(const char *val, int single)
+{
+   const char *dp = localeconv()->decimal_point, *dot;
+   char buf[128], *s;
+   size_t len, dl, pre;
+   double d;
+
+   if ((dp[0] == '.' && dp[1] == 0) || (dot = strchr(val, '.')) == NULL)
+      return single ? strtof(val, NULL) : strtod(val, NULL);
+
+   len = strlen(val);
+   dl = strlen(dp);
+   pre = dot - val;
+   s = len + dl < sizeof(buf) ? buf : (char *) malloc(len + dl);
+   memcpy(s, val, pre);
+   memcpy(s + pre, dp, dl);
+   memcpy(s + pre + dl, dot + 1, len - pre);
+   d = single ? strtof(s, NULL) : strtod(s, NULL);
+   if (s != buf)
+      free(s);
+   return d;
+}
+
+static double str2Real(const char *val, int single)
+{
+   double d;
+
+   if (fastReal(val, &d, single) == 0)
+      return d;
+   return localeFreeStrtod(val, single);
+}
+
 char *keytype2Chars(CMPIType type)
 {
    if (type == CMPI_boolean) return "boolean";
@@ -273,11 +579,11 @@ CMPIValue *getKeyValueTypePtr(char *type, char *value, XtokValueReference *ref,
       else if (strcasecmp(type, "numeric") == 0) {
          if (value[0] == '+' || value[0] == '-') {
             *typ = CMPI_sint64;
-            sscanf(value, "%lld", &val->uint64);
+            str2Signed(value, LLONG_MAX, &val->sint64);
          }
          else {
             *typ = CMPI_uint64;
-            sscanf(value, "%llu", &val->sint64);
+            str2Unsigned(value, ULLONG_MAX, &val->uint64);
          }
          return val;
       }
@@ -364,6 +670,8 @@ CMPIValue str2CMPIValue(CMPIType type, char *val, XtokValueReference *ref)
    CMPIValue value,*valp;
  //  char *val=p->value;
    CMPIType t;
+   unsigned long long u;
+   long long l;
 
    if (type==0) {
       type=guessType(val);
@@ -407,39 +715,45 @@ CMPIValue str2CMPIValue(CMPIType type, char *val, XtokValueReference *ref)
       value.string = native_new_CMPIString(val, NULL);
       break;
    case CMPI_sint64:
-      sscanf(val, "%lld", &value.sint64);
+      str2Signed(val, LLONG_MAX, &l);
+      value.sint64 = l;
       break;
    case CMPI_uint64:
-      sscanf(val, "%llu", &value.uint64);
+      str2Unsigned(val, ULLONG_MAX, &u);
+      value.uint64 = u;
       break;
    case CMPI_sint32:
-      sscanf(val, "%ld", &value.sint32);
+      str2Signed(val, 0x7fffffff, &l);
+      value.sint32 = l;
       break;
    case CMPI_uint32:
-      sscanf(val, "%lu", &value.uint32);
+      str2Unsigned(val, 0xffffffff, &u);
+      value.uint32 = u;
       break;
    case CMPI_sint16:
-      sscanf(val, "%hd", &value.sint16);
+      str2Signed(val, 0x7fff, &l);
+      value.sint16 = l;
       break;
    case CMPI_uint16:
-      sscanf(val, "%hu", &value.uint16);
+      str2Unsigned(val, 0xffff, &u);
+      value.uint16 = u;
       break;
    case CMPI_uint8:
-      sscanf(val, "%lu", &value.uint32);
-      value.uint8 = value.uint32;
+      str2Unsigned(val, 0xff, &u);
+      value.uint8 = u;
       break;
    case CMPI_sint8:
-      sscanf(val, "%ld", &value.sint32);
-      value.sint8 = value.sint32;
+      str2Signed(val, 0x7f, &l);
+      value.sint8 = l;
       break;
    case CMPI_boolean:
       value.boolean = strcasecmp(val, "false");
       break;
    case CMPI_real32:
-      sscanf(val, "%f", &value.real32);
+      value.real32 = str2Real(val, 1);
       break;
    case CMPI_real64:
-      sscanf(val, "%lf", &value.real64);
+      value.real64 = str2Real(val, 0);
       break;
    case CMPI_dateTime:
       value.dateTime = native_new_CMPIDateTime_fromChars(val, NULL);
@@ -33,6 +33,123 @@ extern "C" {
 /* NewCIMCEnv options */
 
 #define CIMC_NO_CURL_INIT 1  /* don't call curl_global_init() or _cleanup() */
+#define CIMC_STREAM_ENUMERATIONS 2  /* parse enumerations while they are received,
+                                       getNext() results are only valid up to
+                                       the next hasNext()/getNext() call */
+#define CIMC_COMPRESS_RESPONSES 4  /* ask for gzip or deflate compressed
+                                      responses, they are decoded while
+                                      received; ignored if libcurl has no
+                                      zlib support */
+
+/* CIMCEnv setOption() options, CIMXML environment only */
+
+#define CIMC_OPT_POOL_SIZE         1  /* idle connections kept for reuse by all
+                                         clients of the environment, 0 gives
+                                         every client its own connection */
+#define CIMC_OPT_POOL_IDLE_TIMEOUT 2  /* seconds an idle connection is kept */
+#define CIMC_OPT_PULL_MAX_OBJECT_COUNT 3  /* objects per pull request */
+#define CIMC_OPT_PULL_OPERATION_TIMEOUT 4 /* seconds the server keeps an open
+                                             enumeration between pulls,
+                                             0 for its default */
+#define CIMC_OPT_CLASS_CACHE_SIZE  5  /* classes kept by getClass() and
+                                         enumClasses(), 0 (the default)
+                                         disables the cache */
+#define CIMC_OPT_CLASS_CACHE_TTL   6  /* seconds a class is kept, 0 for
+                                         until evicted or flushed */
+#define CIMC_OPT_TIMEZONE_REFRESH  7  /* any value, looks up the local
+                                         timezone used for datetimes again
+                                         after TZ or the system timezone
+                                         was changed */
+#define CIMC_OPT_LISTENER_BACKLOG  8  /* connections waiting to be accepted
+                                         by indication listeners created
+                                         afterwards, 0 for 128 */
+#define CIMC_OPT_LISTENER_WORKERS  9  /* threads of such a listener reading
+                                         and decoding indications, 0 for 2 */
+#define CIMC_OPT_LISTENER_IDLE_TIMEOUT 10 /* seconds such a listener keeps an
+                                             idle connection, 0 for 15 */
+#define CIMC_OPT_LISTENER_QUEUE_SIZE 11 /* decoded indications such a listener
+                                           holds for its callback, rounded up
+                                           to a power of 2, 0 for 1024 */
+#define CIMC_OPT_LISTENER_OVERFLOW 12 /* what such a listener does with an
+                                         indication when the queue is full,
+                                         a CIMC_OVERFLOW_ value */
+#define CIMC_OPT_LISTENER_BATCH_SIZE 13 /* most indications passed to a batch
+                                           callback at once, 0 for 64 */
+#define CIMC_OPT_LISTENER_LINGER   14 /* milliseconds a batch callback is held
+                                         back for more indications to fill
+                                         the batch, 0 (the default) to pass
+                                         what is queued at once */
+#define CIMC_OPT_METRICS           15 /* 1 counts the operations of all
+                                         clients in getMetrics(), 0 (the
+                                         default) stops counting and keeps
+                                         what was counted */
+
+/* CIMC_OPT_LISTENER_OVERFLOW policies */
+
+#define CIMC_OVERFLOW_BLOCK        0  /* the worker waits for room, which holds
+                                         up the next request on its
+                                         connection (the default) */
+#define CIMC_OVERFLOW_DROP_OLDEST  1  /* the oldest queued indication is
+                                         dropped and counted */
+#define CIMC_OVERFLOW_DROP_NEWEST  2  /* the new indication is dropped and
+                                         counted */
+
+/* CIMCEnv getCounter() counters, CIMXML environment only */
+
+#define CIMC_CNT_POOL_HITS         1  /* requests sent on a pooled connection */
+#define CIMC_CNT_POOL_MISSES       2  /* requests that needed a new connection */
+#define CIMC_CNT_POOL_EXPIRED      3  /* idle connections closed by the pool */
+#define CIMC_CNT_POOL_IDLE         4  /* idle connections currently pooled */
+#define CIMC_CNT_BYTES_RECEIVED    5  /* response body bytes received */
+#define CIMC_CNT_BYTES_DECODED     6  /* the same after decompression */
+#define CIMC_CNT_CLASS_CACHE_HITS  7  /* classes taken from the cache */
+#define CIMC_CNT_CLASS_CACHE_MISSES 8 /* classes requested from the server */
+#define CIMC_CNT_CLASS_CACHE_EVICTED 9 /* classes dropped as least recently
+                                          used or expired */
+#define CIMC_CNT_CLASS_CACHE_ENTRIES 10 /* classes currently cached */
+
+/* CIMCIndicationListener getCounter() counters */
+
+#define CIMC_CNT_LISTENER_QUEUED   1  /* indications currently waiting for
+                                         the callback */
+#define CIMC_CNT_LISTENER_DELIVERED 2 /* indications passed to the callback */
+#define CIMC_CNT_LISTENER_DROPPED  3  /* indications dropped from a full queue */
+#define CIMC_CNT_LISTENER_BLOCKED  4  /* indications that waited for room */
+#define CIMC_CNT_LISTENER_MALFORMED 5 /* requests that could not be decoded */
+
+/* CIMCEnv getMetrics() phases of an operation, CIMXML environment only */
+
+#define CIMC_PHASE_TOTAL           0  /* from building the request to the
+                                         result */
+#define CIMC_PHASE_REQUEST         1  /* building the request, up to the
+                                         start of the transfer */
+#define CIMC_PHASE_RESOLVE         2  /* name lookup, only for requests that
+                                         opened a new connection */
+#define CIMC_PHASE_CONNECT         3  /* connecting, the same */
+#define CIMC_PHASE_TLS             4  /* TLS handshake, the same for https */
+#define CIMC_PHASE_SERVER          5  /* sending the request and waiting for
+                                         the first byte of the response */
+#define CIMC_PHASE_TRANSFER        6  /* receiving the rest of the response,
+                                         streamed enumerations are parsed
+                                         in this phase */
+#define CIMC_PHASE_PARSE           7  /* parsing the response into objects */
+#define CIMC_PHASES                8
+
+#define CIMC_METRICS_BUCKETS       32 /* histogram bucket 0 counts times below
+                                         1 microsecond, bucket b those from
+                                         2^(b-1) up to 2^b microseconds, the
+                                         last one also all longer times */
+
+/* CIMCResultTable getColumn() formats */
+
+#define CIMC_COLUMN_VALUES 0  /* an array of the column's type, CIMCUint32
+                                 for CIMC_uint32, CIMCBoolean for
+                                 CIMC_boolean and so on */
+#define CIMC_COLUMN_CODES  1  /* CIMCUint32 indexes into the column's
+                                 dictionary, for strings and datetimes */
+#define CIMC_COLUMN_DATA   2  /* CIMCData, for references, embedded objects
+                                 and arrays, or when rows have different
+                                 types */
 
   
   /*
@@ -42,6 +159,8 @@ extern "C" {
 
   struct _CIMCClient;
   typedef struct _CIMCClient CIMCClient;
+  struct _CIMCResultTable;
+  typedef struct _CIMCResultTable CIMCResultTable;
   
   typedef struct _CIMCClientFT {
     
@@ -355,6 +474,55 @@ extern "C" {
       (CIMCClient *cl, 
        CIMCObjectPath *op, const char *name, CIMCStatus *rc);
 
+    /** Enumerate Instances of the class (and subclasses) defined by &lt;op&gt;
+	with the pull operations (OpenEnumerateInstances, PullInstancesWithPath),
+	CIMXML only. The instances are fetched CIMC_OPT_PULL_MAX_OBJECT_COUNT at a
+	time while the enumeration is iterated, getNext() results are only valid
+	up to the call that fetches the next page. Releasing the enumeration
+	before its end closes it on the server.
+	@param cl Client this pointer.
+	@param op ObjectPath containing nameSpace and classname components.
+	@param flags CIMC_FLAG_DeepInheritance and CIMC_FLAG_IncludeClassOrigin.
+	@param properties If not NULL, the members of the array define one or more Property
+	names. Each returned Object MUST NOT include elements for any Properties
+	missing from this list
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Enumeration of Instances.
+    */
+    CIMCEnumeration* (*openEnumInstances)
+      (CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties, CIMCStatus* rc);
+
+    /** Enumerate Instance Names of the class (and subclasses) defined by
+	&lt;op&gt; with the pull operations (OpenEnumerateInstancePaths,
+	PullInstancePaths), like openEnumInstances(). CIMXML only.
+	@param cl Client this pointer.
+	@param op ObjectPath containing nameSpace and classname components.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Enumeration of ObjectPathes.
+    */
+    CIMCEnumeration* (*openEnumInstanceNames)
+      (CIMCClient* cl,
+       CIMCObjectPath* op, CIMCStatus* rc);
+
+    /** Enumerate Instances of the class (and subclasses) defined by &lt;op&gt;
+	into a CIMCResultTable, one row per instance and one column per
+	property, CIMXML only. The response is decoded straight into the
+	columns without creating instance objects.
+	@param cl Client this pointer.
+	@param op ObjectPath containing nameSpace and classname components.
+	@param flags Any combination of the following flags are supported:
+	CIMC_FLAG_LocalOnly, CIMC_FLAG_DeepInheritance and
+	CIMC_FLAG_IncludeClassOrigin. Qualifiers are not kept.
+	@param properties If not NULL, the members of the array define one or more Property
+	names. Each returned Object MUST NOT include elements for any Properties
+	missing from this list
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Table of the Instances.
+    */
+    CIMCResultTable* (*enumInstancesTable)
+      (CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties, CIMCStatus* rc);
 
   } CIMCClientFT;
 
@@ -364,12 +532,456 @@ extern "C" {
   };
 
 
+  /*
+   * _CIMCAsyncFT Function Table
+   *
+   * Asynchronous operations, CIMXML environment only. Operations submitted
+   * to a CIMCAsync object are transferred concurrently over their own
+   * connections and are driven by perform() or wait(), so that a single
+   * thread can keep many requests in flight. A client must not be released
+   * while operations submitted for it are outstanding.
+   */
+
+  struct _CIMCAsync;
+  typedef struct _CIMCAsync CIMCAsync;
+  struct _CIMCAsyncOp;
+  typedef struct _CIMCAsyncOp CIMCAsyncOp;
+
+  /** Called from perform() or wait() when an operation is complete.
+      @param op The handle returned when the operation was submitted,
+      invalid after the callback returns.
+      @param data The data pointer given when the operation was submitted.
+      @param rc Operation status, rc->msg is released after the callback.
+      @param result The result the synchronous operation would have
+      returned, owned by the callback: CIMC_enumeration, CIMC_class,
+      CIMC_instance or CIMC_ref for the respective operations, the property
+      or return value for getProperty() and invokeMethod() and CIMC_null for
+      setInstance(), deleteInstance() and setProperty().
+  */
+  typedef void (*CIMCAsyncCallback)
+    (CIMCAsyncOp *op, void *data, CIMCStatus *rc, CIMCData *result);
+
+  typedef struct _CIMCAsyncFT {
+
+    /** Function table version
+     */
+    int ftVersion;
+
+    /** Cancels all outstanding operations without calling their callbacks
+	and frees the CIMCAsync object.
+	@param as CIMCAsync this pointer.
+	@return Service return status.
+    */
+    CIMCStatus (*release)
+      (CIMCAsync *as);
+
+    /** Transfers whatever can be transferred without blocking and calls the
+	callbacks of the operations that completed.
+	@param as CIMCAsync this pointer.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Number of operations still outstanding.
+    */
+    int (*perform)
+      (CIMCAsync *as, CIMCStatus *rc);
+
+    /** Waits up to timeout milliseconds for one of the outstanding
+	operations to make progress, then does the same as perform().
+	@param as CIMCAsync this pointer.
+	@param timeout Maximum time to wait in milliseconds.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Number of operations still outstanding.
+    */
+    int (*wait)
+      (CIMCAsync *as, int timeout, CIMCStatus *rc);
+
+    /** Cancels an outstanding operation, its callback is not called.
+	@param as CIMCAsync this pointer.
+	@param op The operation handle.
+	@return Service return status.
+    */
+    CIMCStatus (*cancel)
+      (CIMCAsync *as, CIMCAsyncOp *op);
+
+    /* The submit functions take the arguments of the CIMCClientFT function
+       of the same name followed by the completion callback and its data.
+       All arguments can be released when the function returns, except for
+       the client and the out argument of invokeMethod(), which is filled
+       when the operation completes. They return NULL and set rc when the
+       request can not be submitted. */
+
+    CIMCAsyncOp* (*getClass)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*enumClassNames)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*enumClasses)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*getInstance)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*createInstance)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCInstance* inst,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*setInstance)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCInstance* inst, CIMCFlags flags, char ** properties,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*deleteInstance)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*execQuery)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *query, const char *lang,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*enumInstanceNames)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*enumInstances)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*associators)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *assocClass, const char *resultClass,
+       const char *role, const char *resultRole, CIMCFlags flags,
+       char** properties,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*associatorNames)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *assocClass, const char *resultClass,
+       const char *role, const char *resultRole,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*references)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *resultClass ,const char *role ,
+       CIMCFlags flags, char** properties,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*referenceNames)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *resultClass ,const char *role,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*invokeMethod)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op,const char *method,
+       CIMCArgs* in, CIMCArgs* out,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*setProperty)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *name , CIMCValue* value,
+       CIMCType type,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+    CIMCAsyncOp* (*getProperty)
+      (CIMCAsync *as, CIMCClient* cl,
+       CIMCObjectPath* op, const char *name,
+       CIMCAsyncCallback cb, void *data, CIMCStatus* rc);
+  } CIMCAsyncFT;
+
+  struct _CIMCAsync {
+    void *hdl;
+    CIMCAsyncFT *ft;
+  };
+
+
+  /*
+   * _CIMCBatchFT Function Table
+   *
+   * Batched operations, CIMXML environment only. Operations added to a
+   * CIMCBatch object are sent to the CIMOM of its client by execute() in a
+   * single multiple operation request (DSP0200 MULTIREQ) and their results
+   * are taken from the multiple operation response. CIMOMs that do not
+   * support multiple requests get the operations one after the other.
+   */
+
+  struct _CIMCBatch;
+  typedef struct _CIMCBatch CIMCBatch;
+
+  typedef struct _CIMCBatchFT {
+
+    /** Function table version
+     */
+    int ftVersion;
+
+    /** Releases the CIMCBatch object and the results of its operations.
+	@param bt CIMCBatch this pointer.
+	@return Service return status.
+    */
+    CIMCStatus (*release)
+      (CIMCBatch *bt);
+
+    /** Sends the operations added since the last execute() and receives
+	their results.
+	@param bt CIMCBatch this pointer.
+	@return Service return status, the status of the exchange as a whole;
+	the operations have a status of their own.
+    */
+    CIMCStatus (*execute)
+      (CIMCBatch *bt);
+
+    /** Gets the number of operations added.
+	@param bt CIMCBatch this pointer.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Number of operations.
+    */
+    CIMCCount (*getCount)
+      (CIMCBatch *bt, CIMCStatus *rc);
+
+    /** Gets the result of an executed operation.
+	@param bt CIMCBatch this pointer.
+	@param index Number returned when the operation was added.
+	@param rc Output: Status of the operation (suppressed when NULL).
+	@return The result the synchronous operation would have returned,
+	as for CIMCAsyncCallback, but owned by the CIMCBatch object.
+    */
+    CIMCData (*getResult)
+      (CIMCBatch *bt, CIMCCount index, CIMCStatus *rc);
+
+    /* The add functions take the arguments of the CIMCClientFT function of
+       the same name, all of which can be released when the function
+       returns, except for the out argument of invokeMethod(), which is
+       filled by execute(). They return the index of the operation in the
+       batch, or -1 and set rc when the request can not be built. */
+
+    int (*getClass)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties, CIMCStatus* rc);
+    int (*enumClassNames)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCFlags flags, CIMCStatus* rc);
+    int (*enumClasses)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCFlags flags, CIMCStatus* rc);
+    int (*getInstance)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties, CIMCStatus* rc);
+    int (*createInstance)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCInstance* inst, CIMCStatus* rc);
+    int (*setInstance)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCInstance* inst, CIMCFlags flags, char ** properties,
+       CIMCStatus* rc);
+    int (*deleteInstance)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCStatus* rc);
+    int (*execQuery)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *query, const char *lang, CIMCStatus* rc);
+    int (*enumInstanceNames)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCStatus* rc);
+    int (*enumInstances)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, CIMCFlags flags, char** properties, CIMCStatus* rc);
+    int (*associators)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *assocClass, const char *resultClass,
+       const char *role, const char *resultRole, CIMCFlags flags,
+       char** properties, CIMCStatus* rc);
+    int (*associatorNames)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *assocClass, const char *resultClass,
+       const char *role, const char *resultRole, CIMCStatus* rc);
+    int (*references)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *resultClass ,const char *role ,
+       CIMCFlags flags, char** properties, CIMCStatus* rc);
+    int (*referenceNames)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *resultClass ,const char *role,
+       CIMCStatus* rc);
+    int (*invokeMethod)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op,const char *method,
+       CIMCArgs* in, CIMCArgs* out, CIMCStatus* rc);
+    int (*setProperty)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *name , CIMCValue* value,
+       CIMCType type, CIMCStatus* rc);
+    int (*getProperty)
+      (CIMCBatch *bt,
+       CIMCObjectPath* op, const char *name, CIMCStatus* rc);
+  } CIMCBatchFT;
+
+  struct _CIMCBatch {
+    void *hdl;
+    CIMCBatchFT *ft;
+  };
+
+
+  /*
+   * _CIMCResultTableFT Function Table
+   *
+   * Instances of an enumeration stored column-wise, CIMXML environment
+   * only. Every property is a column holding the values of all rows in
+   * one contiguous array, with a bitmap of the rows where it is NULL or
+   * missing. Strings are stored once per column in a dictionary. Rows of
+   * subclasses add columns, which are NULL in the other rows. getRow()
+   * gives a row as a read-only CIMCInstance for code expecting instances.
+   * A table must not be used by several threads at once.
+   */
+
+  typedef struct _CIMCResultTableFT {
+
+    /** Function table version
+     */
+    int ftVersion;
+
+    /** Releases the table. Rows obtained with getRow() remain valid
+	until they are released themselves.
+	@param rt CIMCResultTable this pointer.
+	@return Service return status.
+    */
+    CIMCStatus (*release)
+      (CIMCResultTable *rt);
+
+    /** Gets the number of rows, one per instance.
+	@param rt CIMCResultTable this pointer.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Number of rows.
+    */
+    CIMCCount (*getRowCount)
+      (CIMCResultTable *rt, CIMCStatus *rc);
+
+    /** Gets the number of columns, one per property name.
+	@param rt CIMCResultTable this pointer.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Number of columns.
+    */
+    CIMCCount (*getColumnCount)
+      (CIMCResultTable *rt, CIMCStatus *rc);
+
+    /** Gets the property name of a column.
+	@param rt CIMCResultTable this pointer.
+	@param col Column index.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Property name, owned by the table.
+    */
+    const char* (*getColumnName)
+      (CIMCResultTable *rt, CIMCCount col, CIMCStatus *rc);
+
+    /** Gets the CIMCType of a column's values.
+	@param rt CIMCResultTable this pointer.
+	@param col Column index.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Type of the first value stored in the column.
+    */
+    CIMCType (*getColumnType)
+      (CIMCResultTable *rt, CIMCCount col, CIMCStatus *rc);
+
+    /** Looks a column up by property name, case insensitively.
+	@param rt CIMCResultTable this pointer.
+	@param name Property name.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Column index or -1 if there is no such property.
+    */
+    int (*findColumn)
+      (CIMCResultTable *rt, const char *name, CIMCStatus *rc);
+
+    /** Gets the values of a column, one per row.
+	@param rt CIMCResultTable this pointer.
+	@param col Column index.
+	@param format Output: CIMC_COLUMN_VALUES, CIMC_COLUMN_CODES or
+	CIMC_COLUMN_DATA, how the values are stored.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return The values, owned by the table; the entries of NULL rows are
+	zero.
+    */
+    const void* (*getColumn)
+      (CIMCResultTable *rt, CIMCCount col, int *format, CIMCStatus *rc);
+
+    /** Gets the NULL bitmap of a column.
+	@param rt CIMCResultTable this pointer.
+	@param col Column index.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Bit (row % 8) of byte (row / 8) is set when the row has no
+	value in the column. Owned by the table.
+    */
+    const unsigned char* (*getNulls)
+      (CIMCResultTable *rt, CIMCCount col, CIMCStatus *rc);
+
+    /** Gets the distinct values of a CIMC_COLUMN_CODES column.
+	@param rt CIMCResultTable this pointer.
+	@param col Column index.
+	@param size Output: Number of entries.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return The strings the codes of the column index, owned by the
+	table; datetimes are in their CIM string format.
+    */
+    const char* const* (*getDictionary)
+      (CIMCResultTable *rt, CIMCCount col, CIMCCount *size, CIMCStatus *rc);
+
+    /** Gets a single value.
+	@param rt CIMCResultTable this pointer.
+	@param row Row index.
+	@param col Column index.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return The value as a CIMCInstance property would hold it, owned
+	by the table.
+    */
+    CIMCData (*getData)
+      (CIMCResultTable *rt, CIMCCount row, CIMCCount col, CIMCStatus *rc);
+
+    /** Gets the class of a row's instance.
+	@param rt CIMCResultTable this pointer.
+	@param row Row index.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Class name, owned by the table.
+    */
+    const char* (*getClassName)
+      (CIMCResultTable *rt, CIMCCount row, CIMCStatus *rc);
+
+    /** Gets a row as an instance. The instance reads from the table and
+	can't be modified, its clone() is a regular CIMCInstance.
+	@param rt CIMCResultTable this pointer.
+	@param row Row index.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return Instance, to be released by the caller.
+    */
+    CIMCInstance* (*getRow)
+      (CIMCResultTable *rt, CIMCCount row, CIMCStatus *rc);
+  } CIMCResultTableFT;
+
+  struct _CIMCResultTable {
+    void *hdl;
+    CIMCResultTableFT *ft;
+  };
+
+
   /*
    * CIMCEnv function table definition
    */
    
   struct _CIMCEnv;
   typedef struct _CIMCEnv CIMCEnv;
+
+  /*
+   * Operations counted by CIMCEnv getMetrics(), for one operation type or
+   * all of them when operation is NULL. An operation type is the
+   * intrinsic method name, "InvokeMethod" for extrinsic methods and
+   * "Batch" for the multiple operation requests of a CIMCBatch.
+   * dumpMetrics() returns the metrics of every type as a JSON object,
+   * to be freed by the caller.
+   */
+
+  typedef struct _CIMCMetrics {
+    CIMCUint64 operations;
+    CIMCUint64 failures;          /* by transfer, HTTP or CIM error */
+    CIMCUint64 requestBytes;      /* request bodies sent */
+    CIMCUint64 responseBytes;     /* response bodies received */
+    CIMCUint64 decodedBytes;      /* the same after decompression */
+    CIMCUint64 objects;           /* results of the operations */
+    CIMCUint64 time[CIMC_PHASES]; /* microseconds, summed up */
+    CIMCUint64 histogram[CIMC_PHASES][CIMC_METRICS_BUCKETS];
+  } CIMCMetrics;
   
   typedef struct _CIMCEnvFT {
     char *env;
@@ -404,6 +1016,24 @@ extern "C" {
        void (*fp) (CIMCInstance *indInstance), CIMCStatus* rc);
     void* (*markHeap) ();
     void  (*releaseHeap) (void* heap);
+    CIMCStatus (*setOption)
+      (CIMCEnv *ce, int option, long value);
+    CIMCUint64 (*getCounter)
+      (CIMCEnv *ce, int counter, CIMCStatus* rc);
+    CIMCAsync* (*newAsync)
+      (CIMCEnv *ce, CIMCStatus* rc);
+    CIMCBatch* (*newBatch)
+      (CIMCEnv *ce, CIMCClient *cl, CIMCStatus* rc);
+    CIMCStatus (*flushClassCache)
+      (CIMCEnv *ce, CIMCObjectPath *op);
+    CIMCIndicationListener* (*newBatchIndicationListener)
+      (CIMCEnv *ce, int sslMode, int *portNumber, char **socketName,
+       void (*fp) (CIMCInstance **indInstances, CIMCCount count),
+       CIMCStatus* rc);
+    CIMCStatus (*getMetrics)
+      (CIMCEnv *ce, const char *operation, CIMCMetrics *metrics);
+    char* (*dumpMetrics)
+      (CIMCEnv *ce, CIMCStatus* rc);
   } CIMCEnvFT;
 
   struct _CIMCEnv {
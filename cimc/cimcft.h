@@ -756,6 +756,15 @@ extern "C" {
     */
     CIMCStatus (*stop)
       (CIMCIndicationListener* il);      
+
+    /** Get a counter of the indications received by the listener.
+	@param il pointer to this indication listener.
+	@param counter a CIMC_CNT_LISTENER_ value.
+	@param rc Output: Service return status (suppressed when NULL).
+	@return The counter, summed over all starts of the listener.
+    */
+    CIMCUint64 (*getCounter)
+      (CIMCIndicationListener* il, int counter, CIMCStatus* rc);
   };
 #ifdef __cplusplus
 };
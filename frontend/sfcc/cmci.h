@@ -363,6 +363,27 @@ typedef struct _CMCIClientFT {
                 (CMCIClient *cl, 
                  CMPIObjectPath *op, const char *name, CMPIStatus *rc);
 
+     /** Enumerate Instances with the pull operations, CIMXML only.
+         See openEnumInstances in cimc.h.
+     */
+     CMPIEnumeration* (*openEnumInstances)
+                (CMCIClient* cl,
+                 CMPIObjectPath* op, CMPIFlags flags, char** properties, CMPIStatus* rc);
+
+     /** Enumerate Instance Names with the pull operations, CIMXML only.
+         See openEnumInstanceNames in cimc.h.
+     */
+     CMPIEnumeration* (*openEnumInstanceNames)
+                (CMCIClient* cl,
+                 CMPIObjectPath* op, CMPIStatus* rc);
+
+     /** Enumerate Instances into a column-wise table, CIMXML only.
+         See enumInstancesTable and CIMCResultTable in cimc.h.
+     */
+     struct _CIMCResultTable* (*enumInstancesTable)
+                (CMCIClient* cl,
+                 CMPIObjectPath* op, CMPIFlags flags, char** properties, CMPIStatus* rc);
+
 
 } CMCIClientFT;
 
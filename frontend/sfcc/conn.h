@@ -20,6 +20,15 @@ struct _CMCIConnection {
     UtilStringBuffer *mResponse; // Used to store the HTTP response
     CMPIStatus        mStatus;   // returned request status (via HTTP trailers)               
     struct _TimeoutControl mTimeout; /* Used for timeout control */
+    CURLM *mMulti;               // Drives streamed responses
+    struct _StreamEnumeration *mStream; // Streamed response in progress
+    struct _ConnectionPool *mPool; // Supplies mHandle while a request is active
+    char *mPoolKey;              // Identifies the handles mHandle can be taken from
+    struct parser_heap *mHeap;   // Parser allocations, reused for every response
+    CMPIUint64 mDecoded;         // Response bytes received after decompression
+    struct _OperationMetrics *mMetrics; // Counts the request, NULL unless metrics are on
+    CMPIUint64 mStarted;         // When the request was prepared, in microseconds
+    CMPIUint64 mSent;            // Request body bytes
 };
 #ifdef __cplusplus
  }
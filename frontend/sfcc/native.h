@@ -50,6 +50,7 @@ struct native_enum {
 
 //! Forward declaration for anonymous struct.
 struct native_property;
+struct native_propertyTable;
 struct native_qualifier;
 struct native_method;
 
@@ -58,9 +59,11 @@ struct native_constClass {
 
 	char * classname;
 
-	struct native_property * props;
+	struct native_propertyTable * props;
 	struct native_qualifier *qualifiers;
 	struct native_method *methods;
+
+	int refCount;		/* see native_ref_CMPIConstClass() */
 };
 
 struct native_instance {
@@ -73,7 +76,7 @@ struct native_instance {
 	char ** property_list;
 	char ** key_list;
 
-	struct native_property * props;
+	struct native_propertyTable * props;
     struct native_qualifier *qualifiers;
 };
 
@@ -102,7 +105,29 @@ struct native_property {
 	CMPIValueState state; 	                //!< Current value state.
 	CMPIValue value;	                //!< Current value.
 	struct native_qualifier *qualifiers;	//!< Qualifiers.
-	struct native_property * next;	        //!< Pointer to next property.
+	unsigned int hash;	                //!< Case insensitive hash of name.
+	char * raw;		                //!< Value text not converted yet.
+	unsigned int rawCount;	                //!< Array elements in raw.
+	int converting;		                //!< raw claimed by a reader.
+};
+
+struct native_rawChunk;
+
+//! Properties in insertion order, indexed by name.
+/*!
+  The properties are kept in one array, so positions are looked up
+  directly. Tables with more than a few properties get a hash index on
+  the case insensitive name. Adding a property may move the array.
+  Values parsed from a response are kept as text, stored in chunks owned
+  by the table, until they are first read.
+*/
+struct native_propertyTable {
+	struct native_property * props;	        //!< Properties in insertion order.
+	unsigned int count;	                //!< Properties in use.
+	unsigned int max;	                //!< Properties allocated.
+	unsigned int * index;	                //!< Hash index: position + 1, 0 if free.
+	unsigned int mask;	                //!< Size of the index - 1.
+	struct native_rawChunk * raw;	        //!< Storage of the raw values.
 };
 
 struct native_qualifier {
@@ -117,7 +142,7 @@ struct native_qualifier {
 //! Function table for native_property handling functions.
 /*!
   This structure holds all the function pointers necessary to handle
-  linked lists of native_property structs.
+  tables of native_property structs.
 
   \sa propertyFT in native.h
 */
@@ -126,50 +151,56 @@ struct native_propertyFT
         //! Function table version
         int ftVersion;
 
-	//! Releases a complete list of native_property items.
-	void (* release) ( struct native_property * );
+	//! Releases a complete table of native_property items.
+	void (* release) ( struct native_propertyTable * );
 
-	//! Clones a complete list of native_property items.
-	struct native_property * (* clone) ( struct native_property *,
+	//! Clones a complete table of native_property items.
+	struct native_propertyTable * (* clone) ( struct native_propertyTable *,
 					     CMPIStatus * );
                                              
-	//! Adds a new native_property to a list.
-	struct native_property* (* getProperty) ( struct native_property *,
+	//! Looks up a specific native_property.
+	struct native_property* (* getProperty) ( struct native_propertyTable *,
 			      const char *);
 
-	//! Adds a new native_property to a list.
-	int (* addProperty) ( struct native_property **,
+	//! Adds a new native_property to a table, allocated if NULL.
+	int (* addProperty) ( struct native_propertyTable **,
 			      const char *,
 			      CMPIType,
 			      CMPIValueState,
 			      CMPIValue * );
 
 	//! Resets the values of an existing native_property, if existant.
-	int (* setProperty) ( struct native_property *,
+	int (* setProperty) ( struct native_propertyTable *,
 			      const char *,
 			      CMPIType,
 			      CMPIValue * );
 
 	//! Looks up a specifix native_property in CMPIData format.
-	CMPIData (* getDataProperty) ( struct native_property *,
+	CMPIData (* getDataProperty) ( struct native_propertyTable *,
 				       const char *,
 				       CMPIStatus * );
 
 	//! Extract an indexed native_property in CMPIData format.
-	CMPIData (* getDataPropertyAt) ( struct native_property *,
+	CMPIData (* getDataPropertyAt) ( struct native_propertyTable *,
 					 unsigned int,
 					 CMPIString **,
 					 CMPIStatus * );
 
-	//! Yields the number of native_property items in a list.
-	CMPICount (* getPropertyCount) ( struct native_property *,
+	//! Yields the number of native_property items in a table.
+	CMPICount (* getPropertyCount) ( struct native_propertyTable *,
 					 CMPIStatus * );
 
 	//! Looks up a specifix native_property and return qualifier chain.
-	struct native_qualifier *(*__getDataPropertyQualifiers ) ( struct native_property *,
+	struct native_qualifier *(*__getDataPropertyQualifiers ) ( struct native_propertyTable *,
 				       const char *,
 				       CMPIStatus * );
 
+	//! Adds or resets a native_property to text values converted on first access.
+	int (* setRawProperty) ( struct native_propertyTable **,
+				 const char *,
+				 CMPIType,
+				 char **,
+				 unsigned int );
 };
 
 
@@ -317,6 +348,7 @@ CMPIArray * native_new_CMPIArray ( CMPICount size,
 void native_array_increase_size ( CMPIArray *, CMPICount );
 CMPIEnumeration * native_new_CMPIEnumeration ( CMPIArray *, CMPIStatus * );
 CMPIInstance * native_new_CMPIInstance ( CMPIObjectPath *, CMPIStatus * );
+CMPIConstClass * native_ref_CMPIConstClass ( CMPIConstClass * );
 CMPIObjectPath * native_new_CMPIObjectPath ( const char *,
 					     const char *,
 					     CMPIStatus * );
@@ -327,6 +359,7 @@ CMPIDateTime * native_new_CMPIDateTime_fromBinary ( CMPIUint64,
 						    CMPIStatus * );
 CMPIDateTime * native_new_CMPIDateTime_fromChars ( const char *,
 						   CMPIStatus * );
+void native_datetime_refresh_timezone ( void );
 
 struct xtokValueReference;
 CMPIValue str2CMPIValue(CMPIType type, char *val, struct xtokValueReference *ref);